@@ -34,159 +34,332 @@ SOFTWARE.
 #ifndef ABAG_HPP_
 #define ABAG_HPP_
 #include <Eigen/Core>
-#include <iostream>
-#include <sstream>
-#include <fstream>
-#include <chrono>
-#include <time.h>
-#include <thread> 
+#include <cassert>
 #include <cmath>
-#include <stdlib.h>     /* abs */
 
+/**
+ * State and parameters of ROWS x COLS independent ABAG channels, stored column-major.
+ * A single ABAG is one column, a pack of controllers is one column per controller.
+ * The update is written as one coefficient-wise expression per signal: Eigen fuses each
+ * into a single loop without intermediate vectors, and every decision of the original
+ * algorithm is expressed through sign and min/max, so there is no data-dependent branch.
+ */
+template <int ROWS, int COLS>
+struct abag_kernel
+{
+    typedef Eigen::Matrix<double, ROWS, COLS> matrix_type;
+
+    abag_kernel(const int rows, const int cols):
+        error_sign_(matrix_type::Zero(rows, cols)),
+        error_(matrix_type::Zero(rows, cols)),
+        bias_(matrix_type::Zero(rows, cols)),
+        gain_(matrix_type::Zero(rows, cols)),
+        command_(matrix_type::Zero(rows, cols)),
+        ERROR_ALPHA(matrix_type::Zero(rows, cols)),
+        BIAS_THRESHOLD(matrix_type::Zero(rows, cols)),
+        BIAS_STEP(matrix_type::Zero(rows, cols)),
+        GAIN_THRESHOLD(matrix_type::Zero(rows, cols)),
+        GAIN_STEP(matrix_type::Zero(rows, cols)),
+        MIN_BIAS_SAT_LIMIT(-matrix_type::Ones(rows, cols)),
+        MAX_BIAS_SAT_LIMIT(matrix_type::Ones(rows, cols)),
+        MIN_GAIN_SAT_LIMIT(matrix_type::Zero(rows, cols)),
+        MAX_GAIN_SAT_LIMIT(matrix_type::Ones(rows, cols)),
+        MIN_COMMAND_SAT_LIMIT(-matrix_type::Ones(rows, cols)),
+        MAX_COMMAND_SAT_LIMIT(matrix_type::Ones(rows, cols)){};
+    ~abag_kernel(){};
+
+    template <typename Derived>
+    void update(const Eigen::MatrixBase<Derived> &raw_error)
+    {
+        /*
+        *   Be careful with direction of error!
+        *   Reversing error is important due to possibility of different controller inputs.
+        *   If e.g. velocity is given in Hz or m/s, the error should be reversed w.r.t. 
+        *   pseudo code error explained in the original publication. 
+        *   Else if, e.g. the velocity is given as a period of rotation, 
+        *   the error calculation should be the same as in the original pseudo code.
+        */
+        error_sign_.array() = raw_error.array().sign();
+
+        error_.array() = ERROR_ALPHA.array() * error_.array() + (1.0 - ERROR_ALPHA.array()) * error_sign_.array();
+
+        // Bias decision map: heaviside(|e| - threshold) * sign(e - threshold)
+        bias_.array() = (bias_.array() + BIAS_STEP.array() * 
+                         (0.5 * ((error_.array().abs() - BIAS_THRESHOLD.array()).sign() + 1.0) *
+                          (error_.array() - BIAS_THRESHOLD.array()).sign())
+                        ).min(MAX_BIAS_SAT_LIMIT.array()).max(MIN_BIAS_SAT_LIMIT.array());
+
+        // Gain decision map: sign(|e| - threshold)
+        gain_.array() = (gain_.array() + GAIN_STEP.array() * (error_.array().abs() - GAIN_THRESHOLD.array()).sign()
+                        ).min(MAX_GAIN_SAT_LIMIT.array()).max(MIN_GAIN_SAT_LIMIT.array());
+
+        command_.array() = (bias_.array() + gain_.array() * error_sign_.array()
+                           ).min(MAX_COMMAND_SAT_LIMIT.array()).max(MIN_COMMAND_SAT_LIMIT.array());
+    }
+
+    // Signals
+    matrix_type error_sign_, error_, bias_, gain_, command_;
+
+    // Parameters
+    matrix_type ERROR_ALPHA;
+    matrix_type BIAS_THRESHOLD;
+    matrix_type BIAS_STEP;
+    matrix_type GAIN_THRESHOLD;
+    matrix_type GAIN_STEP;
+    matrix_type MIN_BIAS_SAT_LIMIT;
+    matrix_type MAX_BIAS_SAT_LIMIT;
+    matrix_type MIN_GAIN_SAT_LIMIT;
+    matrix_type MAX_GAIN_SAT_LIMIT;
+    matrix_type MIN_COMMAND_SAT_LIMIT;
+    matrix_type MAX_COMMAND_SAT_LIMIT;
+};
+
+template <int N, int K> class ABAG_pack;
+
+/**
+ * N: number of controlled dimensions, fixed at compile time, 
+ * or Eigen::Dynamic if it is only known at run time (e.g. number of robot joints).
+ */
+template <int N = Eigen::Dynamic>
 class ABAG
 {
   public:
-    ABAG(const int num_of_dimensions);
+    typedef Eigen::Matrix<double, N, 1> vector_type;
 
-    ABAG(const int num_of_dimensions, const Eigen::VectorXd &error_alpha,
-         const Eigen::VectorXd &bias_threshold, const Eigen::VectorXd &bias_step, 
-         const Eigen::VectorXd &gain_threshold, const Eigen::VectorXd &gain_step,
-         const Eigen::VectorXd &min_bias_sat_limit, const Eigen::VectorXd &max_bias_sat_limit,
-         const Eigen::VectorXd &min_gain_sat_limit, const Eigen::VectorXd &max_gain_sat_limit,
-         const Eigen::VectorXd &min_command_sat_limit, const Eigen::VectorXd &max_command_sat_limit);
+    ABAG(const int num_of_dimensions):
+        DIMENSIONS_(num_of_dimensions), kernel_(num_of_dimensions, 1)
+    {
+        assert(("ABAG Controller not initialized properly", DIMENSIONS_ > 0));
+        assert(("ABAG dimensions do not match the template", N == Eigen::Dynamic || N == DIMENSIONS_));
+    };
+
+    ABAG(const int num_of_dimensions, const vector_type &error_alpha,
+         const vector_type &bias_threshold, const vector_type &bias_step, 
+         const vector_type &gain_threshold, const vector_type &gain_step,
+         const vector_type &min_bias_sat_limit, const vector_type &max_bias_sat_limit,
+         const vector_type &min_gain_sat_limit, const vector_type &max_gain_sat_limit,
+         const vector_type &min_command_sat_limit, const vector_type &max_command_sat_limit):
+        ABAG(num_of_dimensions)
+    {
+        // Enforce general parameter constraints and those defined in the original publication 
+        set_error_alpha(error_alpha);
+        set_bias_threshold(bias_threshold);
+        set_bias_step(bias_step);
+        set_gain_threshold(gain_threshold);
+        set_gain_step(gain_step);
+        set_min_bias_sat_limit(min_bias_sat_limit);
+        set_max_bias_sat_limit(max_bias_sat_limit);
+        set_min_gain_sat_limit(min_gain_sat_limit);
+        set_max_gain_sat_limit(max_gain_sat_limit);
+        set_min_command_sat_limit(min_command_sat_limit);
+        set_max_command_sat_limit(max_command_sat_limit);
+    };
 
     ~ABAG(){};
 
-    Eigen::VectorXd update_state(const Eigen::VectorXd &error);
+    // Update state values for all dimensions and return the command signal
+    template <typename Derived>
+    const vector_type &update_state(const Eigen::MatrixBase<Derived> &error)
+    {
+        assert(DIMENSIONS_ == error.rows());
+        kernel_.update(error);
+        return kernel_.command_;
+    };
+
+    const vector_type &get_command() const { return kernel_.command_; };
+    double get_command(const int dimension) const { check_dimension(dimension); return kernel_.command_(dimension); };
 
-    Eigen::VectorXd get_command();
-    double get_command(const int dimension);
+    const vector_type &get_error() const { return kernel_.error_; };
+    double get_error(const int dimension) const { check_dimension(dimension); return kernel_.error_(dimension); };
 
-    Eigen::VectorXd get_error();
-    double get_error(const int dimension);
+    const vector_type &get_bias() const { return kernel_.bias_; };
+    double get_bias(const int dimension) const { check_dimension(dimension); return kernel_.bias_(dimension); };
 
-    Eigen::VectorXd get_bias();
-    double get_bias(const int dimension);
+    // Gain is stored unsigned, the reported value carries the direction of the error
+    vector_type get_gain() const { return kernel_.gain_.cwiseProduct(kernel_.error_sign_); };
+    double get_gain(const int dimension) const { check_dimension(dimension); return kernel_.gain_(dimension) * kernel_.error_sign_(dimension); };
 
-    Eigen::VectorXd get_gain();
-    double get_gain(const int dimension);
+    /*
+        Setters: Useful for online parameter adaptation
+    */
+    void set_error_alpha(const vector_type &error_alpha)         { set_unit_interval(kernel_.ERROR_ALPHA, error_alpha); };
+    void set_error_alpha(const double error_alpha, const int dimension)       { set_unit_interval(kernel_.ERROR_ALPHA, error_alpha, dimension); };
 
-    void set_error_alpha(const Eigen::VectorXd &error_alpha);
-    void set_error_alpha(const double error_alpha, const int dimension);
-    
-    void set_bias_threshold(const Eigen::VectorXd &bias_threshold);
-    void set_bias_threshold(double bias_threshold, const int dimension);
+    void set_bias_threshold(const vector_type &bias_threshold)   { set_unit_interval(kernel_.BIAS_THRESHOLD, bias_threshold); };
+    void set_bias_threshold(double bias_threshold, const int dimension)       { set_unit_interval(kernel_.BIAS_THRESHOLD, bias_threshold, dimension); };
 
-    void set_bias_step(const Eigen::VectorXd &bias_step);
-    void set_bias_step(double bias_step, const int dimension);
+    void set_bias_step(const vector_type &bias_step)             { set_unit_interval(kernel_.BIAS_STEP, bias_step); };
+    void set_bias_step(double bias_step, const int dimension)                 { set_unit_interval(kernel_.BIAS_STEP, bias_step, dimension); };
 
-    void set_gain_threshold(const Eigen::VectorXd &gain_threshold);
-    void set_gain_threshold(double gain_threshold, const int dimension);
+    void set_gain_threshold(const vector_type &gain_threshold)   { set_unit_interval(kernel_.GAIN_THRESHOLD, gain_threshold); };
+    void set_gain_threshold(double gain_threshold, const int dimension)       { set_unit_interval(kernel_.GAIN_THRESHOLD, gain_threshold, dimension); };
 
-    void set_gain_step(const Eigen::VectorXd &gain_step);
-    void set_gain_step(double gain_step, const int dimension);
+    void set_gain_step(const vector_type &gain_step)             { set_unit_interval(kernel_.GAIN_STEP, gain_step); };
+    void set_gain_step(double gain_step, const int dimension)                 { set_unit_interval(kernel_.GAIN_STEP, gain_step, dimension); };
 
-    void set_min_bias_sat_limit(const Eigen::VectorXd &sat_limit);
-    void set_max_bias_sat_limit(const Eigen::VectorXd &sat_limit);
-    void set_min_gain_sat_limit(const Eigen::VectorXd &sat_limit);
-    void set_max_gain_sat_limit(const Eigen::VectorXd &sat_limit);
-    void set_min_command_sat_limit(const Eigen::VectorXd &sat_limit);
-    void set_max_command_sat_limit(const Eigen::VectorXd &sat_limit);
+    void set_min_bias_sat_limit(const vector_type &sat_limit)    { set_limit(kernel_.MIN_BIAS_SAT_LIMIT, sat_limit); };
+    void set_max_bias_sat_limit(const vector_type &sat_limit)    { set_limit(kernel_.MAX_BIAS_SAT_LIMIT, sat_limit); };
+    void set_min_gain_sat_limit(const vector_type &sat_limit)    { set_limit(kernel_.MIN_GAIN_SAT_LIMIT, sat_limit); };
+    void set_max_gain_sat_limit(const vector_type &sat_limit)    { set_limit(kernel_.MAX_GAIN_SAT_LIMIT, sat_limit); };
+    void set_min_command_sat_limit(const vector_type &sat_limit) { set_limit(kernel_.MIN_COMMAND_SAT_LIMIT, sat_limit); };
+    void set_max_command_sat_limit(const vector_type &sat_limit) { set_limit(kernel_.MAX_COMMAND_SAT_LIMIT, sat_limit); };
 
-    void reset_state();
-    void reset_state(const int dimension);
+    // Start from a previously learned bias and gain instead of zero, e.g. carried over from an earlier run
+    void set_state(const vector_type &bias, const vector_type &gain)
+    {
+        assert(("Not valid dimension number", bias.rows() == DIMENSIONS_ && gain.rows() == DIMENSIONS_));
+        kernel_.error_.setZero();
+        kernel_.error_sign_.setZero();
+        kernel_.bias_    = bias.cwiseMin(kernel_.MAX_BIAS_SAT_LIMIT).cwiseMax(kernel_.MIN_BIAS_SAT_LIMIT);
+        kernel_.gain_    = gain.cwiseMin(kernel_.MAX_GAIN_SAT_LIMIT).cwiseMax(kernel_.MIN_GAIN_SAT_LIMIT);
+        kernel_.command_ = kernel_.bias_.cwiseMin(kernel_.MAX_COMMAND_SAT_LIMIT).cwiseMax(kernel_.MIN_COMMAND_SAT_LIMIT);
+    };
+
+    // Unsigned gain, as accumulated by the controller
+    const vector_type &get_gain_magnitude() const { return kernel_.gain_; };
+
+    // Set all state values to 0, for all dimensions
+    void reset_state()
+    {
+        kernel_.command_.setZero();
+        kernel_.error_.setZero();
+        kernel_.bias_.setZero();
+        kernel_.gain_.setZero();
+    };
+
+    // Set all state values to 0, for specific dimension
+    void reset_state(const int dimension)
+    {
+        check_dimension(dimension);
+        kernel_.command_(dimension) = 0.0;
+        kernel_.error_(dimension)   = 0.0;
+        kernel_.bias_(dimension)    = 0.0;
+        kernel_.gain_(dimension)    = 0.0;
+    };
 
   private:
+    template <int, int> friend class ABAG_pack;
+
     const int DIMENSIONS_;
-    const Eigen::VectorXd ONES_;
-    Eigen::VectorXd error_sign_;
-
-    struct abag_signal 
-    {
-        abag_signal(const int num_of_dimensions) 
-        {
-            command_ = Eigen::VectorXd::Zero(num_of_dimensions);
-            error_ = Eigen::VectorXd::Zero(num_of_dimensions);
-            bias_ = Eigen::VectorXd::Zero(num_of_dimensions);
-            gain_ = Eigen::VectorXd::Zero(num_of_dimensions);
-        }
-        ~abag_signal(){};
-
-        Eigen::VectorXd command_;
-        Eigen::VectorXd error_;
-        Eigen::VectorXd bias_;
-        Eigen::VectorXd gain_;
-    } signal;
-
-    struct abag_parameter
-    {
-        abag_parameter(const int num_of_dimensions): 
-            ERROR_ALPHA(Eigen::VectorXd::Zero(num_of_dimensions)),
-            BIAS_THRESHOLD(Eigen::VectorXd::Zero(num_of_dimensions)),
-            BIAS_STEP(Eigen::VectorXd::Zero(num_of_dimensions)),
-            GAIN_THRESHOLD(Eigen::VectorXd::Zero(num_of_dimensions)),
-            GAIN_STEP(Eigen::VectorXd::Zero(num_of_dimensions)),
-            MIN_BIAS_SAT_LIMIT(-Eigen::VectorXd::Ones(num_of_dimensions)),
-            MAX_BIAS_SAT_LIMIT(Eigen::VectorXd::Ones(num_of_dimensions)),
-            MIN_GAIN_SAT_LIMIT(Eigen::VectorXd::Zero(num_of_dimensions)),
-            MAX_GAIN_SAT_LIMIT(Eigen::VectorXd::Ones(num_of_dimensions)),
-            MIN_COMMAND_SAT_LIMIT(-Eigen::VectorXd::Ones(num_of_dimensions)),
-            MAX_COMMAND_SAT_LIMIT(Eigen::VectorXd::Ones(num_of_dimensions)){};
-
-        abag_parameter(const Eigen::VectorXd &error_alpha, 
-                       const Eigen::VectorXd &bias_threshold, 
-                       const Eigen::VectorXd &bias_step,
-                       const Eigen::VectorXd &gain_threshold, 
-                       const Eigen::VectorXd &gain_step,
-                       const Eigen::VectorXd &min_bias_sat_limit, 
-                       const Eigen::VectorXd &max_bias_sat_limit,
-                       const Eigen::VectorXd &min_gain_sat_limit, 
-                       const Eigen::VectorXd &max_gain_sat_limit,
-                       const Eigen::VectorXd &min_command_sat_limit, 
-                       const Eigen::VectorXd &max_command_sat_limit):
-            ERROR_ALPHA(error_alpha),
-            BIAS_THRESHOLD(bias_threshold),
-            BIAS_STEP(bias_step),
-            GAIN_THRESHOLD(gain_threshold),
-            GAIN_STEP(gain_step),
-            MIN_BIAS_SAT_LIMIT(min_bias_sat_limit),
-            MAX_BIAS_SAT_LIMIT(max_bias_sat_limit),
-            MIN_GAIN_SAT_LIMIT(min_gain_sat_limit),
-            MAX_GAIN_SAT_LIMIT(max_gain_sat_limit),
-            MIN_COMMAND_SAT_LIMIT(min_command_sat_limit),
-            MAX_COMMAND_SAT_LIMIT(max_command_sat_limit){};
-
-        ~abag_parameter(){};
-
-        Eigen::VectorXd ERROR_ALPHA;
-        Eigen::VectorXd BIAS_THRESHOLD;
-        Eigen::VectorXd BIAS_STEP;
-        Eigen::VectorXd GAIN_THRESHOLD;
-        Eigen::VectorXd GAIN_STEP;
-        Eigen::VectorXd MIN_BIAS_SAT_LIMIT;
-        Eigen::VectorXd MAX_BIAS_SAT_LIMIT;
-        Eigen::VectorXd MIN_GAIN_SAT_LIMIT;
-        Eigen::VectorXd MAX_GAIN_SAT_LIMIT;
-        Eigen::VectorXd MIN_COMMAND_SAT_LIMIT;
-        Eigen::VectorXd MAX_COMMAND_SAT_LIMIT;
-    } parameter;
-
-    void update_error(const Eigen::VectorXd &error);
-    void update_bias();
-    void update_gain();
-    void update_command();
-    
-    // User customizable functions
-    Eigen::VectorXd bias_decision_map();
-    Eigen::VectorXd gain_decision_map();
-
-    // Help functions
-    Eigen::VectorXd saturate_bias(const Eigen::VectorXd &value);
-    Eigen::VectorXd saturate_gain(const Eigen::VectorXd &value);
-    Eigen::VectorXd saturate_command(const Eigen::VectorXd &value);
-    Eigen::VectorXd saturate(const Eigen::VectorXd &value, 
-                             const Eigen::VectorXd &MIN_LIMIT, 
-                             const Eigen::VectorXd &MAX_LIMIT);
-    Eigen::VectorXd heaviside(const Eigen::VectorXd &value);
+    abag_kernel<N, 1> kernel_;
+
+    void check_dimension(const int dimension) const
+    {
+        assert(("Not valid dimension number", dimension >= 0));
+        assert(("Not valid dimension number", dimension <= (DIMENSIONS_ - 1) ));
+        (void)dimension;
+    };
+
+    void set_unit_interval(vector_type &parameter, const vector_type &value)
+    {
+        assert(("Not valid dimension number", value.rows() == DIMENSIONS_));
+        assert(value.maxCoeff() < 1.0);
+        assert(value.minCoeff() > 0.0);
+        parameter = value;
+    };
+
+    void set_unit_interval(vector_type &parameter, const double value, const int dimension)
+    {
+        check_dimension(dimension);
+        assert(value < 1.0);
+        assert(value > 0.0);
+        parameter(dimension) = value;
+    };
+
+    void set_limit(vector_type &parameter, const vector_type &value)
+    {
+        assert(("Not valid dimension number", value.rows() == DIMENSIONS_));
+        parameter = value;
+    };
+};
+
+/**
+ * K independent N-dimensional ABAG controllers, updated together in one call.
+ * Each controller is one column: the update loops run over N x K values at once,
+ * which keeps the vector units busy for small N, e.g. for the 1-dimensional null-space controller
+ * or for evaluating many candidate parameter sets of the same controller side by side.
+ */
+template <int N, int K>
+class ABAG_pack
+{
+  public:
+    typedef Eigen::Matrix<double, N, K> matrix_type;
+
+    ABAG_pack(const int num_of_dimensions, const int num_of_controllers):
+        DIMENSIONS_(num_of_dimensions), CONTROLLERS_(num_of_controllers), 
+        kernel_(num_of_dimensions, num_of_controllers)
+    {
+        assert(("ABAG pack not initialized properly", DIMENSIONS_ > 0 && CONTROLLERS_ > 0));
+        assert(("ABAG pack dimensions do not match the template", N == Eigen::Dynamic || N == DIMENSIONS_));
+        assert(("ABAG pack size does not match the template", K == Eigen::Dynamic || K == CONTROLLERS_));
+    };
+    ~ABAG_pack(){};
+
+    // Copy parameters and state of a single controller into the given column
+    template <int M>
+    void set_controller(const int controller, const ABAG<M> &abag)
+    {
+        check_controller(controller);
+        assert(abag.DIMENSIONS_ == DIMENSIONS_);
+        const abag_kernel<M, 1> &source = abag.kernel_;
+        kernel_.error_sign_.col(controller)            = source.error_sign_;
+        kernel_.error_.col(controller)                 = source.error_;
+        kernel_.bias_.col(controller)                  = source.bias_;
+        kernel_.gain_.col(controller)                  = source.gain_;
+        kernel_.command_.col(controller)               = source.command_;
+        kernel_.ERROR_ALPHA.col(controller)            = source.ERROR_ALPHA;
+        kernel_.BIAS_THRESHOLD.col(controller)         = source.BIAS_THRESHOLD;
+        kernel_.BIAS_STEP.col(controller)              = source.BIAS_STEP;
+        kernel_.GAIN_THRESHOLD.col(controller)         = source.GAIN_THRESHOLD;
+        kernel_.GAIN_STEP.col(controller)              = source.GAIN_STEP;
+        kernel_.MIN_BIAS_SAT_LIMIT.col(controller)     = source.MIN_BIAS_SAT_LIMIT;
+        kernel_.MAX_BIAS_SAT_LIMIT.col(controller)     = source.MAX_BIAS_SAT_LIMIT;
+        kernel_.MIN_GAIN_SAT_LIMIT.col(controller)     = source.MIN_GAIN_SAT_LIMIT;
+        kernel_.MAX_GAIN_SAT_LIMIT.col(controller)     = source.MAX_GAIN_SAT_LIMIT;
+        kernel_.MIN_COMMAND_SAT_LIMIT.col(controller)  = source.MIN_COMMAND_SAT_LIMIT;
+        kernel_.MAX_COMMAND_SAT_LIMIT.col(controller)  = source.MAX_COMMAND_SAT_LIMIT;
+    };
+
+    // One error column per controller; returns one command column per controller
+    template <typename Derived>
+    const matrix_type &update_state(const Eigen::MatrixBase<Derived> &errors)
+    {
+        assert(errors.rows() == DIMENSIONS_ && errors.cols() == CONTROLLERS_);
+        kernel_.update(errors);
+        return kernel_.command_;
+    };
+
+    const matrix_type &get_command() const { return kernel_.command_; };
+    const matrix_type &get_error() const { return kernel_.error_; };
+    const matrix_type &get_bias() const { return kernel_.bias_; };
+    matrix_type get_gain() const { return kernel_.gain_.cwiseProduct(kernel_.error_sign_); };
+
+    void reset_state()
+    {
+        kernel_.command_.setZero();
+        kernel_.error_.setZero();
+        kernel_.bias_.setZero();
+        kernel_.gain_.setZero();
+    };
+
+    void reset_state(const int controller)
+    {
+        check_controller(controller);
+        kernel_.command_.col(controller).setZero();
+        kernel_.error_.col(controller).setZero();
+        kernel_.bias_.col(controller).setZero();
+        kernel_.gain_.col(controller).setZero();
+    };
+
+  private:
+    const int DIMENSIONS_, CONTROLLERS_;
+    abag_kernel<N, K> kernel_;
+
+    void check_controller(const int controller) const
+    {
+        assert(("Not valid controller number", controller >= 0));
+        assert(("Not valid controller number", controller <= (CONTROLLERS_ - 1) ));
+        (void)controller;
+    };
 };
-#endif /* ABAG_HPP_*/
\ No newline at end of file
+#endif /* ABAG_HPP_*/
@@ -0,0 +1,74 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ABAG_WARM_START_HPP_
+#define ABAG_WARM_START_HPP_
+#include <Eigen/Core>
+#include <string>
+#include <vector>
+
+/**
+ * Converged ABAG bias and (unsigned) gain, kept per task model, robot and tool,
+ * so that a task can start from what the previous runs of the same job have learned,
+ * e.g. the payload's gravity offset, instead of re-learning it from zero.
+ * The stored state is an exponential moving average over the cleanly completed runs:
+ * each run is weighted by dynamics_parameter::ABAG_WARM_START_SMOOTHING_FACTOR, older runs decay geometrically.
+ *
+ * File format: one record per line, whitespace separated:
+ *      task_model robot_id tool runs bias_1 ... bias_n gain_1 ... gain_n
+ * Keys are added by load() and reserve(), outside of the control loop. store() only updates
+ * the records of these keys, thus it does not allocate and can be called at task boundaries in the loop.
+ */
+class abag_warm_start
+{
+  public:
+    abag_warm_start(const int num_of_dimensions);
+    ~abag_warm_start(){};
+
+    int load(const std::string &file_path);
+    int save(const std::string &file_path) const;
+
+    // Adds an empty record for the key, if not present yet. Empty records are neither found nor saved
+    void reserve(const int task_model, const int robot_id, const std::string &tool);
+    bool find(const int task_model, const int robot_id, const std::string &tool,
+              Eigen::VectorXd &bias, Eigen::VectorXd &gain) const;
+    // Ignored for keys that are neither loaded nor reserved
+    void store(const int task_model, const int robot_id, const std::string &tool,
+               const Eigen::Ref<const Eigen::VectorXd> &bias, const Eigen::Ref<const Eigen::VectorXd> &gain);
+
+  private:
+    const int DIMENSIONS_;
+
+    struct record
+    {
+        int task_model, robot_id, runs;
+        std::string tool;
+        Eigen::VectorXd bias, gain;
+    };
+    std::vector<record> records_;
+
+    int find_record(const int task_model, const int robot_id, const std::string &tool) const;
+};
+#endif /* ABAG_WARM_START_HPP_*/
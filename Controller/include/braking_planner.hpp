@@ -0,0 +1,69 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef BRAKING_PLANNER_HPP_
+#define BRAKING_PLANNER_HPP_
+#include <Eigen/Core>
+#include <vector>
+#include <cmath>
+#include <cassert>
+
+/**
+ * Analytic, time-indexed velocity profile for bringing the joints to rest.
+ * Planning and evaluation are closed-form: no setpoint arrays are built,
+ * and no memory is allocated after construction.
+ *  - Default: constant deceleration at the joint acceleration limit.
+ *  - Optional jerk limit: S-curve (trapezoidal deceleration) profile.
+ *  - Optional synchronization: all joints reach zero velocity at the same time,
+ *    the time of the slowest joint, by reducing deceleration of the others.
+ * Setpoints below the velocity threshold are cut to zero.
+ */
+class braking_planner
+{
+  public:
+    braking_planner(const std::vector<double> &acceleration_limits,
+                    const double max_jerk,
+                    const double velocity_threshold);
+    ~braking_planner(){};
+
+    // O(number of joints) computation of the braking profile, starting at the given velocities
+    void plan(const Eigen::VectorXd &initial_velocity, const bool synchronize);
+
+    // Velocity setpoint at the given time after the stop trigger
+    double get_velocity(const int joint, const double time_sec) const;
+
+    double get_stop_time(const int joint) const;
+    double get_stop_time() const;
+
+  private:
+    const int NUM_OF_JOINTS_;
+    const double MAX_JERK_, VELOCITY_THRESHOLD_;
+    Eigen::VectorXd acceleration_limits_;
+    Eigen::VectorXd initial_speed_, direction_, deceleration_, stop_time_;
+
+    double minimum_stop_time(const double speed, const double acceleration) const;
+    double deceleration_for_stop_time(const double speed, const double stop_time) const;
+};
+#endif /* BRAKING_PLANNER_HPP_*/
@@ -40,6 +40,12 @@ enum integration_method
     SYMPLECTIC_EULER = 1
 };
 
+enum cartesian_prediction_method 
+{
+    EXPONENTIAL_MAP = 0,
+    UNIT_QUATERNION = 1
+};
+
 namespace youbot_constants
 {
     //Robot ID/Name
@@ -174,6 +180,8 @@ namespace abag_parameter
 
     extern const Eigen::VectorXd MIN_COMMAND_SAT_LIMIT;
     extern const Eigen::VectorXd MAX_COMMAND_SAT_LIMIT;
+
+    extern const double APPROACH_MAX_COMMAND;
 }
 
 namespace dynamics_parameter
@@ -184,8 +192,31 @@ namespace dynamics_parameter
     extern const int STEADY_STOP_ITERATION_THRESHOLD;
     extern const double LOWER_DECELERATION_RAMP_THRESHOLD;
     extern const double STOPPING_MOTION_LOOP_FREQ; // Hz
+    extern const double STOPPING_MOTION_MAX_JERK; // rad/sec^3
+    extern const bool SYNCHRONIZE_STOPPING_MOTION;
+    extern const double LAZY_DYNAMICS_DELTA_Q_BOUND; // rad
+    extern const int LAZY_DYNAMICS_REFRESH_PERIOD; // Iterations
     extern const Eigen::VectorXd MAX_CART_FORCE;
     extern const Eigen::VectorXd MAX_CART_ACC;
+    extern const double PATH_MAX_LINEAR_VELOCITY; // m/s
+    extern const double PATH_MAX_LINEAR_ACCELERATION; // m/s^2
+    extern const double PATH_MAX_LINEAR_JERK; // m/s^3
+    extern const double PATH_PROJECTION_HYSTERESIS; // m
+    extern const int PATH_STREAM_WINDOW; // Tube sections
+    extern const int PATH_STREAM_SECTIONS_PER_CYCLE; // Tube sections
+    extern const int TASK_QUEUE_CAPACITY; // Tasks
+    extern const int EVENT_CHANNEL_CAPACITY; // Events
+    extern const int EVENT_SINK_POLL_PERIOD_MS; // ms
+    extern const int TRACE_RING_SIZE; // Bytes
+    extern const int TRACE_WRITER_POLL_PERIOD_MS; // ms
+    extern const int PARAMETER_FILE_POLL_PERIOD_MS; // ms
+    extern const double ABAG_WARM_START_MAX_BIAS;
+    extern const double ABAG_WARM_START_MAX_GAIN;
+    extern const double ABAG_WARM_START_SMOOTHING_FACTOR;
+    extern const int SAFETY_HORIZON_MIN_STEPS; // Iterations
+    extern const int SAFETY_HORIZON_MAX_STEPS; // Iterations
+    extern const double SAFETY_HORIZON_TIME_MARGIN; // us
+    extern const double SAFETY_HORIZON_COST_FILTER;
     extern const Eigen::IOFormat WRITE_FORMAT;
     extern const std::string LOG_FILE_CART_PATH;
     extern const std::string LOG_FILE_STOP_MOTION_PATH;
@@ -194,6 +225,8 @@ namespace dynamics_parameter
     extern const std::string LOG_FILE_EXT_WRENCH_PATH;
     extern const std::string LOG_FILE_PREDICTIONS_PATH;
     extern const std::string LOG_FILE_NULL_SPACE_PATH;
+    extern const std::string LOG_FILE_COMPENSATION_PATH;
+    extern const std::string LOG_FILE_EVENTS_PATH;
 }
 
 namespace prediction_parameter
@@ -39,7 +39,17 @@ SOFTWARE.
 #include <safety_monitor.hpp>
 #include <finite_state_machine.hpp>
 #include <motion_profile.hpp>
+#include <braking_planner.hpp>
+#include <path_projection.hpp>
+#include <spline_path.hpp>
+#include <path_loader.hpp>
+#include <task_queue.hpp>
+#include <parameter_store.hpp>
+#include <abag_warm_start.hpp>
+#include <event_channel.hpp>
 #include <utility> 
+#include <memory>
+#include <limits>
 #include <abag.hpp>
 #include <constants.hpp>
 #include <kdl_eigen_conversions.hpp>
@@ -51,6 +61,7 @@ SOFTWARE.
 #include <thread> 
 #include <unistd.h> /*usleep function*/
 #include <cmath>
+#include <algorithm>
 #include <stdlib.h> /* abs */
 
 enum dynamics_interface
@@ -60,6 +71,20 @@ enum dynamics_interface
   FF_JOINT_TORQUE = 2
 };
 
+// Stages of one step() call, as timed by the opt-in stage timing
+enum step_stage
+{
+  PARAMETER_UPDATE = 0,
+  FORWARD_KINEMATICS = 1,
+  CONTROL_ERROR = 2, // Task switch, control error and FSM update
+  FSM_STATUS = 3,
+  CARTESIAN_COMMANDS = 4, // ABAG commands, and weight compensation if enabled
+  HYBRID_DYNAMICS = 5, // Vereshchagin solver
+  GRAVITY_COMPENSATION = 6,
+  STOPPING_MOTION = 7, // Braking plan and stop motion commands
+  NUMBER_OF_STEP_STAGES = 8
+};
+
 enum class error_source
 {
     empty = 0,
@@ -100,23 +125,32 @@ class dynamics_controller
              const int stop_loop_iteration,
              const bool stopping_behaviour_on);
 
-    void set_parameters(const double damper_amplitude,
-                        const Eigen::VectorXd &max_command,
-                        const Eigen::VectorXd &error_alpha, 
-                        const Eigen::VectorXd &bias_threshold, 
-                        const Eigen::VectorXd &bias_step, 
-                        const Eigen::VectorXd &gain_threshold, 
-                        const Eigen::VectorXd &gain_step,
-                        const Eigen::VectorXd &min_bias_sat,
-                        const Eigen::VectorXd &min_command_sat,
-                        const Eigen::VectorXd &null_space_parameters,
-                        const Eigen::VectorXd &compensation_parameters,
-                        const Eigen::VectorXd &stop_motion_error_alpha,
-                        const Eigen::VectorXd &stop_motion_bias_threshold,
-                        const Eigen::VectorXd &stop_motion_bias_step,
-                        const Eigen::VectorXd &stop_motion_gain_threshold,
-                        const Eigen::VectorXd &stop_motion_gain_step,
-                        const Eigen::VectorXd &wrench_estimation_gain);
+    int set_parameters(const double damper_amplitude,
+                       const Eigen::VectorXd &max_command,
+                       const Eigen::VectorXd &error_alpha, 
+                       const Eigen::VectorXd &bias_threshold, 
+                       const Eigen::VectorXd &bias_step, 
+                       const Eigen::VectorXd &gain_threshold, 
+                       const Eigen::VectorXd &gain_step,
+                       const Eigen::VectorXd &min_bias_sat,
+                       const Eigen::VectorXd &min_command_sat,
+                       const Eigen::VectorXd &null_space_parameters,
+                       const Eigen::VectorXd &compensation_parameters,
+                       const Eigen::VectorXd &stop_motion_error_alpha,
+                       const Eigen::VectorXd &stop_motion_bias_threshold,
+                       const Eigen::VectorXd &stop_motion_bias_step,
+                       const Eigen::VectorXd &stop_motion_gain_threshold,
+                       const Eigen::VectorXd &stop_motion_gain_step,
+                       const Eigen::VectorXd &wrench_estimation_gain);
+    /**
+     * Parameters are only validated and published here, from any thread.
+     * The control loop applies them at the start of its next step(), also the first one.
+    */
+    int set_parameters(const controller_parameters &parameters);
+    // Named parameter set from file. If watched, modifications of the file are validated and applied while running
+    int load_parameters(const std::string &file_path, const std::string &set_name, const bool watch_file);
+    // Persist converged ABAG state per task model, robot and tool, and start each task from it
+    int set_abag_warm_start(const std::string &file_path, const std::string &tool_name);
     int initialize(const int desired_control_mode, 
                    const int desired_dynamics_interface,
                    const int desired_motion_profile,
@@ -124,6 +158,50 @@ class dynamics_controller
                    const bool use_estimated_external_wrench);
     void deinitialize();
 
+    /**
+    * Opt-in reuse of configuration-dependent terms (M(q), g(q), J(q)):
+    * the last result is reused while ||q - q_last_refresh|| < delta_q_bound,
+    * with a hard refresh every refresh_period iterations
+    */
+    void set_lazy_dynamics(const bool enable,
+                           const double delta_q_bound,
+                           const int refresh_period);
+
+    /**
+    * Follow-path tasks: select the tube section closest to the end-effector,
+    * instead of advancing it one by one on the FSM's CHANGE_TUBE_SECTION status
+    */
+    void set_path_projection(const bool enable);
+
+    /**
+    * Offline replay: run the control loop at full speed, without waiting for the loop period.
+    * Control time still advances with the nominal period DT_SEC
+    */
+    void set_free_running(const bool enable);
+
+    // Closed-loop evaluation (e.g. simulated scenarios): FSM inputs of the last nominal control cycle
+    const fsm_snapshot &get_fsm_snapshot() const;
+    bool is_goal_reached() const;
+    int get_task_status() const; // FSM result of the last nominal control cycle
+
+    /**
+    * Worst-case execution time analysis: wall-clock time spent in each stage of the last step() call,
+    * in microseconds and indexed by step_stage. Stages that did not run in that call are 0
+    */
+    void set_stage_timing(const bool enable);
+    const std::vector<double> &get_stage_times() const;
+
+    /**
+    * Task chaining: appends a copy of the last defined task to the queue.
+    * If the queue is not empty, initialize() starts with its first task, otherwise with the last defined one.
+    * Each following task is switched in once its predecessor has reached the goal, without stopping the robot
+    * and with the ABAG states, solvers and log files kept alive. During the first blend_time_sec
+    * of the new task, its joint torque commands are blended with the last command of the previous task.
+    * Single producer: tasks are defined and queued outside of the control loop
+    */
+    int queue_task(const double blend_time_sec);
+    int get_number_of_queued_tasks() const;
+
     void engage_lock();
     int apply_joint_control_commands(const bool bypass_safeties);
     int monitor_joint_safety();
@@ -190,6 +268,53 @@ class dynamics_controller
                                         const bool control_null_space,
                                         const double desired_null_space_angle,
                                         std::vector< std::vector<double> > &task_frame_poses);
+
+    // Spline paths: sampled such that the tube sections deviate from the curve at most by the tube tolerance
+    void define_moveConstrained_follow_path_task(const std::vector<bool> &constraint_direction,
+                                                 const spline_path &tube_path,
+                                                 const std::vector<double> &tube_tolerances,
+                                                 const double tube_speed,
+                                                 const double tube_force,
+                                                 const double contact_threshold_linear,
+                                                 const double contact_threshold_angular,
+                                                 const double task_time_limit_sec,
+                                                 const bool control_null_space,
+                                                 const double desired_null_space_angle,
+                                                 std::vector< std::vector<double> > &task_frame_poses);
+
+    void define_moveTo_follow_path_task(const std::vector<bool> &constraint_direction,
+                                        const spline_path &tube_path,
+                                        const std::vector<double> &tube_tolerances,
+                                        const double tube_speed,
+                                        const double contact_threshold_linear,
+                                        const double contact_threshold_angular,
+                                        const double task_time_limit_sec,
+                                        const bool control_null_space,
+                                        const double desired_null_space_angle,
+                                        std::vector< std::vector<double> > &task_frame_poses);
+
+    // Paths loaded from file: task frames are built in bounded chunks, ahead of the current tube section.
+    // The loader must stay open until the task is completed
+    int define_moveConstrained_follow_path_task(const std::vector<bool> &constraint_direction,
+                                                path_loader &tube_path,
+                                                const std::vector<double> &tube_tolerances,
+                                                const double tube_speed,
+                                                const double tube_force,
+                                                const double contact_threshold_linear,
+                                                const double contact_threshold_angular,
+                                                const double task_time_limit_sec,
+                                                const bool control_null_space,
+                                                const double desired_null_space_angle);
+
+    int define_moveTo_follow_path_task(const std::vector<bool> &constraint_direction,
+                                       path_loader &tube_path,
+                                       const std::vector<double> &tube_tolerances,
+                                       const double tube_speed,
+                                       const double contact_threshold_linear,
+                                       const double contact_threshold_angular,
+                                       const double task_time_limit_sec,
+                                       const bool control_null_space,
+                                       const double desired_null_space_angle);
     void define_full_pose_task(const std::vector<bool> &constraint_direction,
                                const std::vector<double> &cartesian_pose,
                                const double contact_threshold_linear,
@@ -223,8 +348,45 @@ class dynamics_controller
       int robot_id_;
     } error_logger_;
 
+    struct lazy_dynamics_cache
+    {
+      KDL::JntArray q_reference;
+      int age;
+      int hits;
+      int misses;
+    } mass_cache_, gravity_cache_;
+
+    struct tube_path_stream
+    {
+      path_loader *loader; // Null when all task frames are in memory
+      KDL::Vector last_point;
+      int built_sections;
+    } path_stream_;
+    std::vector< std::vector<double> > path_stream_points_; // Preallocated chunk buffer
+
+    // Spline paths: task frame taken from the curve at the robot's position, not per tube section
+    struct spline_task_frames
+    {
+      std::shared_ptr<const spline_path> path; // Null for the other paths
+      std::vector<double> arc_lengths; // At the ends of the tube sections
+    } spline_frames_;
+    KDL::Frame spline_section_frame_;
+
+    bool lazy_dynamics_on_;
+    double lazy_delta_q_bound_;
+    int lazy_refresh_period_;
+    bool use_path_projection_;
+    bool free_running_;
+    bool event_sink_on_;
+    bool stage_timing_on_;
+    std::vector<double> stage_time_micro_;
+    std::chrono::steady_clock::time_point stage_start_time_;
+
     std::chrono::steady_clock::time_point loop_start_time_;
+    bool loop_start_stamped_; // Set by control(); external loops get the cycle start stamped by step()
     std::chrono::duration <double, std::micro> loop_interval_{};
+    int safety_horizon_steps_;
+    double safety_step_cost_micro_; // Filtered cost of one step of the joint-space prediction
     double total_time_sec_;
     int loop_iteration_count_, stop_loop_iteration_count_, steady_stop_iteration_count_,
         feedforward_loop_count_, control_loop_delay_count_;
@@ -243,8 +405,11 @@ class dynamics_controller
     const std::vector<double> JOINT_ACC_LIMITS_, JOINT_TORQUE_LIMITS_, JOINT_STOPPING_TORQUE_LIMITS_, JOINT_INERTIA_;
     const KDL::Twist ROOT_ACC_;
     std::vector<bool> CTRL_DIM_, POS_TUBE_DIM_, MOTION_CTRL_DIM_, FORCE_CTRL_DIM_;
-    std::vector< std::deque<double> > stop_motion_setpoint_array_;
+    braking_planner braking_planner_;
+    path_projection path_projection_;
     int fsm_result_, fsm_force_task_result_, previous_task_status_, tube_section_count_;
+    fsm_snapshot fsm_snapshot_;
+    fsm_output fsm_output_;
     bool transform_drivers_, transform_force_drivers_, apply_feedforward_force_, 
          compute_null_space_command_, write_contact_time_to_file_, compensate_unknown_weight_, trigger_stopping_sequence_, stopping_sequence_on_;
 
@@ -256,10 +421,76 @@ class dynamics_controller
     moveTo_follow_path_task moveTo_follow_path_task_;
     moveConstrained_follow_path_task moveConstrained_follow_path_task_;
 
+    /**
+     * Active task, bound once at task definition: one indirect call per control cycle
+     * instead of switching over the task model in every stage.
+     * Fixed-frame tasks keep their task frame rotation, path tasks return the current tube section's.
+     */
+    class control_task
+    {
+      public:
+        control_task(dynamics_controller &controller): controller_(controller){};
+        virtual ~control_task(){};
+
+        virtual void compute_error() = 0;
+        virtual const KDL::Rotation &get_task_frame_rotation() const = 0;
+        virtual void transform_force_driver(KDL::Wrench &force_command) const;
+
+      protected:
+        dynamics_controller &controller_;
+    };
+
+    template <void (dynamics_controller::*compute_task_error)()> class fixed_frame_task;
+    class moveTo_follow_path_control_task;
+    class moveConstrained_follow_path_control_task;
+    std::shared_ptr<control_task> active_task_;
+
+    /**
+     * Task state as built by define_*_task, outside of the control loop.
+     * The loop only sees it once loaded: by initialize() or, when chaining queued tasks, at run-time
+     */
+    struct task_definition
+    {
+      int task_model;
+      std::shared_ptr<control_task> task;
+      moveTo_task moveTo;
+      moveGuarded_task moveGuarded;
+      moveTo_weight_compensation_task moveTo_weight_compensation;
+      full_pose_task full_pose;
+      gravity_compensation_task gravity_compensation;
+      moveTo_follow_path_task moveTo_follow_path;
+      moveConstrained_follow_path_task moveConstrained_follow_path;
+      std::vector<bool> ctrl_dim, pos_tube_dim, motion_ctrl_dim, force_ctrl_dim;
+      KDL::Frame desired_pose;
+      KDL::Twist desired_velocity;
+      KDL::Wrench desired_force;
+      bool transform_drivers, transform_force_drivers, compute_null_space_command, compensate_unknown_weight;
+      double desired_null_space_angle, blend_time_sec;
+      path_projection projection;
+      tube_path_stream path_stream;
+      spline_task_frames spline_frames;
+    };
+
+    task_definition defined_task_; // Last defined task
+    task_queue<task_definition> task_queue_;
+    int desired_motion_profile_;
+    KDL::JntArray blend_start_torque_;
+    double blend_start_time_sec_, blend_time_sec_;
+
+    parameter_store parameter_store_;
+    int parameter_mode_;
+    bool log_parameter_header_;
+
+    abag_warm_start abag_warm_start_;
+    bool warm_start_abag_;
+    std::string abag_state_file_, tool_name_;
+    Eigen::VectorXd warm_start_bias_, warm_start_gain_;
+
     KDL::Twist current_error_twist_;
     Eigen::VectorXd abag_error_vector_, null_space_abag_error_, stop_motion_abag_error_, predicted_error_twist_, compensation_error_;
     double horizon_amplitude_, null_space_abag_command_, null_space_angle_, desired_null_space_angle_, updated_mass_estimation_;
-    Eigen::VectorXd abag_command_, abag_stop_motion_command_, max_command_, compensation_parameters_, null_space_parameters_, force_task_parameters_, min_sat_limits_, filtered_bias_;
+    double null_space_tolerance_; // Degrees, of the loaded task
+    Eigen::VectorXd abag_command_, abag_stop_motion_command_, max_command_, compensation_parameters_, null_space_parameters_, filtered_bias_;
     KDL::Wrenches cart_force_command_, zero_wrenches_full_model_;
     KDL::Wrench ext_wrench_, ext_wrench_base_, compensated_weight_;
     KDL::JntArray zero_joint_array_, gravity_torque_, coriolis_torque_, estimated_ext_torque_, filtered_estimated_ext_torque_, 
@@ -273,7 +504,9 @@ class dynamics_controller
     KDL::FK_Vereshchagin fk_vereshchagin_;
     KDL::ChainJntToJacSolver jacobian_solver_;
     safety_monitor safety_monitor_;
-    ABAG abag_, abag_null_space_, abag_stop_motion_;
+    ABAG<6> abag_; // Vereshchagin task constraints: Cartesian DOFs of the end-effector
+    ABAG<1> abag_null_space_;
+    ABAG<Eigen::Dynamic> abag_stop_motion_;
     finite_state_machine fsm_;
     model_prediction predictor_;
 
@@ -320,6 +553,40 @@ class dynamics_controller
     int evaluate_dynamics();
     int compute_gravity_compensation_control_commands();
     int enforce_loop_frequency(const int dt);
+    void report_deadline_miss(const int dt);
+    void compute_path_speed_profile(const std::vector< std::vector<double> > &tube_path_points,
+                                    const double tube_speed,
+                                    const double corner_deviation,
+                                    const double position_tolerance,
+                                    path_speed_profile &speed_profile);
+    bool reuse_cached_terms(const KDL::JntArray &q, lazy_dynamics_cache &cache);
+    void refresh_cached_terms(const KDL::JntArray &q, lazy_dynamics_cache &cache);
+    void reset_lazy_dynamics_cache(lazy_dynamics_cache &cache);
+    void reset_stage_times();
+    void record_stage_time(const int stage);
+    void update_tube_section(const int num_of_sections);
+    int initialize_fsm();
+    void load_task_definition(task_definition &definition, const double time_offset_sec);
+    void switch_to_queued_task();
+    void apply_parameters(const controller_parameters &parameters);
+    void switch_parameter_mode(const int mode);
+    void update_parameters();
+    void write_parameter_header();
+    void warm_start_abag();
+    void store_abag_state();
+    int get_safety_horizon();
+    int update_motion_task_status();
+    KDL::Frame compute_tube_section_frame(const KDL::Vector &tube_start_position,
+                                          const KDL::Vector &tf_position) const;
+    void define_spline_task_frames(const spline_path &tube_path,
+                                   const std::vector<double> &arc_lengths,
+                                   std::vector<KDL::Frame> &tf_poses,
+                                   std::vector< std::vector<double> > &task_frame_poses);
+    int load_path_stream(path_loader &tube_path, std::vector< std::vector<double> > &tube_path_points);
+    void stream_tube_sections(std::vector<KDL::Frame> &tf_poses, int &num_of_sections);
+    int get_number_of_path_sections(const path_loader &tube_path) const;
+    KDL::Frame compute_spline_section_frame(const int section, const KDL::Vector &position) const;
+    const KDL::Frame &get_tube_section_frame(const std::vector<KDL::Frame> &tf_poses) const;
 
     // Methods for defining robot task via 3 interfaces exposed by Vereshchagin
     void define_ee_acc_constraint(const std::vector<bool> &constraint_direction,
@@ -0,0 +1,175 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef EVENT_CHANNEL_HPP_
+#define EVENT_CHANNEL_HPP_
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cassert>
+
+/**
+ * Typed events of the control path. Meaning of the fields, per event type:
+ *   FSM_TRANSITION:      code = fsm_reason, index = task status entered (tasks left, for TASK_SWITCHED),
+ *                        value[0] = previous task status (STATUS_CHANGED)
+ *   CONTACT:             code = contact_kind, value = linear external force [N]
+ *   SAFETY_STOP:         code = safety_check, index = joint, value[0] = joint value, value[1] = limit,
+ *                        value[2] = prediction step (0: current state)
+ *   SOLVER_ERROR:        code = solver return value, index = solver_source
+ *   DEADLINE_MISS:       code = loop period [us], index = misses so far, value[0] = cycle time [us]
+ *   WEIGHT_COMPENSATION: code = compensation_step, index = axis,
+ *                        value = filtered bias (TRIGGERED), force [N] (FORCE_UPDATED) or mass [kg] (MASS_UPDATED)
+ *   TASK_ERROR:          code = task_error, index = path point (PATH_READ_FAILED, INVALID_PATH_POINT),
+ *                        value[0] = plane norm (NULL_SPACE_NORM_TOO_SMALL)
+ */
+namespace rt_event
+{
+    enum event_type
+    {
+        FSM_TRANSITION      = 1,
+        CONTACT             = 2,
+        SAFETY_STOP         = 3,
+        SOLVER_ERROR        = 4,
+        DEADLINE_MISS       = 5,
+        WEIGHT_COMPENSATION = 6,
+        TASK_ERROR          = 7
+    };
+
+    enum fsm_reason
+    {
+        STATUS_CHANGED     = 0,
+        TIME_LIMIT_REACHED = 1,
+        PATH_COVERED       = 2,
+        GOAL_REACHED       = 3,
+        TASK_SWITCHED      = 4
+    };
+
+    enum contact_kind
+    {
+        CONTACT_DETECTED    = 0,
+        NON_DESIRED_CONTACT = 1,
+        CONTACT_LOST        = 2
+    };
+
+    enum safety_check
+    {
+        TORQUE_NOT_FINITE       = 0,
+        ACCELERATION_NOT_FINITE = 1,
+        VELOCITY_NOT_FINITE     = 2,
+        POSITION_NOT_FINITE     = 3,
+        TORQUE_LIMIT            = 4,
+        VELOCITY_LIMIT          = 5,
+        POSITION_LIMIT          = 6,
+        APPROACHING_MAX_LIMIT   = 7,
+        APPROACHING_MIN_LIMIT   = 8
+    };
+
+    enum solver_source
+    {
+        KINOVA_MEDIATOR     = 0,
+        SIMULATION_MEDIATOR = 1,
+        SAFETY_PREDICTION   = 2
+    };
+
+    enum compensation_step
+    {
+        TRIGGERED            = 0,
+        ESTIMATION_COMPLETED = 1,
+        FORCE_UPDATED        = 2,
+        MASS_UPDATED         = 3
+    };
+
+    enum task_error
+    {
+        NULL_SPACE_NORM_TOO_SMALL = 0,
+        PATH_READ_FAILED          = 1,
+        INVALID_PATH_POINT        = 2
+    };
+
+    // Plain data: copied into and out of the preallocated slots
+    struct event
+    {
+        int type;
+        int code;
+        int index;
+        int cycle;       // Control loop iteration of the publishing thread
+        double time_sec; // Since the start of the channel
+        double value[3];
+    };
+
+    /**
+     * Stamps the event with the cycle index and time, and queues it on the process-wide channel.
+     * Real-time safe: no allocation, no locks, no I/O. If the channel is full, the event is dropped and counted.
+     */
+    void publish(const int type, const int code, const int index,
+                 const double value_0 = 0.0, const double value_1 = 0.0, const double value_2 = 0.0);
+
+    // Cycle index stamped on the events published from the calling thread
+    void set_cycle(const int cycle);
+
+    /**
+     * Background sink, writing the queued events to the console and to the file.
+     * Reference counted: the first start launches it, the last stop drains the channel and joins it.
+     * Returns -1 if the file cannot be opened; events are then written to the console only.
+     */
+    int start_sink(const std::string &file_path);
+    void stop_sink();
+}
+
+/**
+ * Bounded, lock-free, multi-producer single-consumer queue of events.
+ * Slots are preallocated and carry a sequence number, telling whether a slot is free for the producer
+ * of a given position or filled for the consumer. Producers claim positions with a compare-and-swap,
+ * so any thread may publish (e.g. the controllers of the parallel tuner).
+ */
+class event_channel
+{
+  public:
+    event_channel(const int capacity);
+    ~event_channel(){};
+
+    // Producer side, any thread. Never blocks: false if the channel is full
+    bool push(const rt_event::event &item);
+
+    // Consumer side, single thread
+    bool pop(rt_event::event &item);
+
+    // Events lost because the channel was full
+    int get_dropped_count() const;
+
+  private:
+    struct slot
+    {
+        std::atomic<unsigned int> sequence;
+        rt_event::event item;
+    };
+
+    const unsigned int MASK_;
+    std::unique_ptr<slot[]> slots_;
+    std::atomic<unsigned int> enqueue_position_;
+    unsigned int dequeue_position_;
+    std::atomic<int> dropped_count_;
+};
+#endif /* EVENT_CHANNEL_HPP_*/
@@ -32,6 +32,8 @@ SOFTWARE.
 #include <motion_profile.hpp>
 #include <moving_variance.hpp>
 #include <moving_slope.hpp>
+#include <path_speed_profile.hpp>
+#include <event_channel.hpp>
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -73,6 +75,8 @@ struct moveConstrained_follow_path_task
     KDL::Vector null_space_force_direction;
     std::vector< std::vector<double> > tube_path_points{1, std::vector<double>(3, 0.0)};
     std::vector<double> tube_tolerances{std::vector<double>(8, 0.0)};
+    path_speed_profile speed_profile;
+    int num_of_sections = 0; // May exceed tf_poses size: streamed paths keep only a window of task frames
     double null_space_tolerance = 0.0;  // Tolerance unit in degrees
     double tube_speed = 0.0;
     double tube_force = 0.0;
@@ -88,6 +92,8 @@ struct moveTo_follow_path_task
     std::vector< std::vector<double> > tube_path_points{1, std::vector<double>(3, 0.0)};
     std::vector<double> tube_tolerances{std::vector<double>(7, 0.0)};
     KDL::Vector null_space_force_direction;
+    path_speed_profile speed_profile;
+    int num_of_sections = 0;
     double null_space_tolerance = 0.0;  // Tolerance unit in degrees
     double tube_speed = 0.0;
     double contact_threshold_linear = 0.0;
@@ -153,6 +159,28 @@ struct gravity_compensation_task
     double time_limit = 0.0;
 };
 
+/**
+ * Read-only snapshot of the controller state used by the FSM in one cycle.
+ * Filled by the controller; quantities are expressed in the task frame.
+*/
+struct fsm_snapshot
+{
+    KDL::Frame end_effector_pose{KDL::Frame::Identity()};
+    KDL::Twist end_effector_twist{KDL::Twist::Zero()};
+    KDL::Twist current_error{KDL::Twist::Zero()};
+    KDL::Wrench ext_force{KDL::Wrench::Zero()}; // Filtered external wrench
+    double desired_speed = 0.0; // Desired end-effector velocity along the tube, before the update
+    double time_passed_sec = 0.0;
+    int tube_section_count = 0;
+};
+
+// Outputs of the FSM for one cycle
+struct fsm_output
+{
+    int status = task_status::NOMINAL;
+    double desired_speed = 0.0; // Desired end-effector velocity along the tube, unchanged if not commanded by the task
+};
+
 class finite_state_machine
 {
     public:
@@ -161,10 +189,15 @@ class finite_state_machine
                              const int num_of_frames,
                              const int num_of_constraints);
         ~finite_state_machine(){};
+        // The task is referenced, not copied: it has to stay valid while the FSM is updated with it
         int initialize_with_moveConstrained_follow_path(const moveConstrained_follow_path_task &task, const int motion_profile);
         int initialize_with_moveTo_follow_path(const moveTo_follow_path_task &task, const int motion_profile);
-        int initialize_with_moveTo_weight_compensation(const moveTo_weight_compensation_task &task, const int motion_profile,
-                                                       const Eigen::VectorXd &compensation_parameters);
+        int initialize_with_moveTo_weight_compensation(const moveTo_weight_compensation_task &task, const int motion_profile);
+        // Estimation data of the weight-compensation tasks. Opened once per run, kept open across task switches
+        int open_compensation_log();
+        void close_compensation_log();
+        // Applied by the controller together with the rest of its parameters
+        void set_compensation_parameters(const Eigen::VectorXd &compensation_parameters);
         int initialize_with_moveTo(const moveTo_task &task, const int motion_profile);
         int initialize_with_moveGuarded(const moveGuarded_task &task, const int motion_profile);
         int initialize_with_full_pose(const full_pose_task &task, const int motion_profile);
@@ -176,45 +209,43 @@ class finite_state_machine
         int update_force_task_status(const KDL::Wrench &desired_force, 
                                      const KDL::Wrench &ext_force,
                                      const double current_task_time);
-        int update_motion_task_status(const state_specification &robot_state,
-                                      state_specification &desired_state,
-                                      const KDL::Twist &current_error,
-                                      const KDL::Wrench &ext_force,
-                                      const double time_passed_sec,
-                                      const int tube_section_count);
+        int update_motion_task_status(const fsm_snapshot &snapshot, fsm_output &output);
+        // Clears the outcome of the previous task, such that tasks can be chained without re-constructing the FSM
+        void reset_task_status();
+        bool is_goal_reached() const;
 
     private:
         const int NUM_OF_JOINTS_, NUM_OF_SEGMENTS_, NUM_OF_FRAMES_, NUM_OF_CONSTRAINTS_;
         const int END_EFF_;
-        int desired_task_model_, motion_profile_, loop_period_count_, compensator_trigger_count_, iterations_;
-        double total_control_time_sec_, previous_task_time_, total_contact_time_;
+        int desired_task_model_, motion_profile_, loop_period_count_, compensator_trigger_count_;
+        double total_control_time_sec_, previous_task_time_, total_contact_time_, profile_start_time_sec_;
         bool goal_reached_, time_limit_reached_, contact_detected_, 
-             contact_alignment_performed_, write_compensation_time_to_file_;
+             contact_alignment_performed_, write_compensation_time_to_file_, write_compensation_header_;
         Eigen::VectorXd filtered_bias_, compensation_parameters_;
-        state_specification robot_state_, desired_state_;
         moving_variance variance_gain_, variance_bias_;
         moving_slope slope_bias_;
-        KDL::Twist current_error_;
         KDL::Wrench ext_wrench_;
-        moveTo_task moveTo_task_;
-        moveGuarded_task moveGuarded_task_;
-        moveTo_weight_compensation_task moveTo_weight_compensation_task_;
-        full_pose_task full_pose_task_;
-        gravity_compensation_task gravity_compensation_task_;
-        moveTo_follow_path_task moveTo_follow_path_task_;
-        moveConstrained_follow_path_task moveConstrained_follow_path_task_;
+        // Tasks are owned by the controller and only read here: switching tasks copies no containers
+        const moveTo_task *moveTo_task_;
+        const moveGuarded_task *moveGuarded_task_;
+        const moveTo_weight_compensation_task *moveTo_weight_compensation_task_;
+        const full_pose_task *full_pose_task_;
+        const gravity_compensation_task *gravity_compensation_task_;
+        const moveTo_follow_path_task *moveTo_follow_path_task_;
+        const moveConstrained_follow_path_task *moveConstrained_follow_path_task_;
         std::ofstream log_file_ext_force_, log_file_compensation_;
-        std::deque<double> speed_array_;
-
-        int update_full_pose_task(state_specification &desired_state);
-        int update_gravity_compensation_task();
-        int update_moveTo_task(state_specification &desired_state);
-        int update_moveGuarded_task(state_specification &desired_state);
-        int update_moveTo_weight_compensation_task(state_specification &desired_state);
-        int update_moveTo_follow_path_task(state_specification &desired_state,
-                                           const int tube_section_count);
-        int update_moveConstrained_follow_path_task(state_specification &desired_state,
-                                                    const int tube_section_count);
+
+        // Task-specific status update, bound at initialization
+        typedef int (finite_state_machine::*task_update)(const fsm_snapshot &snapshot, fsm_output &output);
+        task_update update_task_;
+
+        int update_full_pose_task(const fsm_snapshot &snapshot, fsm_output &output);
+        int update_gravity_compensation_task(const fsm_snapshot &snapshot, fsm_output &output);
+        int update_moveTo_task(const fsm_snapshot &snapshot, fsm_output &output);
+        int update_moveGuarded_task(const fsm_snapshot &snapshot, fsm_output &output);
+        int update_moveTo_weight_compensation_task(const fsm_snapshot &snapshot, fsm_output &output);
+        int update_moveTo_follow_path_task(const fsm_snapshot &snapshot, fsm_output &output);
+        int update_moveConstrained_follow_path_task(const fsm_snapshot &snapshot, fsm_output &output);
         bool contact_detected(const double linear_force_threshold, 
                               const double angular_force_threshold);
         bool contact_alignment_secured(const KDL::Wrench &desired_force,
@@ -81,6 +81,21 @@ namespace geometry
     */
     KDL::Frame exp_map_se3(const KDL::Twist &current_twist);
 
+    /**
+     * Closed-form exponential map from a rotation vector to a unit quaternion.
+     * Given rotation vector should NOT be normalized!
+     * Small rotations are handled with a Taylor expansion instead of 
+     * being discarded, so the result stays exact down to zero angle.
+    */
+    Eigen::Quaterniond exp_map_quaternion(const Eigen::Vector3d &rot_vector);
+
+    /**
+     * First-order renormalization of a quaternion that drifted slightly 
+     * from the unit sphere: q * (3 - |q|^2) / 2. No square root or division,
+     * valid as long as it is applied after each integration step.
+    */
+    void renormalize_quaternion(Eigen::Quaterniond &quaternion);
+
 
     //Converts a 3D vector to an skew matrix representation
     KDL::Rotation skew_matrix(const KDL::Vector &vector);
@@ -49,6 +49,7 @@ SOFTWARE.
 #include <Eigen/Dense>// Eigen
 #include <model_prediction.hpp>
 #include <fd_solver_rne.hpp>
+#include <event_channel.hpp>
 
 #include <KDetailedException.h>
 
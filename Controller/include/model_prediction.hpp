@@ -28,10 +28,12 @@ SOFTWARE.
 #include <state_specification.hpp>
 #include <constants.hpp>
 #include <fk_vereshchagin.hpp>
+#include <solver_vereshchagin.hpp>
 #include <Eigen/Geometry>
 #include <geometry_utils.hpp>
 #include <kdl_eigen_conversions.hpp>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <fstream>
 #include <unistd.h>
@@ -42,6 +44,14 @@ class model_prediction
 {
 	public:
 		model_prediction(const KDL::Chain &robot_chain);
+		/**
+		 * Additionally sets up forward dynamics for integrate_joint_space,
+		 * used when re-computing accelerations along the horizon.
+		*/
+		model_prediction(const KDL::Chain &robot_chain,
+						 const std::vector<double> &joint_inertia,
+						 const std::vector<double> &joint_torque_limits,
+						 const KDL::Twist &root_acc);
 		~model_prediction(){};
 		
 		// Used for predicting future deviation from the goal state
@@ -50,8 +60,25 @@ class model_prediction
                                        const double dt_sec, 
 									   const int num_of_steps);
 
-		// Used for checking joint limits
-		void integrate_joint_space(
+		/**
+		 * Predict end-effector poses for several horizons in one pass,
+		 * under the constant base-frame twist of the current state.
+		 * Horizons are given in number of steps, in any order.
+		 * Orientation is integrated in unit quaternions.
+		*/
+		void predict_cartesian_poses(const state_specification &current_state,
+									 const double dt_sec,
+									 const std::vector<int> &horizon_steps,
+									 std::vector<KDL::Frame> &predicted_poses);
+
+		// Select the backend used in integrate_cartesian_space: exponential map on SO(3) or unit quaternion
+		void set_cartesian_prediction_method(const int method);
+
+		/**
+		 * Used for checking joint limits.
+		 * Returns 0, or the error of the first failed forward dynamics step
+		*/
+		int integrate_joint_space(
 							const state_specification &current_state,
 							std::vector<state_specification> &predicted_states,
 							const double dt_sec, const int num_of_steps,
@@ -81,10 +108,18 @@ class model_prediction
 		
 		KDL::FK_Vereshchagin fk_vereshchagin_;
 
+		// Forward dynamics (unconstrained Vereshchagin, O(n)), with preallocated inputs
+		std::shared_ptr<KDL::Solver_Vereshchagin> fd_solver_;
+		KDL::Jacobian zero_unit_constraint_force_;
+		KDL::JntArray zero_acceleration_energy_;
+		KDL::Wrenches zero_virtual_force_;
+		KDL::JntArray held_torque_;
+
 		// Temp variable required for saving intermediate state,
 		// if multi-step integration requirested
 		state_specification temp_state_;
 		KDL::Frame temp_pose_;
+		int cartesian_prediction_method_;
 
 		std::ofstream current_pose_data_file_;
 		std::ofstream predicted_pose_data_file_;
@@ -109,6 +144,19 @@ class model_prediction
 								  KDL::Twist &current_twist,
 								  const bool rescale_rotation,
 								  const bool decouple_dimensions);
+
+		/**
+		 * Integrates pose under a constant base-frame twist, in unit quaternions.
+		 * Rotation over k steps is closed-form: q_k = exp(k * dt * w) * q_0,
+		 * so the cost does not depend on the length of the horizon.
+		 * Fills one pose per requested horizon (number of steps).
+		*/
+		void integrate_quaternion_poses(const KDL::Frame &current_pose,
+										const KDL::Twist &twist,
+										const double dt_sec,
+										const int *horizon_steps,
+										const int num_of_horizons,
+										KDL::Frame *predicted_poses);
 		
 		// Forward position and velocity kinematics, from integrated joint values
 		void compute_FK(state_specification &predicted_state);
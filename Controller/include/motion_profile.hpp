@@ -33,7 +33,7 @@ SOFTWARE.
 #include <unistd.h>
 #include <cmath>
 #include <assert.h>
-#include <deque>
+#include <algorithm>
 
 enum m_profile 
 {
@@ -41,16 +41,28 @@ enum m_profile
     TANH = 1,
     S_CURVE = 2,
     STEP = 3,
-    RAMP = 4
+    RAMP = 4,
+    TIME_OPTIMAL = 5,
+    JERK_LIMITED = 6
 };
 
+/**
+ * Closed-form profile evaluators: no setpoints are stored.
+ * The state argument is either the time elapsed since the start of the
+ * profile or the arc-length progress, depending on the units of the rate/slope.
+ */
 namespace motion_profile
 {
-    std::deque<double> ramp_array(const double start, const double stop,
-                                  const double rate, const double threshold);
-    std::deque<double> s_curve_array(const double start_state, const double end_state,
-                                     const double step, const double offset,
-                                     const double amplitude, const double slope);
+    double ramp_function(const double state,
+                         const double start_value,
+                         const double end_value,
+                         const double rate);
+    // Rest-to-rest velocity profile with limited acceleration and jerk, covering path_length
+    double jerk_limited_trapezoid_function(const double time,
+                                           const double path_length,
+                                           const double max_velocity,
+                                           const double max_acceleration,
+                                           const double max_jerk);
     double tanh_function(const double state,
                          const double offset,
                          const double amplitude,
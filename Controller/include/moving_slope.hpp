@@ -26,8 +26,8 @@ SOFTWARE.
 #ifndef MOVING_SLOPE_HPP_
 #define MOVING_SLOPE_HPP_
 #include <Eigen/Core>
+#include <sliding_window.hpp>
 #include <iostream>
-#include <list>
 #include <vector>
 #include <stdlib.h>     /* abs */
 
@@ -49,7 +49,6 @@ class moving_slope
   private:
     const int DIMENSIONS_, WINDOW_SIZE_;
     Eigen::VectorXd slopes_;
-    std::vector<int> indexes_;
-    std::vector<std::list<double>> windows_;
+    sliding_window window_;
 };
-#endif /* MOVING_SLOPE_HPP_*/
\ No newline at end of file
+#endif /* MOVING_SLOPE_HPP_*/
@@ -26,9 +26,9 @@ SOFTWARE.
 #ifndef MOVING_VARIANCE_HPP_
 #define MOVING_VARIANCE_HPP_
 #include <Eigen/Core>
+#include <sliding_window.hpp>
 #include <iostream>
 #include <vector>
-#include <list>
 #include <stdlib.h>     /* abs */
 
 class moving_variance
@@ -51,8 +51,6 @@ class moving_variance
 
   private:
     const int DIMENSIONS_, WINDOW_SIZE_;
-    std::vector<int> indexes_;
-    Eigen::VectorXd means_, variances_;
-    std::vector<std::list<double>> windows_;
+    sliding_window window_;
 };
-#endif /* MOVING_VARIANCE_HPP_*/
\ No newline at end of file
+#endif /* MOVING_VARIANCE_HPP_*/
@@ -0,0 +1,131 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef PARAMETER_STORE_HPP_
+#define PARAMETER_STORE_HPP_
+#include <Eigen/Core>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <time.h>
+#include <task_queue.hpp>
+
+enum parameter_mode
+{
+    NOMINAL_PARAMETERS  = 0, // Parameters of the task itself
+    APPROACH_PARAMETERS = 1, // Linear Z axis velocity-controlled, towards the contact surface
+    CONTACT_PARAMETERS  = 2, // Linear Z axis force-controlled, while in contact
+    NUMBER_OF_PARAMETER_MODES = 3
+};
+
+struct controller_parameters
+{
+    std::string name;
+    double horizon_amplitude;
+    Eigen::VectorXd max_command, error_alpha, bias_threshold, bias_step, gain_threshold, gain_step,
+                    min_bias_sat, min_command_sat, null_space_parameters, compensation_parameters,
+                    stop_motion_error_alpha, stop_motion_bias_threshold, stop_motion_bias_step,
+                    stop_motion_gain_threshold, stop_motion_gain_step, wrench_estimation_gain;
+};
+
+/**
+ * Immutable, validated parameter sets of one task: the nominal set and its variants
+ * for the FSM modes of the force task. Switching between modes is thus a matter of indexing,
+ * not of rebuilding vectors in the control loop.
+ */
+struct parameter_bundle
+{
+    controller_parameters mode[NUMBER_OF_PARAMETER_MODES];
+};
+
+/**
+ * Publishes parameter bundles to the control loop without blocking it.
+ * Bundles are built and validated on the caller's thread or on a background thread watching a file,
+ * then handed over through an atomic pointer. The control loop picks up the latest bundle
+ * at its cycle boundary with acquire() and hands the replaced one back through a queue,
+ * so that memory is never allocated or freed on the real-time side.
+ *
+ * File format: named sections, each holding "key = values" lines, values separated by commas or spaces.
+ *      # comment
+ *      [moveConstrained_follow_path]
+ *      horizon_amplitude = 2.5
+ *      error_alpha = 0.9, 0.9, 0.9, 0.9, 0.9, 0.9
+ *      ...
+ *      [moveConstrained_follow_path.approach]
+ *      bias_step = 0.0005, 0.0005, 0.0005, 0.0035, 0.0035, 0.0035
+ * A nominal section must define all keys. The optional ".approach" and ".contact" sections
+ * override keys of the respective FSM mode, which is otherwise derived from the nominal set.
+ */
+class parameter_store
+{
+  public:
+    parameter_store(const int num_of_constraints, const int num_of_joints);
+    ~parameter_store();
+
+    // Non real-time side
+    int publish(const controller_parameters &nominal);
+    int load(const std::string &file_path, const std::string &set_name);
+    int watch(const std::string &file_path, const std::string &set_name);
+    void stop_watching();
+
+    // Real-time side: returns the newly published bundle, or nullptr if nothing changed since the last call
+    const parameter_bundle *acquire();
+    const parameter_bundle *get_active() const;
+
+    int validate(const controller_parameters &parameters) const;
+
+    // Writes a nominal set as a section of the file format above, e.g. for sets found by a tuner
+    static void write(std::ostream &stream, const controller_parameters &parameters);
+
+  private:
+    const int NUM_OF_CONSTRAINTS_, NUM_OF_JOINTS_;
+    static const int RETIRED_CAPACITY_ = 4;
+
+    std::atomic<parameter_bundle*> pending_;
+    parameter_bundle *active_;
+    task_queue<parameter_bundle*> retired_;
+
+    // Serializes the publishing threads, never taken by the control loop
+    std::mutex publish_mutex_;
+
+    std::thread watcher_;
+    std::mutex watcher_mutex_;
+    std::condition_variable watcher_condition_;
+    bool stop_watcher_;
+    std::string watched_file_, watched_set_;
+    struct timespec watched_modification_time_;
+
+    void derive_modes(parameter_bundle &bundle) const;
+    int validate_bundle(const parameter_bundle &bundle) const;
+    static int assign(controller_parameters &parameters, const std::string &key, const std::vector<double> &values);
+    int parse_file(const std::string &file_path, const std::string &set_name, parameter_bundle &bundle) const;
+    int publish_bundle(parameter_bundle *bundle);
+    void watch_file();
+};
+#endif /* PARAMETER_STORE_HPP_*/
@@ -0,0 +1,101 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef PATH_LOADER_HPP_
+#define PATH_LOADER_HPP_
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cassert>
+#include <event_channel.hpp>
+
+enum path_file_format
+{
+    CSV_PATH = 0,
+    BINARY_PATH = 1
+};
+
+/**
+ * Read-only, memory-mapped access to externally generated tube paths.
+ * Two layouts are supported:
+ *  - CSV: one "x, y, z" point per line; empty lines, comments (#) and a header line are skipped.
+ *  - Binary: a 32-byte header (magic "TUBEPATH", version, dimensions, number of points, reserved)
+ *    followed by the points as little-endian doubles, x-y-z interleaved.
+ * Opening a file only maps it, nothing is parsed. The number of points is taken from the binary header;
+ * CSV files are not scanned for it: their number of points is unknown until a read reaches the end of the file.
+ * Points are then read in bounded chunks into a caller-provided, preallocated buffer:
+ * random access for the binary layout, forward-sequential cursor for CSV.
+ * Pages ahead of the last read are requested from the kernel in advance,
+ * so that the chunk reads of the control loop do not wait on the disk.
+ */
+class path_loader
+{
+  public:
+    path_loader();
+    ~path_loader();
+
+    int open(const std::string &file_path);
+    void close();
+    bool is_open() const;
+
+    int get_format() const;
+    // -1 while unknown (CSV file not yet read to its end)
+    int get_number_of_points() const;
+
+    // Returns the number of points written into "points", starting at index 0 of the buffer.
+    // Fewer than requested only at the end of the file, or -1 on an invalid CSV line
+    int read_points(const int first_point, const int num_of_points,
+                    std::vector< std::vector<double> > &points);
+
+    static int write_binary_file(const std::string &file_path,
+                                 const std::vector< std::vector<double> > &points);
+
+  private:
+    static const char MAGIC_[8];
+    static const uint32_t VERSION_ = 1;
+    static const uint32_t DIMENSIONS_ = 3;
+    static const int HEADER_SIZE_ = 32;
+    static const int MAX_LINE_LENGTH_ = 256;
+    static const size_t READ_AHEAD_BYTES_ = 256 * 1024;
+
+    int file_descriptor_, format_, num_of_points_;
+    const char *data_;
+    size_t size_, page_size_;
+
+    // End of the range already requested from the kernel
+    size_t advised_end_;
+
+    // CSV cursor: byte offset of the next unread point and its index
+    size_t csv_offset_;
+    int csv_point_index_;
+
+    int open_binary();
+    int open_csv();
+    bool is_point_line(const size_t line_start) const;
+    size_t next_line(const size_t line_start) const;
+    int parse_csv_line(const size_t line_start, std::vector<double> &point) const;
+    void advise_read_ahead(const size_t offset);
+};
+#endif /* PATH_LOADER_HPP_*/
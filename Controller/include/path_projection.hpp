@@ -0,0 +1,99 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef PATH_PROJECTION_HPP_
+#define PATH_PROJECTION_HPP_
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <vector>
+#include <cmath>
+#include <cassert>
+#include <limits>
+
+struct path_projection_result
+{
+    int segment = 0;
+    double segment_parameter = 0.0; // [0, 1] along the segment
+    double arc_length = 0.0; // From the path start
+    double distance = 0.0; // From the query point to the path
+};
+
+/**
+ * Closest-segment and arc-length projection onto a polyline.
+ * A bounding-volume hierarchy (axis-aligned boxes over ranges of consecutive segments)
+ * is built once, at task definition. Each query is warm-started from the previous answer:
+ * the neighbourhood of the previous segment provides the initial bound for the
+ * branch-and-bound tree traversal, which then visits O(log n) nodes for coherent motion.
+ * A segment away from the neighbourhood is accepted only if it is closer by the hysteresis,
+ * such that self-crossing paths do not cause jumps between branches.
+ * Queries do not allocate memory.
+ */
+class path_projection
+{
+  public:
+    path_projection();
+    ~path_projection(){};
+
+    // Queued path tasks carry their own projection, swapped in by move
+    path_projection(const path_projection &other) = default;
+    path_projection(path_projection &&other) = default;
+    path_projection &operator=(const path_projection &other) = default;
+    path_projection &operator=(path_projection &&other) = default;
+
+    void build(const std::vector< std::vector<double> > &path_points,
+               const double hysteresis);
+    bool is_built() const;
+
+    // Projection warm-started from the previous answer
+    const path_projection_result &project(const Eigen::Vector3d &point);
+    const path_projection_result &project(const Eigen::Vector3d &point, const int warm_start_segment);
+
+    const path_projection_result &get_result() const;
+    double get_path_length() const;
+    int get_number_of_segments() const;
+    void reset();
+
+  private:
+    static const int LEAF_SIZE_ = 4;
+    static const int STACK_SIZE_ = 64;
+    static const int WARM_START_WINDOW_ = 2;
+
+    struct bvh_node
+    {
+        Eigen::AlignedBox3d box;
+        int first_segment, last_segment; // Inclusive range
+        int left_child, right_child; // -1 for leaves
+    };
+
+    double hysteresis_;
+    std::vector<Eigen::Vector3d> points_;
+    std::vector<double> cumulative_lengths_;
+    std::vector<bvh_node> nodes_;
+    path_projection_result result_;
+
+    int build_node(const int first_segment, const int last_segment);
+    double squared_distance_to_segment(const Eigen::Vector3d &point, const int segment, double &parameter) const;
+};
+#endif /* PATH_PROJECTION_HPP_*/
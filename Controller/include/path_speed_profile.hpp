@@ -0,0 +1,71 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef PATH_SPEED_PROFILE_HPP_
+#define PATH_SPEED_PROFILE_HPP_
+#include <Eigen/Core>
+#include <vector>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+/**
+ * Near time-optimal speed profile along a polyline path.
+ * Computed once, at task definition, via a forward-backward pass over the path vertices:
+ *  - each segment has its own speed and (tangential) acceleration limit,
+ *  - speed at each corner is limited such that the centripetal acceleration
+ *    stays within the limit while deviating at most corner_deviation from the corner,
+ *  - path starts and ends at rest.
+ * Evaluated in closed form from the section index and the distance left to the section end.
+ */
+class path_speed_profile
+{
+  public:
+    path_speed_profile();
+    ~path_speed_profile(){};
+
+    // Explicit defaults: the declared destructor would otherwise suppress moves
+    path_speed_profile(const path_speed_profile &other) = default;
+    path_speed_profile(path_speed_profile &&other) = default;
+    path_speed_profile &operator=(const path_speed_profile &other) = default;
+    path_speed_profile &operator=(path_speed_profile &&other) = default;
+
+    void compute(const std::vector< std::vector<double> > &path_points,
+                 const std::vector<double> &segment_speed_limits,
+                 const std::vector<double> &segment_acceleration_limits,
+                 const double corner_deviation,
+                 const double minimum_speed);
+
+    bool is_computed() const;
+    double get_speed(const int segment, const double distance_to_segment_end) const;
+    double get_vertex_speed(const int vertex) const;
+    double get_segment_length(const int segment) const;
+    double get_traversal_time() const;
+
+  private:
+    double minimum_speed_;
+    std::vector<double> segment_lengths_, speed_limits_, acceleration_limits_, vertex_speeds_;
+};
+#endif /* PATH_SPEED_PROFILE_HPP_*/
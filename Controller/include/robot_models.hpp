@@ -0,0 +1,47 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ROBOT_MODELS_HPP_
+#define ROBOT_MODELS_HPP_
+#include <kdl/chain.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * Chains and limits of every supported robot model, for the offline benchmark harnesses.
+ * Chains are extracted from the URDF files in the same way as in the robot mediators.
+ */
+struct robot_model
+{
+    std::string name;
+    KDL::Chain chain;
+    std::vector<double> joint_inertia, joint_torque_limits;
+    std::vector<double> position_limits_min, position_limits_max, root_acceleration;
+    std::vector<double> joint_velocity_limits;
+};
+
+// youBot arm, Kinova Gen3 and KUKA LWR, in this order
+int load_models(std::vector<robot_model> &models);
+#endif /* ROBOT_MODELS_HPP_*/
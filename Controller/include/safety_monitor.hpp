@@ -30,13 +30,35 @@ SOFTWARE.
 #include <robot_mediator.hpp>
 #include <model_prediction.hpp>
 #include <constants.hpp>
+#include <event_channel.hpp>
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <cmath>
 #include <math.h>       /* fabs */
+#include <algorithm>
 #include <stdlib.h>     /* abs */
 
+/**
+ * Non-owning view of the joint quantities checked by the safety monitor.
+ * Binds to the data of an existing state: nothing is copied.
+*/
+struct joint_state_view
+{
+    joint_state_view(const state_specification &state):
+      q(state.q.data), qd(state.qd.data), qdd(state.qdd.data), 
+      control_torque(state.control_torque.data){}
+
+    joint_state_view(const Eigen::VectorXd &q_, const Eigen::VectorXd &qd_,
+                     const Eigen::VectorXd &qdd_, const Eigen::VectorXd &control_torque_):
+      q(q_), qd(qd_), qdd(qdd_), control_torque(control_torque_){}
+
+    Eigen::Ref<const Eigen::VectorXd> q;
+    Eigen::Ref<const Eigen::VectorXd> qd;
+    Eigen::Ref<const Eigen::VectorXd> qdd;
+    Eigen::Ref<const Eigen::VectorXd> control_torque;
+};
+
 class safety_monitor
 {
   public:
@@ -46,14 +68,21 @@ class safety_monitor
     int monitor_joint_state(const state_specification &current_state,
                             const double dt_sec,
                             const int desired_control_mode,
-                            const std::vector<state_specification> &predicted_states);
+                            const std::vector<state_specification> &predicted_states,
+                            const int num_of_predicted_states = 2);
+
+    int monitor_joint_state(const joint_state_view &current_state,
+                            const double dt_sec,
+                            const int desired_control_mode,
+                            const std::vector<state_specification> &predicted_states,
+                            const int num_of_predicted_states = 2);
 
   private:
-    const std::vector<double> joint_position_limits_max_;
-    const std::vector<double> joint_position_limits_min_;
-    const std::vector<double> joint_position_thresholds_;
-    const std::vector<double> joint_velocity_limits_;
-    const std::vector<double> joint_torque_limits_;
+    const Eigen::ArrayXd joint_position_limits_max_;
+    const Eigen::ArrayXd joint_position_limits_min_;
+    const Eigen::ArrayXd joint_position_thresholds_;
+    const Eigen::ArrayXd joint_velocity_limits_;
+    const Eigen::ArrayXd joint_torque_limits_;
     
     const int NUM_OF_JOINTS_;
     const int NUM_OF_SEGMENTS_;
@@ -61,16 +90,27 @@ class safety_monitor
     const int NUM_OF_CONSTRAINTS_;
     const bool PRINT_LOGS_;
 
-    state_specification current_state_;
-    std::vector<state_specification> predicted_states_; 
+    // Step of the predicted horizon being checked, 0 for the current state. Reported with the failed check
+    int prediction_step_;
+
+    // Per-joint result of the vectorized limit checks: true if the joint is within limits
+    Eigen::Array<bool, Eigen::Dynamic, 1> joint_mask_;
+
+    bool is_current_state_safe(const joint_state_view &state);
+    bool is_position_safe(const Eigen::Ref<const Eigen::VectorXd> &q);
+    int first_unsafe_joint() const;
+    void report(const int check, const int joint, const double value, const double limit) const;
 
-    bool is_current_state_safe();
-    bool is_state_finite(const state_specification &state, const int joint);
-    bool torque_limit_reached(const state_specification &state, const int joint);
-    bool velocity_limit_reached(const state_specification &state, const int joint);
-    bool position_limit_reached(const state_specification &state, const int joint);
-    bool reaching_position_limits(const state_specification &state, const int joint);
+    // Per-joint checks, used for diagnostics of the joint that failed the vectorized check
+    bool is_state_finite(const joint_state_view &state, const int joint);
+    bool torque_limit_reached(const joint_state_view &state, const int joint);
+    bool velocity_limit_reached(const joint_state_view &state, const int joint);
+    bool position_limit_reached(const Eigen::Ref<const Eigen::VectorXd> &q, const int joint);
+    bool reaching_position_limits(const joint_state_view &state, const int joint);
     
-    int monitor_future_state(const int desired_control_mode);
+    int monitor_future_state(const joint_state_view &current_state,
+                             const int desired_control_mode,
+                             const std::vector<state_specification> &predicted_states,
+                             const int num_of_predicted_states);
 };
 #endif /* SAFETY_MONITOR_HPP_*/
\ No newline at end of file
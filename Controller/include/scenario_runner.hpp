@@ -0,0 +1,106 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SCENARIO_RUNNER_HPP_
+#define SCENARIO_RUNNER_HPP_
+#include <dynamics_controller.hpp>
+#include <simulation_mediator.hpp>
+#include <parameter_store.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Closed-loop scenarios: one task model each, run through the full control loop
+ * on the simulated Kinova Gen3 plant. The start configuration is a seeded perturbation 
+ * of the HOME configuration, and the same seed drives the sensor noise, so that a run
+ * is reproducible from its seed. Every run builds its own plant and controller:
+ * runs are independent of each other and may execute on different threads.
+ */
+namespace scenario_runner
+{
+    const int RATE_HZ                = 1000;
+    const double DT_SEC              = 1.0 / static_cast<double>(RATE_HZ);
+    const double TASK_TIME_LIMIT_SEC = 6.5;
+    const int SETTLE_CYCLES          = 500; // Cycles recorded after the goal is reached
+
+    struct scenario
+    {
+        std::string name; // Also the name of the parameter set in the Kinova parameter file
+        int task_model;
+        std::vector<int> tube_dims; // Linear dimensions constrained by the tube
+        std::vector<double> tube_tolerances; // Used both to define the task and to measure tube violations
+        std::vector<int> tracked_dims; // Linear dimensions of the tracking error. Empty: end-effector drift
+        bool has_goal;
+    };
+
+    struct result
+    {
+        std::string name;
+        unsigned int seed = 0;
+        bool completed = false;
+        double completion_time_sec = 0.0;
+        double tube_violation_sec = 0.0;
+        double peak_error = 0.0, rms_error = 0.0;
+        double torque_usage = 0.0; // RMS of the joint torques, relative to their limits
+        int cycles = 0;
+        double compute_mean_us = 0.0, compute_p50_us = 0.0, compute_p99_us = 0.0, compute_max_us = 0.0;
+        int return_flag = 0;
+    };
+
+    // Plant and controller of one run. The controller refers to the plant: not copyable
+    struct session
+    {
+        session() = default;
+        session(const session &) = delete;
+        session &operator=(const session &) = delete;
+
+        simulation_mediator plant;
+        std::unique_ptr<dynamics_controller> controller;
+        std::vector< std::vector<double> > path_points, path_poses;
+    };
+
+    const std::vector<scenario> &get_scenarios();
+    const scenario *find_scenario(const std::string &name);
+
+    // Nominal parameter set of the scenario, as stored in the parameter file
+    int load_parameters(const scenario &task, const std::string &parameter_file, controller_parameters &parameters);
+
+    /**
+     * Builds the plant, defines the task and initializes the controller as run() does, without running it.
+     * For harnesses that call dynamics_controller::step() themselves. Returns -1 if the set-up failed
+     */
+    int setup(const scenario &task, const unsigned int seed, const std::string &parameter_file,
+              const controller_parameters *parameters, session &run_session);
+
+    /**
+     * Runs the scenario with the given nominal parameter set, 
+     * or with its named set from the parameter file if parameters is nullptr.
+     * Returns -1 if the scenario could not be set up; failures of the task itself are part of the result
+     */
+    int run(const scenario &task, const unsigned int seed, const std::string &parameter_file,
+            const controller_parameters *parameters, result &run_result);
+}
+#endif /* SCENARIO_RUNNER_HPP_*/
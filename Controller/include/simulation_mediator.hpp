@@ -0,0 +1,152 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SIMULATION_MEDIATOR_HPP_
+#define SIMULATION_MEDIATOR_HPP_
+#include <robot_mediator.hpp>
+#include <kdl_parser/kdl_parser.hpp>
+#include <kdl/chainfksolvervel_recursive.hpp>
+#include <urdf/model.h>
+#include <constants.hpp>
+#include <fd_solver_rne.hpp>
+#include <event_channel.hpp>
+#include <memory>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <cmath>
+#include <string>
+#include <vector>
+
+/**
+ * Simulated Kinova Gen3 plant, without the Kortex API: the joint torque commands are integrated 
+ * with the forward dynamics of the simulation model (symplectic Euler, one step per control cycle),
+ * in the same way as the simulation environment of the kinova mediator.
+ * Optional: seeded Gaussian sensor noise, and a compliant contact plane acting on the end-effector.
+ * The wall-clock time the controller spends between reading the state and sending the command
+ * is measured for every cycle and handed to the cycle callback.
+ */
+class simulation_mediator: public robot_mediator
+{
+	public:
+		simulation_mediator();
+		~simulation_mediator(){};
+
+		virtual bool is_initialized();
+		virtual int get_robot_ID();
+		virtual int get_robot_environment();
+		// Robot model and environment arguments are ignored: the plant is always the simulated URDF model
+		virtual void initialize(const int robot_model,
+								const int robot_environment,
+								const int id,
+                                const double DT_SEC);
+
+		virtual void get_joint_state(KDL::JntArray &joint_positions,
+									 KDL::JntArray &joint_velocities,
+									 KDL::JntArray &joint_torques);
+		virtual void get_robot_state(KDL::JntArray &joint_positions,
+                                     KDL::JntArray &joint_velocities,
+                                     KDL::JntArray &joint_torques,
+                                     KDL::Wrench &end_effector_wrench);
+
+		virtual int set_joint_command(const KDL::JntArray &joint_positions,
+						              const KDL::JntArray &joint_velocities,
+							          const KDL::JntArray &joint_torques,
+							          const int desired_control_mode);
+		virtual int set_joint_positions(const KDL::JntArray &joint_positions);
+		virtual int set_joint_velocities(const KDL::JntArray &joint_velocities);
+		virtual int set_joint_torques(const KDL::JntArray &joint_torques); 
+		virtual int stop_robot_motion();
+
+		virtual std::vector<double> get_maximum_joint_pos_limits();
+		virtual std::vector<double> get_minimum_joint_pos_limits();
+		virtual std::vector<double> get_joint_position_thresholds();
+		virtual std::vector<double> get_joint_velocity_limits();
+		virtual std::vector<double> get_joint_acceleration_limits();
+		virtual std::vector<double> get_joint_torque_limits();
+		virtual std::vector<double> get_joint_stopping_torque_limits();
+		virtual std::vector<double> get_joint_inertia();
+		virtual std::vector<double> get_joint_offsets();
+
+		virtual KDL::Twist get_root_acceleration();
+		virtual KDL::Chain get_robot_model();
+		virtual KDL::Chain get_full_robot_model();
+
+		// Simulation set-up. Joint positions in radians
+		void set_joint_state(const KDL::JntArray &joint_positions, const KDL::JntArray &joint_velocities);
+		void set_sensor_noise(const double position_stddev, const double velocity_stddev, const unsigned int seed);
+
+		// Half-space behind the plane (opposite to its normal) pushes the end-effector back, as a spring-damper
+		void set_contact_plane(const KDL::Vector &point, const KDL::Vector &normal,
+		                       const double stiffness, const double damping);
+		void remove_contact_plane();
+
+		// Commands are rejected (-1) once the number of simulated cycles reaches the limit. Negative: no limit
+		void set_cycle_limit(const int max_cycles);
+		int get_cycle_count() const;
+
+		// Called after every simulated cycle, with the controller's compute time of that cycle
+		void set_cycle_callback(const std::function<void(const double compute_time_micro)> &callback);
+
+		// Joint torques applied in the last cycle of the torque control mode
+		const KDL::JntArray &get_commanded_torques() const;
+
+	private:
+		bool is_initialized_;
+		int robot_id_;
+		double DT_SEC_;
+		const int NUM_OF_JOINTS_;
+		KDL::Chain robot_chain_, robot_chain_full_, sim_chain_;
+		std::shared_ptr<KDL::FdSolver_RNE> fd_solver_rne_;
+		std::shared_ptr<KDL::ChainFkSolverVel_recursive> fk_vel_solver_;
+		KDL::JntArray q_, qd_, qdd_, measured_torque_, total_torque_, commanded_torque_;
+		KDL::Wrenches ext_wrenches_;
+		KDL::Wrench contact_wrench_; // Expressed in the end-effector frame
+
+		std::mt19937 noise_generator_;
+		std::normal_distribution<double> standard_normal_;
+		double position_noise_stddev_, velocity_noise_stddev_;
+
+		struct contact_plane
+		{
+			bool active;
+			KDL::Vector point, normal;
+			double stiffness, damping;
+		} contact_plane_;
+
+		int cycle_count_, max_cycles_;
+		std::chrono::steady_clock::time_point state_read_time_;
+		std::function<void(const double compute_time_micro)> cycle_callback_;
+
+		int get_model_from_urdf(const std::string &urdf_path, const std::string &tip_name, KDL::Chain &chain);
+		void update_contact_wrench();
+
+		virtual void get_joint_positions(KDL::JntArray &joint_positions);
+		virtual void get_joint_velocities(KDL::JntArray &joint_velocities);
+		virtual void get_joint_torques(KDL::JntArray &joint_torques);
+		virtual void get_end_effector_wrench(KDL::Wrench &end_effector_wrench);
+};
+#endif /* SIMULATION_MEDIATOR_HPP_*/
@@ -0,0 +1,88 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SLIDING_WINDOW_HPP_
+#define SLIDING_WINDOW_HPP_
+#include <Eigen/Core>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+/**
+ * Fixed-capacity, multi-dimensional sliding window.
+ * Samples are stored in a preallocated ring buffer (one column per time slot),
+ * hence no heap allocation takes place after construction.
+ * Mean and variance are updated incrementally (Welford), the least-squares
+ * slope uses running sums, while min/max/median are evaluated on request.
+ */
+class sliding_window
+{
+  public:
+    sliding_window(const int window_size, const int num_dimensions);
+    ~sliding_window(){};
+
+    // Push one sample for all dimensions at once
+    void update(const Eigen::VectorXd &state);
+    void update(const int dimension, const double state);
+
+    void clear();
+    void clear(const int dimension);
+
+    int get_size(const int dimension) const;
+    bool is_full(const int dimension) const;
+
+    // Oldest and newest stored samples
+    double get_oldest(const int dimension) const;
+    double get_newest(const int dimension) const;
+
+    Eigen::VectorXd get_mean() const;
+    double get_mean(const int dimension) const;
+
+    // Population variance, i.e. normalized by the number of stored samples
+    Eigen::VectorXd get_variance() const;
+    double get_variance(const int dimension) const;
+
+    // Least-squares slope per sample, over the stored samples
+    Eigen::VectorXd get_slope() const;
+    double get_slope(const int dimension) const;
+
+    double get_min(const int dimension) const;
+    double get_max(const int dimension) const;
+    double get_median(const int dimension);
+
+  private:
+    const int WINDOW_SIZE_, DIMENSIONS_;
+    bool synchronized_;
+    Eigen::MatrixXd samples_;
+    Eigen::VectorXi heads_, counts_;
+    Eigen::VectorXd means_, variances_, sums_, index_sums_, removed_, delta_;
+    std::vector<double> median_buffer_;
+
+    void push_sample(const int dimension, const double state);
+    void refresh_sums(const int dimension);
+    void check_synchronization();
+    int oldest_index(const int dimension) const;
+};
+#endif /* SLIDING_WINDOW_HPP_*/
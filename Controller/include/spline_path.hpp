@@ -0,0 +1,85 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SPLINE_PATH_HPP_
+#define SPLINE_PATH_HPP_
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <vector>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+/**
+ * C1-continuous cubic (Hermite, chord-length parameterized Catmull-Rom) spline
+ * interpolating the given path points.
+ * An arc-length table is precomputed at construction. Queries by arc length use
+ * a binary search in the table followed by a Newton correction: their cost does
+ * not depend on the path resolution beyond the logarithmic search.
+ * Tangent, normal and curvature are evaluated analytically from the polynomial pieces.
+ */
+class spline_path
+{
+  public:
+    spline_path(const std::vector< std::vector<double> > &path_points);
+    ~spline_path(){};
+
+    double get_length() const;
+    int get_number_of_pieces() const;
+
+    Eigen::Vector3d get_position(const double arc_length) const;
+    Eigen::Vector3d get_tangent(const double arc_length) const;
+    Eigen::Vector3d get_normal(const double arc_length) const;
+    double get_curvature(const double arc_length) const;
+
+    // Frenet frame, columns: tangent, normal, binormal
+    Eigen::Matrix3d get_frenet_frame(const double arc_length) const;
+
+    // Task (tube) frame convention: minimal rotation of the world X axis onto the tangent
+    Eigen::Matrix3d get_task_frame(const double arc_length) const;
+
+    // Points on the curve such that the chords deviate at most max_deviation from it
+    void sample_points(const double max_deviation,
+                       std::vector< std::vector<double> > &path_points) const;
+
+    // Same, with the arc length of each point along the curve
+    void sample_points(const double max_deviation,
+                       std::vector< std::vector<double> > &path_points,
+                       std::vector<double> &arc_lengths) const;
+
+  private:
+    static const int TABLE_SAMPLES_PER_PIECE_ = 16;
+
+    // P(u) = a + b*u + c*u^2 + d*u^3, u in [0, 1]
+    std::vector<Eigen::Vector3d> a_, b_, c_, d_;
+    std::vector<double> arc_length_table_;
+
+    void locate(const double arc_length, int &piece, double &u) const;
+    Eigen::Vector3d position(const int piece, const double u) const;
+    Eigen::Vector3d first_derivative(const int piece, const double u) const;
+    Eigen::Vector3d second_derivative(const int piece, const double u) const;
+    double piece_length(const int piece, const double u_start, const double u_end) const;
+};
+#endif /* SPLINE_PATH_HPP_*/
@@ -0,0 +1,91 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef TASK_QUEUE_HPP_
+#define TASK_QUEUE_HPP_
+#include <vector>
+#include <atomic>
+#include <cassert>
+
+/**
+ * Bounded, lock-free, single-producer single-consumer queue.
+ * Slots are preallocated: the producer copies items into a free slot (may allocate, non real-time side),
+ * the consumer works on the front item in place and releases the slot (real-time side).
+ * Whatever the consumer leaves in a released slot is destroyed by the producer, on its next push.
+ */
+template <typename T>
+class task_queue
+{
+  public:
+    task_queue(const int capacity):
+        CAPACITY_(capacity + 1), slots_(capacity + 1), head_(0), tail_(0)
+    {
+        assert(("Queue capacity must be positive", capacity > 0));
+    };
+    ~task_queue(){};
+
+    // Producer side
+    bool push(const T &item)
+    {
+        const int tail = tail_.load(std::memory_order_relaxed);
+        const int next = (tail + 1) % CAPACITY_;
+        if (next == head_.load(std::memory_order_acquire)) return false;
+
+        slots_[tail] = item;
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    T *front()
+    {
+        const int head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) return nullptr;
+        return &slots_[head];
+    }
+
+    void pop()
+    {
+        const int head = head_.load(std::memory_order_relaxed);
+        assert(head != tail_.load(std::memory_order_acquire));
+        head_.store((head + 1) % CAPACITY_, std::memory_order_release);
+    }
+
+    bool empty() const
+    {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    int size() const
+    {
+        return (tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire) + CAPACITY_) % CAPACITY_;
+    }
+
+  private:
+    const int CAPACITY_;
+    std::vector<T> slots_;
+    std::atomic<int> head_, tail_;
+};
+#endif /* TASK_QUEUE_HPP_*/
@@ -0,0 +1,221 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef TRACE_MEDIATOR_HPP_
+#define TRACE_MEDIATOR_HPP_
+#include <robot_mediator.hpp>
+#include <cstdio>
+#include <cassert>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+
+/**
+ * Binary trace of a control session: header, then one record per sensor read
+ * or joint command, in call order. Values are stored as raw doubles (bit-exact).
+ *   header:  "MTTRACE1" | int32 robot ID | int32 environment | int32 number of joints
+ *   record:  uint8 type | payload
+ *     JOINT_STATE:  q, qd, tau                           (3 x NJ doubles)
+ *     ROBOT_STATE:  q, qd, tau, end-effector wrench      (3 x NJ + 6 doubles)
+ *     JOINT_COMMAND: int32 control mode, q, qd, tau      (3 x NJ doubles)
+ */
+namespace trace
+{
+    enum record_type
+    {
+        JOINT_STATE   = 1,
+        ROBOT_STATE   = 2,
+        JOINT_COMMAND = 3
+    };
+
+    extern const char MAGIC[8];
+}
+
+/**
+ * Forwards all model and limit queries to the wrapped mediator.
+ * Base for the recording and replaying mediators.
+ */
+class trace_mediator: public robot_mediator
+{
+	public:
+		trace_mediator(robot_mediator *robot_driver);
+		virtual ~trace_mediator(){};
+
+		virtual bool is_initialized();
+		virtual int get_robot_ID();
+		virtual int get_robot_environment();
+		virtual void initialize(const int robot_model,
+								const int robot_environment,
+								const int id,
+                                const double DT_SEC);
+
+		virtual int set_joint_positions(const KDL::JntArray &joint_positions);
+		virtual int set_joint_velocities(const KDL::JntArray &joint_velocities);
+		virtual int set_joint_torques(const KDL::JntArray &joint_torques); 
+		virtual int stop_robot_motion();
+
+		virtual std::vector<double> get_maximum_joint_pos_limits();
+		virtual std::vector<double> get_minimum_joint_pos_limits();
+		virtual std::vector<double> get_joint_position_thresholds();
+		virtual std::vector<double> get_joint_velocity_limits();
+		virtual std::vector<double> get_joint_acceleration_limits();
+		virtual std::vector<double> get_joint_torque_limits();
+		virtual std::vector<double> get_joint_stopping_torque_limits();
+		virtual std::vector<double> get_joint_inertia();
+		virtual std::vector<double> get_joint_offsets();
+
+		virtual KDL::Twist get_root_acceleration();
+		virtual KDL::Chain get_robot_model();
+		virtual KDL::Chain get_full_robot_model();
+
+	protected:
+		robot_mediator *robot_driver_;
+
+	private:
+		virtual void get_joint_positions(KDL::JntArray &joint_positions);
+		virtual void get_joint_velocities(KDL::JntArray &joint_velocities);
+		virtual void get_joint_torques(KDL::JntArray &joint_torques);
+		virtual void get_end_effector_wrench(KDL::Wrench &end_effector_wrench);
+};
+
+/**
+ * Records every state read and joint command of the wrapped (real) mediator
+ * into a binary trace, then passes the call through unchanged.
+ * The control thread only copies records into a lock-free ring; a background thread
+ * writes them to the file. If the ring overflows, recording stops, so that the trace
+ * remains a replayable prefix of the session. The trace is complete after close() or destruction.
+ */
+class recording_mediator: public trace_mediator
+{
+	public:
+		recording_mediator(robot_mediator *robot_driver);
+		~recording_mediator();
+
+		// Opens the trace, writes its header and starts the writer thread. Robot must be initialized
+		int open(const std::string &trace_file);
+		// Writes the remaining records and closes the trace. Call once the control loop has stopped
+		void close();
+
+		// For drivers whose samples and commands bypass the mediator (e.g. RTT ports). No-op if the trace is not open
+		void record_robot_state(const KDL::JntArray &joint_positions,
+								const KDL::JntArray &joint_velocities,
+								const KDL::JntArray &joint_torques,
+								const KDL::Wrench &end_effector_wrench);
+		void record_joint_command(const KDL::JntArray &joint_positions,
+								  const KDL::JntArray &joint_velocities,
+								  const KDL::JntArray &joint_torques,
+								  const int control_mode);
+
+		virtual void get_joint_state(KDL::JntArray &joint_positions,
+									 KDL::JntArray &joint_velocities,
+									 KDL::JntArray &joint_torques);
+		virtual void get_robot_state(KDL::JntArray &joint_positions,
+                                     KDL::JntArray &joint_velocities,
+                                     KDL::JntArray &joint_torques,
+                                     KDL::Wrench &end_effector_wrench);
+		virtual int set_joint_command(const KDL::JntArray &joint_positions,
+						              const KDL::JntArray &joint_velocities,
+							          const KDL::JntArray &joint_torques,
+							          const int desired_control_mode);
+
+	private:
+		FILE *trace_file_;
+		std::vector<char> ring_;
+		const std::size_t RING_MASK_;
+
+		// Monotonic byte positions; the ring index is position & RING_MASK_.
+		// Written by the control thread and the writer thread, respectively
+		std::atomic<std::size_t> write_position_, read_position_;
+		std::size_t pending_position_; // End of the record being appended, published by end_record()
+		bool recording_;
+		int lost_records_;
+		std::atomic<bool> writer_running_;
+		std::thread writer_;
+
+		bool begin_record(const uint8_t type, const std::size_t payload_size);
+		void append(const void *data, const std::size_t size);
+		void end_record();
+		void write_joint_arrays(const KDL::JntArray &a, const KDL::JntArray &b, const KDL::JntArray &c);
+
+		void write_out();
+		void run_writer();
+};
+
+/**
+ * Feeds a recorded sensor stream to the controller, without a robot attached,
+ * and compares the new joint commands to the recorded ones.
+ * Model, limits and robot ID come from the wrapped mediator (e.g. in simulation environment).
+ * Once the trace is exhausted, set_joint_command returns -1, which stops the controller.
+ */
+class replay_mediator: public trace_mediator
+{
+	public:
+		replay_mediator(robot_mediator *robot_driver);
+		~replay_mediator(){};
+
+		// Loads the whole trace in memory. Tolerance is the max. absolute command difference accepted as equivalent
+		int load(const std::string &trace_file, const double tolerance);
+		bool is_finished() const;
+
+		// Environment of the recorded session: stop-motion behaviour is replayed as recorded
+		virtual int get_robot_environment();
+
+		virtual void get_joint_state(KDL::JntArray &joint_positions,
+									 KDL::JntArray &joint_velocities,
+									 KDL::JntArray &joint_torques);
+		virtual void get_robot_state(KDL::JntArray &joint_positions,
+                                     KDL::JntArray &joint_velocities,
+                                     KDL::JntArray &joint_torques,
+                                     KDL::Wrench &end_effector_wrench);
+		virtual int set_joint_command(const KDL::JntArray &joint_positions,
+						              const KDL::JntArray &joint_velocities,
+							          const KDL::JntArray &joint_torques,
+							          const int desired_control_mode);
+
+		// Summary of the command comparison. Returns 0 if all commands are within tolerance
+		int print_report() const;
+
+	private:
+		std::vector<char> trace_;
+		std::size_t read_position_;
+		int num_of_joints_, recorded_environment_;
+		double tolerance_;
+		bool finished_, out_of_sync_;
+
+		// Command comparison statistics
+		int compared_commands_, identical_commands_, commands_over_tolerance_;
+		int mode_mismatches_, first_command_over_tolerance_;
+		double max_command_difference_;
+
+		bool next_record(const uint8_t expected_type);
+		void read_joint_arrays(KDL::JntArray &a, KDL::JntArray &b, KDL::JntArray &c);
+		double compare(const KDL::JntArray &command, bool &identical);
+};
+#endif /* TRACE_MEDIATOR_HPP_*/
@@ -0,0 +1,161 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <abag_warm_start.hpp>
+#include <constants.hpp>
+#include <cstdio>
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+abag_warm_start::abag_warm_start(const int num_of_dimensions):
+    DIMENSIONS_(num_of_dimensions)
+{
+}
+
+int abag_warm_start::load(const std::string &file_path)
+{
+    records_.clear();
+
+    std::ifstream file(file_path);
+    if (!file.is_open()) return 0; // Nothing learned yet
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line))
+    {
+        line_number++;
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream line_stream(line);
+        record entry;
+        entry.bias = Eigen::VectorXd::Zero(DIMENSIONS_);
+        entry.gain = Eigen::VectorXd::Zero(DIMENSIONS_);
+
+        bool valid = static_cast<bool>(line_stream >> entry.task_model >> entry.robot_id >> entry.tool >> entry.runs);
+        for (int i = 0; valid && i < DIMENSIONS_; i++) valid = static_cast<bool>(line_stream >> entry.bias(i));
+        for (int i = 0; valid && i < DIMENSIONS_; i++) valid = static_cast<bool>(line_stream >> entry.gain(i));
+
+        if (!valid || !entry.bias.allFinite() || !entry.gain.allFinite())
+        {
+            printf("Skipping invalid ABAG state record on line %d of: %s\n", line_number, file_path.c_str());
+            continue;
+        }
+        records_.push_back(entry);
+    }
+
+    return 0;
+}
+
+// Written to a temporary file first, so that an interrupted session cannot leave a truncated file behind
+int abag_warm_start::save(const std::string &file_path) const
+{
+    const std::string temporary_path = file_path + ".tmp";
+    std::ofstream file(temporary_path);
+    if (!file.is_open())
+    {
+        printf("Unable to write ABAG state file: %s\n", file_path.c_str());
+        return -1;
+    }
+
+    file << "# task_model robot_id tool runs bias[" << DIMENSIONS_ << "] gain[" << DIMENSIONS_ << "]\n";
+    file.precision(9);
+    for (const record &entry : records_)
+    {
+        if (entry.runs == 0) continue;
+        file << entry.task_model << " " << entry.robot_id << " " << entry.tool << " " << entry.runs;
+        for (int i = 0; i < DIMENSIONS_; i++) file << " " << entry.bias(i);
+        for (int i = 0; i < DIMENSIONS_; i++) file << " " << entry.gain(i);
+        file << "\n";
+    }
+    file.close();
+
+    if (file.fail() || std::rename(temporary_path.c_str(), file_path.c_str()) != 0)
+    {
+        printf("Unable to write ABAG state file: %s\n", file_path.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+int abag_warm_start::find_record(const int task_model, const int robot_id, const std::string &tool) const
+{
+    for (int i = 0; i < static_cast<int>(records_.size()); i++)
+    {
+        if (records_[i].task_model == task_model && records_[i].robot_id == robot_id && records_[i].tool == tool) return i;
+    }
+    return -1;
+}
+
+void abag_warm_start::reserve(const int task_model, const int robot_id, const std::string &tool)
+{
+    if (find_record(task_model, robot_id, tool) != -1) return;
+
+    record entry;
+    entry.task_model = task_model;
+    entry.robot_id   = robot_id;
+    entry.tool       = tool;
+    entry.runs       = 0;
+    entry.bias       = Eigen::VectorXd::Zero(DIMENSIONS_);
+    entry.gain       = Eigen::VectorXd::Zero(DIMENSIONS_);
+    records_.push_back(entry);
+}
+
+bool abag_warm_start::find(const int task_model, const int robot_id, const std::string &tool,
+                           Eigen::VectorXd &bias, Eigen::VectorXd &gain) const
+{
+    const int index = find_record(task_model, robot_id, tool);
+    if (index == -1 || records_[index].runs == 0) return false;
+
+    // A single record must not be able to command more than a fraction of the actuator range
+    bias = records_[index].bias.cwiseMin(dynamics_parameter::ABAG_WARM_START_MAX_BIAS).cwiseMax(-dynamics_parameter::ABAG_WARM_START_MAX_BIAS);
+    gain = records_[index].gain.cwiseMin(dynamics_parameter::ABAG_WARM_START_MAX_GAIN).cwiseMax(0.0);
+    return true;
+}
+
+void abag_warm_start::store(const int task_model, const int robot_id, const std::string &tool,
+                            const Eigen::Ref<const Eigen::VectorXd> &bias, const Eigen::Ref<const Eigen::VectorXd> &gain)
+{
+    assert(bias.size() == DIMENSIONS_ && gain.size() == DIMENSIONS_);
+    if (!bias.allFinite() || !gain.allFinite()) return;
+
+    const int index = find_record(task_model, robot_id, tool);
+    if (index == -1) return;
+
+    record &entry = records_[index];
+    if (entry.runs == 0)
+    {
+        entry.bias = bias;
+        entry.gain = gain;
+        entry.runs = 1;
+        return;
+    }
+
+    // Exponential moving average: a single unusual run only moves the stored state part of the way
+    const double smoothing_factor = dynamics_parameter::ABAG_WARM_START_SMOOTHING_FACTOR;
+    entry.bias = (1.0 - smoothing_factor) * entry.bias + smoothing_factor * bias;
+    entry.gain = (1.0 - smoothing_factor) * entry.gain + smoothing_factor * gain;
+    entry.runs++;
+}
@@ -0,0 +1,128 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <braking_planner.hpp>
+
+braking_planner::braking_planner(const std::vector<double> &acceleration_limits,
+                                 const double max_jerk,
+                                 const double velocity_threshold):
+    NUM_OF_JOINTS_(acceleration_limits.size()), MAX_JERK_(max_jerk),
+    VELOCITY_THRESHOLD_(std::fabs(velocity_threshold)),
+    acceleration_limits_(Eigen::Map<const Eigen::VectorXd>(acceleration_limits.data(), acceleration_limits.size())),
+    initial_speed_(Eigen::VectorXd::Zero(NUM_OF_JOINTS_)),
+    direction_(Eigen::VectorXd::Zero(NUM_OF_JOINTS_)),
+    deceleration_(Eigen::VectorXd::Zero(NUM_OF_JOINTS_)),
+    stop_time_(Eigen::VectorXd::Zero(NUM_OF_JOINTS_))
+{
+    assert(("Braking planner not initialized properly", NUM_OF_JOINTS_ > 0));
+    assert(("Acceleration limits must be positive", (acceleration_limits_.array() > 0.0).all()));
+    assert(("Jerk limit must be non-negative", MAX_JERK_ >= 0.0));
+}
+
+void braking_planner::plan(const Eigen::VectorXd &initial_velocity, const bool synchronize)
+{
+    assert(initial_velocity.size() == NUM_OF_JOINTS_);
+
+    for (int i = 0; i < NUM_OF_JOINTS_; i++)
+    {
+        initial_speed_(i) = std::fabs(initial_velocity(i));
+        direction_(i)     = (initial_velocity(i) > 0.0)? 1.0 : -1.0;
+        deceleration_(i)  = acceleration_limits_(i);
+        stop_time_(i)     = minimum_stop_time(initial_speed_(i), deceleration_(i));
+    }
+
+    if (!synchronize) return;
+
+    // Stretch all profiles to the stop time of the slowest joint
+    const double common_stop_time = stop_time_.maxCoeff();
+    if (common_stop_time <= 0.0) return;
+
+    for (int i = 0; i < NUM_OF_JOINTS_; i++)
+    {
+        deceleration_(i) = deceleration_for_stop_time(initial_speed_(i), common_stop_time);
+        stop_time_(i)    = common_stop_time;
+    }
+}
+
+double braking_planner::minimum_stop_time(const double speed, const double acceleration) const
+{
+    if (MAX_JERK_ <= 0.0) return speed / acceleration;
+
+    // Trapezoidal deceleration if the acceleration limit is reached, triangular otherwise
+    if (speed >= acceleration * acceleration / MAX_JERK_) return speed / acceleration + acceleration / MAX_JERK_;
+    return 2.0 * std::sqrt(speed / MAX_JERK_);
+}
+
+/**
+ * Inverse of the minimum_stop_time for a prescribed (longer) stop time.
+ * Jerk-limited case: smaller root of a^2 - J*T*a + J*v = 0,
+ * which always lies in the trapezoidal regime.
+ */
+double braking_planner::deceleration_for_stop_time(const double speed, const double stop_time) const
+{
+    if (MAX_JERK_ <= 0.0) return speed / stop_time;
+
+    const double discriminant = MAX_JERK_ * MAX_JERK_ * stop_time * stop_time - 4.0 * MAX_JERK_ * speed;
+    return 0.5 * (MAX_JERK_ * stop_time - std::sqrt(std::max(discriminant, 0.0)));
+}
+
+double braking_planner::get_velocity(const int joint, const double time_sec) const
+{
+    assert(joint >= 0);
+    assert(joint < NUM_OF_JOINTS_);
+
+    const double v0 = initial_speed_(joint);
+    const double a  = deceleration_(joint);
+    const double T  = stop_time_(joint);
+    double speed = 0.0;
+
+    if (time_sec >= T) speed = 0.0;
+    else if (time_sec <= 0.0) speed = v0;
+    else if (MAX_JERK_ <= 0.0) speed = v0 - a * time_sec;
+    else
+    {
+        // Duration of the jerk phases: equal to T/2 if the profile is triangular
+        const double t_jerk = std::min(a / MAX_JERK_, 0.5 * T);
+
+        if      (time_sec < t_jerk)     speed = v0 - 0.5 * MAX_JERK_ * time_sec * time_sec;
+        else if (time_sec < T - t_jerk) speed = v0 - 0.5 * a * t_jerk - a * (time_sec - t_jerk);
+        else                            speed = 0.5 * MAX_JERK_ * (T - time_sec) * (T - time_sec);
+    }
+
+    if (speed < VELOCITY_THRESHOLD_) return 0.0;
+    return direction_(joint) * speed;
+}
+
+double braking_planner::get_stop_time(const int joint) const
+{
+    assert(joint >= 0);
+    assert(joint < NUM_OF_JOINTS_);
+
+    return stop_time_(joint);
+}
+
+double braking_planner::get_stop_time() const
+{
+    return stop_time_.maxCoeff();
+}
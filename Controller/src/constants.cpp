@@ -222,6 +222,9 @@ namespace abag_parameter
     const Eigen::VectorXd MIN_COMMAND_SAT_LIMIT = (Eigen::VectorXd(DIMENSIONS) << -1.0, -1.0, -1.0, -1.0, -1.0, -1.0).finished();
    //  const Eigen::VectorXd MIN_COMMAND_SAT_LIMIT = (Eigen::VectorXd(DIMENSIONS) <<  0.0, 0.0, 0.0, 0.0, 0.0, 0.0).finished();
     const Eigen::VectorXd MAX_COMMAND_SAT_LIMIT = (Eigen::VectorXd(DIMENSIONS) << 1.0, 1.0, 1.0, 1.0, 1.0, 1.0).finished();
+
+    // Command saturation of the linear Z axis, while velocity-controlled towards the contact surface
+    const double APPROACH_MAX_COMMAND = 20.0;
 }
 
 namespace dynamics_parameter
@@ -232,8 +235,31 @@ namespace dynamics_parameter
     const int STEADY_STOP_ITERATION_THRESHOLD = 40; // Iterations
     const double LOWER_DECELERATION_RAMP_THRESHOLD = 0.05; // rad/sec
     const double STOPPING_MOTION_LOOP_FREQ = 750.0; // Hz  ... Higher than 750 Hz not yet feasible with the current Kinova API
+    const double STOPPING_MOTION_MAX_JERK = 0.0; // rad/sec^3 ... 0 disables the jerk limit. Limiting the jerk increases the stopping distance
+    const bool SYNCHRONIZE_STOPPING_MOTION = false; // All joints stop at the same time. Increases the stopping distance of the faster-stopping joints
+    const double LAZY_DYNAMICS_DELTA_Q_BOUND = 1e-4; // rad ... Norm of the joint displacement since the last refresh of M(q), g(q) and J(q)
+    const int LAZY_DYNAMICS_REFRESH_PERIOD = 10; // Iterations ... Hard refresh, regardless of the joint displacement
     const Eigen::VectorXd MAX_CART_FORCE = (Eigen::VectorXd(NUMBER_OF_CONSTRAINTS) << 50.0, 50.0, 200.0, 2.0, 2.0, 2.0).finished();
     const Eigen::VectorXd MAX_CART_ACC = (Eigen::VectorXd(NUMBER_OF_CONSTRAINTS) << 100.0, 100.0, 200.0, 2.0, 2.0, 2.0).finished();
+    const double PATH_MAX_LINEAR_VELOCITY = 0.2; // m/s ... Used by the time-optimal profile along tube paths
+    const double PATH_MAX_LINEAR_ACCELERATION = 0.5; // m/s^2
+    const double PATH_MAX_LINEAR_JERK = 5.0; // m/s^3 ... Used by the jerk-limited profile of the moveTo task
+    const double PATH_PROJECTION_HYSTERESIS = 0.005; // m ... Non-neighbouring tube sections must be closer by this distance to be selected
+    const int PATH_STREAM_WINDOW = 512; // Tube sections ... Task frames kept in memory for paths loaded from file
+    const int PATH_STREAM_SECTIONS_PER_CYCLE = 16; // Tube sections ... Upper bound on the task frames built in one control cycle
+    const int TASK_QUEUE_CAPACITY = 16; // Tasks ... Chained tasks waiting for the active one to complete
+    const int EVENT_CHANNEL_CAPACITY = 1024; // Events ... Queued for the background sink; further events are dropped and counted
+    const int EVENT_SINK_POLL_PERIOD_MS = 20; // ms ... How often the background sink writes the queued events
+    const int TRACE_RING_SIZE = 1 << 22; // Bytes ... Records of the control thread not yet written to the trace file, ~10 s of a 7-joint session at 1 kHz
+    const int TRACE_WRITER_POLL_PERIOD_MS = 20; // ms ... How often the trace writer empties the ring
+    const int PARAMETER_FILE_POLL_PERIOD_MS = 500; // ms ... How often a watched parameter file is checked for modifications
+    const double ABAG_WARM_START_MAX_BIAS = 0.5; // Normalized ABAG command ... Upper bound on a restored bias
+    const double ABAG_WARM_START_MAX_GAIN = 0.3; // Normalized ABAG command ... Upper bound on a restored gain
+    const double ABAG_WARM_START_SMOOTHING_FACTOR = 0.5; // Weight of the latest completed run in the exponential moving average of the stored ABAG state
+    const int SAFETY_HORIZON_MIN_STEPS = 2; // Iterations ... Joint-space prediction horizon of the safety monitor, always evaluated
+    const int SAFETY_HORIZON_MAX_STEPS = 50; // Iterations ... Upper bound, when enough time is left in the control cycle
+    const double SAFETY_HORIZON_TIME_MARGIN = 200.0; // us ... Time kept free at the end of the cycle for sending the commands
+    const double SAFETY_HORIZON_COST_FILTER = 0.1; // Weight of the latest measurement in the per-step prediction cost estimate
     const Eigen::IOFormat WRITE_FORMAT(6, Eigen::DontAlignCols, " ", "", "", "\n");
     const std::string LOG_FILE_CART_PATH("/home/djole/Master/Thesis/GIT/MT_testing/Controller/visualization/archive/control_error.txt");
     const std::string LOG_FILE_STOP_MOTION_PATH("/home/djole/Master/Thesis/GIT/MT_testing/Controller/visualization/archive/stop_motion_error.txt");
@@ -242,6 +268,8 @@ namespace dynamics_parameter
     const std::string LOG_FILE_EXT_WRENCH_PATH("/home/djole/Master/Thesis/GIT/MT_testing/Controller/visualization/archive/ext_wrench_data.txt");
     const std::string LOG_FILE_PREDICTIONS_PATH("/home/djole/Master/Thesis/GIT/MT_testing/Controller/visualization/archive/prediction_effects.txt");
     const std::string LOG_FILE_NULL_SPACE_PATH("/home/djole/Master/Thesis/GIT/MT_testing/Controller/visualization/archive/null_space_error.txt");
+    const std::string LOG_FILE_COMPENSATION_PATH("/home/djole/Master/Thesis/GIT/MT_testing/Controller/visualization/archive/compensation_data.txt");
+    const std::string LOG_FILE_EVENTS_PATH("/home/djole/Master/Thesis/GIT/MT_testing/Controller/visualization/archive/events.txt");
 }
 
 namespace prediction_parameter
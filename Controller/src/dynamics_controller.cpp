@@ -27,6 +27,58 @@ SOFTWARE.
 #define SECOND 1000000 // 1sec = 1 000 000 us
 const double MIN_NORM = 1e-3;
 
+void dynamics_controller::control_task::transform_force_driver(KDL::Wrench &force_command) const
+{
+    force_command = get_task_frame_rotation() * force_command;
+}
+
+template <void (dynamics_controller::*compute_task_error)()>
+class dynamics_controller::fixed_frame_task: public dynamics_controller::control_task
+{
+  public:
+    fixed_frame_task(dynamics_controller &controller, const KDL::Rotation &tf_orientation):
+        control_task(controller), TF_ORIENTATION_(tf_orientation){};
+
+    void compute_error() { (controller_.*compute_task_error)(); }
+    const KDL::Rotation &get_task_frame_rotation() const { return TF_ORIENTATION_; }
+
+  private:
+    const KDL::Rotation TF_ORIENTATION_;
+};
+
+class dynamics_controller::moveTo_follow_path_control_task: public dynamics_controller::control_task
+{
+  public:
+    moveTo_follow_path_control_task(dynamics_controller &controller): control_task(controller){};
+
+    void compute_error() { controller_.compute_moveTo_follow_path_task_error(); }
+    const KDL::Rotation &get_task_frame_rotation() const
+    {
+        return controller_.get_tube_section_frame(controller_.moveTo_follow_path_task_.tf_poses).M;
+    }
+};
+
+class dynamics_controller::moveConstrained_follow_path_control_task: public dynamics_controller::control_task
+{
+  public:
+    moveConstrained_follow_path_control_task(dynamics_controller &controller): control_task(controller){};
+
+    void compute_error() { controller_.compute_moveConstrained_follow_path_task_error(); }
+    const KDL::Rotation &get_task_frame_rotation() const
+    {
+        return controller_.get_tube_section_frame(controller_.moveConstrained_follow_path_task_.tf_poses).M;
+    }
+
+    void transform_force_driver(KDL::Wrench &force_command) const
+    {
+        // First transform the wrench command from the tool-tip to the end-effector reference point but not the reference frame
+        force_command = force_command.RefPoint(controller_.moveConstrained_follow_path_task_.end_eff_wrt_tool_tip.p);
+
+        // Now tranform the reference frame, from task frame to base frame
+        force_command = controller_.moveConstrained_follow_path_task_.tf_force * force_command;
+    }
+};
+
 dynamics_controller::dynamics_controller(robot_mediator *robot_driver,
                                          const int rate_hz,
                                          const bool compensate_gravity):
@@ -35,7 +87,13 @@ dynamics_controller::dynamics_controller(robot_mediator *robot_driver,
     DT_STOPPING_MICRO_(SECOND / dynamics_parameter::STOPPING_MOTION_LOOP_FREQ),
     store_control_data_(false), use_estimated_external_wrench_(false),
     desired_dynamics_interface_(dynamics_interface::CART_ACCELERATION), 
-    desired_task_model_(task_model::full_pose), loop_start_time_(std::chrono::steady_clock::now()),
+    desired_task_model_(task_model::full_pose), lazy_dynamics_on_(false),
+    lazy_delta_q_bound_(dynamics_parameter::LAZY_DYNAMICS_DELTA_Q_BOUND),
+    lazy_refresh_period_(dynamics_parameter::LAZY_DYNAMICS_REFRESH_PERIOD),
+    use_path_projection_(false), free_running_(false), event_sink_on_(false), stage_timing_on_(false),
+    stage_time_micro_(step_stage::NUMBER_OF_STEP_STAGES, 0.0),
+    loop_start_time_(std::chrono::steady_clock::now()), loop_start_stamped_(false),
+    safety_horizon_steps_(dynamics_parameter::SAFETY_HORIZON_MIN_STEPS), safety_step_cost_micro_(0.0),
     total_time_sec_(0.0), loop_iteration_count_(0), stop_loop_iteration_count_(0),
     steady_stop_iteration_count_(0), feedforward_loop_count_(0), control_loop_delay_count_(0),
     robot_driver_(robot_driver), robot_chain_(robot_driver_->get_robot_model()),
@@ -49,7 +107,6 @@ dynamics_controller::dynamics_controller(robot_mediator *robot_driver,
     COMPENSATE_GRAVITY_(compensate_gravity),
     CTRL_DIM_(NUM_OF_CONSTRAINTS_, false), POS_TUBE_DIM_(NUM_OF_CONSTRAINTS_, false),
     MOTION_CTRL_DIM_(NUM_OF_CONSTRAINTS_, false), FORCE_CTRL_DIM_(NUM_OF_CONSTRAINTS_, false),
-    stop_motion_setpoint_array_(0, std::deque<double>(0, 0.0)),
     fsm_result_(task_status::NOMINAL), fsm_force_task_result_(task_status::APPROACH),
     previous_task_status_(fsm_result_), tube_section_count_(0), 
     transform_drivers_(false), transform_force_drivers_(false),
@@ -61,6 +118,12 @@ dynamics_controller::dynamics_controller(robot_mediator *robot_driver,
     JOINT_STOPPING_TORQUE_LIMITS_(robot_driver_->get_joint_stopping_torque_limits()),
     JOINT_INERTIA_(robot_driver_->get_joint_inertia()),
     ROOT_ACC_(robot_driver_->get_root_acceleration()),
+    braking_planner_(JOINT_ACC_LIMITS_, dynamics_parameter::STOPPING_MOTION_MAX_JERK, dynamics_parameter::LOWER_DECELERATION_RAMP_THRESHOLD),
+    task_queue_(dynamics_parameter::TASK_QUEUE_CAPACITY), desired_motion_profile_(m_profile::CONSTANT),
+    blend_start_torque_(NUM_OF_JOINTS_), blend_start_time_sec_(0.0), blend_time_sec_(0.0),
+    parameter_store_(NUM_OF_CONSTRAINTS_, NUM_OF_JOINTS_), parameter_mode_(parameter_mode::NOMINAL_PARAMETERS), log_parameter_header_(false),
+    abag_warm_start_(NUM_OF_CONSTRAINTS_), warm_start_abag_(false), abag_state_file_(""), tool_name_(""),
+    warm_start_bias_(Eigen::VectorXd::Zero(NUM_OF_CONSTRAINTS_)), warm_start_gain_(Eigen::VectorXd::Zero(NUM_OF_CONSTRAINTS_)),
     current_error_twist_(KDL::Twist::Zero()),
     abag_error_vector_(Eigen::VectorXd::Zero(NUM_OF_CONSTRAINTS_)),
     null_space_abag_error_(Eigen::VectorXd::Zero(1)),
@@ -68,14 +131,12 @@ dynamics_controller::dynamics_controller(robot_mediator *robot_driver,
     predicted_error_twist_(Eigen::VectorXd::Zero(NUM_OF_CONSTRAINTS_)),
     compensation_error_(Eigen::VectorXd::Zero(NUM_OF_CONSTRAINTS_)),
     horizon_amplitude_(1.0), null_space_abag_command_(0.0), 
-    null_space_angle_(0.0), desired_null_space_angle_(0.0), updated_mass_estimation_(0.0),
+    null_space_angle_(0.0), desired_null_space_angle_(0.0), updated_mass_estimation_(0.0), null_space_tolerance_(0.0),
     abag_command_(Eigen::VectorXd::Zero(NUM_OF_CONSTRAINTS_)),
     abag_stop_motion_command_(Eigen::VectorXd::Zero(NUM_OF_JOINTS_)),
     max_command_(Eigen::VectorXd::Zero(NUM_OF_CONSTRAINTS_)),
     compensation_parameters_(Eigen::VectorXd::Constant(12, 0.0)),
     null_space_parameters_(Eigen::VectorXd::Constant(6, 0.1)),
-    force_task_parameters_(Eigen::VectorXd::Zero(NUM_OF_CONSTRAINTS_)),
-    min_sat_limits_(Eigen::VectorXd::Zero(NUM_OF_CONSTRAINTS_)),
     filtered_bias_(Eigen::VectorXd::Zero(NUM_OF_CONSTRAINTS_)),
     cart_force_command_(NUM_OF_SEGMENTS_, KDL::Wrench::Zero()), 
     zero_wrenches_full_model_(robot_chain_full_.getNrOfSegments(), KDL::Wrench::Zero()),
@@ -91,10 +152,11 @@ dynamics_controller::dynamics_controller(robot_mediator *robot_driver,
     wrench_estimation_gain_(NUM_OF_JOINTS_), tool_tip_frame_full_model_(KDL::Frame::Identity()),
     fk_vereshchagin_(robot_chain_), safety_monitor_(robot_driver_, true), jacobian_solver_(robot_chain_full_),
     fsm_(NUM_OF_JOINTS_, NUM_OF_SEGMENTS_, NUM_OF_FRAMES_, NUM_OF_CONSTRAINTS_),
-    abag_(NUM_OF_CONSTRAINTS_), abag_null_space_(1), abag_stop_motion_(NUM_OF_JOINTS_), predictor_(robot_chain_),
+    abag_(NUM_OF_CONSTRAINTS_), abag_null_space_(1), abag_stop_motion_(NUM_OF_JOINTS_), 
+    predictor_(robot_chain_, JOINT_INERTIA_, JOINT_TORQUE_LIMITS_, COMPENSATE_GRAVITY_? KDL::Twist::Zero() : ROOT_ACC_),
     robot_state_(NUM_OF_JOINTS_, NUM_OF_SEGMENTS_, NUM_OF_FRAMES_, NUM_OF_CONSTRAINTS_),
     robot_state_base_(robot_state_), desired_state_(robot_state_),
-    desired_state_base_(robot_state_), predicted_state_(robot_state_), predicted_states_(2, robot_state_),
+    desired_state_base_(robot_state_), predicted_state_(robot_state_), predicted_states_(dynamics_parameter::SAFETY_HORIZON_MAX_STEPS, robot_state_),
     WRITE_FORMAT_STOP_MOTION(Eigen::IOFormat(6, Eigen::DontAlignCols, " ", "", "", "\n"))
 {
     assert(("Robot is not initialized", robot_driver_->is_initialized()));
@@ -124,6 +186,20 @@ dynamics_controller::dynamics_controller(robot_mediator *robot_driver,
     error_logger_.error_source_ = error_source::empty;
     error_logger_.error_status_ = 0;
 
+    reset_lazy_dynamics_cache(mass_cache_);
+    reset_lazy_dynamics_cache(gravity_cache_);
+
+    path_stream_.loader         = nullptr;
+    path_stream_.last_point     = KDL::Vector::Zero();
+    path_stream_.built_sections = 0;
+    path_stream_points_         = std::vector< std::vector<double> >(dynamics_parameter::PATH_STREAM_WINDOW + 1, std::vector<double>(3, 0.0));
+
+    active_task_ = std::make_shared< fixed_frame_task<&dynamics_controller::compute_full_pose_task_error> >(*this, full_pose_task_.tf_pose.M);
+
+    // Null-space saturation limits are not part of the parameter sets
+    abag_null_space_.set_min_bias_sat_limit((Eigen::VectorXd(1) << -1.0).finished());
+    abag_null_space_.set_min_command_sat_limit((Eigen::VectorXd(1) << -1.0).finished());
+
     // Clear Acceleration-Constraint task driver
     define_ee_acc_constraint(std::vector<bool>{false, false, false, // Linear
                                                false, false, false}, // Angular
@@ -134,6 +210,24 @@ dynamics_controller::dynamics_controller(robot_mediator *robot_driver,
                                                  0.0, 0.0, 0.0}); // Angular
     // Clear Feedforward-torques task driver
     define_feedforward_torque(std::vector<double>{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0});
+
+    // Task definitions start from the initial state; each define_*_task then changes only its own part
+    defined_task_.task_model                 = desired_task_model_;
+    defined_task_.task                       = active_task_;
+    defined_task_.ctrl_dim                   = CTRL_DIM_;
+    defined_task_.pos_tube_dim               = POS_TUBE_DIM_;
+    defined_task_.motion_ctrl_dim            = MOTION_CTRL_DIM_;
+    defined_task_.force_ctrl_dim             = FORCE_CTRL_DIM_;
+    defined_task_.desired_pose               = desired_state_.frame_pose[END_EFF_];
+    defined_task_.desired_velocity           = desired_state_.frame_velocity[END_EFF_];
+    defined_task_.desired_force              = desired_state_.external_force[END_EFF_];
+    defined_task_.transform_drivers          = transform_drivers_;
+    defined_task_.transform_force_drivers    = transform_force_drivers_;
+    defined_task_.compute_null_space_command = compute_null_space_command_;
+    defined_task_.compensate_unknown_weight  = compensate_unknown_weight_;
+    defined_task_.desired_null_space_angle   = desired_null_space_angle_;
+    defined_task_.blend_time_sec             = 0.0;
+    defined_task_.path_stream                = path_stream_;
 }
 
 //Print information about controller settings
@@ -241,31 +335,31 @@ int dynamics_controller::check_fsm_status()
     switch (fsm_result_)
     {
         case task_status::NOMINAL:
-            if (previous_task_status_ != task_status::NOMINAL) printf("Control status changed to NOMINAL\n");
+            if (previous_task_status_ != task_status::NOMINAL) rt_event::publish(rt_event::FSM_TRANSITION, rt_event::STATUS_CHANGED, fsm_result_, previous_task_status_);
             previous_task_status_ = fsm_result_;
             return 0;
             break;
         
         case task_status::START_TO_CRUISE:
-            if (previous_task_status_ != task_status::START_TO_CRUISE) printf("Control status changed to START_TO_CRUISE\n");
+            if (previous_task_status_ != task_status::START_TO_CRUISE) rt_event::publish(rt_event::FSM_TRANSITION, rt_event::STATUS_CHANGED, fsm_result_, previous_task_status_);
             previous_task_status_ = fsm_result_;
             return 0;
             break;
 
         case task_status::CRUISE_TO_STOP:
-            if (previous_task_status_ != task_status::CRUISE_TO_STOP) printf("Control status changed to CRUISE_TO_STOP\n");
+            if (previous_task_status_ != task_status::CRUISE_TO_STOP) rt_event::publish(rt_event::FSM_TRANSITION, rt_event::STATUS_CHANGED, fsm_result_, previous_task_status_);
             previous_task_status_ = fsm_result_;
             return 0;
             break;
 
         case task_status::CRUISE_THROUGH_TUBE:
-            if ((previous_task_status_ != task_status::CRUISE_THROUGH_TUBE) && (previous_task_status_ != task_status::CHANGE_TUBE_SECTION)) printf("Control status changed to CRUISE_THROUGH_TUBE\n");
+            if ((previous_task_status_ != task_status::CRUISE_THROUGH_TUBE) && (previous_task_status_ != task_status::CHANGE_TUBE_SECTION)) rt_event::publish(rt_event::FSM_TRANSITION, rt_event::STATUS_CHANGED, fsm_result_, previous_task_status_);
             previous_task_status_ = fsm_result_;
             return 0;
             break;
         
         case task_status::CRUISE:
-            if (previous_task_status_ != task_status::CRUISE) printf("Control status changed to CRUISE\n");
+            if (previous_task_status_ != task_status::CRUISE) rt_event::publish(rt_event::FSM_TRANSITION, rt_event::STATUS_CHANGED, fsm_result_, previous_task_status_);
             previous_task_status_ = fsm_result_;
             return 0;
             break;
@@ -277,13 +371,13 @@ int dynamics_controller::check_fsm_status()
             break;
 
         case task_status::APPROACH:
-            if (previous_task_status_ != task_status::APPROACH) printf("Control status changed to APPROACH\n");
+            if (previous_task_status_ != task_status::APPROACH) rt_event::publish(rt_event::FSM_TRANSITION, rt_event::STATUS_CHANGED, fsm_result_, previous_task_status_);
             previous_task_status_ = fsm_result_;
             return 0;
             break;
 
         case task_status::STOP_ROBOT:
-            if (previous_task_status_ != task_status::STOP_ROBOT) printf("Control status changed to STOP_ROBOT\n");
+            if (previous_task_status_ != task_status::STOP_ROBOT) rt_event::publish(rt_event::FSM_TRANSITION, rt_event::STATUS_CHANGED, fsm_result_, previous_task_status_);
             previous_task_status_ = fsm_result_;
             return 1;
             break;
@@ -458,81 +552,48 @@ void dynamics_controller::define_moveConstrained_follow_path_task(
     assert(tube_path_points[0].size()  == 3);
     assert(task_frame_poses[0].size()  == 12);
 
-    moveConstrained_follow_path_task_.tf_poses   = std::vector<KDL::Frame>(tube_path_points.size() - 1);
-    moveConstrained_follow_path_task_.goal_poses = moveConstrained_follow_path_task_.tf_poses;
+    defined_task_.moveConstrained_follow_path.tf_poses   = std::vector<KDL::Frame>(tube_path_points.size() - 1);
+    defined_task_.moveConstrained_follow_path.goal_poses = defined_task_.moveConstrained_follow_path.tf_poses;
 
-    CTRL_DIM_           = constraint_direction;
-    POS_TUBE_DIM_[0]    = CTRL_DIM_[0]; POS_TUBE_DIM_[1]    = CTRL_DIM_[1];
-    MOTION_CTRL_DIM_[0] = CTRL_DIM_[0]; MOTION_CTRL_DIM_[1] = CTRL_DIM_[1];
-    FORCE_CTRL_DIM_[3]  = CTRL_DIM_[3]; FORCE_CTRL_DIM_[4]  = CTRL_DIM_[4];
+    defined_task_.ctrl_dim           = constraint_direction;
+    defined_task_.pos_tube_dim[0]    = defined_task_.ctrl_dim[0]; defined_task_.pos_tube_dim[1]    = defined_task_.ctrl_dim[1];
+    defined_task_.motion_ctrl_dim[0] = defined_task_.ctrl_dim[0]; defined_task_.motion_ctrl_dim[1] = defined_task_.ctrl_dim[1];
+    defined_task_.force_ctrl_dim[3]  = defined_task_.ctrl_dim[3]; defined_task_.force_ctrl_dim[4]  = defined_task_.ctrl_dim[4];
 
     // Reset the motion and force flags. Each will be later set by a different task stage
-    FORCE_CTRL_DIM_ [2] = false;
-    MOTION_CTRL_DIM_[2] = false;
-    MOTION_CTRL_DIM_[5] = false;
+    defined_task_.force_ctrl_dim [2] = false;
+    defined_task_.motion_ctrl_dim[2] = false;
+    defined_task_.motion_ctrl_dim[5] = false;
 
     // X-Y-Z linear
-    KDL::Vector x_world(1.0, 0.0, 0.0);
-    std::vector<double> task_frame_pose(12, 0.0);
-    // KDL::Rotation task_orientation = KDL::Rotation::EulerZYZ(0.0, 0.0, -M_PI/4);
     for (int i = 0; (unsigned)i < tube_path_points.size() - 1; i++)
     {
         KDL::Vector tube_start_position = KDL::Vector(tube_path_points[i    ][0], tube_path_points[i    ][1], tube_path_points[i    ][2]);
         KDL::Vector tf_position         = KDL::Vector(tube_path_points[i + 1][0], tube_path_points[i + 1][1], tube_path_points[i + 1][2]);
+        KDL::Frame tf_pose              = compute_tube_section_frame(tube_start_position, tf_position);
 
-        // tube_start_position = task_orientation * tube_start_position;
-        // tf_position         = task_orientation * tf_position;
-
-        KDL::Vector x_task  = tf_position - tube_start_position;
-        x_task.Normalize();
-
-        KDL::Vector cross_product = x_world * x_task;
-        double cosine             = dot(x_world, x_task);
-        double sine               = cross_product.Norm();
-        double angle              = atan2(sine, cosine);
-
-        task_frame_pose[0] = tf_position[0]; 
-        task_frame_pose[1] = tf_position[1]; 
-        task_frame_pose[2] = tf_position[2];
+        for (int k = 0; k < 3; k++) task_frame_poses[i][k]     = tf_position[k];
+        for (int k = 0; k < 9; k++) task_frame_poses[i][k + 3] = tf_pose.M.data[k];
 
-        KDL::Rotation tf_orientation;
-        if (cosine < (-1 + 1e-6))
-        {
-            tf_orientation = KDL::Rotation::EulerZYZ(M_PI, 0.0, 0.0);
-            task_frame_pose[3] = -1.0; task_frame_pose[4]  =  0.0; task_frame_pose[5]  = 0.0;
-            task_frame_pose[6] =  0.0; task_frame_pose[7]  = -1.0; task_frame_pose[8]  = 0.0;
-            task_frame_pose[9] =  0.0; task_frame_pose[10] =  0.0; task_frame_pose[11] = 1.0;
-        }
-        else if (sine < 1e-6)
-        {
-            tf_orientation = KDL::Rotation::Identity();
-            task_frame_pose[3] = 1.0; task_frame_pose[4]  = 0.0; task_frame_pose[5]  = 0.0;
-            task_frame_pose[6] = 0.0; task_frame_pose[7]  = 1.0; task_frame_pose[8]  = 0.0;
-            task_frame_pose[9] = 0.0; task_frame_pose[10] = 0.0; task_frame_pose[11] = 1.0;
-        }
-        else
-        {
-            tf_orientation = geometry::exp_map_so3(cross_product / sine * angle);
-            task_frame_pose[3] = tf_orientation.data[0]; task_frame_pose[4]  = tf_orientation.data[1]; task_frame_pose[5]  = tf_orientation.data[2];
-            task_frame_pose[6] = tf_orientation.data[3]; task_frame_pose[7]  = tf_orientation.data[4]; task_frame_pose[8]  = tf_orientation.data[5];
-            task_frame_pose[9] = tf_orientation.data[6]; task_frame_pose[10] = tf_orientation.data[7]; task_frame_pose[11] = tf_orientation.data[8];
-        }
-
-        task_frame_poses[i]                             = task_frame_pose;
-        moveConstrained_follow_path_task_.tf_poses[i]   = KDL::Frame(tf_orientation, tf_position);
-        moveConstrained_follow_path_task_.goal_poses[i] = KDL::Frame::Identity();
+        defined_task_.moveConstrained_follow_path.tf_poses[i]   = tf_pose;
+        defined_task_.moveConstrained_follow_path.goal_poses[i] = KDL::Frame::Identity();
     }
-
-    moveConstrained_follow_path_task_.tube_path_points             = tube_path_points;
-    moveConstrained_follow_path_task_.tube_tolerances              = tube_tolerances;
-    moveConstrained_follow_path_task_.tube_speed                   = tube_speed;
-    moveConstrained_follow_path_task_.tube_force                   = tube_force;
-    moveConstrained_follow_path_task_.contact_threshold_linear     = contact_threshold_linear;
-    moveConstrained_follow_path_task_.contact_threshold_angular    = contact_threshold_angular;
-    moveConstrained_follow_path_task_.time_limit                   = task_time_limit_sec;
-    moveConstrained_follow_path_task_.tf_force                     = KDL::Rotation::Identity();
-    moveConstrained_follow_path_task_.null_space_plane_orientation = KDL::Rotation::Identity();
-    moveConstrained_follow_path_task_.null_space_force_direction   = KDL::Vector::Zero();
+    defined_task_.moveConstrained_follow_path.num_of_sections = tube_path_points.size() - 1;
+    defined_task_.path_stream.loader = nullptr;
+    defined_task_.spline_frames.path.reset();
+
+    defined_task_.moveConstrained_follow_path.tube_path_points             = tube_path_points;
+    defined_task_.moveConstrained_follow_path.tube_tolerances              = tube_tolerances;
+    defined_task_.moveConstrained_follow_path.tube_speed                   = tube_speed;
+    defined_task_.moveConstrained_follow_path.tube_force                   = tube_force;
+    defined_task_.moveConstrained_follow_path.contact_threshold_linear     = contact_threshold_linear;
+    defined_task_.moveConstrained_follow_path.contact_threshold_angular    = contact_threshold_angular;
+    defined_task_.moveConstrained_follow_path.time_limit                   = task_time_limit_sec;
+    defined_task_.moveConstrained_follow_path.tf_force                     = KDL::Rotation::Identity();
+    defined_task_.moveConstrained_follow_path.null_space_plane_orientation = KDL::Rotation::Identity();
+    defined_task_.moveConstrained_follow_path.null_space_force_direction   = KDL::Vector::Zero();
+    compute_path_speed_profile(tube_path_points, tube_speed, tube_tolerances[1], tube_tolerances[0], defined_task_.moveConstrained_follow_path.speed_profile);
+    defined_task_.projection.build(tube_path_points, dynamics_parameter::PATH_PROJECTION_HYSTERESIS);
 
     /**
      * Compute tranformation from the tool-tip to the end-effector frame.
@@ -541,24 +602,26 @@ void dynamics_controller::define_moveConstrained_follow_path_task(
     */
     KDL::Frame end_eff_frame;
     KDL::Frame tool_tip_frame;
-    fk_pos_solver_->JntToCart(KDL::JntArray(NUM_OF_JOINTS_), end_eff_frame);
-    fk_pos_solver_full_->JntToCart(KDL::JntArray(NUM_OF_JOINTS_), tool_tip_frame);
-    moveConstrained_follow_path_task_.end_eff_wrt_tool_tip = tool_tip_frame.Inverse() * end_eff_frame;
+    // Local solvers, as the control loop may be running with the member ones
+    KDL::ChainFkSolverPos_recursive(robot_chain_).JntToCart(KDL::JntArray(NUM_OF_JOINTS_), end_eff_frame);
+    KDL::ChainFkSolverPos_recursive(robot_chain_full_).JntToCart(KDL::JntArray(NUM_OF_JOINTS_), tool_tip_frame);
+    defined_task_.moveConstrained_follow_path.end_eff_wrt_tool_tip = tool_tip_frame.Inverse() * end_eff_frame;
 
     // Set null-space error tolerance; small null-space oscillations are desired in this mode
-    moveConstrained_follow_path_task_.null_space_tolerance = moveConstrained_follow_path_task_.tube_tolerances[5];
-
-    desired_state_.frame_pose[END_EFF_]        = moveConstrained_follow_path_task_.goal_poses[0];
-    desired_task_model_                        = task_model::moveConstrained_follow_path;
-    desired_state_.frame_velocity[END_EFF_](0) = tube_speed;
-    desired_state_.frame_velocity[END_EFF_](5) = 0.0;
-    desired_state_.external_force[END_EFF_](2) = tube_force; // Sensor/tool frame
-    desired_state_.external_force[END_EFF_](3) = 0.0; // Sensor/tool frame
-    desired_state_.external_force[END_EFF_](4) = 0.0; // Sensor/tool frame
-    compute_null_space_command_ = control_null_space;
-    desired_null_space_angle_   = desired_null_space_angle;
-    transform_force_drivers_    = true;
-    compensate_unknown_weight_  = false;
+    defined_task_.moveConstrained_follow_path.null_space_tolerance = defined_task_.moveConstrained_follow_path.tube_tolerances[5];
+
+    defined_task_.desired_pose               = defined_task_.moveConstrained_follow_path.goal_poses[0];
+    defined_task_.task_model                 = task_model::moveConstrained_follow_path;
+    defined_task_.task                       = std::make_shared<moveConstrained_follow_path_control_task>(*this);
+    defined_task_.desired_velocity(0)        = tube_speed;
+    defined_task_.desired_velocity(5)        = 0.0;
+    defined_task_.desired_force(2)           = tube_force; // Sensor/tool frame
+    defined_task_.desired_force(3)           = 0.0; // Sensor/tool frame
+    defined_task_.desired_force(4)           = 0.0; // Sensor/tool frame
+    defined_task_.compute_null_space_command = control_null_space;
+    defined_task_.desired_null_space_angle   = desired_null_space_angle;
+    defined_task_.transform_force_drivers    = true;
+    defined_task_.compensate_unknown_weight  = false;
 }
 
 void dynamics_controller::define_moveTo_follow_path_task(
@@ -579,80 +642,280 @@ void dynamics_controller::define_moveTo_follow_path_task(
     assert(tube_path_points[0].size()  == 3);
     assert(task_frame_poses[0].size()  == 12);
 
-    moveTo_follow_path_task_.tf_poses   = std::vector<KDL::Frame>(tube_path_points.size() - 1);
-    moveTo_follow_path_task_.goal_poses = moveTo_follow_path_task_.tf_poses;
+    defined_task_.moveTo_follow_path.tf_poses   = std::vector<KDL::Frame>(tube_path_points.size() - 1);
+    defined_task_.moveTo_follow_path.goal_poses = defined_task_.moveTo_follow_path.tf_poses;
 
-    CTRL_DIM_ = constraint_direction;
-    MOTION_CTRL_DIM_ = CTRL_DIM_;
+    defined_task_.ctrl_dim        = constraint_direction;
+    defined_task_.motion_ctrl_dim = defined_task_.ctrl_dim;
 
     // X-Y-Z linear
-    KDL::Vector x_world(1.0, 0.0, 0.0);
-    std::vector<double> task_frame_pose(12, 0.0);
-
     for (int i = 0; (unsigned)i < tube_path_points.size() - 1; i++)
     {
         KDL::Vector tube_start_position = KDL::Vector(tube_path_points[i    ][0], tube_path_points[i    ][1], tube_path_points[i    ][2]);
         KDL::Vector tf_position         = KDL::Vector(tube_path_points[i + 1][0], tube_path_points[i + 1][1], tube_path_points[i + 1][2]);
-        KDL::Vector x_task              = tf_position - tube_start_position;
-        x_task.Normalize();
+        KDL::Frame tf_pose              = compute_tube_section_frame(tube_start_position, tf_position);
 
-        KDL::Vector cross_product = x_world * x_task;
-        double cosine             = dot(x_world, x_task);
-        double sine               = cross_product.Norm();
-        double angle              = atan2(sine, cosine);
+        for (int k = 0; k < 3; k++) task_frame_poses[i][k]     = tf_position[k];
+        for (int k = 0; k < 9; k++) task_frame_poses[i][k + 3] = tf_pose.M.data[k];
+
+        defined_task_.moveTo_follow_path.tf_poses[i]   = tf_pose;
+        defined_task_.moveTo_follow_path.goal_poses[i] = KDL::Frame::Identity();
+    }
+    defined_task_.moveTo_follow_path.num_of_sections = tube_path_points.size() - 1;
+    defined_task_.path_stream.loader = nullptr;
+    defined_task_.spline_frames.path.reset();
+
+    defined_task_.moveTo_follow_path.tube_path_points          = tube_path_points;
+    defined_task_.moveTo_follow_path.tube_tolerances           = tube_tolerances;
+    defined_task_.moveTo_follow_path.tube_speed                = tube_speed;
+    defined_task_.moveTo_follow_path.contact_threshold_linear  = contact_threshold_linear;
+    defined_task_.moveTo_follow_path.contact_threshold_angular = contact_threshold_angular;
+    defined_task_.moveTo_follow_path.time_limit                = task_time_limit_sec;
+    compute_path_speed_profile(tube_path_points, tube_speed, std::min(tube_tolerances[1], tube_tolerances[2]), tube_tolerances[0], defined_task_.moveTo_follow_path.speed_profile);
+    defined_task_.projection.build(tube_path_points, dynamics_parameter::PATH_PROJECTION_HYSTERESIS);
+    
+    // Set null-space error tolerance; small null-space oscillations are desired in this mode
+    defined_task_.moveTo_follow_path.null_space_force_direction = KDL::Vector::Zero();
+    defined_task_.moveTo_follow_path.null_space_tolerance       = tube_tolerances[7];
+
+    defined_task_.desired_pose               = defined_task_.moveTo_follow_path.goal_poses[0];
+    defined_task_.task_model                 = task_model::moveTo_follow_path;
+    defined_task_.task                       = std::make_shared<moveTo_follow_path_control_task>(*this);
+    defined_task_.transform_drivers          = true;
+    defined_task_.transform_force_drivers    = false;
+    defined_task_.compute_null_space_command = control_null_space;
+    defined_task_.desired_null_space_angle   = desired_null_space_angle;
+    defined_task_.compensate_unknown_weight  = false;
+}
 
-        task_frame_pose[0] = tf_position[0]; 
-        task_frame_pose[1] = tf_position[1]; 
-        task_frame_pose[2] = tf_position[2];
 
-        KDL::Rotation tf_orientation;
-        if(cosine < (-1 + 1e-6))
-        {
-            tf_orientation = KDL::Rotation::EulerZYZ(M_PI, 0.0, 0.0);
-            task_frame_pose[3] = -1.0; task_frame_pose[4]  =  0.0; task_frame_pose[5]  = 0.0;
-            task_frame_pose[6] =  0.0; task_frame_pose[7]  = -1.0; task_frame_pose[8]  = 0.0;
-            task_frame_pose[9] =  0.0; task_frame_pose[10] =  0.0; task_frame_pose[11] = 1.0;
-        }
-        else if(sine < 1e-6)
-        {
-            tf_orientation = KDL::Rotation::Identity();
-            task_frame_pose[3] = 1.0; task_frame_pose[4]  = 0.0; task_frame_pose[5]  = 0.0;
-            task_frame_pose[6] = 0.0; task_frame_pose[7]  = 1.0; task_frame_pose[8]  = 0.0;
-            task_frame_pose[9] = 0.0; task_frame_pose[10] = 0.0; task_frame_pose[11] = 1.0;
-        }
-        else
-        {
-            tf_orientation = geometry::exp_map_so3(cross_product / sine * angle);
-            task_frame_pose[3] = tf_orientation.data[0]; task_frame_pose[4]  = tf_orientation.data[1]; task_frame_pose[5]  = tf_orientation.data[2];
-            task_frame_pose[6] = tf_orientation.data[3]; task_frame_pose[7]  = tf_orientation.data[4]; task_frame_pose[8]  = tf_orientation.data[5];
-            task_frame_pose[9] = tf_orientation.data[6]; task_frame_pose[10] = tf_orientation.data[7]; task_frame_pose[11] = tf_orientation.data[8];
-        }
+void dynamics_controller::define_moveConstrained_follow_path_task(
+                                const std::vector<bool> &constraint_direction,
+                                const spline_path &tube_path,
+                                const std::vector<double> &tube_tolerances,
+                                const double tube_speed,
+                                const double tube_force,
+                                const double contact_threshold_linear,
+                                const double contact_threshold_angular,
+                                const double task_time_limit_sec,
+                                const bool control_null_space,
+                                const double desired_null_space_angle,
+                                std::vector< std::vector<double> > &task_frame_poses)
+{
+    // Y position is the only position tube in this task; Z is force-controlled
+    std::vector< std::vector<double> > tube_path_points;
+    std::vector<double> arc_lengths;
+    tube_path.sample_points(tube_tolerances[1], tube_path_points, arc_lengths);
+    task_frame_poses.assign(tube_path_points.size() - 1, std::vector<double>(12, 0.0));
+
+    define_moveConstrained_follow_path_task(constraint_direction, tube_path_points, tube_tolerances, tube_speed, tube_force,
+                                            contact_threshold_linear, contact_threshold_angular, task_time_limit_sec,
+                                            control_null_space, desired_null_space_angle, task_frame_poses);
+    define_spline_task_frames(tube_path, arc_lengths, defined_task_.moveConstrained_follow_path.tf_poses, task_frame_poses);
+}
+
+void dynamics_controller::define_moveTo_follow_path_task(
+                                const std::vector<bool> &constraint_direction,
+                                const spline_path &tube_path,
+                                const std::vector<double> &tube_tolerances,
+                                const double tube_speed,
+                                const double contact_threshold_linear,
+                                const double contact_threshold_angular,
+                                const double task_time_limit_sec,
+                                const bool control_null_space,
+                                const double desired_null_space_angle,
+                                std::vector< std::vector<double> > &task_frame_poses)
+{
+    std::vector< std::vector<double> > tube_path_points;
+    std::vector<double> arc_lengths;
+    tube_path.sample_points(std::min(tube_tolerances[1], tube_tolerances[2]), tube_path_points, arc_lengths);
+    task_frame_poses.assign(tube_path_points.size() - 1, std::vector<double>(12, 0.0));
+
+    define_moveTo_follow_path_task(constraint_direction, tube_path_points, tube_tolerances, tube_speed,
+                                   contact_threshold_linear, contact_threshold_angular, task_time_limit_sec,
+                                   control_null_space, desired_null_space_angle, task_frame_poses);
+    define_spline_task_frames(tube_path, arc_lengths, defined_task_.moveTo_follow_path.tf_poses, task_frame_poses);
+}
 
-        task_frame_poses[i]                        = task_frame_pose;
-        moveTo_follow_path_task_.tf_poses[i]       = KDL::Frame(tf_orientation, tf_position);
-        moveTo_follow_path_task_.goal_poses[i]     = KDL::Frame::Identity();
+/**
+ * Task frames of a spline path: rotation from the curve's tangent instead of the chords.
+ * The control loop re-evaluates it at the robot's position, see compute_spline_section_frame.
+ */
+void dynamics_controller::define_spline_task_frames(const spline_path &tube_path,
+                                                    const std::vector<double> &arc_lengths,
+                                                    std::vector<KDL::Frame> &tf_poses,
+                                                    std::vector< std::vector<double> > &task_frame_poses)
+{
+    for (int i = 0; (unsigned)i < tf_poses.size(); i++)
+    {
+        tf_poses[i].M = conversions::eigen_to_rotation(tube_path.get_task_frame(arc_lengths[i + 1]));
+        for (int k = 0; k < 9; k++) task_frame_poses[i][k + 3] = tf_poses[i].M.data[k];
     }
 
-    moveTo_follow_path_task_.tube_path_points          = tube_path_points;
-    moveTo_follow_path_task_.tube_tolerances           = tube_tolerances;
-    moveTo_follow_path_task_.tube_speed                = tube_speed;
-    moveTo_follow_path_task_.contact_threshold_linear  = contact_threshold_linear;
-    moveTo_follow_path_task_.contact_threshold_angular = contact_threshold_angular;
-    moveTo_follow_path_task_.time_limit                = task_time_limit_sec;
-    
-    // Set null-space error tolerance; small null-space oscillations are desired in this mode
-    moveTo_follow_path_task_.null_space_force_direction = KDL::Vector::Zero();
-    moveTo_follow_path_task_.null_space_tolerance       = tube_tolerances[7];
+    defined_task_.spline_frames.path        = std::make_shared<const spline_path>(tube_path);
+    defined_task_.spline_frames.arc_lengths = arc_lengths;
+}
+
+int dynamics_controller::define_moveConstrained_follow_path_task(
+                                const std::vector<bool> &constraint_direction,
+                                path_loader &tube_path,
+                                const std::vector<double> &tube_tolerances,
+                                const double tube_speed,
+                                const double tube_force,
+                                const double contact_threshold_linear,
+                                const double contact_threshold_angular,
+                                const double task_time_limit_sec,
+                                const bool control_null_space,
+                                const double desired_null_space_angle)
+{
+    std::vector< std::vector<double> > tube_path_points;
+    const int num_of_points = load_path_stream(tube_path, tube_path_points);
+    if (num_of_points < 2) return -1;
+
+    std::vector< std::vector<double> > task_frame_poses(num_of_points - 1, std::vector<double>(12, 0.0));
+
+    define_moveConstrained_follow_path_task(constraint_direction, tube_path_points, tube_tolerances, tube_speed, tube_force,
+                                            contact_threshold_linear, contact_threshold_angular, task_time_limit_sec,
+                                            control_null_space, desired_null_space_angle, task_frame_poses);
+
+    // Remaining sections are built while the robot moves; the profile needs the full path
+    if (num_of_points != tube_path.get_number_of_points())
+    {
+        defined_task_.path_stream.loader                          = &tube_path;
+        defined_task_.moveConstrained_follow_path.num_of_sections = get_number_of_path_sections(tube_path);
+        defined_task_.moveConstrained_follow_path.speed_profile   = path_speed_profile();
+    }
+    return 0;
+}
+
+int dynamics_controller::define_moveTo_follow_path_task(
+                                const std::vector<bool> &constraint_direction,
+                                path_loader &tube_path,
+                                const std::vector<double> &tube_tolerances,
+                                const double tube_speed,
+                                const double contact_threshold_linear,
+                                const double contact_threshold_angular,
+                                const double task_time_limit_sec,
+                                const bool control_null_space,
+                                const double desired_null_space_angle)
+{
+    std::vector< std::vector<double> > tube_path_points;
+    const int num_of_points = load_path_stream(tube_path, tube_path_points);
+    if (num_of_points < 2) return -1;
+
+    std::vector< std::vector<double> > task_frame_poses(num_of_points - 1, std::vector<double>(12, 0.0));
+
+    define_moveTo_follow_path_task(constraint_direction, tube_path_points, tube_tolerances, tube_speed,
+                                   contact_threshold_linear, contact_threshold_angular, task_time_limit_sec,
+                                   control_null_space, desired_null_space_angle, task_frame_poses);
+
+    if (num_of_points != tube_path.get_number_of_points())
+    {
+        defined_task_.path_stream.loader                 = &tube_path;
+        defined_task_.moveTo_follow_path.num_of_sections = get_number_of_path_sections(tube_path);
+        defined_task_.moveTo_follow_path.speed_profile   = path_speed_profile();
+    }
+    return 0;
+}
+
+/**
+ * Reads the first chunk of a path file: at most one window of tube sections.
+ * Returns the number of points read. The chunk buffer of the control loop is not used here.
+ */
+int dynamics_controller::load_path_stream(path_loader &tube_path, std::vector< std::vector<double> > &tube_path_points)
+{
+    if (!tube_path.is_open())
+    {
+        printf("Path file is not open\n");
+        return -1;
+    }
+
+    tube_path_points.assign(dynamics_parameter::PATH_STREAM_WINDOW + 1, std::vector<double>(3, 0.0));
+    const int num_of_points = tube_path.read_points(0, dynamics_parameter::PATH_STREAM_WINDOW + 1, tube_path_points);
+    if (num_of_points < 2) return -1;
+    tube_path_points.resize(num_of_points);
+
+    const std::vector<double> &last_point = tube_path_points[num_of_points - 1];
+    defined_task_.path_stream.last_point     = KDL::Vector(last_point[0], last_point[1], last_point[2]);
+    defined_task_.path_stream.built_sections = num_of_points - 1;
+    return num_of_points;
+}
 
-    desired_state_.frame_pose[END_EFF_]    = moveTo_follow_path_task_.goal_poses[0];
-    desired_task_model_                    = task_model::moveTo_follow_path;
-    transform_drivers_          = true;
-    transform_force_drivers_    = false;
-    compute_null_space_command_ = control_null_space;
-    desired_null_space_angle_   = desired_null_space_angle;
-    compensate_unknown_weight_  = false;
+// Sections of a streamed path. Not known before a CSV file is read to its end: the final section is not reached until then
+int dynamics_controller::get_number_of_path_sections(const path_loader &tube_path) const
+{
+    const int num_of_points = tube_path.get_number_of_points();
+    return (num_of_points < 0)? std::numeric_limits<int>::max() : num_of_points - 1;
 }
 
+/**
+ * Path parameterization for the TIME_OPTIMAL motion profile.
+ * Per segment, the Cartesian limits are reduced by the joint velocity, acceleration and torque limits,
+ * mapped along the segment direction via the Jacobian pseudo-inverse and the joint-space inertia matrix.
+ * No IK is available: joint-space limits are evaluated at the robot's configuration at task definition.
+ */
+void dynamics_controller::compute_path_speed_profile(const std::vector< std::vector<double> > &tube_path_points,
+                                                     const double tube_speed,
+                                                     const double corner_deviation,
+                                                     const double position_tolerance,
+                                                     path_speed_profile &speed_profile)
+{
+    const int num_of_segments = tube_path_points.size() - 1;
+    // Commanded tube speed bounds every segment, thus every vertex and sample of the profile
+    std::vector<double> speed_limits(num_of_segments, std::min(tube_speed, dynamics_parameter::PATH_MAX_LINEAR_VELOCITY));
+    std::vector<double> acceleration_limits(num_of_segments, dynamics_parameter::PATH_MAX_LINEAR_ACCELERATION);
+
+    KDL::JntArray q(NUM_OF_JOINTS_), qd(NUM_OF_JOINTS_), tau(NUM_OF_JOINTS_), gravity(NUM_OF_JOINTS_);
+    KDL::JntSpaceInertiaMatrix mass_matrix(NUM_OF_JOINTS_);
+    KDL::Jacobian jacobian(NUM_OF_JOINTS_);
+    robot_driver_->get_joint_state(q, qd, tau);
+
+    // Tasks are defined outside of the control loop: the member solvers are not used here
+    KDL::ChainJntToJacSolver jacobian_solver(robot_chain_full_);
+    KDL::Solver_Dynamic_Parameter dynamic_parameter_solver(robot_chain_full_, -1 * ROOT_ACC_.vel, JOINT_INERTIA_);
+
+    if ((jacobian_solver.JntToJac(q, jacobian) != 0) || 
+        (dynamic_parameter_solver.JntToMass(q, mass_matrix) != 0) ||
+        (dynamic_parameter_solver.JntToGravity(q, gravity) != 0))
+    {
+        printf("Warning: joint limits are not considered in the path speed profile\n");
+    }
+    else
+    {
+        const std::vector<double> joint_velocity_limits = robot_driver_->get_joint_velocity_limits();
+        Eigen::JacobiSVD<Eigen::MatrixXd> svd(jacobian.data, Eigen::ComputeThinU | Eigen::ComputeThinV);
+        Eigen::VectorXd task_direction = Eigen::VectorXd::Zero(NUM_OF_CONSTRAINTS_);
+
+        for (int i = 0; i < num_of_segments; i++)
+        {
+            for (int k = 0; k < 3; k++) task_direction(k) = tube_path_points[i + 1][k] - tube_path_points[i][k];
+            if (task_direction.norm() < 1e-9) continue;
+            task_direction.normalize();
+
+            // Joint velocities and torques for unit speed/acceleration along the segment
+            Eigen::VectorXd joint_direction  = svd.solve(task_direction);
+            Eigen::VectorXd torque_direction = mass_matrix.data * joint_direction;
+
+            for (int j = 0; j < NUM_OF_JOINTS_; j++)
+            {
+                if (std::fabs(joint_direction(j)) > 1e-9)
+                {
+                    speed_limits[i]        = std::min(speed_limits[i], joint_velocity_limits[j] / std::fabs(joint_direction(j)));
+                    acceleration_limits[i] = std::min(acceleration_limits[i], JOINT_ACC_LIMITS_[j] / std::fabs(joint_direction(j)));
+                }
+
+                double torque_margin = JOINT_TORQUE_LIMITS_[j] - std::fabs(gravity(j));
+                if ((std::fabs(torque_direction(j)) > 1e-9) && (torque_margin > 0.0))
+                    acceleration_limits[i] = std::min(acceleration_limits[i], torque_margin / std::fabs(torque_direction(j)));
+            }
+        }
+    }
+
+    // Minimum speed: the one reached after covering the position tolerance, but not above the nominal tube speed.
+    // Otherwise, the robot could not leave the start of the path
+    const double minimum_speed = std::min(tube_speed, std::sqrt(2.0 * (*std::min_element(acceleration_limits.begin(), acceleration_limits.end())) * position_tolerance));
+    speed_profile.compute(tube_path_points, speed_limits, acceleration_limits, corner_deviation, minimum_speed);
+}
 
 void dynamics_controller::define_moveTo_task(
                                 const std::vector<bool> &constraint_direction,
@@ -671,14 +934,14 @@ void dynamics_controller::define_moveTo_task(
     assert(task_frame_pose.size()      == 12);
     assert(tube_start_position.size()  == 3);
 
-    CTRL_DIM_ = constraint_direction;
-    MOTION_CTRL_DIM_ = CTRL_DIM_;
+    defined_task_.ctrl_dim        = constraint_direction;
+    defined_task_.motion_ctrl_dim = defined_task_.ctrl_dim;
 
     // X-Y-Z linear
     KDL::Vector x_world(1.0, 0.0, 0.0);
     KDL::Vector tf_position = KDL::Vector(task_frame_pose[0], task_frame_pose[1], task_frame_pose[2]);
     KDL::Vector x_task = tf_position - KDL::Vector(tube_start_position[0], tube_start_position[1], tube_start_position[2]);
-    moveTo_task_.tube_length = x_task.Normalize();
+    defined_task_.moveTo.tube_length = x_task.Normalize();
 
     KDL::Vector cross_product = x_world * x_task;
     double cosine             = dot(x_world, x_task);
@@ -708,26 +971,27 @@ void dynamics_controller::define_moveTo_task(
         task_frame_pose[9] = tf_orientation.data[6]; task_frame_pose[10] = tf_orientation.data[7]; task_frame_pose[11] = tf_orientation.data[8];
     }
 
-    moveTo_task_.tf_pose                   = KDL::Frame(tf_orientation, tf_position);
-    moveTo_task_.goal_pose                 = KDL::Frame::Identity();
-    moveTo_task_.tube_start_position       = tube_start_position;
-    moveTo_task_.tube_tolerances           = tube_tolerances;
-    moveTo_task_.tube_speed                = tube_speed;
-    moveTo_task_.contact_threshold_linear  = contact_threshold_linear;
-    moveTo_task_.contact_threshold_angular = contact_threshold_angular;
-    moveTo_task_.time_limit                = task_time_limit_sec;
+    defined_task_.moveTo.tf_pose                   = KDL::Frame(tf_orientation, tf_position);
+    defined_task_.moveTo.goal_pose                 = KDL::Frame::Identity();
+    defined_task_.moveTo.tube_start_position       = tube_start_position;
+    defined_task_.moveTo.tube_tolerances           = tube_tolerances;
+    defined_task_.moveTo.tube_speed                = tube_speed;
+    defined_task_.moveTo.contact_threshold_linear  = contact_threshold_linear;
+    defined_task_.moveTo.contact_threshold_angular = contact_threshold_angular;
+    defined_task_.moveTo.time_limit                = task_time_limit_sec;
 
     // Set null-space error tolerance; small null-space oscillations are desired in this mode
-    moveTo_task_.null_space_force_direction = KDL::Vector::Zero();
-    moveTo_task_.null_space_tolerance       = tube_tolerances[7];
-
-    desired_state_.frame_pose[END_EFF_]    = moveTo_task_.goal_pose;
-    desired_task_model_                    = task_model::moveTo;
-    transform_drivers_          = true;
-    transform_force_drivers_    = false;
-    compute_null_space_command_ = control_null_space;
-    desired_null_space_angle_   = desired_null_space_angle;
-    compensate_unknown_weight_  = false;
+    defined_task_.moveTo.null_space_force_direction = KDL::Vector::Zero();
+    defined_task_.moveTo.null_space_tolerance       = tube_tolerances[7];
+
+    defined_task_.desired_pose               = defined_task_.moveTo.goal_pose;
+    defined_task_.task_model                 = task_model::moveTo;
+    defined_task_.task                       = std::make_shared< fixed_frame_task<&dynamics_controller::compute_moveTo_task_error> >(*this, defined_task_.moveTo.tf_pose.M);
+    defined_task_.transform_drivers          = true;
+    defined_task_.transform_force_drivers    = false;
+    defined_task_.compute_null_space_command = control_null_space;
+    defined_task_.desired_null_space_angle   = desired_null_space_angle;
+    defined_task_.compensate_unknown_weight  = false;
 }
 
 void dynamics_controller::define_moveTo_weight_compensation_task(
@@ -749,8 +1013,8 @@ void dynamics_controller::define_moveTo_weight_compensation_task(
     assert(tube_start_position.size()  == 3);
     printf("Initial End-Effector Mass: %f\n", INITIAL_END_EFF_MASS_);
 
-    CTRL_DIM_ = constraint_direction;
-    MOTION_CTRL_DIM_ = CTRL_DIM_;
+    defined_task_.ctrl_dim        = constraint_direction;
+    defined_task_.motion_ctrl_dim = defined_task_.ctrl_dim;
 
     // X-Y-Z linear
     KDL::Vector x_world(1.0, 0.0, 0.0);
@@ -786,27 +1050,28 @@ void dynamics_controller::define_moveTo_weight_compensation_task(
         task_frame_pose[9] = tf_orientation.data[6]; task_frame_pose[10] = tf_orientation.data[7]; task_frame_pose[11] = tf_orientation.data[8];
     }
 
-    moveTo_weight_compensation_task_.tf_pose                   = KDL::Frame(tf_orientation, tf_position);
-    moveTo_weight_compensation_task_.goal_pose                 = KDL::Frame::Identity();
-    moveTo_weight_compensation_task_.tube_start_position       = tube_start_position;
-    moveTo_weight_compensation_task_.tube_tolerances           = tube_tolerances;
-    moveTo_weight_compensation_task_.tube_speed                = tube_speed;
-    moveTo_weight_compensation_task_.contact_threshold_linear  = contact_threshold_linear;
-    moveTo_weight_compensation_task_.contact_threshold_angular = contact_threshold_angular;
-    moveTo_weight_compensation_task_.time_limit                = task_time_limit_sec;
-    moveTo_weight_compensation_task_.use_mass_alternation      = use_mass_alternation;
+    defined_task_.moveTo_weight_compensation.tf_pose                   = KDL::Frame(tf_orientation, tf_position);
+    defined_task_.moveTo_weight_compensation.goal_pose                 = KDL::Frame::Identity();
+    defined_task_.moveTo_weight_compensation.tube_start_position       = tube_start_position;
+    defined_task_.moveTo_weight_compensation.tube_tolerances           = tube_tolerances;
+    defined_task_.moveTo_weight_compensation.tube_speed                = tube_speed;
+    defined_task_.moveTo_weight_compensation.contact_threshold_linear  = contact_threshold_linear;
+    defined_task_.moveTo_weight_compensation.contact_threshold_angular = contact_threshold_angular;
+    defined_task_.moveTo_weight_compensation.time_limit                = task_time_limit_sec;
+    defined_task_.moveTo_weight_compensation.use_mass_alternation      = use_mass_alternation;
 
     // Set null-space error tolerance; small null-space oscillations are desired in this mode
-    moveTo_weight_compensation_task_.null_space_force_direction = KDL::Vector::Zero();
-    moveTo_weight_compensation_task_.null_space_tolerance       = tube_tolerances[7];
-
-    desired_state_.frame_pose[END_EFF_]    = moveTo_weight_compensation_task_.goal_pose;
-    desired_task_model_                    = task_model::moveTo_weight_compensation;
-    transform_drivers_          = true;
-    transform_force_drivers_    = false;
-    compute_null_space_command_ = control_null_space;
-    desired_null_space_angle_   = desired_null_space_angle;
-    compensate_unknown_weight_  = true;
+    defined_task_.moveTo_weight_compensation.null_space_force_direction = KDL::Vector::Zero();
+    defined_task_.moveTo_weight_compensation.null_space_tolerance       = tube_tolerances[7];
+
+    defined_task_.desired_pose               = defined_task_.moveTo_weight_compensation.goal_pose;
+    defined_task_.task_model                 = task_model::moveTo_weight_compensation;
+    defined_task_.task                       = std::make_shared< fixed_frame_task<&dynamics_controller::compute_moveTo_weight_compensation_task_error> >(*this, defined_task_.moveTo_weight_compensation.tf_pose.M);
+    defined_task_.transform_drivers          = true;
+    defined_task_.transform_force_drivers    = false;
+    defined_task_.compute_null_space_command = control_null_space;
+    defined_task_.desired_null_space_angle   = desired_null_space_angle;
+    defined_task_.compensate_unknown_weight  = true;
 }
 
 void dynamics_controller::define_moveGuarded_task(
@@ -826,8 +1091,8 @@ void dynamics_controller::define_moveGuarded_task(
     assert(tube_end_position.size()    == 12);
     assert(tube_start_position.size()  == 3);
 
-    CTRL_DIM_ = constraint_direction;
-    MOTION_CTRL_DIM_ = CTRL_DIM_;
+    defined_task_.ctrl_dim        = constraint_direction;
+    defined_task_.motion_ctrl_dim = defined_task_.ctrl_dim;
 
     // X-Y-Z linear
     KDL::Vector x_world(1.0, 0.0, 0.0);
@@ -863,27 +1128,28 @@ void dynamics_controller::define_moveGuarded_task(
         tube_end_position[9] = tf_orientation.data[6]; tube_end_position[10] = tf_orientation.data[7]; tube_end_position[11] = tf_orientation.data[8];
     }
 
-    moveGuarded_task_.tf_pose                   = KDL::Frame(tf_orientation, tf_position);
-    moveGuarded_task_.goal_pose                 = KDL::Frame::Identity();
-    moveGuarded_task_.tube_start_position       = tube_start_position;
-    moveGuarded_task_.tube_end_position         = tube_end_position;
-    moveGuarded_task_.tube_tolerances           = tube_tolerances;
-    moveGuarded_task_.tube_speed                = tube_speed;
-    moveGuarded_task_.contact_threshold_linear  = contact_threshold_linear;
-    moveGuarded_task_.contact_threshold_angular = contact_threshold_angular;
-    moveGuarded_task_.time_limit                = task_time_limit_sec;
+    defined_task_.moveGuarded.tf_pose                   = KDL::Frame(tf_orientation, tf_position);
+    defined_task_.moveGuarded.goal_pose                 = KDL::Frame::Identity();
+    defined_task_.moveGuarded.tube_start_position       = tube_start_position;
+    defined_task_.moveGuarded.tube_end_position         = tube_end_position;
+    defined_task_.moveGuarded.tube_tolerances           = tube_tolerances;
+    defined_task_.moveGuarded.tube_speed                = tube_speed;
+    defined_task_.moveGuarded.contact_threshold_linear  = contact_threshold_linear;
+    defined_task_.moveGuarded.contact_threshold_angular = contact_threshold_angular;
+    defined_task_.moveGuarded.time_limit                = task_time_limit_sec;
 
     // Set null-space error tolerance; small null-space oscillations are desired in this mode
-    moveGuarded_task_.null_space_force_direction = KDL::Vector::Zero();
-    moveGuarded_task_.null_space_tolerance       = tube_tolerances[7];
-
-    desired_state_.frame_pose[END_EFF_]    = moveGuarded_task_.goal_pose;
-    desired_task_model_                    = task_model::moveGuarded;
-    transform_drivers_          = true;
-    transform_force_drivers_    = false;
-    compute_null_space_command_ = control_null_space;
-    desired_null_space_angle_   = desired_null_space_angle;
-    compensate_unknown_weight_  = false;
+    defined_task_.moveGuarded.null_space_force_direction = KDL::Vector::Zero();
+    defined_task_.moveGuarded.null_space_tolerance       = tube_tolerances[7];
+
+    defined_task_.desired_pose               = defined_task_.moveGuarded.goal_pose;
+    defined_task_.task_model                 = task_model::moveGuarded;
+    defined_task_.task                       = std::make_shared< fixed_frame_task<&dynamics_controller::compute_moveGuarded_task_error> >(*this, defined_task_.moveGuarded.tf_pose.M);
+    defined_task_.transform_drivers          = true;
+    defined_task_.transform_force_drivers    = false;
+    defined_task_.compute_null_space_command = control_null_space;
+    defined_task_.desired_null_space_angle   = desired_null_space_angle;
+    defined_task_.compensate_unknown_weight  = false;
 }
 
 
@@ -900,46 +1166,46 @@ void dynamics_controller::define_full_pose_task(
     assert(constraint_direction.size() == NUM_OF_CONSTRAINTS_);
     assert(cartesian_pose.size()       == NUM_OF_CONSTRAINTS_ * 2);
     
-    CTRL_DIM_ = constraint_direction;
-    MOTION_CTRL_DIM_ = CTRL_DIM_;
+    defined_task_.ctrl_dim        = constraint_direction;
+    defined_task_.motion_ctrl_dim = defined_task_.ctrl_dim;
 
-    desired_state_.frame_pose[END_EFF_].p(0) = cartesian_pose[0];
-    desired_state_.frame_pose[END_EFF_].p(1) = cartesian_pose[1];
-    desired_state_.frame_pose[END_EFF_].p(2) = cartesian_pose[2];
+    defined_task_.desired_pose.p(0) = cartesian_pose[0];
+    defined_task_.desired_pose.p(1) = cartesian_pose[1];
+    defined_task_.desired_pose.p(2) = cartesian_pose[2];
 
-    desired_state_.frame_pose[END_EFF_].M = KDL::Rotation(cartesian_pose[3], cartesian_pose[4], cartesian_pose[5],
-                                                          cartesian_pose[6], cartesian_pose[7], cartesian_pose[8],
-                                                          cartesian_pose[9], cartesian_pose[10], cartesian_pose[11]);
+    defined_task_.desired_pose.M = KDL::Rotation(cartesian_pose[3], cartesian_pose[4], cartesian_pose[5],
+                                                 cartesian_pose[6], cartesian_pose[7], cartesian_pose[8],
+                                                 cartesian_pose[9], cartesian_pose[10], cartesian_pose[11]);
     
-    full_pose_task_.tf_pose                   = KDL::Frame::Identity();
-    full_pose_task_.goal_pose                 = desired_state_.frame_pose[END_EFF_];
-    full_pose_task_.goal_area                 = std::vector<double>(6, 0.01);
-    full_pose_task_.contact_threshold_linear  = contact_threshold_linear;
-    full_pose_task_.contact_threshold_angular = contact_threshold_angular;
-    full_pose_task_.time_limit                = task_time_limit_sec;
+    defined_task_.full_pose.tf_pose                   = KDL::Frame::Identity();
+    defined_task_.full_pose.goal_pose                 = defined_task_.desired_pose;
+    defined_task_.full_pose.goal_area                 = std::vector<double>(6, 0.01);
+    defined_task_.full_pose.contact_threshold_linear  = contact_threshold_linear;
+    defined_task_.full_pose.contact_threshold_angular = contact_threshold_angular;
+    defined_task_.full_pose.time_limit                = task_time_limit_sec;
   
     // Set null-space error tolerance; small null-space oscillations are desired in this mode
-    full_pose_task_.null_space_force_direction = KDL::Vector::Zero();
-    full_pose_task_.null_space_tolerance       = null_space_tolerance;
-
-    desired_task_model_                        = task_model::full_pose;
-    transform_drivers_          = false;
-    transform_force_drivers_    = false;
-    compute_null_space_command_ = control_null_space;
-    desired_null_space_angle_   = desired_null_space_angle;
-    compensate_unknown_weight_  = false;
+    defined_task_.full_pose.null_space_force_direction = KDL::Vector::Zero();
+    defined_task_.full_pose.null_space_tolerance       = null_space_tolerance;
+
+    defined_task_.task_model                 = task_model::full_pose;
+    defined_task_.task                       = std::make_shared< fixed_frame_task<&dynamics_controller::compute_full_pose_task_error> >(*this, defined_task_.full_pose.tf_pose.M);
+    defined_task_.transform_drivers          = false;
+    defined_task_.transform_force_drivers    = false;
+    defined_task_.compute_null_space_command = control_null_space;
+    defined_task_.desired_null_space_angle   = desired_null_space_angle;
+    defined_task_.compensate_unknown_weight  = false;
 }
 
 void dynamics_controller::define_gravity_compensation_task(const double task_time_limit_sec)
 {
-    gravity_compensation_task_.time_limit = task_time_limit_sec;
-    desired_task_model_                   = task_model::gravity_compensation;
-    transform_drivers_                    = false;
-    transform_force_drivers_              = false;
-    compute_null_space_command_           = false;
-    compensate_unknown_weight_            = false;
-    abag_error_vector_.setZero();
-    KDL::SetToZero(cart_force_command_[END_EFF_]);
+    defined_task_.gravity_compensation.time_limit = task_time_limit_sec;
+    defined_task_.task_model                      = task_model::gravity_compensation;
+    defined_task_.task                            = std::make_shared< fixed_frame_task<&dynamics_controller::compute_gravity_compensation_task_error> >(*this, KDL::Rotation::Identity());
+    defined_task_.transform_drivers               = false;
+    defined_task_.transform_force_drivers         = false;
+    defined_task_.compute_null_space_command      = false;
+    defined_task_.compensate_unknown_weight       = false;
 }
 
 void dynamics_controller::define_ee_acc_constraint(const std::vector<bool> &constraint_direction,
@@ -1035,6 +1301,7 @@ void dynamics_controller::set_feedforward_torque(state_specification &state,
 //Make sure that the control loop runs exactly with the specified frequency
 int dynamics_controller::enforce_loop_frequency(const int dt)
 {
+    if (free_running_) return 0;
     loop_interval_ = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - loop_start_time_);
 
     if (loop_interval_ < std::chrono::microseconds(dt)) // Loop is sufficiently fast
@@ -1049,6 +1316,13 @@ int dynamics_controller::enforce_loop_frequency(const int dt)
     else return -1; //Loop is too slow
 }
 
+// Queued on the real-time event channel, with the measured cycle time: never blocks the loop
+void dynamics_controller::report_deadline_miss(const int dt)
+{
+    control_loop_delay_count_++;
+    rt_event::publish(rt_event::DEADLINE_MISS, dt, control_loop_delay_count_, loop_interval_.count());
+}
+
 /*
     Safety monitor checks if the commands are over the limits.
     If yes: stop the robot motion
@@ -1056,10 +1330,69 @@ int dynamics_controller::enforce_loop_frequency(const int dt)
 */
 int dynamics_controller::monitor_joint_safety()
 {
-    // Integrate joint accelerations to velocities and positions with _two_ time steps
-    predictor_.integrate_joint_space(robot_state_, predicted_states_, DT_SEC_, 2, integration_method::SYMPLECTIC_EULER, false, false);
+    if (desired_control_mode_.interface != control_mode::TORQUE)
+    {
+        // Integrate joint accelerations to velocities and positions with _two_ time steps
+        predictor_.integrate_joint_space(robot_state_, predicted_states_, DT_SEC_, 2, integration_method::SYMPLECTIC_EULER, false, false);
+        return safety_monitor_.monitor_joint_state(robot_state_, DT_SEC_, desired_control_mode_.interface, predicted_states_, 2);
+    }
+
+    /*
+        Commanded torques are held over the horizon and forward dynamics is
+        re-evaluated at each predicted state. The horizon length is limited
+        by the time left in the current control cycle.
+    */
+    safety_horizon_steps_ = get_safety_horizon();
+
+    std::chrono::steady_clock::time_point prediction_start_time = std::chrono::steady_clock::now();
+    int solver_result = predictor_.integrate_joint_space(robot_state_, predicted_states_, DT_SEC_, safety_horizon_steps_, integration_method::SYMPLECTIC_EULER, false, true);
+    double step_cost = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - prediction_start_time).count() / safety_horizon_steps_;
+
+    if (safety_step_cost_micro_ == 0.0) safety_step_cost_micro_ = step_cost;
+    else safety_step_cost_micro_ += dynamics_parameter::SAFETY_HORIZON_COST_FILTER * (step_cost - safety_step_cost_micro_);
+    if (solver_result != 0) rt_event::publish(rt_event::SOLVER_ERROR, solver_result, rt_event::SAFETY_PREDICTION);
+
+    return safety_monitor_.monitor_joint_state(robot_state_, DT_SEC_, desired_control_mode_.interface, predicted_states_, safety_horizon_steps_);
+}
+
+/*
+    Passes the end-effector quantities read by the FSM as a compact snapshot,
+    and applies its output (desired velocity along the tube) to the desired state.
+*/
+int dynamics_controller::update_motion_task_status()
+{
+    fsm_snapshot_.end_effector_pose  = robot_state_.frame_pose[END_EFF_];
+    fsm_snapshot_.end_effector_twist = robot_state_.frame_velocity[END_EFF_];
+    fsm_snapshot_.current_error      = current_error_twist_;
+    fsm_snapshot_.ext_force          = ext_wrench_;
+    fsm_snapshot_.desired_speed      = desired_state_.frame_velocity[END_EFF_].vel(0);
+    fsm_snapshot_.time_passed_sec    = total_time_sec_;
+    fsm_snapshot_.tube_section_count = tube_section_count_;
+
+    fsm_.update_motion_task_status(fsm_snapshot_, fsm_output_);
+
+    desired_state_.frame_velocity[END_EFF_].vel(0) = fsm_output_.desired_speed;
+    return fsm_output_.status;
+}
+
+/*
+    Number of prediction steps that fit in the time left in the current cycle,
+    given the filtered per-step cost measured in previous cycles.
+    Falls back to the minimum horizon if the cycle is already over budget.
+*/
+int dynamics_controller::get_safety_horizon()
+{
+    if (safety_step_cost_micro_ <= 0.0) return dynamics_parameter::SAFETY_HORIZON_MIN_STEPS;
+
+    double time_left = DT_MICRO_ - dynamics_parameter::SAFETY_HORIZON_TIME_MARGIN - 
+                       std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - loop_start_time_).count();
+    
+    if (time_left <= 0.0) return dynamics_parameter::SAFETY_HORIZON_MIN_STEPS;
 
-    return safety_monitor_.monitor_joint_state(robot_state_, DT_SEC_, desired_control_mode_.interface, predicted_states_);
+    int horizon_steps = static_cast<int>(time_left / safety_step_cost_micro_);
+    if (horizon_steps < dynamics_parameter::SAFETY_HORIZON_MIN_STEPS) return dynamics_parameter::SAFETY_HORIZON_MIN_STEPS;
+    if (horizon_steps > dynamics_parameter::SAFETY_HORIZON_MAX_STEPS) return dynamics_parameter::SAFETY_HORIZON_MAX_STEPS;
+    return horizon_steps;
 }
 
 /*
@@ -1159,9 +1492,11 @@ void dynamics_controller::compute_moveConstrained_null_space_task_error()
     
     if (norm < MIN_NORM)
     {
+        // Reported once, when the null-space force is first disabled
+        if (moveConstrained_follow_path_task_.null_space_force_direction != KDL::Vector::Zero())
+            rt_event::publish(rt_event::TASK_ERROR, rt_event::NULL_SPACE_NORM_TOO_SMALL, 0, norm);
         null_space_abag_error_(0) = 0.0;
         moveConstrained_follow_path_task_.null_space_force_direction = KDL::Vector::Zero();
-        printf("Null space norm too small 1 \n");
     }
     else 
     {
@@ -1173,7 +1508,7 @@ void dynamics_controller::compute_moveConstrained_null_space_task_error()
         null_space_angle_ = std::atan2(r_direction(2), r_direction(1)); // Angle between Y and R_yz
 
         // Unit of tolerance is degree
-        if (std::fabs(null_space_angle_) <= DEG_TO_RAD(moveConstrained_follow_path_task_.null_space_tolerance)) null_space_abag_error_(0) = 0.0;
+        if (std::fabs(null_space_angle_) <= DEG_TO_RAD(null_space_tolerance_)) null_space_abag_error_(0) = 0.0;
         else null_space_abag_error_(0) = null_space_angle_;
 
         // Calculate control/force direction: Cart force for null-space motion
@@ -1232,14 +1567,7 @@ void dynamics_controller::compute_moveConstrained_follow_path_task_error()
         case task_status::APPROACH:
             if (previous_task_status_ == task_status::NOMINAL) // Set ABAG parameters for linear Z axis velocity control
             {
-                abag_.set_error_alpha(   abag_parameter::ERROR_ALPHA(2),    2);
-                abag_.set_bias_threshold(abag_parameter::BIAS_THRESHOLD(2), 2);
-                abag_.set_bias_step(     abag_parameter::BIAS_STEP(2),      2);
-                abag_.set_gain_threshold(abag_parameter::GAIN_THRESHOLD(2), 2);
-                abag_.set_gain_step(     abag_parameter::GAIN_STEP(2),      2);
-                abag_.set_min_bias_sat_limit(   Eigen::VectorXd::Constant(6, -1.0));
-                abag_.set_min_command_sat_limit(Eigen::VectorXd::Constant(6, -1.0));
-                max_command_(2) = 20.0;
+                switch_parameter_mode(parameter_mode::APPROACH_PARAMETERS);
 
                 MOTION_CTRL_DIM_[2] = true; FORCE_CTRL_DIM_[2] = false;
                 MOTION_CTRL_DIM_[3] = true; FORCE_CTRL_DIM_[3] = false;
@@ -1278,14 +1606,8 @@ void dynamics_controller::compute_moveConstrained_follow_path_task_error()
             {
                 abag_.reset_state();
 
-                abag_.set_error_alpha(   force_task_parameters_(0), 2);
-                abag_.set_bias_threshold(force_task_parameters_(1), 2);
-                abag_.set_bias_step(     force_task_parameters_(2), 2);
-                abag_.set_gain_threshold(force_task_parameters_(3), 2);
-                abag_.set_gain_step(     force_task_parameters_(4), 2);
-                abag_.set_min_bias_sat_limit(   min_sat_limits_);
-                abag_.set_min_command_sat_limit(min_sat_limits_);
-                max_command_(2) = force_task_parameters_(5);
+                switch_parameter_mode(parameter_mode::CONTACT_PARAMETERS);
+                warm_start_abag();
                 apply_feedforward_force_ = true;
                 write_contact_time_to_file_ = true; // Visualize time flag in control graphs, for this control mode switching
 
@@ -1295,17 +1617,17 @@ void dynamics_controller::compute_moveConstrained_follow_path_task_error()
             }
 
             // Update tube section count 
-            if (previous_task_status_ == task_status::CHANGE_TUBE_SECTION) tube_section_count_++;
-            if ((unsigned)tube_section_count_ > moveConstrained_follow_path_task_.tf_poses.size() - 1) tube_section_count_ = moveConstrained_follow_path_task_.tf_poses.size() - 1;
+            update_tube_section(moveConstrained_follow_path_task_.num_of_sections);
+            stream_tube_sections(moveConstrained_follow_path_task_.tf_poses, moveConstrained_follow_path_task_.num_of_sections);
 
             // Make prediction while the state is expressed in the base frame
             make_Cartesian_predictions(horizon_amplitude_, 1);
 
             // Change the reference frame of the robot motion state, from base frame to task frame
-            robot_state_.frame_pose[END_EFF_]        = moveConstrained_follow_path_task_.tf_poses[tube_section_count_].Inverse()   * robot_state_.frame_pose[END_EFF_];
-            robot_state_.frame_velocity[END_EFF_]    = moveConstrained_follow_path_task_.tf_poses[tube_section_count_].M.Inverse() * robot_state_.frame_velocity[END_EFF_];
-            predicted_state_.frame_pose[END_EFF_]    = moveConstrained_follow_path_task_.tf_poses[tube_section_count_].Inverse()   * predicted_state_.frame_pose[END_EFF_];
-            desired_state_base_.frame_pose[END_EFF_] = moveConstrained_follow_path_task_.tf_poses[tube_section_count_]             * desired_state_.frame_pose[END_EFF_];
+            robot_state_.frame_pose[END_EFF_]        = get_tube_section_frame(moveConstrained_follow_path_task_.tf_poses).Inverse()   * robot_state_.frame_pose[END_EFF_];
+            robot_state_.frame_velocity[END_EFF_]    = get_tube_section_frame(moveConstrained_follow_path_task_.tf_poses).M.Inverse() * robot_state_.frame_velocity[END_EFF_];
+            predicted_state_.frame_pose[END_EFF_]    = get_tube_section_frame(moveConstrained_follow_path_task_.tf_poses).Inverse()   * predicted_state_.frame_pose[END_EFF_];
+            desired_state_base_.frame_pose[END_EFF_] = get_tube_section_frame(moveConstrained_follow_path_task_.tf_poses)             * desired_state_.frame_pose[END_EFF_];
 
             current_error_twist_   = finite_displacement_twist(desired_state_, robot_state_);
             predicted_error_twist_ = conversions::kdl_twist_to_eigen( finite_displacement_twist(desired_state_, predicted_state_) );
@@ -1314,7 +1636,7 @@ void dynamics_controller::compute_moveConstrained_follow_path_task_error()
             current_error_twist_(1) = POS_TUBE_DIM_[1]? current_error_twist_(1) : 0.0;
 
             // fsm_result_ = task_status::CRUISE_THROUGH_TUBE;
-            fsm_result_ = fsm_.update_motion_task_status(robot_state_, desired_state_, current_error_twist_, ext_wrench_, total_time_sec_, tube_section_count_);
+            fsm_result_ = update_motion_task_status();
 
             // Check for tube on velocity X-linear
             abag_error_vector_(0) = desired_state_.frame_velocity[END_EFF_](0) - robot_state_.frame_velocity[END_EFF_](0);
@@ -1407,28 +1729,116 @@ void dynamics_controller::compute_moveToGuarded_null_space_task_error()
     null_space_abag_error_(0) = DEG_TO_RAD(desired_null_space_angle_) - null_space_angle_;
 
     // Unit of this tube tolerance is degree
-    switch (desired_task_model_)
+    if (std::fabs(null_space_abag_error_(0)) <= DEG_TO_RAD(null_space_tolerance_)) null_space_abag_error_(0) = 0.0;
+}
+
+// Current tube section: projected onto the path, or advanced by the FSM
+void dynamics_controller::update_tube_section(const int num_of_sections)
+{
+    // Projection requires the full path in memory
+    if (use_path_projection_ && path_projection_.is_built() && path_stream_.loader == nullptr)
     {
-        case task_model::moveTo_follow_path:
-            if (std::fabs(null_space_abag_error_(0)) <= DEG_TO_RAD(moveTo_follow_path_task_.null_space_tolerance)) null_space_abag_error_(0) = 0.0;
-            break;
+        // End-effector pose is still expressed in the base frame, same as the path points
+        const KDL::Vector &position = robot_state_.frame_pose[END_EFF_].p;
+        tube_section_count_ = path_projection_.project(Eigen::Vector3d(position(0), position(1), position(2))).segment;
+    }
+    else if (previous_task_status_ == task_status::CHANGE_TUBE_SECTION) tube_section_count_++;
 
-        case task_model::moveTo_weight_compensation:
-            if (std::fabs(null_space_abag_error_(0)) <= DEG_TO_RAD(moveTo_weight_compensation_task_.null_space_tolerance)) null_space_abag_error_(0) = 0.0;
-            break;
+    if (tube_section_count_ > num_of_sections - 1) tube_section_count_ = num_of_sections - 1;
 
-        case task_model::moveGuarded:
-            if (std::fabs(null_space_abag_error_(0)) <= DEG_TO_RAD(moveGuarded_task_.null_space_tolerance)) null_space_abag_error_(0) = 0.0;
-            break;
+    // Streamed path: the robot cannot pass the sections that are not built yet
+    if (path_stream_.loader != nullptr && tube_section_count_ > path_stream_.built_sections - 1)
+        tube_section_count_ = path_stream_.built_sections - 1;
+    if (spline_frames_.path != nullptr) spline_section_frame_ = compute_spline_section_frame(tube_section_count_, robot_state_.frame_pose[END_EFF_].p);
+}
 
-        case task_model::moveTo:
-            if (std::fabs(null_space_abag_error_(0)) <= DEG_TO_RAD(moveTo_task_.null_space_tolerance)) null_space_abag_error_(0) = 0.0;
-            break;
+// Task frame with the X axis along the tube section
+KDL::Frame dynamics_controller::compute_tube_section_frame(const KDL::Vector &tube_start_position,
+                                                           const KDL::Vector &tf_position) const
+{
+    const KDL::Vector x_world(1.0, 0.0, 0.0);
+    KDL::Vector x_task = tf_position - tube_start_position;
+    x_task.Normalize();
 
-        default:
-            if (std::fabs(null_space_abag_error_(0)) <= DEG_TO_RAD(full_pose_task_.null_space_tolerance)) null_space_abag_error_(0) = 0.0;
-            break;
+    KDL::Vector cross_product = x_world * x_task;
+    double cosine             = dot(x_world, x_task);
+    double sine               = cross_product.Norm();
+    double angle              = atan2(sine, cosine);
+
+    KDL::Rotation tf_orientation;
+    if (cosine < (-1 + 1e-6)) tf_orientation = KDL::Rotation::EulerZYZ(M_PI, 0.0, 0.0);
+    else if (sine < 1e-6)     tf_orientation = KDL::Rotation::Identity();
+    else                      tf_orientation = geometry::exp_map_so3(cross_product / sine * angle);
+
+    return KDL::Frame(tf_orientation, tf_position);
+}
+
+/**
+ * Builds the task frames of a streamed path, ahead of the current tube section.
+ * The frames are stored in a ring: a section overwrites the one a full window behind it,
+ * which the robot has already left. Bounded number of sections per control cycle.
+ */
+void dynamics_controller::stream_tube_sections(std::vector<KDL::Frame> &tf_poses, int &num_of_sections)
+{
+    if (path_stream_.loader == nullptr) return;
+
+    const int window        = tf_poses.size();
+    const int num_of_points = path_stream_.loader->get_number_of_points();
+    int num_of_new_sections = std::min(dynamics_parameter::PATH_STREAM_SECTIONS_PER_CYCLE,
+                                       tube_section_count_ + window - path_stream_.built_sections);
+    if (num_of_points >= 0) num_of_new_sections = std::min(num_of_new_sections, num_of_points - 1 - path_stream_.built_sections);
+    if (num_of_new_sections <= 0) return;
+
+    // Section i ends at point i + 1. Short read: the end of a CSV file, only valid if it is the path's end
+    const int num_read = path_stream_.loader->read_points(path_stream_.built_sections + 1, num_of_new_sections, path_stream_points_);
+    if (num_read < 0 || (num_read != num_of_new_sections && 
+                         path_stream_.loader->get_number_of_points() != path_stream_.built_sections + 1 + num_read))
+    {
+        rt_event::publish(rt_event::TASK_ERROR, rt_event::PATH_READ_FAILED, path_stream_.built_sections + 1);
+        path_stream_.loader = nullptr;
+        trigger_stopping_sequence_ = true;
+        return;
     }
+
+    for (int i = 0; i < num_read; i++)
+    {
+        const KDL::Vector tf_position(path_stream_points_[i][0], path_stream_points_[i][1], path_stream_points_[i][2]);
+        tf_poses[(path_stream_.built_sections + i) % window] = compute_tube_section_frame(path_stream_.last_point, tf_position);
+        path_stream_.last_point = tf_position;
+    }
+    path_stream_.built_sections += num_read;
+    num_of_sections = get_number_of_path_sections(*path_stream_.loader);
+}
+
+/**
+ * Task frame of a spline path at the robot's position, within the current tube section.
+ * The position is projected onto the section's chord and mapped to the arc length on the curve.
+ * Rotation: the curve's task frame there. Origin: along the tangent, such that the X error
+ * stays the remaining distance to the end of the section, as with the chord frames.
+ */
+KDL::Frame dynamics_controller::compute_spline_section_frame(const int section, const KDL::Vector &position) const
+{
+    const spline_path &path = *spline_frames_.path;
+    const double s_start    = spline_frames_.arc_lengths[section];
+    const double s_end      = spline_frames_.arc_lengths[section + 1];
+
+    const Eigen::Vector3d start = path.get_position(s_start);
+    const Eigen::Vector3d chord = path.get_position(s_end) - start;
+    const double chord_squared  = chord.squaredNorm();
+
+    double t = (chord_squared > 1e-12)? (conversions::kdl_vector_to_eigen(position) - start).dot(chord) / chord_squared : 0.0;
+    t = std::max(0.0, std::min(t, 1.0));
+    const double s = s_start + t * (s_end - s_start);
+
+    const Eigen::Matrix3d rotation = path.get_task_frame(s);
+    const Eigen::Vector3d origin   = path.get_position(s) + rotation.col(0) * (s_end - s);
+    return KDL::Frame(conversions::eigen_to_rotation(rotation), KDL::Vector(origin(0), origin(1), origin(2)));
+}
+
+const KDL::Frame &dynamics_controller::get_tube_section_frame(const std::vector<KDL::Frame> &tf_poses) const
+{
+    if (spline_frames_.path != nullptr) return spline_section_frame_;
+    return tf_poses[tube_section_count_ % tf_poses.size()];
 }
 
 /**
@@ -1437,16 +1847,16 @@ void dynamics_controller::compute_moveToGuarded_null_space_task_error()
 */
 void dynamics_controller::compute_moveTo_follow_path_task_error()
 {
-    if (previous_task_status_ == task_status::CHANGE_TUBE_SECTION) tube_section_count_++;
-    if ((unsigned)tube_section_count_ > moveTo_follow_path_task_.tf_poses.size() - 1) tube_section_count_ = moveTo_follow_path_task_.tf_poses.size() - 1;
+    update_tube_section(moveTo_follow_path_task_.num_of_sections);
+    stream_tube_sections(moveTo_follow_path_task_.tf_poses, moveTo_follow_path_task_.num_of_sections);
 
     make_Cartesian_predictions(horizon_amplitude_, 1);
 
     //Change the reference frame of the robot state, from base frame to task frame
-    robot_state_.frame_pose[END_EFF_]        = moveTo_follow_path_task_.tf_poses[tube_section_count_].Inverse()   * robot_state_.frame_pose[END_EFF_];
-    robot_state_.frame_velocity[END_EFF_]    = moveTo_follow_path_task_.tf_poses[tube_section_count_].M.Inverse() * robot_state_.frame_velocity[END_EFF_];
-    predicted_state_.frame_pose[END_EFF_]    = moveTo_follow_path_task_.tf_poses[tube_section_count_].Inverse()   * predicted_state_.frame_pose[END_EFF_];
-    desired_state_base_.frame_pose[END_EFF_] = moveTo_follow_path_task_.tf_poses[tube_section_count_]             * desired_state_.frame_pose[END_EFF_];
+    robot_state_.frame_pose[END_EFF_]        = get_tube_section_frame(moveTo_follow_path_task_.tf_poses).Inverse()   * robot_state_.frame_pose[END_EFF_];
+    robot_state_.frame_velocity[END_EFF_]    = get_tube_section_frame(moveTo_follow_path_task_.tf_poses).M.Inverse() * robot_state_.frame_velocity[END_EFF_];
+    predicted_state_.frame_pose[END_EFF_]    = get_tube_section_frame(moveTo_follow_path_task_.tf_poses).Inverse()   * predicted_state_.frame_pose[END_EFF_];
+    desired_state_base_.frame_pose[END_EFF_] = get_tube_section_frame(moveTo_follow_path_task_.tf_poses)             * desired_state_.frame_pose[END_EFF_];
 
     current_error_twist_ = finite_displacement_twist(desired_state_, robot_state_);
 
@@ -1461,7 +1871,7 @@ void dynamics_controller::compute_moveTo_follow_path_task_error()
         current_error_twist_(3) = (std::fabs(angle) <= moveTo_follow_path_task_.tube_tolerances[3])? 0.0 : angle;
     }
 
-    fsm_result_ = fsm_.update_motion_task_status(robot_state_, desired_state_, current_error_twist_, ext_wrench_, total_time_sec_, tube_section_count_);
+    fsm_result_ = update_motion_task_status();
     if (fsm_result_ == task_status::STOP_CONTROL) return;
 
     if (CTRL_DIM_[0]) abag_error_vector_(0) = desired_state_.frame_velocity[END_EFF_].vel(0) - robot_state_.frame_velocity[END_EFF_].vel(0);
@@ -1513,7 +1923,7 @@ void dynamics_controller::compute_moveTo_task_error()
         current_error_twist_(3) = (std::fabs(angle) <= moveTo_task_.tube_tolerances[3])? 0.0 : angle;
     }
 
-    fsm_result_ = fsm_.update_motion_task_status(robot_state_, desired_state_, current_error_twist_, ext_wrench_, total_time_sec_, tube_section_count_);
+    fsm_result_ = update_motion_task_status();
     if (fsm_result_ == task_status::STOP_CONTROL) return;
 
     if (CTRL_DIM_[0]) abag_error_vector_(0) = desired_state_.frame_velocity[END_EFF_].vel(0) - robot_state_.frame_velocity[END_EFF_].vel(0);
@@ -1564,7 +1974,7 @@ void dynamics_controller::compute_moveTo_weight_compensation_task_error()
         current_error_twist_(3) = (std::fabs(angle) <= moveTo_weight_compensation_task_.tube_tolerances[3])? 0.0 : angle;
     }
 
-    fsm_result_ = fsm_.update_motion_task_status(robot_state_, desired_state_, current_error_twist_, ext_wrench_, total_time_sec_, tube_section_count_);
+    fsm_result_ = update_motion_task_status();
     if (fsm_result_ == task_status::STOP_ROBOT || fsm_result_ == task_status::STOP_CONTROL) return;
 
     if (CTRL_DIM_[0]) abag_error_vector_(0) = desired_state_.frame_velocity[END_EFF_].vel(0) - robot_state_.frame_velocity[END_EFF_].vel(0);
@@ -1615,7 +2025,7 @@ void dynamics_controller::compute_moveGuarded_task_error()
         current_error_twist_(3) = (std::fabs(angle) <= moveGuarded_task_.tube_tolerances[3])? 0.0 : angle;
     }
 
-    fsm_result_ = fsm_.update_motion_task_status(robot_state_, desired_state_, current_error_twist_, ext_wrench_, total_time_sec_, tube_section_count_);
+    fsm_result_ = update_motion_task_status();
     if (fsm_result_ == task_status::STOP_ROBOT || fsm_result_ == task_status::STOP_CONTROL) return;
 
     if (CTRL_DIM_[0]) abag_error_vector_(0) = desired_state_.frame_velocity[END_EFF_].vel(0) - robot_state_.frame_velocity[END_EFF_].vel(0);
@@ -1652,7 +2062,7 @@ void dynamics_controller::compute_full_pose_task_error()
     for (int i = 0; i < NUM_OF_CONSTRAINTS_; i++)
         current_error_twist_(i) = CTRL_DIM_[i]? current_error_twist_(i) : 0.0;
 
-    fsm_result_ = fsm_.update_motion_task_status(robot_state_, desired_state_, current_error_twist_, ext_wrench_, total_time_sec_, tube_section_count_);
+    fsm_result_ = update_motion_task_status();
 
     abag_error_vector_ = predicted_error_twist_;
 
@@ -1674,7 +2084,7 @@ void dynamics_controller::compute_full_pose_task_error()
 */
 void dynamics_controller::compute_gravity_compensation_task_error()
 {
-    fsm_result_ = fsm_.update_motion_task_status(robot_state_, desired_state_, current_error_twist_, ext_wrench_, total_time_sec_, tube_section_count_);
+    fsm_result_ = update_motion_task_status();
 }
 
 /**
@@ -1682,72 +2092,14 @@ void dynamics_controller::compute_gravity_compensation_task_error()
  * Internally an error function will be called for each selected task
 */
 void dynamics_controller::compute_control_error()
-{    
-    switch (desired_task_model_)
-    {
-        case task_model::moveConstrained_follow_path:
-            compute_moveConstrained_follow_path_task_error();
-            break;
-
-        case task_model::moveTo_follow_path:
-            compute_moveTo_follow_path_task_error();
-            break;
-
-        case task_model::moveTo:
-            compute_moveTo_task_error();
-            break;
-
-        case task_model::moveGuarded:
-            compute_moveGuarded_task_error();
-            break;
-
-        case task_model::moveTo_weight_compensation:
-            compute_moveTo_weight_compensation_task_error();
-            break;
-
-        case task_model::full_pose:
-            compute_full_pose_task_error(); 
-            break;
-
-        case task_model::gravity_compensation:
-            compute_gravity_compensation_task_error(); 
-            break;
-
-        default:
-            assert(("Unsupported task model", false));
-            break;
-    }
+{
+    active_task_->compute_error();
 }
 
 // Change the reference frame of the external (virtual) forces, from task frame to base frame
 void dynamics_controller::transform_force_driver()
 {
-    switch (desired_task_model_)
-    {
-        case task_model::moveConstrained_follow_path:
-            // First transform the wrench command from the tool-tip to the end-effector reference point but not the reference frame
-            cart_force_command_[END_EFF_] = cart_force_command_[END_EFF_].RefPoint(moveConstrained_follow_path_task_.end_eff_wrt_tool_tip.p);
-
-            // Now tranform the reference frame, from task frame to base frame
-            cart_force_command_[END_EFF_] = moveConstrained_follow_path_task_.tf_force * cart_force_command_[END_EFF_];
-            break;
-        
-        case task_model::moveTo_follow_path:
-            cart_force_command_[END_EFF_] = moveTo_follow_path_task_.tf_poses[tube_section_count_].M * cart_force_command_[END_EFF_];
-            break;
-
-        case task_model::moveTo_weight_compensation:
-            cart_force_command_[END_EFF_] = moveTo_weight_compensation_task_.tf_pose.M * cart_force_command_[END_EFF_];
-            break;
-
-        case task_model::moveGuarded:
-            cart_force_command_[END_EFF_] = moveGuarded_task_.tf_pose.M * cart_force_command_[END_EFF_];
-            break;
-
-        default:
-            cart_force_command_[END_EFF_] = moveTo_task_.tf_pose.M * cart_force_command_[END_EFF_];
-            break;
-    }
+    active_task_->transform_force_driver(cart_force_command_[END_EFF_]);
 }
 
 // Change the reference frame of the constraint forces, from task frame to base frame
@@ -1756,6 +2108,7 @@ void dynamics_controller::transform_motion_driver()
     KDL::Wrench wrench_column;
     KDL::Twist twist_column;
     KDL::Jacobian alpha = robot_state_.ee_unit_constraint_force;
+    const KDL::Rotation &tf_orientation = active_task_->get_task_frame_rotation();
 
     // Change the reference frame of constraint forces, from task frame to base frame
     for (int c = 0; c < NUM_OF_CONSTRAINTS_; c++)
@@ -1763,29 +2116,7 @@ void dynamics_controller::transform_motion_driver()
         // Change data type of constraint forces to fit general KDL type
         wrench_column = KDL::Wrench(KDL::Vector(alpha(0, c), alpha(1, c), alpha(2, c)),
                                     KDL::Vector(alpha(3, c), alpha(4, c), alpha(5, c)));
-        
-        switch (desired_task_model_)
-        {
-            case task_model::moveConstrained_follow_path:
-                wrench_column = moveConstrained_follow_path_task_.tf_poses[tube_section_count_].M * wrench_column;
-                break;
-
-            case task_model::moveTo_follow_path:
-                wrench_column = moveTo_follow_path_task_.tf_poses[tube_section_count_].M * wrench_column;
-                break;
-
-            case task_model::moveTo_weight_compensation:
-                wrench_column = moveTo_weight_compensation_task_.tf_pose.M * wrench_column;
-                break;
-
-            case task_model::moveGuarded:
-                wrench_column = moveGuarded_task_.tf_pose.M * wrench_column;
-                break;
-
-            default:
-                wrench_column = moveTo_task_.tf_pose.M * wrench_column;
-                break;
-        }
+        wrench_column = tf_orientation * wrench_column;
 
         // Change Data Type to fit Vereshchagin
         twist_column = KDL::Twist(wrench_column.force, wrench_column.torque);
@@ -1907,7 +2238,7 @@ int dynamics_controller::compute_weight_compensation_control_commands()
                 {
                     // Force in task frame = error in percentage * max command * proportional gain
                     compensated_weight_.force = compensated_weight_.force + KDL::Vector(compensation_error_(0) * max_command_(0) * compensation_parameters_(3), 0.0, 0.0);
-                    printf("X Force: %f\n", compensated_weight_.force(0));
+                    rt_event::publish(rt_event::WEIGHT_COMPENSATION, rt_event::FORCE_UPDATED, 0, compensated_weight_.force(0));
                 }
                 break;
 
@@ -1923,7 +2254,7 @@ int dynamics_controller::compute_weight_compensation_control_commands()
                 {
                     // Force in task frame = error in percentage * max command * proportional gain
                     compensated_weight_.force = compensated_weight_.force + KDL::Vector(0.0, compensation_error_(1) * max_command_(1) * compensation_parameters_(3), 0.0);
-                    printf("Y Force: %f\n", compensated_weight_.force(1));
+                    rt_event::publish(rt_event::WEIGHT_COMPENSATION, rt_event::FORCE_UPDATED, 1, compensated_weight_.force(1));
                 }
                 break;
 
@@ -1939,7 +2270,7 @@ int dynamics_controller::compute_weight_compensation_control_commands()
                 {
                     // Force in task frame = error in percentage * max command * proportional gain
                     compensated_weight_.force = compensated_weight_.force + KDL::Vector(0.0, 0.0, compensation_error_(2) * max_command_(2) * compensation_parameters_(3));
-                    printf("Z Force: %f\n", compensated_weight_.force(2));
+                    rt_event::publish(rt_event::WEIGHT_COMPENSATION, rt_event::FORCE_UPDATED, 2, compensated_weight_.force(2));
                 }
                 break;
 
@@ -1952,7 +2283,7 @@ int dynamics_controller::compute_weight_compensation_control_commands()
         if (moveTo_weight_compensation_task_.use_mass_alternation)
         {
             // robot_chain_.getSegment(END_EFF_).setMass(updated_mass_estimation_);
-            printf("Updated mass: %f \n", robot_chain_.getSegment(END_EFF_).getInertia().getMass());
+            rt_event::publish(rt_event::WEIGHT_COMPENSATION, rt_event::MASS_UPDATED, 0, robot_chain_.getSegment(END_EFF_).getInertia().getMass());
 
             // Reset solvers with updated model
             this->hd_solver_.reset(new KDL::Solver_Vereshchagin(robot_chain_, JOINT_INERTIA_,
@@ -1994,8 +2325,13 @@ int dynamics_controller::evaluate_dynamics()
 
 int dynamics_controller::compute_gravity_compensation_control_commands()
 {
-    int id_solver_result = this->id_solver_->CartToJnt(robot_state_.q, zero_joint_array_, zero_joint_array_, zero_wrenches_full_model_, gravity_torque_);
-    if (id_solver_result != 0) return id_solver_result;
+    int id_solver_result = 0;
+    if (!reuse_cached_terms(robot_state_.q, gravity_cache_))
+    {
+        id_solver_result = this->id_solver_->CartToJnt(robot_state_.q, zero_joint_array_, zero_joint_array_, zero_wrenches_full_model_, gravity_torque_);
+        if (id_solver_result != 0) return id_solver_result;
+        refresh_cached_terms(robot_state_.q, gravity_cache_);
+    }
 
     if (desired_task_model_ != task_model::gravity_compensation) robot_state_.control_torque.data += gravity_torque_.data;
     else robot_state_.control_torque.data = gravity_torque_.data;
@@ -2009,77 +2345,164 @@ int dynamics_controller::compute_gravity_compensation_control_commands()
     return id_solver_result;
 }
 
-void dynamics_controller::set_parameters(const double horizon_amplitude,
-                                         const Eigen::VectorXd &max_command,
-                                         const Eigen::VectorXd &error_alpha, 
-                                         const Eigen::VectorXd &bias_threshold, 
-                                         const Eigen::VectorXd &bias_step, 
-                                         const Eigen::VectorXd &gain_threshold, 
-                                         const Eigen::VectorXd &gain_step,
-                                         const Eigen::VectorXd &min_bias_sat,
-                                         const Eigen::VectorXd &min_command_sat,
-                                         const Eigen::VectorXd &null_space_parameters,
-                                         const Eigen::VectorXd &compensation_parameters,
-                                         const Eigen::VectorXd &stop_motion_error_alpha,
-                                         const Eigen::VectorXd &stop_motion_bias_threshold,
-                                         const Eigen::VectorXd &stop_motion_bias_step,
-                                         const Eigen::VectorXd &stop_motion_gain_threshold,
-                                         const Eigen::VectorXd &stop_motion_gain_step,
-                                         const Eigen::VectorXd &wrench_estimation_gain)
-{
-    //First check input dimensions
-    assert(max_command.size()             == NUM_OF_CONSTRAINTS_); 
-    assert(error_alpha.size()             == NUM_OF_CONSTRAINTS_); 
-    assert(bias_threshold.size()          == NUM_OF_CONSTRAINTS_); 
-    assert(bias_step.size()               == NUM_OF_CONSTRAINTS_); 
-    assert(gain_threshold.size()          == NUM_OF_CONSTRAINTS_); 
-    assert(gain_step.size()               == NUM_OF_CONSTRAINTS_); 
-    assert(null_space_parameters.size()   == NUM_OF_CONSTRAINTS_); 
-    assert(compensation_parameters.size() == 2 * NUM_OF_CONSTRAINTS_); 
-    assert(stop_motion_error_alpha.size()    == NUM_OF_JOINTS_); 
-    assert(stop_motion_bias_threshold.size() == NUM_OF_JOINTS_); 
-    assert(stop_motion_bias_step.size()      == NUM_OF_JOINTS_); 
-    assert(stop_motion_gain_threshold.size() == NUM_OF_JOINTS_); 
-    assert(stop_motion_gain_step.size()      == NUM_OF_JOINTS_); 
-
-    this->horizon_amplitude_        = horizon_amplitude;
-    this->max_command_              = max_command;
-
-    // Setting parameters of the force controller DOF
-    this->force_task_parameters_(0) = error_alpha(2);
-    this->force_task_parameters_(1) = bias_threshold(2);
-    this->force_task_parameters_(2) = bias_step(2);
-    this->force_task_parameters_(3) = gain_threshold(2);
-    this->force_task_parameters_(4) = gain_step(2);
-    this->force_task_parameters_(5) = max_command(2);
-    this->min_sat_limits_ = min_command_sat;
+int dynamics_controller::set_parameters(const double horizon_amplitude,
+                                        const Eigen::VectorXd &max_command,
+                                        const Eigen::VectorXd &error_alpha, 
+                                        const Eigen::VectorXd &bias_threshold, 
+                                        const Eigen::VectorXd &bias_step, 
+                                        const Eigen::VectorXd &gain_threshold, 
+                                        const Eigen::VectorXd &gain_step,
+                                        const Eigen::VectorXd &min_bias_sat,
+                                        const Eigen::VectorXd &min_command_sat,
+                                        const Eigen::VectorXd &null_space_parameters,
+                                        const Eigen::VectorXd &compensation_parameters,
+                                        const Eigen::VectorXd &stop_motion_error_alpha,
+                                        const Eigen::VectorXd &stop_motion_bias_threshold,
+                                        const Eigen::VectorXd &stop_motion_bias_step,
+                                        const Eigen::VectorXd &stop_motion_gain_threshold,
+                                        const Eigen::VectorXd &stop_motion_gain_step,
+                                        const Eigen::VectorXd &wrench_estimation_gain)
+{
+    controller_parameters parameters;
+    parameters.name                       = "constant";
+    parameters.horizon_amplitude          = horizon_amplitude;
+    parameters.max_command                = max_command;
+    parameters.error_alpha                = error_alpha;
+    parameters.bias_threshold             = bias_threshold;
+    parameters.bias_step                  = bias_step;
+    parameters.gain_threshold             = gain_threshold;
+    parameters.gain_step                  = gain_step;
+    parameters.min_bias_sat               = min_bias_sat;
+    parameters.min_command_sat            = min_command_sat;
+    parameters.null_space_parameters      = null_space_parameters;
+    parameters.compensation_parameters    = compensation_parameters;
+    parameters.stop_motion_error_alpha    = stop_motion_error_alpha;
+    parameters.stop_motion_bias_threshold = stop_motion_bias_threshold;
+    parameters.stop_motion_bias_step      = stop_motion_bias_step;
+    parameters.stop_motion_gain_threshold = stop_motion_gain_threshold;
+    parameters.stop_motion_gain_step      = stop_motion_gain_step;
+    parameters.wrench_estimation_gain     = wrench_estimation_gain;
+
+    return set_parameters(parameters);
+}
+
+int dynamics_controller::set_parameters(const controller_parameters &parameters)
+{
+    return parameter_store_.publish(parameters);
+}
 
-    // Setting parameters of the ABAG Controller
-    abag_.set_error_alpha(error_alpha);    
-    abag_.set_bias_threshold(bias_threshold);
-    abag_.set_bias_step(bias_step);
-    abag_.set_gain_threshold(gain_threshold);
-    abag_.set_gain_step(gain_step);
-    abag_.set_min_bias_sat_limit(min_bias_sat);
-    abag_.set_min_command_sat_limit(min_command_sat);
-
-    abag_null_space_.set_error_alpha(   null_space_parameters(0), 0);
-    abag_null_space_.set_bias_threshold(null_space_parameters(1), 0);
-    abag_null_space_.set_bias_step(     null_space_parameters(2), 0);
-    abag_null_space_.set_gain_threshold(null_space_parameters(3), 0);
-    abag_null_space_.set_gain_step(     null_space_parameters(4), 0);
-    abag_null_space_.set_min_bias_sat_limit((Eigen::VectorXd(1) << -1.0).finished());
-    abag_null_space_.set_min_command_sat_limit((Eigen::VectorXd(1) << -1.0).finished());
+int dynamics_controller::load_parameters(const std::string &file_path,
+                                         const std::string &set_name,
+                                         const bool watch_file)
+{
+    return watch_file? parameter_store_.watch(file_path, set_name) : parameter_store_.load(file_path, set_name);
+}
+
+int dynamics_controller::set_abag_warm_start(const std::string &file_path,
+                                             const std::string &tool_name)
+{
+    if (tool_name.empty() || tool_name.find_first_of(" \t\n") != std::string::npos)
+    {
+        printf("Tool name must be a single, non-empty word\n");
+        return -1;
+    }
+
+    if (abag_warm_start_.load(file_path) != 0) return -1;
+
+    // Keys of all task models exist from here on: storing at task switches does not allocate
+    for (int model = task_model::full_pose; model <= task_model::gravity_compensation; model++)
+        abag_warm_start_.reserve(model, ROBOT_ID_, tool_name);
+
+    abag_state_file_ = file_path;
+    tool_name_       = tool_name;
+    warm_start_abag_ = true;
+    return 0;
+}
+
+// Restore the stored state of the Cartesian ABAG; dimensions that are not controlled start from zero
+void dynamics_controller::warm_start_abag()
+{
+    if (!warm_start_abag_) return;
+    if (!abag_warm_start_.find(desired_task_model_, ROBOT_ID_, tool_name_, warm_start_bias_, warm_start_gain_)) return;
+
+    for (int i = 0; i < NUM_OF_CONSTRAINTS_; i++)
+    {
+        if (CTRL_DIM_[i]) continue;
+        warm_start_bias_(i) = 0.0;
+        warm_start_gain_(i) = 0.0;
+    }
+    abag_.set_state(warm_start_bias_, warm_start_gain_);
+}
+
+// Only runs that reached their goal without errors are remembered
+void dynamics_controller::store_abag_state()
+{
+    if (!warm_start_abag_ || !fsm_.is_goal_reached()) return;
+    if (error_logger_.error_source_ != error_source::empty) return;
+
+    abag_warm_start_.store(desired_task_model_, ROBOT_ID_, tool_name_, abag_.get_bias(), abag_.get_gain_magnitude());
+}
+
+// Called at the start of a control cycle: apply the parameters published since the previous one
+void dynamics_controller::update_parameters()
+{
+    const parameter_bundle *bundle = parameter_store_.acquire();
+    if (bundle == nullptr) return;
+
+    apply_parameters(bundle->mode[parameter_mode_]);
+    write_parameter_header();
+}
 
-    abag_stop_motion_.set_error_alpha(stop_motion_error_alpha);    
-    abag_stop_motion_.set_bias_threshold(stop_motion_bias_threshold);
-    abag_stop_motion_.set_bias_step(stop_motion_bias_step);
-    abag_stop_motion_.set_gain_threshold(stop_motion_gain_threshold);
-    abag_stop_motion_.set_gain_step(stop_motion_gain_step);
+// Command limits of the run, known only once its first parameters are applied
+void dynamics_controller::write_parameter_header()
+{
+    if (!log_parameter_header_) return;
 
-    this->null_space_parameters_   = null_space_parameters;
-    this->compensation_parameters_ = compensation_parameters;
-    this->wrench_estimation_gain_  = wrench_estimation_gain;
+    for (int i = 0; i < NUM_OF_CONSTRAINTS_; i++)
+        log_file_cart_ << max_command_(i) << " ";
+    log_file_cart_ << std::endl;
+    log_parameter_header_ = false;
+}
+
+// FSM mode change: the sets are prepared and validated in advance, only copied here
+void dynamics_controller::switch_parameter_mode(const int mode)
+{
+    parameter_mode_ = mode;
+    const parameter_bundle *bundle = parameter_store_.get_active();
+    if (bundle != nullptr) apply_parameters(bundle->mode[parameter_mode_]);
+}
+
+// Sizes are fixed by the validation, so none of the assignments below allocates
+void dynamics_controller::apply_parameters(const controller_parameters &parameters)
+{
+    this->horizon_amplitude_ = parameters.horizon_amplitude;
+    this->max_command_       = parameters.max_command;
+
+    // Setting parameters of the ABAG Controller
+    abag_.set_error_alpha(parameters.error_alpha);
+    abag_.set_bias_threshold(parameters.bias_threshold);
+    abag_.set_bias_step(parameters.bias_step);
+    abag_.set_gain_threshold(parameters.gain_threshold);
+    abag_.set_gain_step(parameters.gain_step);
+    abag_.set_min_bias_sat_limit(parameters.min_bias_sat);
+    abag_.set_min_command_sat_limit(parameters.min_command_sat);
+
+    abag_null_space_.set_error_alpha(   parameters.null_space_parameters(0), 0);
+    abag_null_space_.set_bias_threshold(parameters.null_space_parameters(1), 0);
+    abag_null_space_.set_bias_step(     parameters.null_space_parameters(2), 0);
+    abag_null_space_.set_gain_threshold(parameters.null_space_parameters(3), 0);
+    abag_null_space_.set_gain_step(     parameters.null_space_parameters(4), 0);
+
+    abag_stop_motion_.set_error_alpha(parameters.stop_motion_error_alpha);
+    abag_stop_motion_.set_bias_threshold(parameters.stop_motion_bias_threshold);
+    abag_stop_motion_.set_bias_step(parameters.stop_motion_bias_step);
+    abag_stop_motion_.set_gain_threshold(parameters.stop_motion_gain_threshold);
+    abag_stop_motion_.set_gain_step(parameters.stop_motion_gain_step);
+
+    this->null_space_parameters_   = parameters.null_space_parameters;
+    this->compensation_parameters_ = parameters.compensation_parameters;
+    this->wrench_estimation_gain_  = parameters.wrench_estimation_gain;
+    fsm_.set_compensation_parameters(parameters.compensation_parameters);
 }
 
 int dynamics_controller::initialize(const int desired_control_mode, 
@@ -2096,42 +2519,38 @@ int dynamics_controller::initialize(const int desired_control_mode,
     desired_dynamics_interface_     = desired_dynamics_interface;
     store_control_data_             = store_control_data;
     use_estimated_external_wrench_  = use_estimated_external_wrench;
+    desired_motion_profile_         = desired_motion_profile;
+    blend_time_sec_                 = 0.0;
 
-    switch (desired_task_model_)
-    {
-        case task_model::moveConstrained_follow_path:
-            fsm_result_ = fsm_.initialize_with_moveConstrained_follow_path(moveConstrained_follow_path_task_, desired_motion_profile);
-            break;
+    // A previous run may have ended with the approach or contact parameters
+    switch_parameter_mode(parameter_mode::NOMINAL_PARAMETERS);
 
-        case task_model::moveTo_follow_path:
-            fsm_result_ = fsm_.initialize_with_moveTo_follow_path(moveTo_follow_path_task_, desired_motion_profile);
-            break;
+    // Events of the control path are only queued there; this background sink writes them out
+    if (!event_sink_on_) rt_event::start_sink(dynamics_parameter::LOG_FILE_EVENTS_PATH);
+    event_sink_on_ = true;
 
-        case task_model::moveTo:
-            fsm_result_ = fsm_.initialize_with_moveTo(moveTo_task_, desired_motion_profile);
-            break;
-
-        case task_model::moveGuarded:
-            fsm_result_ = fsm_.initialize_with_moveGuarded(moveGuarded_task_, desired_motion_profile);
-            break;
+    // Start with the first queued task, if any, otherwise with the last defined one
+    task_definition *queued_task = task_queue_.front();
+    if (queued_task != nullptr)
+    {
+        load_task_definition(*queued_task, 0.0);
+        task_queue_.pop();
+    }
+    else
+    {
+        // Loaded from a copy: the definition stays available for queueing and for following runs
+        task_definition defined_task = defined_task_;
+        load_task_definition(defined_task, 0.0);
+    }
 
-        case task_model::moveTo_weight_compensation:
-            fsm_result_ = fsm_.initialize_with_moveTo_weight_compensation(moveTo_weight_compensation_task_, desired_motion_profile, compensation_parameters_);
-            break;
+    // Estimation data is logged together with the rest of the control data only. Opened before the FSM writes its header
+    if (store_control_data_) fsm_.open_compensation_log();
 
-        case task_model::full_pose:
-            fsm_result_ = fsm_.initialize_with_full_pose(full_pose_task_, desired_motion_profile);
-            break;
+    fsm_result_ = initialize_fsm();
+    if (fsm_result_ == -1) return -1;
 
-        case task_model::gravity_compensation:
-            fsm_result_ = fsm_.initialize_with_gravity_compensation(gravity_compensation_task_);
-            break;
- 
-        default:
-            printf("Unsupported task model\n");
-            return -1;
-            break;
-    }
+    // In-contact state cannot be used for the free-space approach: this task is warm-started once in contact
+    if (desired_task_model_ != task_model::moveConstrained_follow_path) warm_start_abag();
 
     if (store_control_data_) 
     {
@@ -2148,9 +2567,9 @@ int dynamics_controller::initialize(const int desired_control_mode,
         }
         log_file_cart_ << std::endl;
 
-        for (int i = 0; i < NUM_OF_CONSTRAINTS_; i++)
-            log_file_cart_ << max_command_(i) << " ";
-        log_file_cart_ << std::endl;
+        // Written now if a previous run already applied parameters, otherwise by the first step()
+        log_parameter_header_ = true;
+        if (parameter_store_.get_active() != nullptr) write_parameter_header();
 
         log_file_stop_motion_.open(dynamics_parameter::LOG_FILE_STOP_MOTION_PATH);
         assert(log_file_stop_motion_.is_open());
@@ -2174,12 +2593,7 @@ int dynamics_controller::initialize(const int desired_control_mode,
 
         log_file_null_space_.open(dynamics_parameter::LOG_FILE_NULL_SPACE_PATH);
         assert(log_file_null_space_.is_open());
-        if      (desired_task_model_ == task_model::moveConstrained_follow_path) log_file_null_space_ << moveConstrained_follow_path_task_.null_space_tolerance << std::endl;           
-        else if (desired_task_model_ == task_model::moveTo_follow_path)          log_file_null_space_ << moveTo_follow_path_task_.null_space_tolerance << std::endl;
-        else if (desired_task_model_ == task_model::moveTo_weight_compensation)  log_file_null_space_ << moveTo_weight_compensation_task_.null_space_tolerance << std::endl;
-        else if (desired_task_model_ == task_model::moveGuarded)                 log_file_null_space_ << moveGuarded_task_.null_space_tolerance << std::endl;
-        else if (desired_task_model_ == task_model::moveTo)                      log_file_null_space_ << moveTo_task_.null_space_tolerance << std::endl;
-        else                                                                     log_file_null_space_ << full_pose_task_.null_space_tolerance << std::endl;
+        log_file_null_space_ << null_space_tolerance_ << std::endl;
 
         log_file_joint_.open(dynamics_parameter::LOG_FILE_JOINT_PATH);
         assert(log_file_joint_.is_open());
@@ -2235,6 +2649,8 @@ int dynamics_controller::initialize(const int desired_control_mode,
 
     KDL::SetToZero(estimated_momentum_integral_);
     KDL::SetToZero(filtered_estimated_ext_torque_);
+    reset_lazy_dynamics_cache(mass_cache_);
+    reset_lazy_dynamics_cache(gravity_cache_);
 
     // Make sure that the robot is locked (freezed)
     engage_lock();
@@ -2271,15 +2687,25 @@ int dynamics_controller::estimate_external_wrench(const KDL::JntArray &joint_pos
     * in IEEE Transactions on Robotics, vol. 33(6), pp. 1292-1312, 2017.
     * ==========================================================================
     */
-    int solver_result = this->dynamic_parameter_solver_->JntToMass(joint_position_measured, jnt_mass_matrix_);
-    if (solver_result != 0) return solver_result;
+    // Configuration-dependent terms: M(q), g(q) and the Jacobian pseudo-inverse below are reused while the lazy cache is valid
+    const bool reuse_configuration_terms = reuse_cached_terms(joint_position_measured, mass_cache_);
+
+    int solver_result = 0;
+    if (!reuse_configuration_terms)
+    {
+        solver_result = this->dynamic_parameter_solver_->JntToMass(joint_position_measured, jnt_mass_matrix_);
+        if (solver_result != 0) return solver_result;
+        solver_result = this->dynamic_parameter_solver_->JntToGravity(joint_position_measured, gravity_torque_);
+        if (solver_result != 0) return solver_result;
+
+        // Finite difference over the number of iterations passed since the last refresh. Kept constant in between
+        jnt_mass_matrix_dot_.data = (jnt_mass_matrix_.data - previous_jnt_mass_matrix_.data) / (DT_SEC_ * (lazy_dynamics_on_? mass_cache_.age + 1 : 1));
+        previous_jnt_mass_matrix_.data = jnt_mass_matrix_.data;
+    }
+
+    // Coriolis term depends on the joint velocities and is therefore always recomputed
     solver_result = this->dynamic_parameter_solver_->JntToCoriolis(joint_position_measured, joint_velocity_measured, coriolis_torque_);
     if (solver_result != 0) return solver_result;
-    solver_result = this->dynamic_parameter_solver_->JntToGravity(joint_position_measured, gravity_torque_);
-    if (solver_result != 0) return solver_result;
-
-    jnt_mass_matrix_dot_.data = (jnt_mass_matrix_.data - previous_jnt_mass_matrix_.data) / DT_SEC_;
-    previous_jnt_mass_matrix_.data = jnt_mass_matrix_.data;
 
     total_torque_estimation_.data = robot_state_.control_torque.data - gravity_torque_.data - coriolis_torque_.data + jnt_mass_matrix_dot_.data * joint_velocity_measured.data;
     estimated_momentum_integral_.data += (total_torque_estimation_.data + filtered_estimated_ext_torque_.data) * DT_SEC_;
@@ -2297,22 +2723,27 @@ int dynamics_controller::estimate_external_wrench(const KDL::JntArray &joint_pos
     * Propagate joint torques to Cartesian wrench using a pseudo inverse of Jacobian-Transpose
     * ========================================================================================
     */
-    solver_result = jacobian_solver_.JntToJac(joint_position_measured, jacobian_end_eff_);
-    if (solver_result != 0) return solver_result;
+    if (!reuse_configuration_terms)
+    {
+        solver_result = jacobian_solver_.JntToJac(joint_position_measured, jacobian_end_eff_);
+        if (solver_result != 0) return solver_result;
 
-    solver_result = fk_pos_solver_full_->JntToCart(joint_position_measured, tool_tip_frame_full_model_);
-    if (solver_result != 0) return solver_result;
+        solver_result = fk_pos_solver_full_->JntToCart(joint_position_measured, tool_tip_frame_full_model_);
+        if (solver_result != 0) return solver_result;
 
-    // Transform the jacobian from the base to tool-tip frame
-    jacobian_end_eff_transformed_ = jacobian_end_eff_;
-    jacobian_end_eff_transformed_.changeBase(tool_tip_frame_full_model_.M.Inverse());
+        // Transform the jacobian from the base to tool-tip frame
+        jacobian_end_eff_transformed_ = jacobian_end_eff_;
+        jacobian_end_eff_transformed_.changeBase(tool_tip_frame_full_model_.M.Inverse());
 
-    // Compute SVD of the jacobian using Eigen functions
-    Eigen::JacobiSVD<Eigen::MatrixXd> svd(jacobian_end_eff_transformed_.data.transpose(), Eigen::ComputeThinU | Eigen::ComputeThinV);
+        // Compute SVD of the jacobian using Eigen functions
+        Eigen::JacobiSVD<Eigen::MatrixXd> svd(jacobian_end_eff_transformed_.data.transpose(), Eigen::ComputeThinU | Eigen::ComputeThinV);
 
-    Eigen::VectorXd singular_inv(svd.singularValues());
-    for (int j = 0; j < singular_inv.size(); ++j) singular_inv(j) = (singular_inv(j) < 1e-8) ? 0.0 : 1.0 / singular_inv(j);
-    jacobian_end_eff_inv_.noalias() = svd.matrixV() * singular_inv.matrix().asDiagonal() * svd.matrixU().adjoint();
+        Eigen::VectorXd singular_inv(svd.singularValues());
+        for (int j = 0; j < singular_inv.size(); ++j) singular_inv(j) = (singular_inv(j) < 1e-8) ? 0.0 : 1.0 / singular_inv(j);
+        jacobian_end_eff_inv_.noalias() = svd.matrixV() * singular_inv.matrix().asDiagonal() * svd.matrixU().adjoint();
+
+        refresh_cached_terms(joint_position_measured, mass_cache_);
+    }
 
     // Compute End-Effector Cartesian forces from joint external torques
     Eigen::VectorXd wrench = jacobian_end_eff_inv_ * filtered_estimated_ext_torque_.data;
@@ -2331,15 +2762,11 @@ int dynamics_controller::update_stop_motion_commands()
     if (robot_driver_->get_robot_environment() == 1) return 1;
     if (stop_loop_iteration_count_ % dynamics_parameter::DECELERATION_UPDATE_DELAY == 0)
     {
+        // Setpoints are held for DECELERATION_UPDATE_DELAY iterations and sampled one update period ahead
+        const double setpoint_time = (stop_loop_iteration_count_ / dynamics_parameter::DECELERATION_UPDATE_DELAY + 1) * 
+                                     dynamics_parameter::DECELERATION_UPDATE_DELAY / dynamics_parameter::STOPPING_MOTION_LOOP_FREQ; // sec
         for (int i = 0; i < NUM_OF_JOINTS_; i++)
-        {
-            if (stop_motion_setpoint_array_[i].size() > 0)
-            {
-                desired_state_.qd(i) = stop_motion_setpoint_array_[i].front();
-                stop_motion_setpoint_array_[i].pop_front();
-            }
-            else desired_state_.qd(i) = 0.0;
-        }
+            desired_state_.qd(i) = braking_planner_.get_velocity(i, setpoint_time);
     }
 
     // Compute control error
@@ -2393,6 +2820,7 @@ int dynamics_controller::update_commands()
             return -1;
         }
     }
+    record_stage_time(step_stage::CARTESIAN_COMMANDS);
 
     // Evaluate robot dynamics using the Vereshchagin HD solver
     if (desired_task_model_ != task_model::gravity_compensation)
@@ -2405,6 +2833,7 @@ int dynamics_controller::update_commands()
             return -1;
         }
     }
+    record_stage_time(step_stage::HYBRID_DYNAMICS);
 
     // Compute necessary torques for compensating gravity, using the RNE ID solver
     if (COMPENSATE_GRAVITY_ || desired_task_model_ == task_model::gravity_compensation) 
@@ -2417,6 +2846,7 @@ int dynamics_controller::update_commands()
             return -1;
         }
     }
+    record_stage_time(step_stage::GRAVITY_COMPENSATION);
     return 0;
 }
 
@@ -2433,6 +2863,10 @@ int dynamics_controller::step(const KDL::JntArray &q_input,
                               const int stop_loop_iteration,
                               const bool stopping_behaviour_on)
 {
+    // Cycle start for the safety horizon budget. The internal loop stamps it before reading the sensors
+    if (!loop_start_stamped_) loop_start_time_ = std::chrono::steady_clock::now();
+    loop_start_stamped_ = false;
+
     robot_state_.q  = q_input;
     robot_state_.qd = qd_input;
     robot_state_.measured_torque = tau_measured;
@@ -2441,6 +2875,11 @@ int dynamics_controller::step(const KDL::JntArray &q_input,
     loop_iteration_count_ = main_loop_iteration;
     stop_loop_iteration_count_ = stop_loop_iteration;
     stopping_sequence_on_ = stopping_behaviour_on;
+    rt_event::set_cycle(main_loop_iteration);
+
+    reset_stage_times();
+    update_parameters();
+    record_stage_time(step_stage::PARAMETER_UPDATE);
 
     if (!stopping_sequence_on_) // Control main task in Cartesian State
     {
@@ -2457,10 +2896,16 @@ int dynamics_controller::step(const KDL::JntArray &q_input,
         }
         // Save the state expressed in base frame
         robot_state_base_.frame_pose = robot_state_.frame_pose;
+        record_stage_time(step_stage::FORWARD_KINEMATICS);
+
+        // Chain the next queued task, once the current one has reached its goal
+        if (fsm_.is_goal_reached() && !task_queue_.empty()) switch_to_queued_task();
 
         compute_control_error();
+        record_stage_time(step_stage::CONTROL_ERROR);
 
         status = check_fsm_status();
+        record_stage_time(step_stage::FSM_STATUS);
         if (status == -1)
         {
             error_logger_.error_source_ = error_source::fsm;
@@ -2475,6 +2920,14 @@ int dynamics_controller::step(const KDL::JntArray &q_input,
         // }
 
         if (update_commands() == -1) return -1;
+
+        // Cross-fade from the last command of the previous chained task
+        if (total_time_sec_ - blend_start_time_sec_ < blend_time_sec_)
+        {
+            const double s      = (total_time_sec_ - blend_start_time_sec_) / blend_time_sec_;
+            const double weight = s * s * (3.0 - 2.0 * s);
+            robot_state_.control_torque.data = weight * robot_state_.control_torque.data + (1.0 - weight) * blend_start_torque_.data;
+        }
     }
     else // Control in joint space to stop the robot
     {
@@ -2482,16 +2935,12 @@ int dynamics_controller::step(const KDL::JntArray &q_input,
         {
             desired_control_mode_.interface = control_mode::TORQUE;
             steady_stop_iteration_count_ = 0;
-            stop_motion_setpoint_array_.clear();
-            double step = 0.0;
-            for (int i = 0; i < NUM_OF_JOINTS_; i++)
-            {
-                step = JOINT_ACC_LIMITS_[i] * (dynamics_parameter::DECELERATION_UPDATE_DELAY / dynamics_parameter::STOPPING_MOTION_LOOP_FREQ) * ((robot_state_.qd(i) > 0.0)? -1.0 : 1.0); // rad/sec
-                stop_motion_setpoint_array_.push_back(motion_profile::ramp_array(robot_state_.qd(i), 0.0, step, dynamics_parameter::LOWER_DECELERATION_RAMP_THRESHOLD));
-            }
+            braking_planner_.plan(robot_state_.qd.data, dynamics_parameter::SYNCHRONIZE_STOPPING_MOTION);
         }
 
-        if (update_stop_motion_commands() == 1) return 1;
+        const int status = update_stop_motion_commands();
+        record_stage_time(step_stage::STOPPING_MOTION);
+        if (status == 1) return 1;
     }
 
     // Save final commands
@@ -2516,6 +2965,7 @@ int dynamics_controller::control()
     {
         // Save current time point
         loop_start_time_ = std::chrono::steady_clock::now();
+        loop_start_stamped_ = true;
         if (!stopping_sequence_on_) total_time_sec_ = loop_iteration_count_ * DT_SEC_;
 
         // Get current state from robot sensors
@@ -2567,7 +3017,7 @@ int dynamics_controller::control()
             }
 
             stop_loop_iteration_count_++;
-            if (enforce_loop_frequency(DT_STOPPING_MICRO_) != 0) control_loop_delay_count_++;
+            if (enforce_loop_frequency(DT_STOPPING_MICRO_) != 0) report_deadline_miss(DT_STOPPING_MICRO_);
             // Testing loop time
             // loop_time += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - loop_start_time_).count();
             // if (stop_loop_iteration_count_ == 2000) 
@@ -2595,7 +3045,7 @@ int dynamics_controller::control()
             }
 
             loop_iteration_count_++;
-            if (enforce_loop_frequency(DT_MICRO_) != 0) control_loop_delay_count_++;
+            if (enforce_loop_frequency(DT_MICRO_) != 0) report_deadline_miss(DT_MICRO_);
             // Testing loop time
             // loop_time += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - loop_start_time_).count();
             // if (loop_iteration_count_ == 2000) 
@@ -2610,8 +3060,18 @@ int dynamics_controller::control()
 
 void dynamics_controller::deinitialize()
 {
+    // Writes the events still queued, before the statistics below
+    if (event_sink_on_) rt_event::stop_sink();
+    event_sink_on_ = false;
+
     if (store_control_data_) close_files();
 
+    if (warm_start_abag_)
+    {
+        store_abag_state();
+        abag_warm_start_.save(abag_state_file_);
+    }
+
     if (error_logger_.error_source_ != error_source::empty)
     {
         printf("Robot ID: %d\n", error_logger_.robot_id_);
@@ -2622,9 +3082,284 @@ void dynamics_controller::deinitialize()
     printf("Loop Statistics: \n");
     printf("   - Number of iterations: %d\n", loop_iteration_count_);
     printf("   - Total time: %f sec\n", total_time_sec_);
+    if (lazy_dynamics_on_)
+    {
+        printf("   - Lazy M(q)/J(q) cache hits: %d of %d\n", mass_cache_.hits, mass_cache_.hits + mass_cache_.misses);
+        printf("   - Lazy g(q) cache hits: %d of %d\n", gravity_cache_.hits, gravity_cache_.hits + gravity_cache_.misses);
+    }
     // printf("   - Delay in control loop occurred %d times\n\n", control_loop_delay_count_);
 }
 
+void dynamics_controller::set_lazy_dynamics(const bool enable,
+                                            const double delta_q_bound,
+                                            const int refresh_period)
+{
+    assert(("Joint displacement bound must be non-negative", delta_q_bound >= 0.0));
+    assert(("Refresh period must be positive", refresh_period > 0));
+
+    lazy_dynamics_on_ = enable;
+    lazy_delta_q_bound_ = delta_q_bound;
+    lazy_refresh_period_ = refresh_period;
+
+    reset_lazy_dynamics_cache(mass_cache_);
+    reset_lazy_dynamics_cache(gravity_cache_);
+}
+
+void dynamics_controller::set_path_projection(const bool enable)
+{
+    use_path_projection_ = enable;
+}
+
+void dynamics_controller::set_free_running(const bool enable)
+{
+    free_running_ = enable;
+}
+
+const fsm_snapshot &dynamics_controller::get_fsm_snapshot() const
+{
+    return fsm_snapshot_;
+}
+
+bool dynamics_controller::is_goal_reached() const
+{
+    return fsm_.is_goal_reached();
+}
+
+int dynamics_controller::get_task_status() const
+{
+    return fsm_result_;
+}
+
+void dynamics_controller::set_stage_timing(const bool enable)
+{
+    stage_timing_on_ = enable;
+    std::fill(stage_time_micro_.begin(), stage_time_micro_.end(), 0.0);
+}
+
+const std::vector<double> &dynamics_controller::get_stage_times() const
+{
+    return stage_time_micro_;
+}
+
+void dynamics_controller::reset_stage_times()
+{
+    if (!stage_timing_on_) return;
+    std::fill(stage_time_micro_.begin(), stage_time_micro_.end(), 0.0);
+    stage_start_time_ = std::chrono::steady_clock::now();
+}
+
+// Time since the previous stage of the step ended
+void dynamics_controller::record_stage_time(const int stage)
+{
+    if (!stage_timing_on_) return;
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    stage_time_micro_[stage] += std::chrono::duration<double, std::micro>(now - stage_start_time_).count();
+    stage_start_time_ = now;
+}
+
+int dynamics_controller::queue_task(const double blend_time_sec)
+{
+    defined_task_.blend_time_sec = blend_time_sec;
+
+    if (!task_queue_.push(defined_task_))
+    {
+        printf("Task queue is full\n");
+        return -1;
+    }
+    return 0;
+}
+
+int dynamics_controller::get_number_of_queued_tasks() const
+{
+    return task_queue_.size();
+}
+
+/**
+ * Swaps a queued definition in; the previous task's state is left in the queue slot.
+ * No memory is allocated or released here, such that it can be done in the control loop.
+ * Time limits of the task are shifted to the time it is started.
+ */
+void dynamics_controller::load_task_definition(task_definition &definition, const double time_offset_sec)
+{
+    desired_task_model_ = definition.task_model;
+    active_task_.swap(definition.task);
+
+    switch (desired_task_model_)
+    {
+        case task_model::moveConstrained_follow_path:
+            std::swap(moveConstrained_follow_path_task_, definition.moveConstrained_follow_path);
+            moveConstrained_follow_path_task_.time_limit += time_offset_sec;
+            null_space_tolerance_ = moveConstrained_follow_path_task_.null_space_tolerance;
+            break;
+
+        case task_model::moveTo_follow_path:
+            std::swap(moveTo_follow_path_task_, definition.moveTo_follow_path);
+            moveTo_follow_path_task_.time_limit += time_offset_sec;
+            null_space_tolerance_ = moveTo_follow_path_task_.null_space_tolerance;
+            break;
+
+        case task_model::moveTo:
+            std::swap(moveTo_task_, definition.moveTo);
+            moveTo_task_.time_limit += time_offset_sec;
+            null_space_tolerance_ = moveTo_task_.null_space_tolerance;
+            break;
+
+        case task_model::moveGuarded:
+            std::swap(moveGuarded_task_, definition.moveGuarded);
+            moveGuarded_task_.time_limit += time_offset_sec;
+            null_space_tolerance_ = moveGuarded_task_.null_space_tolerance;
+            break;
+
+        case task_model::moveTo_weight_compensation:
+            std::swap(moveTo_weight_compensation_task_, definition.moveTo_weight_compensation);
+            moveTo_weight_compensation_task_.time_limit += time_offset_sec;
+            null_space_tolerance_ = moveTo_weight_compensation_task_.null_space_tolerance;
+            break;
+
+        case task_model::full_pose:
+            std::swap(full_pose_task_, definition.full_pose);
+            full_pose_task_.time_limit += time_offset_sec;
+            null_space_tolerance_ = full_pose_task_.null_space_tolerance;
+            break;
+
+        case task_model::gravity_compensation:
+            std::swap(gravity_compensation_task_, definition.gravity_compensation);
+            gravity_compensation_task_.time_limit += time_offset_sec;
+            null_space_tolerance_ = full_pose_task_.null_space_tolerance; // No tolerance of its own
+            abag_error_vector_.setZero();
+            KDL::SetToZero(cart_force_command_[END_EFF_]);
+            break;
+
+        default:
+            assert(("Unsupported task model", false));
+            break;
+    }
+
+    CTRL_DIM_.swap(definition.ctrl_dim);
+    POS_TUBE_DIM_.swap(definition.pos_tube_dim);
+    MOTION_CTRL_DIM_.swap(definition.motion_ctrl_dim);
+    FORCE_CTRL_DIM_.swap(definition.force_ctrl_dim);
+    desired_state_.frame_pose[END_EFF_]      = definition.desired_pose;
+    desired_state_.frame_velocity[END_EFF_]  = definition.desired_velocity;
+    desired_state_.external_force[END_EFF_]  = definition.desired_force;
+    transform_drivers_          = definition.transform_drivers;
+    transform_force_drivers_    = definition.transform_force_drivers;
+    compute_null_space_command_ = definition.compute_null_space_command;
+    compensate_unknown_weight_  = definition.compensate_unknown_weight;
+    desired_null_space_angle_   = definition.desired_null_space_angle;
+    std::swap(path_projection_, definition.projection);
+    path_stream_ = definition.path_stream;
+    spline_frames_.path.swap(definition.spline_frames.path);
+    spline_frames_.arc_lengths.swap(definition.spline_frames.arc_lengths);
+
+    // Valid before the first tube section update, e.g. for the approach stage of the constrained task
+    if (spline_frames_.path != nullptr)
+    {
+        const Eigen::Vector3d start = spline_frames_.path->get_position(0.0);
+        spline_section_frame_ = compute_spline_section_frame(0, KDL::Vector(start(0), start(1), start(2)));
+    }
+}
+
+void dynamics_controller::switch_to_queued_task()
+{
+    task_definition *queued_task = task_queue_.front();
+    if (queued_task == nullptr) return;
+
+    // Finished task: keep what its ABAG has learned; the next one continues from the current state
+    store_abag_state();
+
+    // Last command of the finished task is the starting point of the blend
+    blend_start_torque_   = robot_state_.control_torque;
+    blend_start_time_sec_ = total_time_sec_;
+    blend_time_sec_       = queued_task->blend_time_sec;
+
+    load_task_definition(*queued_task, total_time_sec_);
+    task_queue_.pop();
+
+    // Restart the task-stage state; ABAG and the solvers keep theirs.
+    // The finished task ended in STOP_ROBOT: without NOMINAL, a force task would skip its APPROACH set-up
+    tube_section_count_      = 0;
+    fsm_force_task_result_   = task_status::APPROACH;
+    previous_task_status_    = task_status::NOMINAL;
+    apply_feedforward_force_ = false;
+    switch_parameter_mode(parameter_mode::NOMINAL_PARAMETERS);
+    fsm_.reset_task_status();
+
+    // FSM references the task members just loaded: nothing is copied here
+    fsm_result_ = initialize_fsm();
+
+    rt_event::publish(rt_event::FSM_TRANSITION, rt_event::TASK_SWITCHED, task_queue_.size());
+}
+
+int dynamics_controller::initialize_fsm()
+{
+    switch (desired_task_model_)
+    {
+        case task_model::moveConstrained_follow_path:
+            return fsm_.initialize_with_moveConstrained_follow_path(moveConstrained_follow_path_task_, desired_motion_profile_);
+
+        case task_model::moveTo_follow_path:
+            return fsm_.initialize_with_moveTo_follow_path(moveTo_follow_path_task_, desired_motion_profile_);
+
+        case task_model::moveTo:
+            return fsm_.initialize_with_moveTo(moveTo_task_, desired_motion_profile_);
+
+        case task_model::moveGuarded:
+            return fsm_.initialize_with_moveGuarded(moveGuarded_task_, desired_motion_profile_);
+
+        case task_model::moveTo_weight_compensation:
+        {
+            int result = fsm_.initialize_with_moveTo_weight_compensation(moveTo_weight_compensation_task_, desired_motion_profile_);
+            // Parameters applied by a previous run or task are handed over at once, otherwise by the first step()
+            if (parameter_store_.get_active() != nullptr) fsm_.set_compensation_parameters(compensation_parameters_);
+            return result;
+        }
+
+        case task_model::full_pose:
+            return fsm_.initialize_with_full_pose(full_pose_task_, desired_motion_profile_);
+
+        case task_model::gravity_compensation:
+            return fsm_.initialize_with_gravity_compensation(gravity_compensation_task_);
+
+        default:
+            printf("Unsupported task model\n");
+            return -1;
+    }
+}
+
+// Returns true if the terms computed at cache.q_reference can be reused for the given configuration
+bool dynamics_controller::reuse_cached_terms(const KDL::JntArray &q, lazy_dynamics_cache &cache)
+{
+    if (!lazy_dynamics_on_) return false;
+
+    if ((cache.age < lazy_refresh_period_) && ((q.data - cache.q_reference.data).norm() < lazy_delta_q_bound_))
+    {
+        cache.age++;
+        cache.hits++;
+        return true;
+    }
+
+    cache.misses++;
+    return false;
+}
+
+void dynamics_controller::refresh_cached_terms(const KDL::JntArray &q, lazy_dynamics_cache &cache)
+{
+    cache.q_reference = q;
+    cache.age = 0;
+}
+
+void dynamics_controller::reset_lazy_dynamics_cache(lazy_dynamics_cache &cache)
+{
+    cache.q_reference.resize(NUM_OF_JOINTS_);
+    KDL::SetToZero(cache.q_reference);
+
+    // Force refresh in the first iteration
+    cache.age = lazy_refresh_period_;
+    cache.hits = 0;
+    cache.misses = 0;
+}
+
 void dynamics_controller::close_files()
 {
     log_file_cart_.close();
@@ -2634,4 +3369,5 @@ void dynamics_controller::close_files()
     log_file_predictions_.close();
     log_file_null_space_.close();
     log_file_ext_wrench_.close();
+    fsm_.close_compensation_log();
 }
\ No newline at end of file
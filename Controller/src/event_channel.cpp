@@ -0,0 +1,324 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <event_channel.hpp>
+#include <finite_state_machine.hpp>
+#include <constants.hpp>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+    const std::chrono::steady_clock::time_point START_TIME = std::chrono::steady_clock::now();
+    thread_local int current_cycle = 0;
+
+    // Defined before the sink: destroyed after it, so that the sink can drain it at exit
+    event_channel events(dynamics_parameter::EVENT_CHANNEL_CAPACITY);
+
+    // Capacity is rounded up to a power of two: positions map to slots with a mask
+    unsigned int slot_mask(const int capacity)
+    {
+        unsigned int size = 1;
+        while (size < (unsigned int)capacity) size <<= 1;
+        return size - 1;
+    }
+
+    const char *task_status_name(const int status)
+    {
+        switch (status)
+        {
+            case task_status::STOP_CONTROL:        return "STOP_CONTROL";
+            case task_status::NOMINAL:             return "NOMINAL";
+            case task_status::START_TO_CRUISE:     return "START_TO_CRUISE";
+            case task_status::CRUISE_TO_STOP:      return "CRUISE_TO_STOP";
+            case task_status::CRUISE_THROUGH_TUBE: return "CRUISE_THROUGH_TUBE";
+            case task_status::CRUISE:              return "CRUISE";
+            case task_status::CHANGE_TUBE_SECTION: return "CHANGE_TUBE_SECTION";
+            case task_status::APPROACH:            return "APPROACH";
+            case task_status::STOP_ROBOT:          return "STOP_ROBOT";
+            default:                               return "UNKNOWN";
+        }
+    }
+
+    const char *safety_check_name(const int check)
+    {
+        switch (check)
+        {
+            case rt_event::TORQUE_NOT_FINITE:       return "computed torque is not finite";
+            case rt_event::ACCELERATION_NOT_FINITE: return "computed acceleration is not finite";
+            case rt_event::VELOCITY_NOT_FINITE:     return "computed velocity is not finite";
+            case rt_event::POSITION_NOT_FINITE:     return "computed position is not finite";
+            case rt_event::TORQUE_LIMIT:            return "torque limit reached";
+            case rt_event::VELOCITY_LIMIT:          return "velocity limit reached";
+            case rt_event::POSITION_LIMIT:          return "position limit reached";
+            case rt_event::APPROACHING_MAX_LIMIT:   return "is too close to the max limit";
+            case rt_event::APPROACHING_MIN_LIMIT:   return "is too close to the min limit";
+            default:                                return "unknown safety check failed";
+        }
+    }
+
+    const char *solver_source_name(const int source)
+    {
+        switch (source)
+        {
+            case rt_event::KINOVA_MEDIATOR:     return "kinova mediator";
+            case rt_event::SIMULATION_MEDIATOR: return "simulation mediator";
+            case rt_event::SAFETY_PREDICTION:   return "safety prediction";
+            default:                            return "unknown source";
+        }
+    }
+
+    // One line of text per event; returns the length of the line
+    int format_event(const rt_event::event &item, char *line, const int size)
+    {
+        const int prefix = snprintf(line, size, "[%10.4f s | cycle %7d] ", item.time_sec, item.cycle);
+        char *text = line + prefix;
+        const int left = size - prefix;
+        const char axis = (item.index >= 0 && item.index < 3)? "XYZ"[item.index] : '?';
+
+        switch (item.type)
+        {
+            case rt_event::FSM_TRANSITION:
+                switch (item.code)
+                {
+                    case rt_event::TIME_LIMIT_REACHED: return prefix + snprintf(text, left, "Time limit reached\n");
+                    case rt_event::PATH_COVERED:       return prefix + snprintf(text, left, "Whole path covered\n");
+                    case rt_event::GOAL_REACHED:       return prefix + snprintf(text, left, "Goal area reached\n");
+                    case rt_event::TASK_SWITCHED:
+                        return prefix + snprintf(text, left, "Switched to the next queued task. Tasks left: %d\n", item.index);
+                    default:
+                        return prefix + snprintf(text, left, "Control status changed to %s, from %s\n",
+                                                 task_status_name(item.index), task_status_name((int)item.value[0]));
+                }
+
+            case rt_event::CONTACT:
+                return prefix + snprintf(text, left, "%s: %f, %f, %f N\n",
+                                         (item.code == rt_event::NON_DESIRED_CONTACT)? "Non-desired contact occurred" :
+                                         (item.code == rt_event::CONTACT_LOST)? "Contact lost" : "Contact occurred",
+                                         item.value[0], item.value[1], item.value[2]);
+
+            case rt_event::SAFETY_STOP:
+                if (item.value[2] > 0.0)
+                    return prefix + snprintf(text, left, "Joint %d %s: %f, limit %f, in %d steps\n", item.index + 1,
+                                             safety_check_name(item.code), item.value[0], item.value[1], (int)item.value[2]);
+                return prefix + snprintf(text, left, "Joint %d %s: %f, limit %f\n", item.index + 1,
+                                         safety_check_name(item.code), item.value[0], item.value[1]);
+
+            case rt_event::SOLVER_ERROR:
+                return prefix + snprintf(text, left, "FD solver in %s returned error: %d\n",
+                                         solver_source_name(item.index), item.code);
+
+            case rt_event::DEADLINE_MISS:
+                return prefix + snprintf(text, left, "Deadline missed (%d so far): cycle time %.1f us, period %d us\n",
+                                         item.index, item.value[0], item.code);
+
+            case rt_event::WEIGHT_COMPENSATION:
+                switch (item.code)
+                {
+                    case rt_event::TRIGGERED:
+                        return prefix + snprintf(text, left, "Trigger %c: %f, %f, %f\n", axis, item.value[0], item.value[1], item.value[2]);
+                    case rt_event::ESTIMATION_COMPLETED:
+                        return prefix + snprintf(text, left, "%c Estimation completed\n", axis);
+                    case rt_event::FORCE_UPDATED:
+                        return prefix + snprintf(text, left, "%c Force: %f\n", axis, item.value[0]);
+                    default:
+                        return prefix + snprintf(text, left, "Updated mass: %f\n", item.value[0]);
+                }
+
+            case rt_event::TASK_ERROR:
+                switch (item.code)
+                {
+                    case rt_event::NULL_SPACE_NORM_TOO_SMALL:
+                        return prefix + snprintf(text, left, "Null space norm too small: %f\n", item.value[0]);
+                    case rt_event::PATH_READ_FAILED:
+                        return prefix + snprintf(text, left, "Reading the path file failed at point %d. Stopping the robot\n", item.index);
+                    default:
+                        return prefix + snprintf(text, left, "Invalid point in path file, at point index: %d\n", item.index);
+                }
+
+            default:
+                return prefix + snprintf(text, left, "Unknown event type: %d\n", item.type);
+        }
+    }
+
+    /**
+     * Owned by the sink functions only: never touched by the control threads.
+     * Its destructor stops a sink that is still running at exit, e.g. after a failed controller run.
+     */
+    struct event_sink
+    {
+        std::mutex mutex;
+        int users = 0;
+        bool file_created = false;
+        std::atomic<bool> running{false};
+        std::thread worker;
+        FILE *file = nullptr;
+
+        void drain()
+        {
+            char line[256];
+            rt_event::event item;
+            bool written = false;
+            while (events.pop(item))
+            {
+                const int length = std::min(format_event(item, line, sizeof(line)), (int)sizeof(line) - 1);
+                fwrite(line, 1, length, stdout);
+                if (file != nullptr) fwrite(line, 1, length, file);
+                written = true;
+            }
+
+            if (!written) return;
+            fflush(stdout);
+            if (file != nullptr) fflush(file);
+        }
+
+        void run()
+        {
+            while (running.load(std::memory_order_acquire))
+            {
+                drain();
+                std::this_thread::sleep_for(std::chrono::milliseconds(dynamics_parameter::EVENT_SINK_POLL_PERIOD_MS));
+            }
+            drain();
+        }
+
+        void stop()
+        {
+            running.store(false, std::memory_order_release);
+            if (worker.joinable()) worker.join();
+
+            const int dropped = events.get_dropped_count();
+            if (dropped > 0) printf("Real-time events dropped: %d\n", dropped);
+            if (file != nullptr) fclose(file);
+            file = nullptr;
+        }
+
+        ~event_sink()
+        {
+            if (users > 0) stop();
+        }
+    };
+
+    event_sink sink;
+}
+
+event_channel::event_channel(const int capacity):
+    MASK_(slot_mask(capacity)),
+    slots_(new slot[MASK_ + 1]), enqueue_position_(0), dequeue_position_(0), dropped_count_(0)
+{
+    assert(("Channel capacity must be positive", capacity > 0));
+    for (unsigned int i = 0; i <= MASK_; i++) slots_[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool event_channel::push(const rt_event::event &item)
+{
+    unsigned int position = enqueue_position_.load(std::memory_order_relaxed);
+    slot *target = nullptr;
+    while (true)
+    {
+        target = &slots_[position & MASK_];
+        const int difference = (int)(target->sequence.load(std::memory_order_acquire) - position);
+
+        // Free for this position: claim it. Otherwise another producer was faster, or the channel is full
+        if (difference == 0)
+        {
+            if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+        }
+        else if (difference < 0)
+        {
+            dropped_count_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else position = enqueue_position_.load(std::memory_order_relaxed);
+    }
+
+    target->item = item;
+    target->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool event_channel::pop(rt_event::event &item)
+{
+    slot &source = slots_[dequeue_position_ & MASK_];
+    if ((int)(source.sequence.load(std::memory_order_acquire) - (dequeue_position_ + 1)) < 0) return false;
+
+    item = source.item;
+    source.sequence.store(dequeue_position_ + MASK_ + 1, std::memory_order_release);
+    dequeue_position_++;
+    return true;
+}
+
+int event_channel::get_dropped_count() const
+{
+    return dropped_count_.load(std::memory_order_relaxed);
+}
+
+void rt_event::publish(const int type, const int code, const int index,
+                       const double value_0, const double value_1, const double value_2)
+{
+    event item;
+    item.type     = type;
+    item.code     = code;
+    item.index    = index;
+    item.cycle    = current_cycle;
+    item.time_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - START_TIME).count();
+    item.value[0] = value_0;
+    item.value[1] = value_1;
+    item.value[2] = value_2;
+    events.push(item);
+}
+
+void rt_event::set_cycle(const int cycle)
+{
+    current_cycle = cycle;
+}
+
+int rt_event::start_sink(const std::string &file_path)
+{
+    std::lock_guard<std::mutex> lock(sink.mutex);
+    if (sink.users++ > 0) return 0;
+
+    // First session of the process starts a new file; later ones append to it
+    sink.file = fopen(file_path.c_str(), sink.file_created? "a" : "w");
+    sink.file_created = sink.file_created || (sink.file != nullptr);
+
+    sink.running.store(true, std::memory_order_release);
+    sink.worker = std::thread(&event_sink::run, &sink);
+
+    if (sink.file != nullptr) return 0;
+    printf("Failed to open the event file: %s\n", file_path.c_str());
+    return -1;
+}
+
+void rt_event::stop_sink()
+{
+    std::lock_guard<std::mutex> lock(sink.mutex);
+    if (sink.users == 0) return;
+    if (--sink.users > 0) return;
+    sink.stop();
+}
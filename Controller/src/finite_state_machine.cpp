@@ -33,15 +33,17 @@ finite_state_machine::finite_state_machine(const int num_of_joints,
     NUM_OF_FRAMES_(num_of_frames), NUM_OF_CONSTRAINTS_(num_of_constraints),
     END_EFF_(NUM_OF_SEGMENTS_ - 1), desired_task_model_(task_model::full_pose),
     motion_profile_(m_profile::CONSTANT), loop_period_count_(0),
-    compensator_trigger_count_(0), iterations_(0), total_control_time_sec_(0.0),
-    previous_task_time_(0.0), total_contact_time_(0.0),
+    compensator_trigger_count_(0), total_control_time_sec_(0.0),
+    previous_task_time_(0.0), total_contact_time_(0.0), profile_start_time_sec_(-1.0),
     goal_reached_(false), time_limit_reached_(false), contact_detected_(false),
-    contact_alignment_performed_(false), write_compensation_time_to_file_(false), 
+    contact_alignment_performed_(false), write_compensation_time_to_file_(false), write_compensation_header_(false),
     filtered_bias_(Eigen::VectorXd::Zero(6)), compensation_parameters_(Eigen::VectorXd::Zero(12)),
-    robot_state_(NUM_OF_JOINTS_, NUM_OF_SEGMENTS_, NUM_OF_FRAMES_, NUM_OF_CONSTRAINTS_),
-    desired_state_(robot_state_), 
     variance_gain_(100, 6), variance_bias_(100, 6), slope_bias_(100, 6),
-    current_error_(KDL::Twist::Zero()), ext_wrench_(KDL::Wrench::Zero())
+    ext_wrench_(KDL::Wrench::Zero()),
+    moveTo_task_(nullptr), moveGuarded_task_(nullptr), moveTo_weight_compensation_task_(nullptr),
+    full_pose_task_(nullptr), gravity_compensation_task_(nullptr),
+    moveTo_follow_path_task_(nullptr), moveConstrained_follow_path_task_(nullptr),
+    update_task_(&finite_state_machine::update_full_pose_task)
 {
 }
 
@@ -49,7 +51,8 @@ int finite_state_machine::initialize_with_moveConstrained_follow_path(const move
                                                                       const int motion_profile)
 {
     desired_task_model_               = task_model::moveConstrained_follow_path;
-    moveConstrained_follow_path_task_ = task;
+    update_task_                      = &finite_state_machine::update_moveConstrained_follow_path_task;
+    moveConstrained_follow_path_task_ = &task;
     motion_profile_                   = motion_profile;
 
     // log_file_ext_force_.open("/home/djole/Master/Thesis/GIT/MT_testing/Controller/visualization/ext_force_data.txt");
@@ -62,7 +65,8 @@ int finite_state_machine::initialize_with_moveTo_follow_path(const moveTo_follow
                                                              const int motion_profile)
 {
     desired_task_model_      = task_model::moveTo_follow_path;
-    moveTo_follow_path_task_ = task;
+    update_task_             = &finite_state_machine::update_moveTo_follow_path_task;
+    moveTo_follow_path_task_ = &task;
     motion_profile_          = motion_profile;
 
     return task_status::NOMINAL;
@@ -72,20 +76,12 @@ int finite_state_machine::initialize_with_moveTo(const moveTo_task &task,
                                                  const int motion_profile)
 {
     desired_task_model_ = task_model::moveTo;
-    moveTo_task_        = task;
+    update_task_        = &finite_state_machine::update_moveTo_task;
+    moveTo_task_        = &task;
     motion_profile_     = motion_profile;
-    switch (motion_profile_)
-    {
-        case m_profile::RAMP:
-            speed_array_ = motion_profile::ramp_array(0.0, 0.21, 0.001, 0.0001);
-            break;
-        case m_profile::S_CURVE:
-            speed_array_ = motion_profile::s_curve_array(0.0, moveTo_task_.tube_length, 0.0005, 0.0, moveTo_task_.tube_speed, M_PI / moveTo_task_.tube_length + 0.1);
-            break;
-        default:
-            speed_array_ = std::deque<double>(1, moveTo_task_.tube_speed);
-            break;
-    }
+
+    // Speed profiles are evaluated in closed form, w.r.t. the time of the first task update
+    profile_start_time_sec_ = -1.0;
 
     return task_status::NOMINAL;
 }
@@ -94,34 +90,60 @@ int finite_state_machine::initialize_with_moveGuarded(const moveGuarded_task &ta
                                                       const int motion_profile)
 {
     desired_task_model_ = task_model::moveGuarded;
-    moveGuarded_task_   = task;
+    update_task_        = &finite_state_machine::update_moveGuarded_task;
+    moveGuarded_task_   = &task;
     motion_profile_     = motion_profile;
 
     return task_status::NOMINAL;
 }
 
 int finite_state_machine::initialize_with_moveTo_weight_compensation(const moveTo_weight_compensation_task &task,
-                                                                     const int motion_profile,
-                                                                     const Eigen::VectorXd &compensation_parameters)
+                                                                     const int motion_profile)
 {
     desired_task_model_              = task_model::moveTo_weight_compensation;
-    moveTo_weight_compensation_task_ = task;
+    update_task_                     = &finite_state_machine::update_moveTo_weight_compensation_task;
+    moveTo_weight_compensation_task_ = &task;
     motion_profile_                  = motion_profile;
-    compensation_parameters_         = compensation_parameters;
 
-    log_file_compensation_.open("/home/djole/Master/Thesis/GIT/MT_testing/Controller/visualization/archive/compensation_data.txt");
-    assert(log_file_compensation_.is_open());
+    // Thresholds of this task are written once the controller applies its parameters
+    write_compensation_header_ = log_file_compensation_.is_open();
+    return task_status::NOMINAL;
+}
+
+int finite_state_machine::open_compensation_log()
+{
+    if (log_file_compensation_.is_open()) log_file_compensation_.close();
+    log_file_compensation_.open(dynamics_parameter::LOG_FILE_COMPENSATION_PATH);
+    if (log_file_compensation_.is_open()) return 0;
+
+    printf("Unable to open the compensation data file: %s\n", dynamics_parameter::LOG_FILE_COMPENSATION_PATH.c_str());
+    return -1;
+}
+
+void finite_state_machine::close_compensation_log()
+{
+    log_file_compensation_.close();
+    write_compensation_header_ = false;
+}
+
+// Sizes are fixed by the parameter validation: the assignment does not allocate
+void finite_state_machine::set_compensation_parameters(const Eigen::VectorXd &compensation_parameters)
+{
+    compensation_parameters_ = compensation_parameters;
+
+    if (!write_compensation_header_ || !log_file_compensation_.is_open()) return;
     log_file_compensation_ << compensation_parameters_(5) << " ";
     log_file_compensation_ << compensation_parameters_(6) << " ";
     log_file_compensation_ << compensation_parameters_(7) << std::endl;
-    return task_status::NOMINAL;
+    write_compensation_header_ = false;
 }
 
 int finite_state_machine::initialize_with_full_pose(const full_pose_task &task,
                                                     const int motion_profile)
 {
     desired_task_model_ = task_model::full_pose;
-    full_pose_task_     = task;
+    update_task_        = &finite_state_machine::update_full_pose_task;
+    full_pose_task_     = &task;
     motion_profile_     = motion_profile;
 
     return task_status::NOMINAL;
@@ -130,17 +152,32 @@ int finite_state_machine::initialize_with_full_pose(const full_pose_task &task,
 int finite_state_machine::initialize_with_gravity_compensation(const gravity_compensation_task &task)
 {
     desired_task_model_        = task_model::gravity_compensation;
-    gravity_compensation_task_ = task;
+    update_task_               = &finite_state_machine::update_gravity_compensation_task;
+    gravity_compensation_task_ = &task;
 
     return task_status::NOMINAL;
 }
 
-int finite_state_machine::update_moveConstrained_follow_path_task(state_specification &desired_state,
-                                                                  const int tube_section_count)
+void finite_state_machine::reset_task_status()
 {
-    if (total_control_time_sec_ > moveConstrained_follow_path_task_.time_limit) 
+    goal_reached_                = false;
+    time_limit_reached_          = false;
+    contact_detected_            = false;
+    contact_alignment_performed_ = false;
+    total_contact_time_          = 0.0;
+    profile_start_time_sec_      = -1.0;
+}
+
+bool finite_state_machine::is_goal_reached() const
+{
+    return goal_reached_;
+}
+
+int finite_state_machine::update_moveConstrained_follow_path_task(const fsm_snapshot &snapshot, fsm_output &output)
+{
+    if (total_control_time_sec_ > moveConstrained_follow_path_task_->time_limit) 
     {
-        printf("Time limit reached\n");
+        if (!time_limit_reached_) rt_event::publish(rt_event::FSM_TRANSITION, rt_event::TIME_LIMIT_REACHED, task_status::STOP_CONTROL);
 
         time_limit_reached_ = true;
         return task_status::STOP_CONTROL;
@@ -148,34 +185,32 @@ int finite_state_machine::update_moveConstrained_follow_path_task(state_specific
 
     if (goal_reached_ || contact_detected_) return task_status::STOP_ROBOT;
 
-    if (std::fabs(ext_wrench_(0)) > moveConstrained_follow_path_task_.contact_threshold_linear ||
-        std::fabs(ext_wrench_(1)) > moveConstrained_follow_path_task_.contact_threshold_linear) 
+    if (std::fabs(ext_wrench_(0)) > moveConstrained_follow_path_task_->contact_threshold_linear ||
+        std::fabs(ext_wrench_(1)) > moveConstrained_follow_path_task_->contact_threshold_linear) 
     {
-        printf("Non-desired contact occurred\n");
+        rt_event::publish(rt_event::CONTACT, rt_event::NON_DESIRED_CONTACT, 0, ext_wrench_(0), ext_wrench_(1), ext_wrench_(2));
 
         contact_detected_ = true;
         return task_status::STOP_ROBOT;
     }
 
     bool final_section_reached = false;
-    if ((unsigned)tube_section_count == moveConstrained_follow_path_task_.tf_poses.size() - 1) final_section_reached = true;
+    if (snapshot.tube_section_count == moveConstrained_follow_path_task_->num_of_sections - 1) final_section_reached = true;
     
     // Check if the current pose of the robot satisfies 2D tolerances
     int count = 0;
     for (int i = 0; i < 2; i++)
     {
-        if (std::fabs(current_error_(i)) <= moveConstrained_follow_path_task_.tube_tolerances[i]) count++;
+        if (std::fabs(snapshot.current_error(i)) <= moveConstrained_follow_path_task_->tube_tolerances[i]) count++;
     }
 
     // Check if the robot has reached the final goal area
     if (count == 2 && final_section_reached) 
     {   
-        // #ifndef NDEBUG
-            printf("Whole path covered\n");
-        // #endif
+        rt_event::publish(rt_event::FSM_TRANSITION, rt_event::PATH_COVERED, task_status::STOP_ROBOT);
 
         goal_reached_ = true;
-        desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+        output.desired_speed = 0.0;
         return task_status::STOP_ROBOT;
     }
 
@@ -184,52 +219,57 @@ int finite_state_machine::update_moveConstrained_follow_path_task(state_specific
      * If yes command zero X linear velocity, to keep it in that x area.
      * Else go with initially commanded tube speed.
     */
-    if (std::fabs(current_error_(1)) <= moveConstrained_follow_path_task_.tube_tolerances[1])
+    if (std::fabs(snapshot.current_error(1)) <= moveConstrained_follow_path_task_->tube_tolerances[1])
     {
         double speed = 0.0;
         switch (motion_profile_)
         {
             case m_profile::STEP:
-                speed = motion_profile::negative_step_function(std::fabs(current_error_(0)), 
-                                                               moveConstrained_follow_path_task_.tube_speed, 
+                speed = motion_profile::negative_step_function(std::fabs(snapshot.current_error(0)), 
+                                                               moveConstrained_follow_path_task_->tube_speed, 
                                                                0.25, 0.4, 0.2);
                 break;
 
             case m_profile::S_CURVE:
-                speed = motion_profile::s_curve_function(std::fabs(current_error_(0)), 
+                speed = motion_profile::s_curve_function(std::fabs(snapshot.current_error(0)), 
                                                          0.05, 
-                                                         moveConstrained_follow_path_task_.tube_speed, 5.0);
+                                                         moveConstrained_follow_path_task_->tube_speed, 5.0);
+                break;
+
+            case m_profile::TIME_OPTIMAL:
+                // Not available for streamed paths
+                if (moveConstrained_follow_path_task_->speed_profile.is_computed()) speed = moveConstrained_follow_path_task_->speed_profile.get_speed(snapshot.tube_section_count, snapshot.current_error(0));
+                else speed = moveConstrained_follow_path_task_->tube_speed;
                 break;
 
             default:
-                speed = moveConstrained_follow_path_task_.tube_speed;
+                speed = moveConstrained_follow_path_task_->tube_speed;
                 break;
         }
 
         // Check for necessary direction of motion
-        if ((sign(current_error_(0)) == -1) && final_section_reached) speed = -1 * speed;
-        desired_state.frame_velocity[END_EFF_].vel(0) = speed;
+        if ((sign(snapshot.current_error(0)) == -1) && final_section_reached) speed = -1 * speed;
+        output.desired_speed = speed;
 
         // Robot has crossed some tube section? If yes, switch to next one.
-        if ((current_error_(0) < moveConstrained_follow_path_task_.tube_tolerances[0]) && !final_section_reached) return task_status::CHANGE_TUBE_SECTION;
+        if ((snapshot.current_error(0) < moveConstrained_follow_path_task_->tube_tolerances[0]) && !final_section_reached) return task_status::CHANGE_TUBE_SECTION;
         return task_status::CRUISE_THROUGH_TUBE;        
     }
     else
     {
-        desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+        output.desired_speed = 0.0;
         return task_status::START_TO_CRUISE;
     }
 }
 
 
-int finite_state_machine::update_moveTo_follow_path_task(state_specification &desired_state,
-                                                         const int tube_section_count)
+int finite_state_machine::update_moveTo_follow_path_task(const fsm_snapshot &snapshot, fsm_output &output)
 {
-    if (total_control_time_sec_ > moveTo_follow_path_task_.time_limit) 
+    ext_wrench_ = snapshot.ext_force;
+
+    if (total_control_time_sec_ > moveTo_follow_path_task_->time_limit) 
     {
-        // #ifndef NDEBUG       
-            if (!time_limit_reached_) printf("Time limit reached\n");
-        // #endif
+        if (!time_limit_reached_) rt_event::publish(rt_event::FSM_TRANSITION, rt_event::TIME_LIMIT_REACHED, task_status::STOP_CONTROL);
 
         time_limit_reached_ = true;
         return task_status::STOP_CONTROL;
@@ -237,37 +277,33 @@ int finite_state_machine::update_moveTo_follow_path_task(state_specification &de
 
     if (goal_reached_ || contact_detected_) return task_status::STOP_ROBOT;
 
-    if (contact_detected(moveTo_follow_path_task_.contact_threshold_linear, 
-                         moveTo_follow_path_task_.contact_threshold_angular))
+    if (contact_detected(moveTo_follow_path_task_->contact_threshold_linear, 
+                         moveTo_follow_path_task_->contact_threshold_angular))
     {
-        // #ifndef NDEBUG       
-            printf("Contact occurred\n");
-        // #endif
+        rt_event::publish(rt_event::CONTACT, rt_event::CONTACT_DETECTED, 0, ext_wrench_(0), ext_wrench_(1), ext_wrench_(2));
 
-        desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+        output.desired_speed = 0.0;
         contact_detected_ = true;
         return task_status::STOP_ROBOT;
     }
 
     bool final_section_reached = false;
-    if ((unsigned)tube_section_count == moveTo_follow_path_task_.tf_poses.size() - 1) final_section_reached = true;
+    if (snapshot.tube_section_count == moveTo_follow_path_task_->num_of_sections - 1) final_section_reached = true;
     
     // Check if the current pose of the robot satisfies all 6D tolerances
     int count = 0;
     for (int i = 0; i < NUM_OF_CONSTRAINTS_; i++)
     {
-        if (std::fabs(current_error_(i)) <= moveTo_follow_path_task_.tube_tolerances[i]) count++;
+        if (std::fabs(snapshot.current_error(i)) <= moveTo_follow_path_task_->tube_tolerances[i]) count++;
     }
 
     // Check if the robot has reached end of the tube path
     if (count == NUM_OF_CONSTRAINTS_ && final_section_reached) 
     {   
-        // #ifndef NDEBUG       
-            printf("Whole path covered\n");
-        // #endif
+        rt_event::publish(rt_event::FSM_TRANSITION, rt_event::PATH_COVERED, task_status::STOP_ROBOT);
 
         goal_reached_ = true;
-        desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+        output.desired_speed = 0.0;
         return task_status::STOP_ROBOT;
     }
 
@@ -277,34 +313,39 @@ int finite_state_machine::update_moveTo_follow_path_task(state_specification &de
      * Else go with initially commanded tube speed.
     */
     if ((count == NUM_OF_CONSTRAINTS_) || \
-        ((count == NUM_OF_CONSTRAINTS_ - 1) && (std::fabs(current_error_(0)) > moveTo_follow_path_task_.tube_tolerances[0])))
+        ((count == NUM_OF_CONSTRAINTS_ - 1) && (std::fabs(snapshot.current_error(0)) > moveTo_follow_path_task_->tube_tolerances[0])))
     {
         double speed = 0.0;
         switch (motion_profile_)
         {
             case m_profile::STEP:
-                speed = motion_profile::negative_step_function(std::fabs(current_error_(0)), 
-                                                               moveTo_follow_path_task_.tube_speed, 
+                speed = motion_profile::negative_step_function(std::fabs(snapshot.current_error(0)), 
+                                                               moveTo_follow_path_task_->tube_speed, 
                                                                0.25, 0.4, 0.2);
                 break;
 
             case m_profile::S_CURVE:
-                speed = motion_profile::s_curve_function(std::fabs(current_error_(0)), 
+                speed = motion_profile::s_curve_function(std::fabs(snapshot.current_error(0)), 
                                                          0.05, 
-                                                         moveTo_follow_path_task_.tube_speed, 5.0);
+                                                         moveTo_follow_path_task_->tube_speed, 5.0);
+                break;
+
+            case m_profile::TIME_OPTIMAL:
+                if (moveTo_follow_path_task_->speed_profile.is_computed()) speed = moveTo_follow_path_task_->speed_profile.get_speed(snapshot.tube_section_count, snapshot.current_error(0));
+                else speed = moveTo_follow_path_task_->tube_speed;
                 break;
 
             default:
-                speed = moveTo_follow_path_task_.tube_speed;
+                speed = moveTo_follow_path_task_->tube_speed;
                 break;
         }
 
         // Check for necessary direction of motion
-        if ((sign(current_error_(0)) == -1) && final_section_reached) speed = -1 * speed;      
-        desired_state.frame_velocity[END_EFF_].vel(0) = speed;      
+        if ((sign(snapshot.current_error(0)) == -1) && final_section_reached) speed = -1 * speed;      
+        output.desired_speed = speed;      
 
         // Robot has crossed some tube section? If yes, switch to next one.
-        if ((current_error_(0) < moveTo_follow_path_task_.tube_tolerances[0]) && !final_section_reached)
+        if ((snapshot.current_error(0) < moveTo_follow_path_task_->tube_tolerances[0]) && !final_section_reached)
         {
             return task_status::CHANGE_TUBE_SECTION;
         }
@@ -313,20 +354,20 @@ int finite_state_machine::update_moveTo_follow_path_task(state_specification &de
     
     else
     {
-        desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+        output.desired_speed = 0.0;
         return task_status::START_TO_CRUISE;
     }
 }
 
-int finite_state_machine::update_moveTo_weight_compensation_task(state_specification &desired_state)
+int finite_state_machine::update_moveTo_weight_compensation_task(const fsm_snapshot &snapshot, fsm_output &output)
 {
-    if (total_control_time_sec_ > moveTo_weight_compensation_task_.time_limit) 
+    ext_wrench_ = snapshot.ext_force;
+
+    if (total_control_time_sec_ > moveTo_weight_compensation_task_->time_limit) 
     {
-        desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+        output.desired_speed = 0.0;
 
-        // #ifndef NDEBUG       
-            if (!time_limit_reached_) printf("Time limit reached\n");
-        // #endif
+        if (!time_limit_reached_) rt_event::publish(rt_event::FSM_TRANSITION, rt_event::TIME_LIMIT_REACHED, task_status::STOP_CONTROL);
 
         time_limit_reached_ = true;
         return task_status::STOP_CONTROL;
@@ -334,14 +375,12 @@ int finite_state_machine::update_moveTo_weight_compensation_task(state_specifica
 
     if (goal_reached_ || contact_detected_) return task_status::STOP_ROBOT;
     
-    if (contact_detected(moveTo_weight_compensation_task_.contact_threshold_linear, 
-                         moveTo_weight_compensation_task_.contact_threshold_angular))
+    if (contact_detected(moveTo_weight_compensation_task_->contact_threshold_linear, 
+                         moveTo_weight_compensation_task_->contact_threshold_angular))
     {
-        // #ifndef NDEBUG       
-            printf("Contact occurred\n");
-        // #endif
+        rt_event::publish(rt_event::CONTACT, rt_event::CONTACT_DETECTED, 0, ext_wrench_(0), ext_wrench_(1), ext_wrench_(2));
 
-        desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+        output.desired_speed = 0.0;
         contact_detected_ = true;
         return task_status::STOP_ROBOT;
     }
@@ -349,17 +388,15 @@ int finite_state_machine::update_moveTo_weight_compensation_task(state_specifica
     int count = 0;
     for (int i = 0; i < NUM_OF_CONSTRAINTS_; i++)
     {
-        if (std::fabs(current_error_(i)) <= moveTo_weight_compensation_task_.tube_tolerances[i]) count++;
+        if (std::fabs(snapshot.current_error(i)) <= moveTo_weight_compensation_task_->tube_tolerances[i]) count++;
     }
     
     if (count == NUM_OF_CONSTRAINTS_) 
     {
-        // #ifndef NDEBUG       
-            printf("Goal area reached\n");
-        // #endif
+        rt_event::publish(rt_event::FSM_TRANSITION, rt_event::GOAL_REACHED, task_status::STOP_ROBOT);
 
         goal_reached_ = true;
-        desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+        output.desired_speed = 0.0;
         return task_status::STOP_ROBOT;
     }
 
@@ -368,12 +405,12 @@ int finite_state_machine::update_moveTo_weight_compensation_task(state_specifica
      * If yes, command zero X linear velocity to keep it in that area, until all DOFs gets back into tube.
      * Else go with initially commanded tube speed.
     */
-    if ( (std::fabs(current_error_(0)) <= moveTo_weight_compensation_task_.tube_tolerances[0]) || \
-         ((std::fabs(current_error_(0)) >  moveTo_weight_compensation_task_.tube_tolerances[0]) && \
+    if ( (std::fabs(snapshot.current_error(0)) <= moveTo_weight_compensation_task_->tube_tolerances[0]) || \
+         ((std::fabs(snapshot.current_error(0)) >  moveTo_weight_compensation_task_->tube_tolerances[0]) && \
           (count < NUM_OF_CONSTRAINTS_ - 1)) 
        )
     {
-        desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+        output.desired_speed = 0.0;
         return task_status::START_TO_CRUISE;
     }
     else
@@ -382,36 +419,36 @@ int finite_state_machine::update_moveTo_weight_compensation_task(state_specifica
         switch (motion_profile_)
         {
             case m_profile::STEP:
-                speed = motion_profile::negative_step_function(std::fabs(current_error_(0)), 
-                                                               moveTo_weight_compensation_task_.tube_speed, 
+                speed = motion_profile::negative_step_function(std::fabs(snapshot.current_error(0)), 
+                                                               moveTo_weight_compensation_task_->tube_speed, 
                                                                0.25, 0.4, 0.2);
                 break;
 
             case m_profile::S_CURVE:
-                speed = motion_profile::s_curve_function(std::fabs(current_error_(0)), 
-                                                         0.05, moveTo_weight_compensation_task_.tube_speed, 5.0);
+                speed = motion_profile::s_curve_function(std::fabs(snapshot.current_error(0)), 
+                                                         0.05, moveTo_weight_compensation_task_->tube_speed, 5.0);
                 break;
 
             default:
-                speed = moveTo_weight_compensation_task_.tube_speed;
+                speed = moveTo_weight_compensation_task_->tube_speed;
                 break;
         }
 
-        if (sign(current_error_(0)) == -1) desired_state.frame_velocity[END_EFF_].vel(0) = -1 * speed;      
-        else desired_state.frame_velocity[END_EFF_].vel(0) = speed;              
+        if (sign(snapshot.current_error(0)) == -1) output.desired_speed = -1 * speed;      
+        else output.desired_speed = speed;              
     }
    
     return task_status::CRUISE_THROUGH_TUBE;
 }
 
 
-int finite_state_machine::update_moveTo_task(state_specification &desired_state)
+int finite_state_machine::update_moveTo_task(const fsm_snapshot &snapshot, fsm_output &output)
 {
-    if (total_control_time_sec_ > moveTo_task_.time_limit) 
+    ext_wrench_ = snapshot.ext_force;
+
+    if (total_control_time_sec_ > moveTo_task_->time_limit) 
     {
-        // #ifndef NDEBUG
-            if (!time_limit_reached_) printf("Time limit reached\n");
-        // #endif
+        if (!time_limit_reached_) rt_event::publish(rt_event::FSM_TRANSITION, rt_event::TIME_LIMIT_REACHED, task_status::STOP_CONTROL);
 
         time_limit_reached_ = true;
         return task_status::STOP_CONTROL;
@@ -419,14 +456,12 @@ int finite_state_machine::update_moveTo_task(state_specification &desired_state)
 
     if (goal_reached_ || contact_detected_) return task_status::STOP_ROBOT;
 
-    if (contact_detected(moveTo_task_.contact_threshold_linear, 
-                         moveTo_task_.contact_threshold_angular))
+    if (contact_detected(moveTo_task_->contact_threshold_linear, 
+                         moveTo_task_->contact_threshold_angular))
     {
-        // #ifndef NDEBUG
-            printf("Contact occurred\n");
-        // #endif
+        rt_event::publish(rt_event::CONTACT, rt_event::CONTACT_DETECTED, 0, ext_wrench_(0), ext_wrench_(1), ext_wrench_(2));
 
-        desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+        output.desired_speed = 0.0;
         contact_detected_ = true;
         return task_status::STOP_ROBOT;
     }
@@ -434,65 +469,63 @@ int finite_state_machine::update_moveTo_task(state_specification &desired_state)
     int count = 0;
     for (int i = 0; i < 4; i++)
     {
-        if (std::fabs(current_error_(i)) <= moveTo_task_.tube_tolerances[i]) count++;
+        if (std::fabs(snapshot.current_error(i)) <= moveTo_task_->tube_tolerances[i]) count++;
     }
     
     if (count == 4) 
     {
-        // #ifndef NDEBUG
-            printf("Goal area reached\n");
-        // #endif
+        rt_event::publish(rt_event::FSM_TRANSITION, rt_event::GOAL_REACHED, task_status::STOP_ROBOT);
 
         goal_reached_ = true;
-        desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+        output.desired_speed = 0.0;
         return task_status::STOP_ROBOT;
     }
 
     // Stop the motion IF the robot has reached goal-x area or IF other DoFs are not within tolerances
-    if ((std::fabs(current_error_(0)) <= moveTo_task_.tube_tolerances[0]) || count < 3) 
+    if ((std::fabs(snapshot.current_error(0)) <= moveTo_task_->tube_tolerances[0]) || count < 3) 
     {
-        desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+        output.desired_speed = 0.0;
         return task_status::START_TO_CRUISE;
     }
     else
     {
+        if (profile_start_time_sec_ < 0.0) profile_start_time_sec_ = total_control_time_sec_;
+        const double profile_time_sec = total_control_time_sec_ - profile_start_time_sec_;
+
         switch (motion_profile_)
         {
             case m_profile::STEP:
-                desired_state.frame_velocity[END_EFF_].vel(0) = motion_profile::negative_step_function(std::fabs(current_error_(0)), 
-                                                                                                       moveTo_task_.tube_speed,
+                output.desired_speed = motion_profile::negative_step_function(std::fabs(snapshot.current_error(0)), 
+                                                                                                       moveTo_task_->tube_speed,
                                                                                                        0.25, 0.4, 0.2);
-                if (sign(current_error_(0)) == -1) desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+                if (sign(snapshot.current_error(0)) == -1) output.desired_speed = 0.0;
                 break;
 
             case m_profile::S_CURVE:
-                if (iterations_ % 8 == 0)
-                {
-                    if (speed_array_.size() > 0)
-                    {
-                        desired_state.frame_velocity[END_EFF_].vel(0) = speed_array_.front();
-                        speed_array_.pop_front();
-                    }
-                }
-                iterations_++;
-                if (sign(current_error_(0)) == -1) desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+                // Virtual progress along the tube: 0.0625 m/s, i.e. 0.0005 m per 8 iterations at 1 kHz
+                output.desired_speed = motion_profile::s_curve_function(std::min(0.0625 * profile_time_sec, moveTo_task_->tube_length),
+                                                                                                 0.0, moveTo_task_->tube_speed,
+                                                                                                 M_PI / moveTo_task_->tube_length + 0.1);
+                if (sign(snapshot.current_error(0)) == -1) output.desired_speed = 0.0;
                 break;
 
             case m_profile::RAMP:
-                if (iterations_ % 10 == 0)
-                {
-                    if (speed_array_.size() > 0)
-                    {
-                        desired_state.frame_velocity[END_EFF_].vel(0) = speed_array_.front();
-                        speed_array_.pop_front();
-                    }
-                }
-                iterations_++;
-                if (sign(current_error_(0)) == -1) desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+                // 0.1 m/s^2, i.e. 0.001 m/s per 10 iterations at 1 kHz
+                output.desired_speed = motion_profile::ramp_function(profile_time_sec, 0.0, 0.21, 0.1);
+                if (sign(snapshot.current_error(0)) == -1) output.desired_speed = 0.0;
+                break;
+
+            case m_profile::JERK_LIMITED:
+                // Rest-to-rest along the tube, with the tube speed as the cruise speed
+                output.desired_speed = motion_profile::jerk_limited_trapezoid_function(profile_time_sec, moveTo_task_->tube_length,
+                                                                                       moveTo_task_->tube_speed,
+                                                                                       dynamics_parameter::PATH_MAX_LINEAR_ACCELERATION,
+                                                                                       dynamics_parameter::PATH_MAX_LINEAR_JERK);
+                if (sign(snapshot.current_error(0)) == -1) output.desired_speed = 0.0;
                 break;
 
             default:
-                desired_state.frame_velocity[END_EFF_].vel(0) = (sign(current_error_(0)) == -1)? 0.0 : moveTo_task_.tube_speed;
+                output.desired_speed = (sign(snapshot.current_error(0)) == -1)? 0.0 : moveTo_task_->tube_speed;
                 break;
         }
     }
@@ -501,15 +534,15 @@ int finite_state_machine::update_moveTo_task(state_specification &desired_state)
 }
 
 
-int finite_state_machine::update_moveGuarded_task(state_specification &desired_state)
+int finite_state_machine::update_moveGuarded_task(const fsm_snapshot &snapshot, fsm_output &output)
 {
-    if (total_control_time_sec_ > moveGuarded_task_.time_limit) 
+    ext_wrench_ = snapshot.ext_force;
+
+    if (total_control_time_sec_ > moveGuarded_task_->time_limit) 
     {
-        desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+        output.desired_speed = 0.0;
 
-        // #ifndef NDEBUG       
-            if (!time_limit_reached_) printf("Time limit reached\n");
-        // #endif
+        if (!time_limit_reached_) rt_event::publish(rt_event::FSM_TRANSITION, rt_event::TIME_LIMIT_REACHED, task_status::STOP_CONTROL);
 
         time_limit_reached_ = true;
         return task_status::STOP_CONTROL;
@@ -517,13 +550,11 @@ int finite_state_machine::update_moveGuarded_task(state_specification &desired_s
 
     if (contact_detected_) return task_status::STOP_ROBOT;
     
-    if (contact_detected(moveGuarded_task_.contact_threshold_linear, moveGuarded_task_.contact_threshold_angular))
+    if (contact_detected(moveGuarded_task_->contact_threshold_linear, moveGuarded_task_->contact_threshold_angular))
     {
-        // #ifndef NDEBUG       
-            printf("Contact occurred\n");
-        // #endif
+        rt_event::publish(rt_event::CONTACT, rt_event::CONTACT_DETECTED, 0, ext_wrench_(0), ext_wrench_(1), ext_wrench_(2));
 
-        desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+        output.desired_speed = 0.0;
         contact_detected_ = true;
         return task_status::STOP_ROBOT;
     }
@@ -531,25 +562,25 @@ int finite_state_machine::update_moveGuarded_task(state_specification &desired_s
     // Check if robot is inside the tube
     for (int i = 1; i < NUM_OF_CONSTRAINTS_; i++)
     {
-        if (std::fabs(current_error_(i)) > moveGuarded_task_.tube_tolerances[i])
+        if (std::fabs(snapshot.current_error(i)) > moveGuarded_task_->tube_tolerances[i])
         {
-            desired_state.frame_velocity[END_EFF_].vel(0) = 0.0;
+            output.desired_speed = 0.0;
             return task_status::START_TO_CRUISE;
         }
     }
     
     // TODO: Add motion profile here
-    desired_state.frame_velocity[END_EFF_].vel(0) = moveGuarded_task_.tube_speed;              
+    output.desired_speed = moveGuarded_task_->tube_speed;              
     return task_status::CRUISE_THROUGH_TUBE;
 }
 
-int finite_state_machine::update_full_pose_task(state_specification &desired_state)
+int finite_state_machine::update_full_pose_task(const fsm_snapshot &snapshot, fsm_output &output)
 {
-    if (total_control_time_sec_ > full_pose_task_.time_limit) 
+    ext_wrench_ = snapshot.ext_force;
+
+    if (total_control_time_sec_ > full_pose_task_->time_limit) 
     {
-        // #ifndef NDEBUG
-            if (!time_limit_reached_) printf("Time limit reached\n");
-        // #endif
+        if (!time_limit_reached_) rt_event::publish(rt_event::FSM_TRANSITION, rt_event::TIME_LIMIT_REACHED, task_status::STOP_CONTROL);
 
         time_limit_reached_ = true;
         return task_status::STOP_CONTROL;
@@ -557,11 +588,9 @@ int finite_state_machine::update_full_pose_task(state_specification &desired_sta
 
     if (goal_reached_ || contact_detected_) return task_status::STOP_ROBOT;
 
-    if (contact_detected(full_pose_task_.contact_threshold_linear, full_pose_task_.contact_threshold_angular))
+    if (contact_detected(full_pose_task_->contact_threshold_linear, full_pose_task_->contact_threshold_angular))
     {
-        // #ifndef NDEBUG       
-            printf("Contact occurred\n");
-        // #endif
+        rt_event::publish(rt_event::CONTACT, rt_event::CONTACT_DETECTED, 0, ext_wrench_(0), ext_wrench_(1), ext_wrench_(2));
         contact_detected_ = true;
         return task_status::STOP_ROBOT;
     }
@@ -569,12 +598,12 @@ int finite_state_machine::update_full_pose_task(state_specification &desired_sta
     int count = 0;
     for (int i = 0; i < NUM_OF_CONSTRAINTS_; i++)
     {
-        if (std::fabs(current_error_(i)) <= full_pose_task_.goal_area[i]) count++;
+        if (std::fabs(snapshot.current_error(i)) <= full_pose_task_->goal_area[i]) count++;
     }
     
     if (count == NUM_OF_CONSTRAINTS_) 
     {
-        printf("Goal area reached\n");
+        rt_event::publish(rt_event::FSM_TRANSITION, rt_event::GOAL_REACHED, task_status::STOP_ROBOT);
 
         goal_reached_ = true;
         return task_status::STOP_ROBOT;
@@ -583,13 +612,13 @@ int finite_state_machine::update_full_pose_task(state_specification &desired_sta
     return task_status::NOMINAL;
 }
 
-int finite_state_machine::update_gravity_compensation_task()
+int finite_state_machine::update_gravity_compensation_task(const fsm_snapshot &snapshot, fsm_output &output)
 {
-    if (total_control_time_sec_ > gravity_compensation_task_.time_limit) 
+    if (total_control_time_sec_ > gravity_compensation_task_->time_limit) 
     {
         if (!time_limit_reached_)
         {
-            printf("Time limit reached\n");
+            rt_event::publish(rt_event::FSM_TRANSITION, rt_event::TIME_LIMIT_REACHED, task_status::STOP_CONTROL);
             time_limit_reached_ = true;
         }
         return task_status::STOP_CONTROL;
@@ -598,58 +627,12 @@ int finite_state_machine::update_gravity_compensation_task()
     return task_status::NOMINAL;
 }
 
-int finite_state_machine::update_motion_task_status(const state_specification &robot_state,
-                                                    state_specification &desired_state,
-                                                    const KDL::Twist &current_error,
-                                                    const KDL::Wrench &ext_force,
-                                                    const double time_passed_sec,
-                                                    const int tube_section_count)
+int finite_state_machine::update_motion_task_status(const fsm_snapshot &snapshot, fsm_output &output)
 {
-    robot_state_            = robot_state;
-    desired_state_          = desired_state;
-    current_error_          = current_error;
-    total_control_time_sec_ = time_passed_sec;
-
-    switch (desired_task_model_)
-    {
-        case task_model::moveConstrained_follow_path:
-            return update_moveConstrained_follow_path_task(desired_state, tube_section_count);
-            break;
-
-        case task_model::moveTo_follow_path:
-            ext_wrench_ = ext_force;
-            return update_moveTo_follow_path_task(desired_state, tube_section_count);
-            break;
-
-        case task_model::moveTo:
-            ext_wrench_ = ext_force;
-            return update_moveTo_task(desired_state);
-            break;
-
-        case task_model::moveGuarded:
-            ext_wrench_ = ext_force;
-            return update_moveGuarded_task(desired_state);
-            break;
-
-        case task_model::moveTo_weight_compensation:
-            ext_wrench_ = ext_force;
-            return update_moveTo_weight_compensation_task(desired_state);
-            break;
-
-        case task_model::full_pose:
-            ext_wrench_ = ext_force;
-            return update_full_pose_task(desired_state);
-            break;
-
-         case task_model::gravity_compensation:
-            return update_gravity_compensation_task();
-            break;
-
-        default:
-            printf("Unsupported task model\n");
-            return task_status::STOP_CONTROL;
-            break;
-    }
+    total_control_time_sec_ = snapshot.time_passed_sec;
+    output.desired_speed    = snapshot.desired_speed;
+    output.status           = (this->*update_task_)(snapshot, output);
+    return output.status;
 }
 
 int finite_state_machine::update_weight_compensation_task_status(const int loop_iteration_count,
@@ -683,7 +666,7 @@ int finite_state_machine::update_weight_compensation_task_status(const int loop_
 
         if ((loop_period_count_ >= compensation_parameters_(8)) && (compensation_error != 0.0))
         {
-            printf("Triger X %d: %f, %f, %f \n", compensator_trigger_count_ + 1, filtered_bias_(0), filtered_bias_(1), filtered_bias_(2));
+            rt_event::publish(rt_event::WEIGHT_COMPENSATION, rt_event::TRIGGERED, 0, filtered_bias_(0), filtered_bias_(1), filtered_bias_(2));
             filtered_bias(0)   = filtered_bias_(0);
             loop_period_count_ = 0;
             write_compensation_time_to_file_ = true;
@@ -692,7 +675,7 @@ int finite_state_machine::update_weight_compensation_task_status(const int loop_
         }
         else if ((compensation_error == 0.0) && (loop_period_count_ > 2 * compensation_parameters_(8)))
         {
-            printf("X Estimation completed\n\n");
+            rt_event::publish(rt_event::WEIGHT_COMPENSATION, rt_event::ESTIMATION_COMPLETED, 0);
             loop_period_count_ = 0;
             compensator_trigger_count_ = compensation_parameters_(9);
             return 0;
@@ -722,7 +705,7 @@ int finite_state_machine::update_weight_compensation_task_status(const int loop_
 
         if ((loop_period_count_ >= compensation_parameters_(8)) && (compensation_error != 0.0))
         {
-            printf("Triger Y %d: %f, %f, %f \n", compensator_trigger_count_ + 1, filtered_bias_(0), filtered_bias_(1), filtered_bias_(2));
+            rt_event::publish(rt_event::WEIGHT_COMPENSATION, rt_event::TRIGGERED, 1, filtered_bias_(0), filtered_bias_(1), filtered_bias_(2));
             filtered_bias(1)   = filtered_bias_(1);
             loop_period_count_ = 0;
             write_compensation_time_to_file_ = true;
@@ -731,7 +714,7 @@ int finite_state_machine::update_weight_compensation_task_status(const int loop_
         }
         else if ((compensation_error == 0.0) && (loop_period_count_ > 2 * compensation_parameters_(8)))
         {
-            printf("Y Estimation completed\n\n");
+            rt_event::publish(rt_event::WEIGHT_COMPENSATION, rt_event::ESTIMATION_COMPLETED, 1);
             loop_period_count_ = 0;
             compensator_trigger_count_ = compensation_parameters_(9) + compensation_parameters_(10);
             return 0;
@@ -759,7 +742,7 @@ int finite_state_machine::update_weight_compensation_task_status(const int loop_
 
         if ((loop_period_count_ >= compensation_parameters_(8)) && (compensation_error != 0.0))
         {
-            printf("Triger Z %d: %f, %f, %f \n", compensator_trigger_count_ + 1, filtered_bias_(0), filtered_bias_(1), filtered_bias_(2));
+            rt_event::publish(rt_event::WEIGHT_COMPENSATION, rt_event::TRIGGERED, 2, filtered_bias_(0), filtered_bias_(1), filtered_bias_(2));
             filtered_bias(2)   = filtered_bias_(2);
             loop_period_count_ = 0;
             write_compensation_time_to_file_ = true;
@@ -768,7 +751,7 @@ int finite_state_machine::update_weight_compensation_task_status(const int loop_
         }
         else if ((compensation_error == 0.0) && (loop_period_count_ > 2 * compensation_parameters_(8)))
         {
-            printf("Z Estimation completed\n\n");
+            rt_event::publish(rt_event::WEIGHT_COMPENSATION, rt_event::ESTIMATION_COMPLETED, 2);
             loop_period_count_ = 0;
             compensator_trigger_count_ = compensation_parameters_(9) + compensation_parameters_(10) + compensation_parameters_(11);
             return 0;
@@ -798,7 +781,7 @@ int finite_state_machine::update_force_task_status(const KDL::Wrench &desired_fo
 
         if (total_contact_time_ >= 0.014)
         {
-            printf("Contact Lost!\n");
+            rt_event::publish(rt_event::CONTACT, rt_event::CONTACT_LOST, 0, ext_wrench_(0), ext_wrench_(1), ext_wrench_(2));
             return task_status::STOP_ROBOT;
         } 
         return task_status::CRUISE;
@@ -836,7 +819,7 @@ bool finite_state_machine::force_goal_maintained(const KDL::Wrench &desired_forc
     for (int i = 2; i < 5; i++)
     {
         double error = desired_force(i) - ext_force(i);
-        if (std::fabs(error) > moveConstrained_follow_path_task_.tube_tolerances[i]) return false;
+        if (std::fabs(error) > moveConstrained_follow_path_task_->tube_tolerances[i]) return false;
     }
 
     return true;
@@ -882,6 +865,7 @@ void finite_state_machine::log_compensation_data(const int loop_iteration_count,
                                                  const Eigen::VectorXd &bias_signal,
                                                  const Eigen::VectorXd &gain_signal)
 {
+    if (!log_file_compensation_.is_open()) return;
     log_file_compensation_ << bias_signal.transpose().format(dynamics_parameter::WRITE_FORMAT);
     log_file_compensation_ << gain_signal.transpose().format(dynamics_parameter::WRITE_FORMAT);
     log_file_compensation_ << filtered_bias_.transpose().format(dynamics_parameter::WRITE_FORMAT);
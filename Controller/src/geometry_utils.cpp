@@ -52,6 +52,36 @@ namespace geometry
         return KDL::Frame(exp_map_so3(current_twist.rot), exp_map_r3(current_twist));
     }
 
+    // Closed-form exponential map from a rotation vector to a unit quaternion
+    Eigen::Quaterniond exp_map_quaternion(const Eigen::Vector3d &rot_vector)
+    {
+        double angle_square = rot_vector.squaredNorm();
+        double real_part, imaginary_scale;
+
+        // Taylor expansion of cos(theta/2) and sin(theta/2)/theta around 0
+        if (angle_square < MIN_ANGLE)
+        {
+            real_part       = 1.0 - angle_square / 8.0;
+            imaginary_scale = 0.5 - angle_square / 48.0;
+        }
+        else
+        {
+            double angle = std::sqrt(angle_square);
+            real_part       = std::cos(0.5 * angle);
+            imaginary_scale = std::sin(0.5 * angle) / angle;
+        }
+
+        return Eigen::Quaterniond(real_part, imaginary_scale * rot_vector(0),
+                                             imaginary_scale * rot_vector(1),
+                                             imaginary_scale * rot_vector(2));
+    }
+
+    // First-order renormalization: q * (3 - |q|^2) / 2
+    void renormalize_quaternion(Eigen::Quaterniond &quaternion)
+    {
+        quaternion.coeffs() *= 0.5 * (3.0 - quaternion.coeffs().squaredNorm());
+    }
+
 
     /** 
      * Perform parameterization of rot twist if the angle is > PI 
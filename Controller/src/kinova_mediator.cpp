@@ -261,7 +261,7 @@ int kinova_mediator::set_joint_torques(const KDL::JntArray &joint_torques)
                                                             ext_wrenches_sim_, robot_state_.qdd, robot_state_.total_torque);
         if (solver_return != 0)
         {
-            printf("FD solver in mediator returned error: %d", solver_return);
+            rt_event::publish(rt_event::SOLVER_ERROR, solver_return, rt_event::KINOVA_MEDIATOR);
             return -1;
         }
 
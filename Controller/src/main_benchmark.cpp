@@ -0,0 +1,527 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * Micro-benchmarks of the dynamics, kinematics and control kernels.
+ * Each kernel runs on a seeded pool of random joint states of every robot model,
+ * and reports ns/op (median of repetitions) and heap allocations/op as JSON.
+ *
+ * Usage: benchmark [--seed N] [--min-time SEC] [--repetitions N] [--filter TEXT]
+ *                  [--output FILE] [--baseline FILE] [--threshold PERCENT]
+ * With --baseline, a comparison table is printed and the exit code is 1
+ * if any kernel is slower than the baseline by more than the threshold.
+ */
+#include <solver_vereshchagin.hpp>
+#include <fk_vereshchagin.hpp>
+#include <solver_recursive_newton_euler.hpp>
+#include <dynamic_parameter_solver.hpp>
+#include <fd_solver_rne.hpp>
+#include <ldl_solver_eigen.hpp>
+#include <external_wrench_estimator.hpp>
+#include <geometry_utils.hpp>
+#include <moving_variance.hpp>
+#include <abag.hpp>
+#include <constants.hpp>
+#include <robot_models.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#define NUM_OF_CONSTRAINTS 6
+#define STATE_POOL_SIZE 64
+
+// Heap allocation counter: every operator new of the process goes through here
+static std::size_t allocation_count = 0;
+
+void *operator new(std::size_t size)
+{
+    allocation_count++;
+    void *pointer = std::malloc(size == 0? 1 : size);
+    if (pointer == nullptr) throw std::bad_alloc();
+    return pointer;
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t size) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t size) noexcept
+{
+    std::free(pointer);
+}
+
+// Results are accumulated here, so that the compiler cannot remove the measured calls
+static volatile double sink = 0.0;
+
+struct benchmark_options
+{
+    unsigned int seed = 42;
+    double min_time_sec = 0.2;
+    int repetitions = 5;
+    double threshold_percent = 10.0;
+    std::string filter = "";
+    std::string output_file = "";
+    std::string baseline_file = "";
+};
+
+struct benchmark_result
+{
+    std::string name, robot;
+    double ns_per_op, allocs_per_op;
+    long iterations;
+};
+
+// Pool of random joint states within the position and velocity limits of the robot
+struct state_pool
+{
+    std::vector<KDL::JntArray> q, qd, qdd, tau;
+
+    state_pool(const robot_model &model, std::mt19937 &generator):
+        q(STATE_POOL_SIZE), qd(STATE_POOL_SIZE), qdd(STATE_POOL_SIZE), tau(STATE_POOL_SIZE)
+    {
+        const int NUM_OF_JOINTS = model.chain.getNrOfJoints();
+        std::uniform_real_distribution<double> unit(-1.0, 1.0);
+
+        for (int s = 0; s < STATE_POOL_SIZE; s++)
+        {
+            q[s].resize(NUM_OF_JOINTS);
+            qd[s].resize(NUM_OF_JOINTS);
+            qdd[s].resize(NUM_OF_JOINTS);
+            tau[s].resize(NUM_OF_JOINTS);
+
+            for (int j = 0; j < NUM_OF_JOINTS; j++)
+            {
+                const double mid   = 0.5 * (model.position_limits_max[j] + model.position_limits_min[j]);
+                const double range = 0.5 * (model.position_limits_max[j] - model.position_limits_min[j]);
+                q[s](j)   = mid + range * unit(generator);
+                qd[s](j)  = model.joint_velocity_limits[j] * unit(generator);
+                qdd[s](j) = unit(generator);
+                tau[s](j) = 0.5 * model.joint_torque_limits[j] * unit(generator);
+            }
+        }
+    }
+};
+
+/**
+ * Runs the kernel (argument: iteration index) in batches until min_time is reached, 
+ * and reports the median time over the repetitions.
+ */
+template <typename Kernel>
+benchmark_result measure(const benchmark_options &options, const std::string &name,
+                         const std::string &robot, Kernel kernel)
+{
+    // Warm-up: caches, lazily allocated solver buffers, and a first estimate of the op time
+    long iterations = 1;
+    double elapsed_sec = 0.0;
+    while (true)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < iterations; i++) kernel(i);
+        elapsed_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed_sec > 0.01 * options.min_time_sec) break;
+        iterations *= 10;
+    }
+    iterations = std::max(1L, (long)(iterations * options.min_time_sec / std::max(elapsed_sec, 1e-9)));
+
+    std::vector<double> ns_per_op(options.repetitions);
+    const std::size_t allocations_before = allocation_count;
+    for (int r = 0; r < options.repetitions; r++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < iterations; i++) kernel(i);
+        ns_per_op[r] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+    }
+    const std::size_t allocations = allocation_count - allocations_before;
+
+    std::sort(ns_per_op.begin(), ns_per_op.end());
+    benchmark_result result;
+    result.name          = name;
+    result.robot         = robot;
+    result.ns_per_op     = ns_per_op[options.repetitions / 2];
+    result.allocs_per_op = (double)allocations / ((double)iterations * options.repetitions);
+    result.iterations    = iterations;
+    return result;
+}
+
+bool selected(const benchmark_options &options, const std::string &name, const std::string &robot)
+{
+    return options.filter.empty() || (name + "/" + robot).find(options.filter) != std::string::npos;
+}
+
+void run_model_benchmarks(const benchmark_options &options, const robot_model &model,
+                          std::vector<benchmark_result> &results)
+{
+    std::mt19937 generator(options.seed);
+    const state_pool states(model, generator);
+    const KDL::Chain &chain = model.chain;
+    const int NUM_OF_JOINTS   = chain.getNrOfJoints();
+    const int NUM_OF_SEGMENTS = chain.getNrOfSegments();
+    const std::vector<double> &acc = model.root_acceleration;
+    const KDL::Twist root_acc(KDL::Vector(acc[0], acc[1], acc[2]), KDL::Vector(acc[3], acc[4], acc[5]));
+    const KDL::Vector gravity = -1.0 * root_acc.vel;
+    const KDL::Wrenches zero_wrenches(NUM_OF_SEGMENTS, KDL::Wrench::Zero());
+    KDL::JntArray q_out(NUM_OF_JOINTS), tau_out(NUM_OF_JOINTS);
+    const auto state = [](const long i) { return i % STATE_POOL_SIZE; };
+
+    if (selected(options, "vereshchagin_cart_to_jnt", model.name))
+    {
+        KDL::Solver_Vereshchagin solver(chain, model.joint_inertia, model.joint_torque_limits,
+                                        false, root_acc, NUM_OF_CONSTRAINTS);
+        KDL::Jacobian alpha(NUM_OF_CONSTRAINTS);
+        KDL::JntArray beta(NUM_OF_CONSTRAINTS);
+        KDL::SetToZero(alpha);
+        for (int c = 0; c < NUM_OF_CONSTRAINTS; c++)
+        {
+            alpha(c, c) = 1.0;
+            beta(c) = 0.1 * (c + 1);
+        }
+
+        results.push_back(measure(options, "vereshchagin_cart_to_jnt", model.name, [&](const long i)
+        {
+            solver.CartToJnt(states.q[state(i)], states.qd[state(i)], q_out, alpha, beta,
+                             zero_wrenches, zero_wrenches, tau_out);
+            sink = sink + q_out(0);
+        }));
+    }
+
+    if (selected(options, "fk_vereshchagin_jnt_to_cart", model.name))
+    {
+        KDL::FK_Vereshchagin solver(chain);
+        std::vector<KDL::Frame> poses(NUM_OF_SEGMENTS);
+        std::vector<KDL::Twist> twists(NUM_OF_SEGMENTS);
+
+        results.push_back(measure(options, "fk_vereshchagin_jnt_to_cart", model.name, [&](const long i)
+        {
+            solver.JntToCart(states.q[state(i)], states.qd[state(i)], poses, twists);
+            sink = sink + poses[NUM_OF_SEGMENTS - 1].p(0);
+        }));
+    }
+
+    if (selected(options, "rne_cart_to_jnt", model.name))
+    {
+        KDL::Solver_RNE solver(chain, gravity, model.joint_inertia, model.joint_torque_limits, false);
+
+        results.push_back(measure(options, "rne_cart_to_jnt", model.name, [&](const long i)
+        {
+            solver.CartToJnt(states.q[state(i)], states.qd[state(i)], states.qdd[state(i)],
+                             zero_wrenches, tau_out);
+            sink = sink + tau_out(0);
+        }));
+    }
+
+    KDL::Solver_Dynamic_Parameter dynamic_parameter_solver(chain, gravity, model.joint_inertia);
+    KDL::JntSpaceInertiaMatrix mass_matrix(NUM_OF_JOINTS);
+
+    if (selected(options, "dynamic_parameter_jnt_to_mass", model.name))
+    {
+        results.push_back(measure(options, "dynamic_parameter_jnt_to_mass", model.name, [&](const long i)
+        {
+            dynamic_parameter_solver.JntToMass(states.q[state(i)], mass_matrix);
+            sink = sink + mass_matrix(0, 0);
+        }));
+    }
+
+    if (selected(options, "dynamic_parameter_jnt_to_coriolis", model.name))
+    {
+        results.push_back(measure(options, "dynamic_parameter_jnt_to_coriolis", model.name, [&](const long i)
+        {
+            dynamic_parameter_solver.JntToCoriolis(states.q[state(i)], states.qd[state(i)], tau_out);
+            sink = sink + tau_out(0);
+        }));
+    }
+
+    if (selected(options, "dynamic_parameter_jnt_to_gravity", model.name))
+    {
+        results.push_back(measure(options, "dynamic_parameter_jnt_to_gravity", model.name, [&](const long i)
+        {
+            dynamic_parameter_solver.JntToGravity(states.q[state(i)], tau_out);
+            sink = sink + tau_out(0);
+        }));
+    }
+
+    if (selected(options, "fd_solver_rne_cart_to_jnt", model.name))
+    {
+        KDL::FdSolver_RNE solver(chain, gravity, model.joint_inertia);
+        KDL::JntArray total_torque(NUM_OF_JOINTS);
+
+        results.push_back(measure(options, "fd_solver_rne_cart_to_jnt", model.name, [&](const long i)
+        {
+            solver.CartToJnt(states.q[state(i)], states.qd[state(i)], states.tau[state(i)],
+                             zero_wrenches, q_out, total_torque);
+            sink = sink + q_out(0);
+        }));
+    }
+
+    if (selected(options, "ldl_solver_eigen", model.name))
+    {
+        // Systems as solved in the forward dynamics: joint space mass matrices of the random states
+        std::vector<Eigen::MatrixXd> mass_matrices(STATE_POOL_SIZE);
+        for (int s = 0; s < STATE_POOL_SIZE; s++)
+        {
+            dynamic_parameter_solver.JntToMass(states.q[s], mass_matrix);
+            mass_matrices[s] = mass_matrix.data;
+        }
+        Eigen::MatrixXd L(NUM_OF_JOINTS, NUM_OF_JOINTS);
+        Eigen::VectorXd D(NUM_OF_JOINTS), v_tmp(NUM_OF_JOINTS), solution(NUM_OF_JOINTS);
+
+        results.push_back(measure(options, "ldl_solver_eigen", model.name, [&](const long i)
+        {
+            KDL::ldl_solver_eigen(mass_matrices[state(i)], states.tau[state(i)].data, L, D, v_tmp, solution);
+            sink = sink + solution(0);
+        }));
+    }
+
+    if (selected(options, "estimate_external_wrench", model.name))
+    {
+        KDL::ChainExternalWrenchEstimator estimator(chain, gravity, model.joint_inertia, 1000.0, 30.0, 0.5);
+        estimator.setInitialMomentum(states.q[0], states.qd[0]);
+        KDL::Wrench wrench;
+
+        results.push_back(measure(options, "estimate_external_wrench", model.name, [&](const long i)
+        {
+            estimator.JntToExtWrench(states.q[state(i)], states.qd[state(i)], states.tau[state(i)], wrench);
+            sink = sink + wrench.force(0);
+        }));
+    }
+}
+
+// Kernels that do not depend on the robot model
+void run_generic_benchmarks(const benchmark_options &options, std::vector<benchmark_result> &results)
+{
+    std::mt19937 generator(options.seed);
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    const auto sample = [](const long i) { return i % STATE_POOL_SIZE; };
+
+    std::vector<KDL::Rotation> rotations(STATE_POOL_SIZE);
+    std::vector<KDL::Vector> rotation_vectors(STATE_POOL_SIZE);
+    std::vector<Eigen::VectorXd> errors(STATE_POOL_SIZE);
+    for (int s = 0; s < STATE_POOL_SIZE; s++)
+    {
+        rotation_vectors[s] = KDL::Vector(unit(generator), unit(generator), unit(generator));
+        rotations[s] = KDL::Rotation::Rot(rotation_vectors[s], M_PI * unit(generator));
+        errors[s] = Eigen::VectorXd::NullaryExpr(NUM_OF_CONSTRAINTS, [&](){ return unit(generator); });
+    }
+
+    if (selected(options, "log_map_so3", "generic"))
+    {
+        results.push_back(measure(options, "log_map_so3", "generic", [&](const long i)
+        {
+            sink = sink + geometry::log_map_so3(rotations[sample(i)])(0);
+        }));
+    }
+
+    if (selected(options, "exp_map_so3", "generic"))
+    {
+        results.push_back(measure(options, "exp_map_so3", "generic", [&](const long i)
+        {
+            sink = sink + geometry::exp_map_so3(rotation_vectors[sample(i)])(0, 0);
+        }));
+    }
+
+    if (selected(options, "orthonormalize_rot_matrix", "generic"))
+    {
+        KDL::Rotation rotation;
+        results.push_back(measure(options, "orthonormalize_rot_matrix", "generic", [&](const long i)
+        {
+            rotation = rotations[sample(i)];
+            rotation.data[0] += 1e-6;
+            geometry::orthonormalize_rot_matrix(rotation);
+            sink = sink + rotation(0, 0);
+        }));
+    }
+
+    if (selected(options, "abag_update_state", "generic"))
+    {
+        ABAG<NUM_OF_CONSTRAINTS> abag(NUM_OF_CONSTRAINTS, 
+                                      abag_parameter::ERROR_ALPHA, abag_parameter::BIAS_THRESHOLD,
+                                      abag_parameter::BIAS_STEP, abag_parameter::GAIN_THRESHOLD,
+                                      abag_parameter::GAIN_STEP, abag_parameter::MIN_BIAS_SAT_LIMIT,
+                                      abag_parameter::MAX_BIAS_SAT_LIMIT, abag_parameter::MIN_GAIN_SAT_LIMIT,
+                                      abag_parameter::MAX_GAIN_SAT_LIMIT, abag_parameter::MIN_COMMAND_SAT_LIMIT,
+                                      abag_parameter::MAX_COMMAND_SAT_LIMIT);
+
+        results.push_back(measure(options, "abag_update_state", "generic", [&](const long i)
+        {
+            sink = sink + abag.update_state(errors[sample(i)])(0);
+        }));
+    }
+
+    if (selected(options, "moving_variance_update", "generic"))
+    {
+        // Same window as the FSM's ABAG signal monitors
+        moving_variance variance(100, NUM_OF_CONSTRAINTS);
+
+        results.push_back(measure(options, "moving_variance_update", "generic", [&](const long i)
+        {
+            sink = sink + variance.update(errors[sample(i)])(0);
+        }));
+    }
+}
+
+void write_results(FILE *file, const benchmark_options &options,
+                   const std::vector<benchmark_result> &results)
+{
+    fprintf(file, "{\n  \"seed\": %u,\n  \"min_time_sec\": %g,\n  \"repetitions\": %d,\n  \"results\": [\n",
+            options.seed, options.min_time_sec, options.repetitions);
+    for (std::size_t r = 0; r < results.size(); r++)
+    {
+        fprintf(file, "    {\"name\": \"%s\", \"robot\": \"%s\", \"ns_per_op\": %.3f, \"allocs_per_op\": %.3f, \"iterations\": %ld}%s\n",
+                results[r].name.c_str(), results[r].robot.c_str(), results[r].ns_per_op,
+                results[r].allocs_per_op, results[r].iterations, (r + 1 < results.size())? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+// Reads the result lines of a file written by write_results
+int read_results(const std::string &file_path, std::vector<benchmark_result> &results)
+{
+    FILE *file = fopen(file_path.c_str(), "r");
+    if (file == nullptr)
+    {
+        printf("Failed to open baseline file: %s\n", file_path.c_str());
+        return -1;
+    }
+
+    char line[512], name[128], robot[128];
+    benchmark_result result;
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        if (sscanf(line, " {\"name\": \"%127[^\"]\", \"robot\": \"%127[^\"]\", \"ns_per_op\": %lf, \"allocs_per_op\": %lf, \"iterations\": %ld",
+                   name, robot, &result.ns_per_op, &result.allocs_per_op, &result.iterations) != 5) continue;
+        result.name = name;
+        result.robot = robot;
+        results.push_back(result);
+    }
+    fclose(file);
+    return 0;
+}
+
+// Returns the number of kernels slower than the baseline by more than the threshold
+int compare_to_baseline(const benchmark_options &options, const std::vector<benchmark_result> &results,
+                        const std::vector<benchmark_result> &baseline)
+{
+    int regressions = 0;
+    fprintf(stderr, "\n%-36s %-12s %14s %14s %9s %15s\n", "kernel", "robot", "baseline ns", "current ns", "change", "allocs/op");
+    for (const benchmark_result &result : results)
+    {
+        auto reference = std::find_if(baseline.begin(), baseline.end(), [&](const benchmark_result &b)
+                                      { return b.name == result.name && b.robot == result.robot; });
+        if (reference == baseline.end())
+        {
+            fprintf(stderr, "%-36s %-12s %14s %14.1f %9s %7s -> %5.2f\n", result.name.c_str(), result.robot.c_str(),
+                    "-", result.ns_per_op, "new", "-", result.allocs_per_op);
+            continue;
+        }
+
+        const double change = 100.0 * (result.ns_per_op - reference->ns_per_op) / reference->ns_per_op;
+        const bool regression = change > options.threshold_percent;
+        if (regression) regressions++;
+        fprintf(stderr, "%-36s %-12s %14.1f %14.1f %+8.1f%% %7.2f -> %5.2f%s\n", result.name.c_str(), result.robot.c_str(),
+                reference->ns_per_op, result.ns_per_op, change, reference->allocs_per_op,
+                result.allocs_per_op, regression? "  REGRESSION" : "");
+    }
+    return regressions;
+}
+
+int parse_arguments(int argc, char **argv, benchmark_options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+        if (i + 1 >= argc)
+        {
+            printf("Missing value for argument: %s\n", argument.c_str());
+            return -1;
+        }
+
+        if      (argument == "--seed")        options.seed              = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--min-time")    options.min_time_sec      = std::atof(argv[++i]);
+        else if (argument == "--repetitions") options.repetitions       = std::max(1, std::atoi(argv[++i]));
+        else if (argument == "--threshold")   options.threshold_percent = std::atof(argv[++i]);
+        else if (argument == "--filter")      options.filter            = argv[++i];
+        else if (argument == "--output")      options.output_file       = argv[++i];
+        else if (argument == "--baseline")    options.baseline_file     = argv[++i];
+        else
+        {
+            printf("Unknown argument: %s\n", argument.c_str());
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    benchmark_options options;
+    if (parse_arguments(argc, argv, options) != 0) return -1;
+
+    std::vector<robot_model> models;
+    if (load_models(models) != 0) return -1;
+
+    std::vector<benchmark_result> results;
+    for (const robot_model &model : models) run_model_benchmarks(options, model, results);
+    run_generic_benchmarks(options, results);
+
+    FILE *output = stdout;
+    if (!options.output_file.empty())
+    {
+        output = fopen(options.output_file.c_str(), "w");
+        if (output == nullptr)
+        {
+            printf("Failed to open output file: %s\n", options.output_file.c_str());
+            return -1;
+        }
+    }
+    write_results(output, options, results);
+    if (output != stdout) fclose(output);
+
+    if (options.baseline_file.empty()) return 0;
+
+    std::vector<benchmark_result> baseline;
+    if (read_results(options.baseline_file, baseline) != 0) return -1;
+    return (compare_to_baseline(options, results, baseline) > 0)? 1 : 0;
+}
@@ -34,6 +34,8 @@ SOFTWARE.
 #include <safety_monitor.hpp>
 #include <finite_state_machine.hpp>
 #include <motion_profile.hpp>
+#include <trace_mediator.hpp>
+#include <cstdlib>
 
 #define IP_ADDRESS_1 "192.168.1.10"
 #define IP_ADDRESS_2 "192.168.1.12"
@@ -94,6 +96,15 @@ bool control_null_space              = false;
 bool control_null_space_moveConstrained = false;
 bool compensate_gravity              = false;
 bool use_mass_alternation            = false;
+bool use_lazy_dynamics               = false;
+std::string path_file                = ""; // CSV or binary path in the base frame. Empty: use the path_type generators
+path_loader tube_path_file;
+std::string parameter_file           = ""; // Named ABAG parameter sets. Empty: use the constant sets below
+std::string parameter_set            = "moveConstrained_follow_path";
+bool watch_parameter_file            = true; // Apply modifications of the parameter file while the robot is running
+std::string abag_state_file          = ""; // Converged ABAG state of previous runs. Empty: every task starts from zero
+std::string tool_name                = "none";
+std::string trace_file               = ""; // Sensor reads and commands of the session, for the replay target. Empty: not recorded
 auto error_callback = [](Kinova::Api::KError err){ cout << "_________ callback error _________" << err.toString(); };
 
 std::vector<bool> control_dims                 = {true, true, true, // Linear
@@ -267,6 +278,9 @@ std::function<void(Kinova::Api::Base::ActionNotification)> create_event_listener
 //Make sure that the control loop runs exactly with the specified frequency
 int enforce_loop_frequency(const int dt)
 {
+#ifdef REPLAY_TRACE
+    return 0; // Replay runs at full speed
+#endif
     loop_interval = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - loop_start_time);
 
     if (loop_interval < std::chrono::microseconds(dt)) // Loop is sufficiently fast
@@ -691,6 +705,21 @@ int define_task(dynamics_controller *dyn_controller)
     switch (desired_task_model)
     {
         case task_model::moveConstrained_follow_path:
+            if (!path_file.empty())
+            {
+                if (tube_path_file.open(path_file) != 0) return -1;
+                return dyn_controller->define_moveConstrained_follow_path_task(std::vector<bool>{control_dims_moveConstrained[0], control_dims_moveConstrained[1], control_dims_moveConstrained[2], // Linear
+                                                                                                 control_dims_moveConstrained[3], control_dims_moveConstrained[4], control_dims_moveConstrained[5]},// Angular
+                                                                               tube_path_file,
+                                                                               tube_tolerances_moveConstrained,
+                                                                               tube_speed,
+                                                                               tube_force,
+                                                                               90.5, 90.4, //contact_threshold linear and angular
+                                                                               task_time_limit_sec,// time_limit
+                                                                               control_null_space_moveConstrained,
+                                                                               desired_null_space_angle);
+            }
+
             switch (path_type)
             {
                 case path_types::STEP_PATH:
@@ -726,6 +755,20 @@ int define_task(dynamics_controller *dyn_controller)
             break;
 
         case task_model::moveTo_follow_path:
+            if (!path_file.empty())
+            {
+                if (tube_path_file.open(path_file) != 0) return -1;
+                return dyn_controller->define_moveTo_follow_path_task(std::vector<bool>{control_dims[0], control_dims[1], control_dims[2], // Linear
+                                                                                        control_dims[3], control_dims[4], control_dims[5]},// Angular
+                                                                      tube_path_file,
+                                                                      tube_tolerances,
+                                                                      tube_speed,
+                                                                      contact_threshold_linear, contact_threshold_angular,
+                                                                      task_time_limit_sec,// time_limit
+                                                                      control_null_space,
+                                                                      desired_null_space_angle);
+            }
+
             switch (path_type)
             {
                 case path_types::STEP_PATH:
@@ -894,7 +937,8 @@ void run_test(kinova_mediator &robot_driver)
     printf("Control loop delay count: %d\n", control_loop_delay_count);
 }
 
-int run_main_control(kinova_mediator &robot_driver)
+// Controller reads the state and sends the commands through the session driver: recording or replaying the robot driver
+int run_main_control(kinova_mediator &robot_driver, robot_mediator &session_driver)
 {
     const int DT_MICRO = SECOND / RATE_HZ;
     const int DT_STOPPING_MICRO = SECOND / dynamics_parameter::STOPPING_MOTION_LOOP_FREQ;
@@ -906,7 +950,7 @@ int run_main_control(kinova_mediator &robot_driver)
     // Above main chain is prepared for vereshchagin (nj == ns) but full contains additional segments
     KDL::Chain robot_chain_full = robot_driver.get_full_robot_model();
 
-    dynamics_controller controller(&robot_driver, RATE_HZ, compensate_gravity);
+    dynamics_controller controller(&session_driver, RATE_HZ, compensate_gravity);
     KDL::ChainExternalWrenchEstimator ext_wrench_estimator(robot_chain_full, -1 * robot_driver.get_root_acceleration().vel, robot_driver.get_joint_inertia(), RATE_HZ, 30.0, 0.5);
 
     int return_flag = define_task(&controller);
@@ -916,7 +960,16 @@ int run_main_control(kinova_mediator &robot_driver)
         return -1;
     }
 
-    if (desired_task_model == task_model::full_pose) 
+    if (!parameter_file.empty())
+    {
+        return_flag = controller.load_parameters(parameter_file, parameter_set, watch_parameter_file);
+        if (return_flag != 0)
+        {
+            printf("Error in loading the parameters\n");
+            return -1;
+        }
+    }
+    else if (desired_task_model == task_model::full_pose) 
     {
         controller.set_parameters(time_horizon_amplitude,
                                   max_command, error_alpha,
@@ -1009,6 +1062,8 @@ int run_main_control(kinova_mediator &robot_driver)
         return -1;
     }
 
+    controller.set_lazy_dynamics(use_lazy_dynamics, dynamics_parameter::LAZY_DYNAMICS_DELTA_Q_BOUND, dynamics_parameter::LAZY_DYNAMICS_REFRESH_PERIOD);
+    if (!abag_state_file.empty() && controller.set_abag_warm_start(abag_state_file, tool_name) != 0) return -1;
     return_flag = controller.initialize(desired_control_mode, desired_dynamics_interface, motion_profile_id, log_data, use_estimated_external_wrench);
     if (return_flag != 0)
     {
@@ -1032,7 +1087,7 @@ int run_main_control(kinova_mediator &robot_driver)
     bool trigger_stopping_sequence = false;
     return_flag = 0;
 
-    robot_driver.get_joint_state(joint_pos, joint_vel, joint_torque);
+    session_driver.get_joint_state(joint_pos, joint_vel, joint_torque);
     if (use_estimated_external_wrench) ext_wrench_estimator.setInitialMomentum(joint_pos, joint_vel);
 
     // Real-time loop
@@ -1045,7 +1100,7 @@ int run_main_control(kinova_mediator &robot_driver)
         // Get current state from robot sensors
         if (use_estimated_external_wrench && !stopping_sequence_on)
         {
-            robot_driver.get_joint_state(joint_pos, joint_vel, joint_torque);
+            session_driver.get_joint_state(joint_pos, joint_vel, joint_torque);
             ext_wrench_estimator.JntToExtWrench(joint_pos, joint_vel, torque_command, wrenches_full_model[robot_chain_full.getNrOfSegments()- 1]);
             // return_flag = controller.estimate_external_wrench(joint_pos, joint_vel, joint_torque, wrenches_full_model[robot_chain_full.getNrOfSegments()- 1]);
             if (return_flag != 0)
@@ -1054,7 +1109,7 @@ int run_main_control(kinova_mediator &robot_driver)
                 trigger_stopping_sequence = true;
             }
         }
-        else robot_driver.get_robot_state(joint_pos, joint_vel, joint_torque, wrenches_full_model[robot_chain_full.getNrOfSegments()- 1]);
+        else session_driver.get_robot_state(joint_pos, joint_vel, joint_torque, wrenches_full_model[robot_chain_full.getNrOfSegments()- 1]);
 
         // Make one control iteration (step) -> Update control commands
         return_flag = controller.step(joint_pos, joint_vel, joint_torque, wrenches_full_model[robot_chain_full.getNrOfSegments()- 1], torque_command, total_time_sec, loop_iteration_count, stop_loop_iteration_count, stopping_sequence_on);
@@ -1089,7 +1144,11 @@ int run_main_control(kinova_mediator &robot_driver)
             }
 
             stop_loop_iteration_count++;
-            if (enforce_loop_frequency(DT_STOPPING_MICRO) != 0) control_loop_delay_count++;
+            if (enforce_loop_frequency(DT_STOPPING_MICRO) != 0)
+            {
+                control_loop_delay_count++;
+                rt_event::publish(rt_event::DEADLINE_MISS, DT_STOPPING_MICRO, control_loop_delay_count, loop_interval.count());
+            }
 
             // Testing loop time
             // static double loop_time = 0.0;
@@ -1123,7 +1182,11 @@ int run_main_control(kinova_mediator &robot_driver)
             }
 
             loop_iteration_count++;
-            if (enforce_loop_frequency(DT_MICRO) != 0) control_loop_delay_count++;
+            if (enforce_loop_frequency(DT_MICRO) != 0)
+            {
+                control_loop_delay_count++;
+                rt_event::publish(rt_event::DEADLINE_MISS, DT_MICRO, control_loop_delay_count, loop_interval.count());
+            }
 
             // Testing loop time
             // static double loop_time = 0.0;
@@ -1190,10 +1253,24 @@ int main(int argc, char **argv)
     log_data             = true;
     use_estimated_external_wrench  = true;
     control_null_space_moveConstrained = false;
+    // trace_file           = "kinova_session.trace";
+
+#ifdef REPLAY_TRACE
+    // Replay target: the recorded session is fed to the controller on the model of the simulated robot
+    if (argc < 2)
+    {
+        printf("Usage: replay TRACE_FILE [TOLERANCE]\n");
+        return -1;
+    }
+    environment          = kinova_environment::SIMULATION;
+#endif
 
     kinova_mediator robot_driver;
-    int return_flag = go_to(robot_driver, desired_pose_id);
+    int return_flag = 0;
+#ifndef REPLAY_TRACE
+    return_flag = go_to(robot_driver, desired_pose_id);
     if (return_flag != 0) return 0;
+#endif
 
     // Calibration function should be used only one-time. The robot must be in the zero-configuration
     // calibrate_torque_offsets(); return 0;
@@ -1210,10 +1287,20 @@ int main(int argc, char **argv)
 
     // run_test(robot_driver); return 0;
 
-    if (run_main_control(robot_driver) == -1) return 0;
+#ifdef REPLAY_TRACE
+    replay_mediator session_driver(&robot_driver);
+    if (session_driver.load(argv[1], (argc > 2)? std::atof(argv[2]) : 0.0) != 0) return -1;
+    run_main_control(robot_driver, session_driver);
+    return session_driver.print_report();
+#else
+    recording_mediator session_driver(&robot_driver);
+    if (!trace_file.empty() && session_driver.open(trace_file) != 0) return 0;
+    if (run_main_control(robot_driver, session_driver) == -1) return 0;
+    session_driver.close();
     robot_driver.deinitialize();
     return_flag = go_to(robot_driver, desired_pose_id);
     return 0;
+#endif
 
     dynamics_controller controller(&robot_driver, RATE_HZ, compensate_gravity);
 
@@ -1311,6 +1398,7 @@ int main(int argc, char **argv)
         return -1;
     }
 
+    controller.set_lazy_dynamics(use_lazy_dynamics, dynamics_parameter::LAZY_DYNAMICS_DELTA_Q_BOUND, dynamics_parameter::LAZY_DYNAMICS_REFRESH_PERIOD);
     initial_result = controller.initialize(desired_control_mode, desired_dynamics_interface, motion_profile_id, log_data, use_estimated_external_wrench);
     if (initial_result != 0) return -1;
 
@@ -0,0 +1,217 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * Closed-loop scenarios: every task model runs on the simulated Kinova Gen3 plant,
+ * from a seeded perturbation of the HOME configuration and with seeded sensor noise.
+ * Per scenario and seed, reports completion time, time spent outside of the tube,
+ * peak and RMS tracking error, torque usage and the per-cycle compute time of the controller, as JSON.
+ *
+ * Usage: scenarios [--seed N] [--seeds N] [--filter TEXT] [--output FILE]
+ *                  [--baseline FILE] [--threshold PERCENT]
+ * With --baseline, a comparison table is printed and the exit code is 1 if any scenario
+ * does not complete anymore, or if its completion time, tube violation or RMS error
+ * increased by more than the threshold. Compute times are machine dependent and only reported.
+ */
+#include <scenario_runner.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#ifndef PARAMETER_DIR
+#define PARAMETER_DIR "parameters/"
+#endif
+
+using scenario_result = scenario_runner::result;
+using scenario_runner::DT_SEC;
+
+struct scenario_options
+{
+    unsigned int seed = 1;
+    int number_of_seeds = 3;
+    double threshold_percent = 10.0;
+    std::string filter = "";
+    std::string output_file = "scenario_results.json"; // The controller itself prints to stdout
+    std::string baseline_file = "";
+};
+
+void write_results(FILE *file, const scenario_options &options,
+                   const std::vector<scenario_result> &results)
+{
+    fprintf(file, "{\n  \"seed\": %u,\n  \"seeds\": %d,\n  \"rate_hz\": %d,\n  \"results\": [\n",
+            options.seed, options.number_of_seeds, scenario_runner::RATE_HZ);
+    for (std::size_t r = 0; r < results.size(); r++)
+    {
+        const scenario_result &result = results[r];
+        fprintf(file, "    {\"scenario\": \"%s\", \"seed\": %u, \"completed\": %d, \"completion_time_sec\": %.4f, "
+                      "\"tube_violation_sec\": %.4f, \"peak_error\": %.6f, \"rms_error\": %.6f, \"torque_usage\": %.6f, \"cycles\": %d, "
+                      "\"compute_mean_us\": %.2f, \"compute_p50_us\": %.2f, \"compute_p99_us\": %.2f, "
+                      "\"compute_max_us\": %.2f, \"return_flag\": %d}%s\n",
+                result.name.c_str(), result.seed, result.completed? 1 : 0, result.completion_time_sec,
+                result.tube_violation_sec, result.peak_error, result.rms_error, result.torque_usage, result.cycles,
+                result.compute_mean_us, result.compute_p50_us, result.compute_p99_us,
+                result.compute_max_us, result.return_flag, (r + 1 < results.size())? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+// Reads the result lines of a file written by write_results
+int read_results(const std::string &file_path, std::vector<scenario_result> &results)
+{
+    FILE *file = fopen(file_path.c_str(), "r");
+    if (file == nullptr)
+    {
+        printf("Failed to open baseline file: %s\n", file_path.c_str());
+        return -1;
+    }
+
+    char line[1024], name[128];
+    int completed = 0;
+    scenario_result result;
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        if (sscanf(line, " {\"scenario\": \"%127[^\"]\", \"seed\": %u, \"completed\": %d, \"completion_time_sec\": %lf, "
+                         "\"tube_violation_sec\": %lf, \"peak_error\": %lf, \"rms_error\": %lf, \"torque_usage\": %lf, \"cycles\": %d, "
+                         "\"compute_mean_us\": %lf, \"compute_p50_us\": %lf, \"compute_p99_us\": %lf, "
+                         "\"compute_max_us\": %lf, \"return_flag\": %d",
+                   name, &result.seed, &completed, &result.completion_time_sec, &result.tube_violation_sec,
+                   &result.peak_error, &result.rms_error, &result.torque_usage, &result.cycles, &result.compute_mean_us,
+                   &result.compute_p50_us, &result.compute_p99_us, &result.compute_max_us,
+                   &result.return_flag) != 14) continue;
+        result.name = name;
+        result.completed = (completed != 0);
+        results.push_back(result);
+    }
+    fclose(file);
+    return 0;
+}
+
+// Worse than the reference by more than the threshold; the floor absorbs differences of numerical noise
+bool is_worse(const double current, const double reference, const double threshold_percent, const double floor)
+{
+    return current > reference + std::max(floor, std::fabs(reference) * threshold_percent / 100.0);
+}
+
+// Returns the number of scenario runs that regressed with respect to the baseline
+int compare_to_baseline(const scenario_options &options, const std::vector<scenario_result> &results,
+                        const std::vector<scenario_result> &baseline)
+{
+    int regressions = 0;
+    fprintf(stderr, "\n%-28s %5s %17s %17s %21s %13s\n", "scenario", "seed", "completion [s]",
+            "tube viol. [s]", "rms error", "p99 [us]");
+    for (const scenario_result &result : results)
+    {
+        auto reference = std::find_if(baseline.begin(), baseline.end(), [&](const scenario_result &b)
+                                      { return b.name == result.name && b.seed == result.seed; });
+        if (reference == baseline.end())
+        {
+            fprintf(stderr, "%-28s %5u %8s -> %6.3f %8s -> %6.3f %10s -> %8.6f %5s -> %5.0f\n", result.name.c_str(),
+                    result.seed, "-", result.completion_time_sec, "-", result.tube_violation_sec, "-",
+                    result.rms_error, "-", result.compute_p99_us);
+            continue;
+        }
+
+        bool regression = reference->completed && !result.completed;
+        if (result.completed && reference->completed)
+            regression |= is_worse(result.completion_time_sec, reference->completion_time_sec, options.threshold_percent, 10.0 * DT_SEC);
+        regression |= is_worse(result.tube_violation_sec, reference->tube_violation_sec, options.threshold_percent, 10.0 * DT_SEC);
+        regression |= is_worse(result.rms_error, reference->rms_error, options.threshold_percent, 1e-6);
+        if (regression) regressions++;
+
+        fprintf(stderr, "%-28s %5u %6.3f -> %6.3f%s %6.3f -> %6.3f %8.6f -> %8.6f %5.0f -> %5.0f%s\n", result.name.c_str(),
+                result.seed, reference->completion_time_sec, result.completion_time_sec, result.completed? " " : "!",
+                reference->tube_violation_sec, result.tube_violation_sec, reference->rms_error, result.rms_error,
+                reference->compute_p99_us, result.compute_p99_us, regression? "  REGRESSION" : "");
+    }
+    return regressions;
+}
+
+int parse_arguments(int argc, char **argv, scenario_options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+        if (i + 1 >= argc)
+        {
+            printf("Missing value for argument: %s\n", argument.c_str());
+            return -1;
+        }
+
+        if      (argument == "--seed")      options.seed              = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--seeds")     options.number_of_seeds   = std::max(1, std::atoi(argv[++i]));
+        else if (argument == "--threshold") options.threshold_percent = std::atof(argv[++i]);
+        else if (argument == "--filter")    options.filter            = argv[++i];
+        else if (argument == "--output")    options.output_file       = argv[++i];
+        else if (argument == "--baseline")  options.baseline_file     = argv[++i];
+        else
+        {
+            printf("Unknown argument: %s\n", argument.c_str());
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    scenario_options options;
+    if (parse_arguments(argc, argv, options) != 0) return -1;
+
+    std::vector<scenario_result> results;
+    const std::string parameter_file = std::string(PARAMETER_DIR) + "kinova_abag_parameters.txt";
+    for (const scenario_runner::scenario &task : scenario_runner::get_scenarios())
+    {
+        if (!options.filter.empty() && task.name.find(options.filter) == std::string::npos) continue;
+
+        for (int s = 0; s < options.number_of_seeds; s++)
+        {
+            scenario_result result;
+            if (scenario_runner::run(task, options.seed + s, parameter_file, nullptr, result) != 0)
+            {
+                printf("Scenario could not be set up: %s\n", task.name.c_str());
+                return -1;
+            }
+            results.push_back(result);
+        }
+    }
+
+    FILE *output = fopen(options.output_file.c_str(), "w");
+    if (output == nullptr)
+    {
+        printf("Failed to open output file: %s\n", options.output_file.c_str());
+        return -1;
+    }
+    write_results(output, options, results);
+    fclose(output);
+
+    if (options.baseline_file.empty()) return 0;
+
+    std::vector<scenario_result> baseline;
+    if (read_results(options.baseline_file, baseline) != 0) return -1;
+    return (compare_to_baseline(options, results, baseline) > 0)? 1 : 0;
+}
@@ -0,0 +1,497 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * Parallel tuning of the nominal ABAG parameter set of one scenario, on the simulated plant.
+ * Every candidate set is evaluated over a number of seeds; each run owns its plant and
+ * controller, and runs are distributed over worker threads. Candidates are generated
+ * by grid, uniform random or CMA-ES search, in a normalized space of per-group scale factors
+ * (linear and angular dimensions of the ABAG vectors separately, one per entry of the null-space ABAG,
+ * one per joint-space vector of the stopping ABAG) applied to the set stored in the parameter file.
+ * The best sets are written as named sections of the parameter file format,
+ * loadable with dynamics_controller::load_parameters.
+ *
+ * Usage: tuner --scenario NAME [--method grid|random|cmaes] [--evaluations N] [--grid-levels N]
+ *              [--parameters KEY,KEY,...] [--seeds N] [--seed N] [--threads N] [--top N]
+ *              [--weights TIME,VIOLATION,TORQUE,ERROR] [--output FILE]
+ * Cost of a run: TIME * completion time (twice the time limit if not completed) + VIOLATION * tube 
+ * violation time + TORQUE * relative torque usage + ERROR * RMS tracking error; averaged over the seeds.
+ */
+#include <scenario_runner.hpp>
+#include <parameter_store.hpp>
+#include <Eigen/Dense>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef PARAMETER_DIR
+#define PARAMETER_DIR "parameters/"
+#endif
+
+const double INCOMPLETE_PENALTY  = 2.0; // Completion time of a failed run, in units of the task time limit
+const double CMAES_INITIAL_SIGMA = 0.3; // In the normalized search space [0, 1]^D
+
+// One search dimension: a scale factor for a group of entries of a parameter vector
+struct tuning_dimension
+{
+    std::string key;
+    int first, count; // Entries scaled together; count 0: all of them (joint-space vectors)
+    double min_factor, max_factor;
+    bool complement; // Scale 1 - value instead of the value (filter constants close to 1)
+    bool unit_interval; // Kept within (0, 1), as required by the ABAG
+};
+
+// ABAG vectors: linear and angular entries separately. Null-space ABAG: one entry each, the last one is its command scale
+const std::vector<tuning_dimension> TUNING_DIMENSIONS = {
+    {"max_command",    0, 3, 0.5,  2.0, false, false}, {"max_command",    3, 3, 0.5,  2.0, false, false},
+    {"error_alpha",    0, 3, 0.25, 4.0, true,  true},  {"error_alpha",    3, 3, 0.25, 4.0, true,  true},
+    {"bias_threshold", 0, 3, 0.25, 4.0, false, true},  {"bias_threshold", 3, 3, 0.25, 4.0, false, true},
+    {"bias_step",      0, 3, 0.25, 4.0, false, true},  {"bias_step",      3, 3, 0.25, 4.0, false, true},
+    {"gain_threshold", 0, 3, 0.25, 4.0, false, true},  {"gain_threshold", 3, 3, 0.25, 4.0, false, true},
+    {"gain_step",      0, 3, 0.25, 4.0, false, true},  {"gain_step",      3, 3, 0.25, 4.0, false, true},
+    {"null_space_parameters", 0, 1, 0.25, 4.0, true,  true},  {"null_space_parameters", 1, 1, 0.25, 4.0, false, true},
+    {"null_space_parameters", 2, 1, 0.25, 4.0, false, true},  {"null_space_parameters", 3, 1, 0.25, 4.0, false, true},
+    {"null_space_parameters", 4, 1, 0.25, 4.0, false, true},  {"null_space_parameters", 5, 1, 0.5,  2.0, false, false},
+    {"stop_motion_error_alpha",    0, 0, 0.25, 4.0, true,  true},
+    {"stop_motion_bias_threshold", 0, 0, 0.25, 4.0, false, true},
+    {"stop_motion_bias_step",      0, 0, 0.25, 4.0, false, true},
+    {"stop_motion_gain_threshold", 0, 0, 0.25, 4.0, false, true},
+    {"stop_motion_gain_step",      0, 0, 0.25, 4.0, false, true}
+};
+
+struct tuner_options
+{
+    std::string scenario = "";
+    std::string method = "cmaes";
+    std::string parameters = "max_command,error_alpha,bias_threshold,bias_step,gain_threshold,gain_step";
+    std::string output_file = "tuned_parameters.txt";
+    int evaluations = 200;
+    int grid_levels = 3;
+    int number_of_seeds = 3;
+    int threads = 0; // 0: one per hardware thread
+    int top = 3;
+    unsigned int seed = 1;
+    double weights[4] = {1.0, 10.0, 1.0, 100.0}; // Completion time, tube violation, torque usage, RMS error
+};
+
+struct evaluation
+{
+    Eigen::VectorXd x;
+    controller_parameters parameters;
+    double cost = 0.0;
+    double completion_time_sec = 0.0, tube_violation_sec = 0.0, torque_usage = 0.0, rms_error = 0.0;
+    int completed_runs = 0;
+};
+
+// Scale factor of a normalized coordinate, geometric between the bounds
+double get_factor(const tuning_dimension &dimension, const double x)
+{
+    const double clipped = std::min(1.0, std::max(0.0, x));
+    return dimension.min_factor * std::pow(dimension.max_factor / dimension.min_factor, clipped);
+}
+
+// Normalized coordinate of the unscaled base set
+double get_neutral_coordinate(const tuning_dimension &dimension)
+{
+    return std::log(1.0 / dimension.min_factor) / std::log(dimension.max_factor / dimension.min_factor);
+}
+
+Eigen::VectorXd *get_vector(controller_parameters &parameters, const std::string &key)
+{
+    if      (key == "max_command")                return &parameters.max_command;
+    else if (key == "error_alpha")                return &parameters.error_alpha;
+    else if (key == "bias_threshold")             return &parameters.bias_threshold;
+    else if (key == "bias_step")                  return &parameters.bias_step;
+    else if (key == "gain_threshold")             return &parameters.gain_threshold;
+    else if (key == "gain_step")                  return &parameters.gain_step;
+    else if (key == "null_space_parameters")      return &parameters.null_space_parameters;
+    else if (key == "stop_motion_error_alpha")    return &parameters.stop_motion_error_alpha;
+    else if (key == "stop_motion_bias_threshold") return &parameters.stop_motion_bias_threshold;
+    else if (key == "stop_motion_bias_step")      return &parameters.stop_motion_bias_step;
+    else if (key == "stop_motion_gain_threshold") return &parameters.stop_motion_gain_threshold;
+    else if (key == "stop_motion_gain_step")      return &parameters.stop_motion_gain_step;
+    return nullptr;
+}
+
+// Candidate set: the base set with scaled vectors, kept within the ranges accepted by the ABAG
+controller_parameters apply_candidate(const controller_parameters &base, const std::vector<tuning_dimension> &dimensions,
+                                      const Eigen::VectorXd &x)
+{
+    controller_parameters candidate = base;
+    for (std::size_t d = 0; d < dimensions.size(); d++)
+    {
+        Eigen::VectorXd *values = get_vector(candidate, dimensions[d].key);
+        const double factor = get_factor(dimensions[d], x(d));
+        const int end = (dimensions[d].count == 0)? values->size() : dimensions[d].first + dimensions[d].count;
+
+        for (int i = dimensions[d].first; i < end; i++)
+        {
+            double &value = (*values)(i);
+            if (dimensions[d].complement) value = 1.0 - factor * (1.0 - value);
+            else value *= factor;
+            if (dimensions[d].unit_interval) value = std::min(1.0 - 1e-6, std::max(1e-6, value));
+        }
+    }
+    return candidate;
+}
+
+double get_run_cost(const tuner_options &options, const scenario_runner::result &run)
+{
+    const double completion_time = run.completed? run.completion_time_sec : 
+                                                  INCOMPLETE_PENALTY * scenario_runner::TASK_TIME_LIMIT_SEC;
+    return options.weights[0] * completion_time + options.weights[1] * run.tube_violation_sec +
+           options.weights[2] * run.torque_usage + options.weights[3] * run.rms_error;
+}
+
+/**
+ * Evaluates the candidates in parallel: workers take the next (candidate, seed) run from a shared counter.
+ * Each run builds its own plant and controller, so the only shared state is the counter and the result slots.
+ */
+int evaluate(const tuner_options &options, const scenario_runner::scenario &task, const std::string &parameter_file,
+             std::vector<evaluation> &candidates)
+{
+    const int number_of_runs = static_cast<int>(candidates.size()) * options.number_of_seeds;
+    std::vector<scenario_runner::result> runs(number_of_runs);
+    std::atomic<int> next_run(0);
+    std::atomic<bool> setup_failed(false);
+
+    auto worker = [&]()
+    {
+        for (int r = next_run++; r < number_of_runs && !setup_failed; r = next_run++)
+        {
+            const evaluation &candidate = candidates[r / options.number_of_seeds];
+            const unsigned int seed = options.seed + r % options.number_of_seeds;
+            if (scenario_runner::run(task, seed, parameter_file, &candidate.parameters, runs[r]) != 0) setup_failed = true;
+        }
+    };
+
+    const int number_of_threads = std::max(1, std::min(options.threads, number_of_runs));
+    std::vector<std::thread> workers;
+    for (int t = 0; t < number_of_threads; t++) workers.emplace_back(worker);
+    for (std::thread &thread : workers) thread.join();
+    if (setup_failed) return -1;
+
+    for (std::size_t c = 0; c < candidates.size(); c++)
+    {
+        evaluation &candidate = candidates[c];
+        candidate.cost = candidate.completion_time_sec = candidate.tube_violation_sec = 0.0;
+        candidate.torque_usage = candidate.rms_error = 0.0;
+        candidate.completed_runs = 0;
+
+        for (int s = 0; s < options.number_of_seeds; s++)
+        {
+            const scenario_runner::result &run = runs[c * options.number_of_seeds + s];
+            candidate.cost                += get_run_cost(options, run) / options.number_of_seeds;
+            candidate.completion_time_sec += run.completion_time_sec / options.number_of_seeds;
+            candidate.tube_violation_sec  += run.tube_violation_sec / options.number_of_seeds;
+            candidate.torque_usage        += run.torque_usage / options.number_of_seeds;
+            candidate.rms_error           += run.rms_error / options.number_of_seeds;
+            if (run.completed) candidate.completed_runs++;
+        }
+    }
+    return 0;
+}
+
+evaluation make_candidate(const controller_parameters &base, const std::vector<tuning_dimension> &dimensions,
+                          const Eigen::VectorXd &x)
+{
+    evaluation candidate;
+    candidate.x = x;
+    candidate.parameters = apply_candidate(base, dimensions, x);
+    return candidate;
+}
+
+int search_grid(const tuner_options &options, const scenario_runner::scenario &task, const std::string &parameter_file,
+                const controller_parameters &base, const std::vector<tuning_dimension> &dimensions,
+                std::vector<evaluation> &evaluations)
+{
+    const int D = dimensions.size();
+    const double grid_size = std::pow(static_cast<double>(options.grid_levels), D);
+    if (grid_size > options.evaluations)
+    {
+        printf("Grid of %.0f points exceeds the budget of %d evaluations: reduce --parameters or --grid-levels\n",
+               grid_size, options.evaluations);
+        return -1;
+    }
+
+    std::vector<evaluation> candidates;
+    std::vector<int> level(D, 0);
+    for (int point = 0; point < static_cast<int>(grid_size); point++)
+    {
+        Eigen::VectorXd x(D);
+        for (int d = 0; d < D; d++) x(d) = (options.grid_levels > 1)? level[d] / (options.grid_levels - 1.0) : 0.5;
+        candidates.push_back(make_candidate(base, dimensions, x));
+
+        for (int d = 0; d < D && ++level[d] == options.grid_levels; d++) level[d] = 0;
+    }
+
+    if (evaluate(options, task, parameter_file, candidates) != 0) return -1;
+    evaluations.insert(evaluations.end(), candidates.begin(), candidates.end());
+    return 0;
+}
+
+int search_random(const tuner_options &options, const scenario_runner::scenario &task, const std::string &parameter_file,
+                  const controller_parameters &base, const std::vector<tuning_dimension> &dimensions,
+                  std::vector<evaluation> &evaluations)
+{
+    std::mt19937 generator(options.seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    std::vector<evaluation> candidates;
+    for (int e = 0; e < options.evaluations; e++)
+    {
+        Eigen::VectorXd x(dimensions.size());
+        for (int d = 0; d < x.size(); d++) x(d) = unit(generator);
+        candidates.push_back(make_candidate(base, dimensions, x));
+    }
+
+    if (evaluate(options, task, parameter_file, candidates) != 0) return -1;
+    evaluations.insert(evaluations.end(), candidates.begin(), candidates.end());
+    return 0;
+}
+
+/**
+ * (mu/mu_w, lambda)-CMA-ES, as in Hansen's tutorial, started from the base set.
+ * Samples outside of [0, 1]^D are repaired by clipping, and the repaired step is used in the update.
+ * Each generation is evaluated in parallel.
+ */
+int search_cmaes(const tuner_options &options, const scenario_runner::scenario &task, const std::string &parameter_file,
+                 const controller_parameters &base, const std::vector<tuning_dimension> &dimensions,
+                 std::vector<evaluation> &evaluations)
+{
+    const int n      = dimensions.size();
+    const int lambda = 4 + static_cast<int>(3.0 * std::log(static_cast<double>(n)));
+    const int mu     = lambda / 2;
+
+    Eigen::VectorXd weights(mu);
+    for (int i = 0; i < mu; i++) weights(i) = std::log(mu + 0.5) - std::log(i + 1.0);
+    weights /= weights.sum();
+    const double mueff = 1.0 / weights.squaredNorm();
+
+    const double cc    = (4.0 + mueff / n) / (n + 4.0 + 2.0 * mueff / n);
+    const double cs    = (mueff + 2.0) / (n + mueff + 5.0);
+    const double c1    = 2.0 / ((n + 1.3) * (n + 1.3) + mueff);
+    const double cmu   = std::min(1.0 - c1, 2.0 * (mueff - 2.0 + 1.0 / mueff) / ((n + 2.0) * (n + 2.0) + mueff));
+    const double damps = 1.0 + 2.0 * std::max(0.0, std::sqrt((mueff - 1.0) / (n + 1.0)) - 1.0) + cs;
+    const double chiN  = std::sqrt(static_cast<double>(n)) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+
+    Eigen::VectorXd mean(n), pc = Eigen::VectorXd::Zero(n), ps = Eigen::VectorXd::Zero(n);
+    for (int d = 0; d < n; d++) mean(d) = get_neutral_coordinate(dimensions[d]);
+    Eigen::MatrixXd C = Eigen::MatrixXd::Identity(n, n);
+    double sigma = CMAES_INITIAL_SIGMA;
+
+    std::mt19937 generator(options.seed);
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    for (int generation = 0; (generation + 1) * lambda <= options.evaluations; generation++)
+    {
+        Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigen_solver(C);
+        const Eigen::MatrixXd B = eigen_solver.eigenvectors();
+        const Eigen::VectorXd D = eigen_solver.eigenvalues().cwiseMax(1e-20).cwiseSqrt();
+        const Eigen::MatrixXd C_inverse_sqrt = B * D.cwiseInverse().asDiagonal() * B.transpose();
+
+        std::vector<evaluation> candidates;
+        for (int k = 0; k < lambda; k++)
+        {
+            Eigen::VectorXd z(n);
+            for (int d = 0; d < n; d++) z(d) = normal(generator);
+            const Eigen::VectorXd x = (mean + sigma * B * D.asDiagonal() * z).cwiseMax(0.0).cwiseMin(1.0);
+            candidates.push_back(make_candidate(base, dimensions, x));
+        }
+
+        if (evaluate(options, task, parameter_file, candidates) != 0) return -1;
+        std::sort(candidates.begin(), candidates.end(), [](const evaluation &a, const evaluation &b) { return a.cost < b.cost; });
+
+        const Eigen::VectorXd old_mean = mean;
+        mean.setZero();
+        for (int i = 0; i < mu; i++) mean += weights(i) * candidates[i].x;
+        const Eigen::VectorXd mean_step = (mean - old_mean) / sigma;
+
+        ps = (1.0 - cs) * ps + std::sqrt(cs * (2.0 - cs) * mueff) * C_inverse_sqrt * mean_step;
+        const double ps_norm = ps.norm() / std::sqrt(1.0 - std::pow(1.0 - cs, 2.0 * (generation + 1)));
+        const double hsig = (ps_norm / chiN < 1.4 + 2.0 / (n + 1.0))? 1.0 : 0.0;
+        pc = (1.0 - cc) * pc + hsig * std::sqrt(cc * (2.0 - cc) * mueff) * mean_step;
+
+        Eigen::MatrixXd rank_mu = Eigen::MatrixXd::Zero(n, n);
+        for (int i = 0; i < mu; i++)
+        {
+            const Eigen::VectorXd step = (candidates[i].x - old_mean) / sigma;
+            rank_mu += weights(i) * step * step.transpose();
+        }
+        C = (1.0 - c1 - cmu) * C + c1 * (pc * pc.transpose() + (1.0 - hsig) * cc * (2.0 - cc) * C) + cmu * rank_mu;
+        C = 0.5 * (C + C.transpose()); // Keep it numerically symmetric
+        sigma *= std::exp((cs / damps) * (ps.norm() / chiN - 1.0));
+
+        fprintf(stderr, "Generation %d: best cost %f, sigma %f\n", generation, candidates[0].cost, sigma);
+        evaluations.insert(evaluations.end(), candidates.begin(), candidates.end());
+    }
+    return 0;
+}
+
+int write_best_sets(const tuner_options &options, const evaluation &reference, std::vector<evaluation> &evaluations)
+{
+    std::ofstream file(options.output_file);
+    if (!file.is_open())
+    {
+        printf("Failed to open output file: %s\n", options.output_file.c_str());
+        return -1;
+    }
+
+    std::sort(evaluations.begin(), evaluations.end(), [](const evaluation &a, const evaluation &b) { return a.cost < b.cost; });
+
+    char line[256];
+    snprintf(line, sizeof(line), "# Tuned with: scenario %s, method %s, %zu evaluations of %d seeds from seed %u\n"
+                                 "# Cost weights (time, violation, torque, error): %g, %g, %g, %g\n"
+                                 "# Cost of the unscaled set: %f\n\n",
+             options.scenario.c_str(), options.method.c_str(), evaluations.size(), options.number_of_seeds,
+             options.seed, options.weights[0], options.weights[1], options.weights[2], options.weights[3], reference.cost);
+    file << line;
+
+    const int number_of_sets = std::min(options.top, static_cast<int>(evaluations.size()));
+    for (int rank = 0; rank < number_of_sets; rank++)
+    {
+        evaluation &best = evaluations[rank];
+        best.parameters.name = options.scenario + "_tuned_" + std::to_string(rank + 1);
+        snprintf(line, sizeof(line), "# cost %f: completed %d/%d, completion %.3f s, tube violation %.3f s, torque usage %.4f, rms error %.6f\n",
+                 best.cost, best.completed_runs, options.number_of_seeds, best.completion_time_sec,
+                 best.tube_violation_sec, best.torque_usage, best.rms_error);
+        file << line;
+        parameter_store::write(file, best.parameters);
+        file << "\n";
+
+        fprintf(stderr, "%-40s cost %f (unscaled %f)\n", best.parameters.name.c_str(), best.cost, reference.cost);
+    }
+    return 0;
+}
+
+int parse_arguments(int argc, char **argv, tuner_options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+        if (i + 1 >= argc)
+        {
+            printf("Missing value for argument: %s\n", argument.c_str());
+            return -1;
+        }
+
+        if      (argument == "--scenario")    options.scenario        = argv[++i];
+        else if (argument == "--method")      options.method          = argv[++i];
+        else if (argument == "--parameters")  options.parameters      = argv[++i];
+        else if (argument == "--output")      options.output_file     = argv[++i];
+        else if (argument == "--evaluations") options.evaluations     = std::max(1, std::atoi(argv[++i]));
+        else if (argument == "--grid-levels") options.grid_levels     = std::max(1, std::atoi(argv[++i]));
+        else if (argument == "--seeds")       options.number_of_seeds = std::max(1, std::atoi(argv[++i]));
+        else if (argument == "--seed")        options.seed            = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--threads")     options.threads         = std::max(0, std::atoi(argv[++i]));
+        else if (argument == "--top")         options.top             = std::max(1, std::atoi(argv[++i]));
+        else if (argument == "--weights")
+        {
+            if (sscanf(argv[++i], "%lf,%lf,%lf,%lf", &options.weights[0], &options.weights[1],
+                       &options.weights[2], &options.weights[3]) != 4)
+            {
+                printf("Weights must be given as TIME,VIOLATION,TORQUE,ERROR\n");
+                return -1;
+            }
+        }
+        else
+        {
+            printf("Unknown argument: %s\n", argument.c_str());
+            return -1;
+        }
+    }
+
+    if (options.method != "grid" && options.method != "random" && options.method != "cmaes")
+    {
+        printf("Unknown search method: %s\n", options.method.c_str());
+        return -1;
+    }
+
+    if (options.threads == 0) options.threads = std::max(1u, std::thread::hardware_concurrency());
+    return 0;
+}
+
+// Dimensions of the requested parameter keys
+int select_dimensions(const std::string &keys, std::vector<tuning_dimension> &dimensions)
+{
+    std::stringstream stream(keys);
+    std::string key;
+    while (std::getline(stream, key, ','))
+    {
+        const std::size_t count = dimensions.size();
+        for (const tuning_dimension &dimension : TUNING_DIMENSIONS)
+            if (dimension.key == key) dimensions.push_back(dimension);
+
+        if (dimensions.size() == count)
+        {
+            printf("Parameter cannot be tuned: %s\n", key.c_str());
+            return -1;
+        }
+    }
+    return dimensions.empty()? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    tuner_options options;
+    if (parse_arguments(argc, argv, options) != 0) return -1;
+
+    const scenario_runner::scenario *task = scenario_runner::find_scenario(options.scenario);
+    if (task == nullptr)
+    {
+        printf("Unknown scenario: %s\n", options.scenario.c_str());
+        return -1;
+    }
+
+    std::vector<tuning_dimension> dimensions;
+    if (select_dimensions(options.parameters, dimensions) != 0) return -1;
+
+    const std::string parameter_file = std::string(PARAMETER_DIR) + "kinova_abag_parameters.txt";
+    controller_parameters base;
+    if (scenario_runner::load_parameters(*task, parameter_file, base) != 0) return -1;
+
+    // Reference: the set as stored in the parameter file
+    Eigen::VectorXd neutral(dimensions.size());
+    for (int d = 0; d < neutral.size(); d++) neutral(d) = get_neutral_coordinate(dimensions[d]);
+    std::vector<evaluation> reference = {make_candidate(base, dimensions, neutral)};
+    if (evaluate(options, *task, parameter_file, reference) != 0) return -1;
+
+    std::vector<evaluation> evaluations = reference;
+    int result = 0;
+    if      (options.method == "grid")   result = search_grid(options, *task, parameter_file, base, dimensions, evaluations);
+    else if (options.method == "random") result = search_random(options, *task, parameter_file, base, dimensions, evaluations);
+    else                                 result = search_cmaes(options, *task, parameter_file, base, dimensions, evaluations);
+    if (result != 0) return -1;
+
+    return write_best_sets(options, reference[0], evaluations);
+}
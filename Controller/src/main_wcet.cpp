@@ -0,0 +1,641 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * Worst-case execution time harness. Reports the worst observed latency of every stage,
+ * together with the input that caused it, so that a safe control rate can be chosen per robot.
+ * - Kernel stages (every robot model): forward kinematics, Vereshchagin hybrid dynamics, RNE gravity
+ *   compensation, external wrench estimation and svd_eigen_HH alone. Each kernel runs on seeded random
+ *   configurations, and on near-singular configurations found by a greedy search on the smallest singular
+ *   value of the Jacobian, ranked by the number of svd_eigen_HH iterations they need.
+ * - Controller stages (Kinova Gen3, simulated plant): every cycle of dynamics_controller::step() over all
+ *   closed-loop scenarios, with the per-stage timing of the controller. Includes the FSM transition cycles,
+ *   e.g. APPROACH->CRUISE with its ABAG parameter switch, and the cycle that triggers the stopping motion.
+ * Caches are flushed before every timed call, unless the flush size is 0.
+ * Runs single-threaded on purpose: pin it to an isolated core for representative numbers.
+ *
+ * Usage: wcet [--seed N] [--seeds N] [--samples N] [--adversarial N] [--repetitions N]
+ *             [--flush-kb N] [--filter TEXT] [--output FILE]
+ * The filter selects kernel stages by "stage/robot" and closed-loop scenarios by name.
+ */
+#include <scenario_runner.hpp>
+#include <robot_models.hpp>
+#include <solver_vereshchagin.hpp>
+#include <fk_vereshchagin.hpp>
+#include <solver_recursive_newton_euler.hpp>
+#include <external_wrench_estimator.hpp>
+#include <constants.hpp>
+#include <kdl/chainjnttojacsolver.hpp>
+#include <kdl/chainfksolverpos_recursive.hpp>
+#include <kdl/utilities/svd_eigen_HH.hpp>
+#include <Eigen/SVD>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef PARAMETER_DIR
+#define PARAMETER_DIR "parameters/"
+#endif
+
+#define NUM_OF_CONSTRAINTS 6
+#define CACHE_LINE_SIZE 64
+#define SVD_MAX_ITERATIONS 150 // Default iteration limit of svd_eigen_HH
+#define SEARCH_STEPS 300 // Greedy steps towards a singularity, per candidate
+#define CANDIDATES_PER_CONFIGURATION 4 // Candidates searched per kept near-singular configuration
+
+// Results are accumulated here, so that the compiler cannot remove the measured calls
+static volatile double sink = 0.0;
+
+struct wcet_options
+{
+    unsigned int seed = 1;
+    int number_of_seeds = 2; // Closed-loop runs per scenario
+    int samples = 64; // Random configurations per robot
+    int adversarial = 16; // Near-singular configurations per robot
+    int repetitions = 3; // Cold-cache calls per kernel and configuration
+    int flush_kb = 32768; // Larger than the last level cache. 0: warm caches
+    std::string filter = "";
+    std::string output_file = "wcet_results.json"; // The controller itself prints to stdout
+};
+
+struct configuration
+{
+    std::string label;
+    KDL::JntArray q, qd;
+};
+
+// Worst observed latency of one stage, and the input of the call that caused it
+struct stage_record
+{
+    std::string robot, source, stage;
+    std::vector<double> latencies; // One entry per timed call, in microseconds
+    double worst_us = 0.0;
+    std::string worst_input;
+    KDL::JntArray worst_q, worst_qd;
+};
+
+// Evicts the data caches by writing every line of a buffer larger than the last level cache
+class cache_flusher
+{
+  public:
+    explicit cache_flusher(const int size_kb): buffer_(static_cast<std::size_t>(size_kb) * 1024, 0) {};
+
+    void flush()
+    {
+        for (std::size_t i = 0; i < buffer_.size(); i += CACHE_LINE_SIZE) buffer_[i]++;
+        if (!buffer_.empty()) sink = sink + buffer_[buffer_.size() / 2];
+    }
+
+  private:
+    std::vector<char> buffer_;
+};
+
+class wcet_report
+{
+  public:
+    void add(const std::string &robot, const std::string &source, const std::string &stage,
+             const double latency_us, const std::string &input,
+             const KDL::JntArray &q, const KDL::JntArray &qd)
+    {
+        stage_record &record = find(robot, source, stage);
+        record.latencies.push_back(latency_us);
+        if (record.latencies.size() > 1 && latency_us <= record.worst_us) return;
+
+        record.worst_us    = latency_us;
+        record.worst_input = input;
+        record.worst_q     = q;
+        record.worst_qd    = qd;
+    }
+
+    std::vector<stage_record> &get_records() { return records_; }
+
+  private:
+    std::vector<stage_record> records_;
+
+    stage_record &find(const std::string &robot, const std::string &source, const std::string &stage)
+    {
+        for (stage_record &record : records_)
+            if (record.robot == robot && record.source == source && record.stage == stage) return record;
+
+        stage_record record;
+        record.robot  = robot;
+        record.source = source;
+        record.stage  = stage;
+        records_.push_back(record);
+        return records_.back();
+    }
+};
+
+const char *task_status_name(const int status)
+{
+    switch (status)
+    {
+        case task_status::STOP_CONTROL:        return "STOP_CONTROL";
+        case task_status::NOMINAL:             return "NOMINAL";
+        case task_status::START_TO_CRUISE:     return "START_TO_CRUISE";
+        case task_status::CRUISE_TO_STOP:      return "CRUISE_TO_STOP";
+        case task_status::CRUISE_THROUGH_TUBE: return "CRUISE_THROUGH_TUBE";
+        case task_status::CRUISE:              return "CRUISE";
+        case task_status::CHANGE_TUBE_SECTION: return "CHANGE_TUBE_SECTION";
+        case task_status::APPROACH:            return "APPROACH";
+        case task_status::STOP_ROBOT:          return "STOP_ROBOT";
+        default:                               return "UNKNOWN";
+    }
+}
+
+const char *step_stage_name(const int stage)
+{
+    switch (stage)
+    {
+        case step_stage::PARAMETER_UPDATE:     return "parameter_update";
+        case step_stage::FORWARD_KINEMATICS:   return "forward_kinematics";
+        case step_stage::CONTROL_ERROR:        return "control_error";
+        case step_stage::FSM_STATUS:           return "fsm_status";
+        case step_stage::CARTESIAN_COMMANDS:   return "cartesian_commands";
+        case step_stage::HYBRID_DYNAMICS:      return "hybrid_dynamics";
+        case step_stage::GRAVITY_COMPENSATION: return "gravity_compensation";
+        case step_stage::STOPPING_MOTION:      return "stopping_motion";
+        default:                               return "unknown";
+    }
+}
+
+double elapsed_micro(const std::chrono::steady_clock::time_point &start,
+                     const std::chrono::steady_clock::time_point &end)
+{
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+/**
+ * Jacobian transpose, expressed in the end-effector frame, as decomposed by the external wrench estimator.
+ * svd_eigen_HH expects at least as many rows as columns: chains with less than 6 joints use the Jacobian itself
+ */
+class svd_probe
+{
+  public:
+    explicit svd_probe(const KDL::Chain &chain):
+        NUM_OF_JOINTS_(chain.getNrOfJoints()), jacobian_solver_(chain), fk_pos_solver_(chain),
+        jacobian_(NUM_OF_JOINTS_) {};
+
+    const Eigen::MatrixXd &get_matrix(const KDL::JntArray &q)
+    {
+        KDL::Frame end_effector_frame;
+        fk_pos_solver_.JntToCart(q, end_effector_frame);
+        jacobian_solver_.JntToJac(q, jacobian_);
+        jacobian_.changeBase(end_effector_frame.M.Inverse());
+
+        if (NUM_OF_JOINTS_ >= NUM_OF_CONSTRAINTS) matrix_ = jacobian_.data.transpose();
+        else matrix_ = jacobian_.data;
+        return matrix_;
+    }
+
+    double min_singular_value(const KDL::JntArray &q)
+    {
+        return Eigen::JacobiSVD<Eigen::MatrixXd>(get_matrix(q)).singularValues().minCoeff();
+    }
+
+    // The smallest iteration limit for which svd_eigen_HH converges. -1: not within its default limit
+    int iterations(const KDL::JntArray &q)
+    {
+        const Eigen::MatrixXd &matrix = get_matrix(q);
+        Eigen::MatrixXd U(matrix.rows(), matrix.cols()), V(matrix.cols(), matrix.cols());
+        Eigen::VectorXd S(matrix.cols()), tmp(matrix.cols());
+        for (int maxiter = 1; maxiter <= SVD_MAX_ITERATIONS; maxiter++)
+            if (KDL::svd_eigen_HH(matrix, U, S, V, tmp, maxiter) == 0) return maxiter;
+        return -1;
+    }
+
+  private:
+    const int NUM_OF_JOINTS_;
+    KDL::ChainJntToJacSolver jacobian_solver_;
+    KDL::ChainFkSolverPos_recursive fk_pos_solver_;
+    KDL::Jacobian jacobian_;
+    Eigen::MatrixXd matrix_;
+};
+
+void sample_configuration(const robot_model &model, std::mt19937 &generator, configuration &sample)
+{
+    const int NUM_OF_JOINTS = model.chain.getNrOfJoints();
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    sample.q.resize(NUM_OF_JOINTS);
+    sample.qd.resize(NUM_OF_JOINTS);
+
+    for (int j = 0; j < NUM_OF_JOINTS; j++)
+    {
+        const double mid   = 0.5 * (model.position_limits_max[j] + model.position_limits_min[j]);
+        const double range = 0.5 * (model.position_limits_max[j] - model.position_limits_min[j]);
+        sample.q(j)  = mid + range * unit(generator);
+        sample.qd(j) = model.joint_velocity_limits[j] * unit(generator);
+    }
+}
+
+/**
+ * Random configurations within the joint limits, followed by the near-singular ones:
+ * random starts driven towards a singularity, by greedy single-joint steps that decrease the smallest
+ * singular value. Of those, the ones on which svd_eigen_HH iterates longest are kept.
+ */
+void generate_configurations(const wcet_options &options, const robot_model &model,
+                             std::vector<configuration> &configurations)
+{
+    const int NUM_OF_JOINTS = model.chain.getNrOfJoints();
+    std::mt19937 generator(options.seed);
+    std::uniform_int_distribution<int> joint(0, NUM_OF_JOINTS - 1);
+    std::normal_distribution<double> standard_normal(0.0, 1.0);
+    svd_probe probe(model.chain);
+
+    for (int s = 0; s < options.samples; s++)
+    {
+        configuration sample;
+        sample_configuration(model, generator, sample);
+        sample.label = "random_" + std::to_string(s);
+        configurations.push_back(sample);
+    }
+
+    struct candidate
+    {
+        configuration sample;
+        double min_singular_value;
+        int iterations;
+    };
+    std::vector<candidate> candidates(options.adversarial * CANDIDATES_PER_CONFIGURATION);
+
+    for (candidate &current : candidates)
+    {
+        sample_configuration(model, generator, current.sample);
+        current.min_singular_value = probe.min_singular_value(current.sample.q);
+
+        KDL::JntArray q_step = current.sample.q;
+        double step_size = 0.2; // rad
+        for (int i = 0; i < SEARCH_STEPS; i++)
+        {
+            const int j = joint(generator);
+            q_step(j) = std::min(model.position_limits_max[j],
+                                 std::max(model.position_limits_min[j], current.sample.q(j) + step_size * standard_normal(generator)));
+
+            const double min_singular_value = probe.min_singular_value(q_step);
+            if (min_singular_value < current.min_singular_value)
+            {
+                current.sample.q(j) = q_step(j);
+                current.min_singular_value = min_singular_value;
+            }
+            else
+            {
+                q_step(j) = current.sample.q(j);
+                step_size = std::max(1e-6, 0.97 * step_size);
+            }
+        }
+        current.iterations = probe.iterations(current.sample.q);
+    }
+
+    // Non-converging first, then the most iterations; ties: closest to the singularity
+    std::sort(candidates.begin(), candidates.end(), [](const candidate &a, const candidate &b)
+    {
+        const int iterations_a = (a.iterations < 0)? SVD_MAX_ITERATIONS + 1 : a.iterations;
+        const int iterations_b = (b.iterations < 0)? SVD_MAX_ITERATIONS + 1 : b.iterations;
+        if (iterations_a != iterations_b) return iterations_a > iterations_b;
+        return a.min_singular_value < b.min_singular_value;
+    });
+
+    for (int c = 0; c < options.adversarial && c < static_cast<int>(candidates.size()); c++)
+    {
+        candidates[c].sample.label = "near_singular_" + std::to_string(c);
+        configurations.push_back(candidates[c].sample);
+    }
+}
+
+// Runs the kernel (argument: configuration index) on every configuration, with flushed caches before each call
+template <typename Kernel>
+void measure(const wcet_options &options, cache_flusher &flusher, wcet_report &report,
+             const robot_model &model, const std::string &stage,
+             const std::vector<configuration> &configurations, Kernel kernel)
+{
+    if (!options.filter.empty() && (stage + "/" + model.name).find(options.filter) == std::string::npos) return;
+
+    // Not timed: buffers that the solvers allocate lazily, on their first call
+    kernel(0);
+
+    for (std::size_t c = 0; c < configurations.size(); c++)
+    {
+        for (int r = 0; r < options.repetitions; r++)
+        {
+            flusher.flush();
+            const auto start = std::chrono::steady_clock::now();
+            kernel(c);
+            const auto end = std::chrono::steady_clock::now();
+            report.add(model.name, "kernel", stage, elapsed_micro(start, end), configurations[c].label,
+                       configurations[c].q, configurations[c].qd);
+        }
+    }
+}
+
+void run_kernel_stages(const wcet_options &options, const robot_model &model,
+                       cache_flusher &flusher, wcet_report &report)
+{
+    std::vector<configuration> configurations;
+    generate_configurations(options, model, configurations);
+
+    const KDL::Chain &chain   = model.chain;
+    const int NUM_OF_JOINTS   = chain.getNrOfJoints();
+    const int NUM_OF_SEGMENTS = chain.getNrOfSegments();
+    const std::vector<double> &acc = model.root_acceleration;
+    const KDL::Twist root_acc(KDL::Vector(acc[0], acc[1], acc[2]), KDL::Vector(acc[3], acc[4], acc[5]));
+    const KDL::Vector gravity = -1.0 * root_acc.vel;
+    const KDL::Wrenches zero_wrenches(NUM_OF_SEGMENTS, KDL::Wrench::Zero());
+    const KDL::JntArray zero_qdd(NUM_OF_JOINTS), zero_tau(NUM_OF_JOINTS);
+    KDL::JntArray q_out(NUM_OF_JOINTS), tau_out(NUM_OF_JOINTS);
+
+    KDL::FK_Vereshchagin fk_solver(chain);
+    std::vector<KDL::Frame> poses(NUM_OF_SEGMENTS);
+    std::vector<KDL::Twist> twists(NUM_OF_SEGMENTS);
+    measure(options, flusher, report, model, "forward_kinematics", configurations, [&](const std::size_t c)
+    {
+        fk_solver.JntToCart(configurations[c].q, configurations[c].qd, poses, twists);
+        sink = sink + poses[NUM_OF_SEGMENTS - 1].p(0);
+    });
+
+    // Full end-effector constraints: the constraint coupling matrix decomposed by svd_eigen_HH is the largest
+    KDL::Solver_Vereshchagin hd_solver(chain, model.joint_inertia, model.joint_torque_limits,
+                                       false, root_acc, NUM_OF_CONSTRAINTS);
+    KDL::Jacobian alpha(NUM_OF_CONSTRAINTS);
+    KDL::JntArray beta(NUM_OF_CONSTRAINTS);
+    KDL::SetToZero(alpha);
+    for (int c = 0; c < NUM_OF_CONSTRAINTS; c++)
+    {
+        alpha(c, c) = 1.0;
+        beta(c) = 0.1 * (c + 1);
+    }
+    measure(options, flusher, report, model, "hybrid_dynamics", configurations, [&](const std::size_t c)
+    {
+        hd_solver.CartToJnt(configurations[c].q, configurations[c].qd, q_out, alpha, beta, zero_wrenches, zero_wrenches, tau_out);
+        sink = sink + q_out(0);
+    });
+
+    KDL::Solver_RNE id_solver(chain, gravity, model.joint_inertia, model.joint_torque_limits, false);
+    measure(options, flusher, report, model, "gravity_compensation", configurations, [&](const std::size_t c)
+    {
+        id_solver.CartToJnt(configurations[c].q, zero_qdd, zero_qdd, zero_wrenches, tau_out);
+        sink = sink + tau_out(0);
+    });
+
+    KDL::ChainExternalWrenchEstimator estimator(chain, gravity, model.joint_inertia, 1000.0, 30.0, 0.5);
+    estimator.setInitialMomentum(configurations[0].q, configurations[0].qd);
+    KDL::Wrench wrench;
+    measure(options, flusher, report, model, "external_wrench_estimation", configurations, [&](const std::size_t c)
+    {
+        estimator.JntToExtWrench(configurations[c].q, configurations[c].qd, zero_tau, wrench);
+        sink = sink + wrench.force(0);
+    });
+
+    // svd_eigen_HH alone, on the matrix decomposed by the estimator. The matrices are prepared in advance
+    svd_probe probe(chain);
+    std::vector<Eigen::MatrixXd> matrices;
+    for (const configuration &sample : configurations) matrices.push_back(probe.get_matrix(sample.q));
+    const int rows = matrices[0].rows(), cols = matrices[0].cols();
+    Eigen::MatrixXd U(rows, cols), V(cols, cols);
+    Eigen::VectorXd S(cols), tmp(cols);
+    measure(options, flusher, report, model, "svd_eigen_HH", configurations, [&](const std::size_t c)
+    {
+        KDL::svd_eigen_HH(matrices[c], U, S, V, tmp, SVD_MAX_ITERATIONS);
+        sink = sink + S(0);
+    });
+}
+
+/**
+ * Drives step() as the control loop of the controller does: estimate the external wrench, step,
+ * and send the torque command to the plant. Once the FSM ends the task (or the cycle limit is hit),
+ * the next cycle triggers the stopping motion. Note that the controller skips the stop motion 
+ * commands in simulation: the stop-trigger cycle consists of the braking plan.
+ */
+int run_controller_stages(const scenario_runner::scenario &task, const unsigned int seed,
+                          cache_flusher &flusher, wcet_report &report)
+{
+    const std::string robot = "kinova_gen3";
+    scenario_runner::session run_session;
+    const std::string parameter_file = std::string(PARAMETER_DIR) + "kinova_abag_parameters.txt";
+    if (scenario_runner::setup(task, seed, parameter_file, nullptr, run_session) != 0) return -1;
+    simulation_mediator &plant = run_session.plant;
+    dynamics_controller &controller = *run_session.controller;
+    controller.set_stage_timing(true);
+
+    const int JOINTS = kinova_constants::NUMBER_OF_JOINTS;
+    KDL::JntArray q(JOINTS), qd(JOINTS), tau(JOINTS), command(JOINTS);
+    KDL::Wrench ext_force_torque;
+    const int max_cycles = static_cast<int>((scenario_runner::TASK_TIME_LIMIT_SEC + 1.0) * scenario_runner::RATE_HZ);
+    int previous_status = controller.get_task_status();
+    char input[256];
+
+    int cycle = 0;
+    for (; cycle < max_cycles; cycle++)
+    {
+        plant.get_joint_state(q, qd, tau);
+        flusher.flush();
+
+        const auto start = std::chrono::steady_clock::now();
+        int return_flag = controller.estimate_external_wrench(q, qd, tau, ext_force_torque);
+        const auto estimated = std::chrono::steady_clock::now();
+        if (return_flag == 0)
+            return_flag = controller.step(q, qd, tau, ext_force_torque, command, cycle * scenario_runner::DT_SEC,
+                                          cycle, 0, false);
+        const auto end = std::chrono::steady_clock::now();
+
+        const int status = controller.get_task_status();
+        if (status != previous_status)
+            snprintf(input, sizeof(input), "%s seed %u cycle %d %s->%s", task.name.c_str(), seed, cycle,
+                     task_status_name(previous_status), task_status_name(status));
+        else
+            snprintf(input, sizeof(input), "%s seed %u cycle %d %s", task.name.c_str(), seed, cycle, task_status_name(status));
+
+        report.add(robot, "controller", "external_wrench_estimation", elapsed_micro(start, estimated), input, q, qd);
+        const std::vector<double> &stage_times = controller.get_stage_times();
+        for (int stage = 0; stage < step_stage::NUMBER_OF_STEP_STAGES; stage++)
+            if (stage_times[stage] > 0.0) report.add(robot, "controller", step_stage_name(stage), stage_times[stage], input, q, qd);
+        report.add(robot, "controller", "step", elapsed_micro(estimated, end), input, q, qd);
+        report.add(robot, "controller", "cycle", elapsed_micro(start, end), input, q, qd);
+        if (status != previous_status) report.add(robot, "controller", "fsm_transition_cycle", elapsed_micro(start, end), input, q, qd);
+        previous_status = status;
+
+        if (return_flag != 0) break;
+        if (plant.set_joint_command(q, qd, command, control_mode::TORQUE) != 0) break;
+    }
+
+    // Stop-trigger cycle
+    plant.get_joint_state(q, qd, tau);
+    flusher.flush();
+    const auto start = std::chrono::steady_clock::now();
+    controller.step(q, qd, tau, ext_force_torque, command, cycle * scenario_runner::DT_SEC, cycle, 0, true);
+    const auto end = std::chrono::steady_clock::now();
+
+    snprintf(input, sizeof(input), "%s seed %u cycle %d stop trigger", task.name.c_str(), seed, cycle);
+    report.add(robot, "controller", step_stage_name(step_stage::STOPPING_MOTION),
+               controller.get_stage_times()[step_stage::STOPPING_MOTION], input, q, qd);
+    report.add(robot, "controller", "stop_trigger_cycle", elapsed_micro(start, end), input, q, qd);
+
+    controller.deinitialize();
+    return 0;
+}
+
+void write_joint_array(FILE *file, const KDL::JntArray &values)
+{
+    fprintf(file, "[");
+    for (unsigned int j = 0; j < values.rows(); j++) fprintf(file, "%s%.6f", (j > 0)? ", " : "", values(j));
+    fprintf(file, "]");
+}
+
+double percentile(std::vector<double> values, const double fraction)
+{
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<std::size_t>(fraction * values.size()))];
+}
+
+/**
+ * Worst case of one full control cycle per robot: measured in closed loop where available,
+ * otherwise the sum of the worst cases of the kernel stages (without the ABAG and FSM updates)
+ */
+void write_rate_bounds(FILE *file, const std::vector<robot_model> &models, std::vector<stage_record> &records)
+{
+    fprintf(file, "  \"rate_bounds\": [\n");
+    for (std::size_t m = 0; m < models.size(); m++)
+    {
+        double closed_loop_us = 0.0, kernel_sum_us = 0.0;
+        for (const stage_record &record : records)
+        {
+            if (record.robot != models[m].name) continue;
+            if (record.source == "controller" && record.stage == "cycle") closed_loop_us = record.worst_us;
+            if (record.source == "kernel" && record.stage != "svd_eigen_HH") kernel_sum_us += record.worst_us;
+        }
+
+        const bool closed_loop = (closed_loop_us > 0.0);
+        const double worst_cycle_us = closed_loop? closed_loop_us : kernel_sum_us;
+        fprintf(file, "    {\"robot\": \"%s\", \"basis\": \"%s\", \"worst_cycle_us\": %.2f, \"max_rate_hz\": %.0f}%s\n",
+                models[m].name.c_str(), closed_loop? "closed_loop" : "kernel_sum", worst_cycle_us,
+                (worst_cycle_us > 0.0)? 1e6 / worst_cycle_us : 0.0, (m + 1 < models.size())? "," : "");
+    }
+    fprintf(file, "  ]\n");
+}
+
+void write_results(FILE *file, const wcet_options &options, const std::vector<robot_model> &models,
+                   std::vector<stage_record> &records)
+{
+    fprintf(file, "{\n  \"seed\": %u,\n  \"flush_kb\": %d,\n  \"repetitions\": %d,\n  \"results\": [\n",
+            options.seed, options.flush_kb, options.repetitions);
+    for (std::size_t r = 0; r < records.size(); r++)
+    {
+        const stage_record &record = records[r];
+        const robot_model *model = nullptr;
+        for (const robot_model &candidate : models)
+            if (candidate.name == record.robot) model = &candidate;
+
+        int iterations = 0;
+        double min_singular_value = 0.0;
+        if (model != nullptr)
+        {
+            svd_probe probe(model->chain);
+            iterations = probe.iterations(record.worst_q);
+            min_singular_value = probe.min_singular_value(record.worst_q);
+        }
+
+        fprintf(file, "    {\"robot\": \"%s\", \"source\": \"%s\", \"stage\": \"%s\", \"calls\": %zu, "
+                      "\"p50_us\": %.2f, \"p99_us\": %.2f, \"worst_us\": %.2f, \"input\": \"%s\", "
+                      "\"svd_iterations\": %d, \"min_singular_value\": %.3e, \"q\": ",
+                record.robot.c_str(), record.source.c_str(), record.stage.c_str(), record.latencies.size(),
+                percentile(record.latencies, 0.5), percentile(record.latencies, 0.99), record.worst_us,
+                record.worst_input.c_str(), iterations, min_singular_value);
+        write_joint_array(file, record.worst_q);
+        fprintf(file, ", \"qd\": ");
+        write_joint_array(file, record.worst_qd);
+        fprintf(file, "}%s\n", (r + 1 < records.size())? "," : "");
+    }
+    fprintf(file, "  ],\n");
+    write_rate_bounds(file, models, records);
+    fprintf(file, "}\n");
+}
+
+int parse_arguments(int argc, char **argv, wcet_options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+        if (i + 1 >= argc)
+        {
+            printf("Missing value for argument: %s\n", argument.c_str());
+            return -1;
+        }
+
+        if      (argument == "--seed")        options.seed            = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--seeds")       options.number_of_seeds = std::max(1, std::atoi(argv[++i]));
+        else if (argument == "--samples")     options.samples         = std::max(1, std::atoi(argv[++i]));
+        else if (argument == "--adversarial") options.adversarial     = std::max(0, std::atoi(argv[++i]));
+        else if (argument == "--repetitions") options.repetitions     = std::max(1, std::atoi(argv[++i]));
+        else if (argument == "--flush-kb")    options.flush_kb        = std::max(0, std::atoi(argv[++i]));
+        else if (argument == "--filter")      options.filter          = argv[++i];
+        else if (argument == "--output")      options.output_file     = argv[++i];
+        else
+        {
+            printf("Unknown argument: %s\n", argument.c_str());
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    wcet_options options;
+    if (parse_arguments(argc, argv, options) != 0) return -1;
+
+    std::vector<robot_model> models;
+    if (load_models(models) != 0) return -1;
+
+    cache_flusher flusher(options.flush_kb);
+    wcet_report report;
+    for (const robot_model &model : models) run_kernel_stages(options, model, flusher, report);
+
+    for (const scenario_runner::scenario &task : scenario_runner::get_scenarios())
+    {
+        if (!options.filter.empty() && task.name.find(options.filter) == std::string::npos) continue;
+
+        for (int s = 0; s < options.number_of_seeds; s++)
+        {
+            if (run_controller_stages(task, options.seed + s, flusher, report) != 0)
+            {
+                printf("Scenario could not be set up: %s\n", task.name.c_str());
+                return -1;
+            }
+        }
+    }
+
+    FILE *output = fopen(options.output_file.c_str(), "w");
+    if (output == nullptr)
+    {
+        printf("Failed to open output file: %s\n", options.output_file.c_str());
+        return -1;
+    }
+    write_results(output, options, models, report.get_records());
+    fclose(output);
+    return 0;
+}
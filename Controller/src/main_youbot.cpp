@@ -31,6 +31,7 @@ SOFTWARE.
 #include <safety_monitor.hpp>
 #include <finite_state_machine.hpp>
 #include <motion_profile.hpp>
+#include <trace_mediator.hpp>
 #include <iostream>
 #include <utility> 
 #include <sstream>
@@ -89,6 +90,7 @@ bool use_estimated_external_wrench   = false;
 bool control_null_space              = false;
 bool compensate_gravity              = false;
 bool use_mass_alternation            = false;
+std::string trace_file               = ""; // Sensor reads and commands of the session, for the replay target. Empty: not recorded
 
 std::vector<bool> control_dims      = {true, true, true, // Linear
                                        false, false, false}; // Angular
@@ -560,6 +562,7 @@ int main(int argc, char **argv)
     tube_tolerances      = std::vector<double>{0.001, 0.01, 0.01, 
                                                0.0, 0.0, 0.0, 
                                                0.005, 5.0}; // Last tolerance is in unit of degrees - Null-space tolerance
+    // trace_file           = "youbot_session.trace";
 
     if (desired_pose_id == desired_pose::LOOK_AT_1 && desired_task_model == task_model::moveTo)
     {
@@ -590,6 +593,16 @@ int main(int argc, char **argv)
     }
     else control_null_space = false;
 
+#ifdef REPLAY_TRACE
+    // Replay target: the recorded session is fed to the controller on the model of the simulated robot
+    if (argc < 2)
+    {
+        printf("Usage: replay TRACE_FILE [TOLERANCE]\n");
+        return -1;
+    }
+    environment          = youbot_environment::SIMULATION;
+#endif
+
     // Extract robot model and if not simulation, establish connection with motor drivers
     robot_driver.initialize(robot_model_id, environment, robot_id::YOUBOT);
     if (!robot_driver.is_initialized())
@@ -603,6 +616,7 @@ int main(int argc, char **argv)
     assert(JOINTS == number_of_segments);
     state_specification motion(number_of_joints, number_of_segments, number_of_segments + 1, NUMBER_OF_CONSTRAINTS);
 
+#ifndef REPLAY_TRACE
     if (robot_driver.stop_robot_motion() == -1) return 0;
     if      (desired_pose_id == desired_pose::LOOK_AT_2)   go_look_at_1(robot_driver);
     else if (desired_pose_id == desired_pose::LOOK_AT_1)   go_look_at_2(robot_driver);
@@ -612,6 +626,7 @@ int main(int argc, char **argv)
     else if (desired_pose_id == desired_pose::LOOK_UP)     go_look_down_2(robot_driver);
     else if (desired_pose_id == desired_pose::CANDLE)      go_navigation_3(robot_driver);
     else return 0;
+#endif
 
     // rotate_joint(robot_driver, 0, 0.1);
     // robot_driver.get_joint_positions(motion.q);
@@ -626,7 +641,16 @@ int main(int argc, char **argv)
 
     //loop rate in Hz
     int rate_hz = 660;
-    dynamics_controller controller(&robot_driver, rate_hz, compensate_gravity);
+
+    // Controller reads the state and sends the commands through the session driver: recording or replaying the robot driver
+#ifdef REPLAY_TRACE
+    replay_mediator session_driver(&robot_driver);
+    if (session_driver.load(argv[1], (argc > 2)? std::atof(argv[2]) : 0.0) != 0) return -1;
+#else
+    recording_mediator session_driver(&robot_driver);
+    if (!trace_file.empty() && session_driver.open(trace_file) != 0) return -1;
+#endif
+    dynamics_controller controller(&session_driver, rate_hz, compensate_gravity);
 
     int initial_result = define_task(&controller);
     if (initial_result != 0) return -1;
@@ -693,5 +717,10 @@ int main(int argc, char **argv)
     if (initial_result != 0) return -1;
     controller.control();
     controller.deinitialize();
+#ifdef REPLAY_TRACE
+    return session_driver.print_report();
+#else
+    session_driver.close();
     return 0;
+#endif
 }
\ No newline at end of file
@@ -32,23 +32,51 @@ model_prediction::model_prediction(const KDL::Chain &robot_chain):
     END_EFF_(NUM_OF_SEGMENTS_ - 1),
     fk_vereshchagin_(robot_chain),
     temp_state_(NUM_OF_JOINTS_, NUM_OF_SEGMENTS_, NUM_OF_FRAMES_, NUM_OF_CONSTRAINTS_),
-    temp_pose_(KDL::Frame::Identity())
+    temp_pose_(KDL::Frame::Identity()),
+    cartesian_prediction_method_(cartesian_prediction_method::UNIT_QUATERNION)
 {
 
 }
 
+model_prediction::model_prediction(const KDL::Chain &robot_chain,
+                                   const std::vector<double> &joint_inertia,
+                                   const std::vector<double> &joint_torque_limits,
+                                   const KDL::Twist &root_acc):
+    model_prediction(robot_chain)
+{
+    /**
+     * Zero unit constraint forces: the solver reduces to the articulated-body
+     * forward dynamics, i.e. applied torques are not modified by the constraints.
+     * Torques are not saturated; the safety monitor checks them separately.
+    */
+    fd_solver_ = std::make_shared<KDL::Solver_Vereshchagin>(robot_chain, joint_inertia, joint_torque_limits, 
+                                                            false, root_acc, NUM_OF_CONSTRAINTS_);
+    zero_unit_constraint_force_ = KDL::Jacobian(NUM_OF_CONSTRAINTS_);
+    zero_unit_constraint_force_.data.setZero();
+    zero_acceleration_energy_   = KDL::JntArray(NUM_OF_CONSTRAINTS_);
+    zero_virtual_force_         = KDL::Wrenches(NUM_OF_SEGMENTS_, KDL::Wrench::Zero());
+    held_torque_                = KDL::JntArray(NUM_OF_JOINTS_);
+}
+
 // Used for checking joint limits
-void model_prediction::integrate_joint_space(const state_specification &current_state,
-                                             std::vector<state_specification> &predicted_states,
-                                             const double dt_sec, const int num_of_steps, 
-                                             const int method, const bool fk_required,
-                                             const bool recompute_acceleration)
+int model_prediction::integrate_joint_space(const state_specification &current_state,
+                                            std::vector<state_specification> &predicted_states,
+                                            const double dt_sec, const int num_of_steps, 
+                                            const int method, const bool fk_required,
+                                            const bool recompute_acceleration)
 {
     assert(("Number of steps higher than the size of provided vector of states", num_of_steps <= predicted_states.size()));  
     assert(NUM_OF_JOINTS_ == predicted_states[0].qd.rows()); 
     assert(NUM_OF_JOINTS_ == current_state.qd.rows());
 
     temp_state_ = current_state;
+    int solver_error = 0;
+
+    if (recompute_acceleration)
+    {
+        assert(("Forward dynamics solver not set up", fd_solver_));
+        held_torque_ = current_state.control_torque;
+    }
 
     // For each step in the future horizon
     for (int i = 0; i < num_of_steps; i++){   
@@ -61,12 +89,27 @@ void model_prediction::integrate_joint_space(const state_specification &current_
         else if (method == integration_method::PREDICTOR_CORRECTOR) predicted_states[i].q.data = temp_state_.q.data + (temp_state_.qd.data - temp_state_.qdd.data * dt_sec / 2.0) * dt_sec; // Trapezoidal method
         else assert(false);
 
-        // TODO (Abstract description):
-        // if(recompute_acceleration){
-        //     predicted_states[i].qdd = evaluate_dynamics(predicted_states[i].q, predicted_states[i].qd)
-        //     // Integrated values overwritten to be current values for the next iteration
-        //     temp_state_.qdd = predicted_states[i].qdd;
-        // }
+        /**
+         * Commanded torques and external forces are held over the horizon,
+         * while the accelerations are re-evaluated at each predicted state
+        */
+        if (recompute_acceleration && fd_solver_)
+        {
+            int fd_solver_result = fd_solver_->CartToJnt(predicted_states[i].q, predicted_states[i].qd, predicted_states[i].qdd,
+                                                         zero_unit_constraint_force_, zero_acceleration_energy_,
+                                                         current_state.external_force, zero_virtual_force_, held_torque_);
+            // Previous accelerations are held; the error is reported once per horizon by the caller
+            if (fd_solver_result != 0)
+            {
+                if (solver_error == 0) solver_error = fd_solver_result;
+                predicted_states[i].qdd = temp_state_.qdd;
+            }
+
+            predicted_states[i].control_torque = held_torque_;
+
+            // Integrated values overwritten to be current values for the next iteration
+            temp_state_.qdd = predicted_states[i].qdd;
+        }
 
         temp_state_.qd = predicted_states[i].qd;
         temp_state_.q = predicted_states[i].q;
@@ -88,6 +131,7 @@ void model_prediction::integrate_joint_space(const state_specification &current_
     // #endif
 
     if (fk_required) compute_FK(predicted_states[0]);
+    return solver_error;
 }
 
 // Vector integration from joint acceleration to joint velocity
@@ -152,6 +196,15 @@ void model_prediction::integrate_cartesian_space(
     assert(NUM_OF_SEGMENTS_ == current_state.frame_velocity.size());
     assert(NUM_OF_SEGMENTS_ == predicted_state.frame_velocity.size()); 
 
+    if (cartesian_prediction_method_ == cartesian_prediction_method::UNIT_QUATERNION)
+    {
+        integrate_quaternion_poses(current_state.frame_pose[END_EFF_], 
+                                   current_state.frame_velocity[END_EFF_],
+                                   dt_sec, &num_of_steps, 1, 
+                                   &predicted_state.frame_pose[END_EFF_]);
+        return;
+    }
+
     temp_pose_ = current_state.frame_pose[END_EFF_];
     KDL::Twist pose_twist = current_state.frame_velocity[END_EFF_] * dt_sec;
     KDL::Twist body_fixed_twist; 
@@ -213,6 +266,64 @@ void model_prediction::integrate_cartesian_space(
     predicted_state.frame_pose[END_EFF_] = temp_pose_;
 }
 
+/*
+    Predicts end-effector poses for all given horizons (number of steps)
+    in a single pass, expecting constant Pose twist as in integrate_cartesian_space.
+*/
+void model_prediction::predict_cartesian_poses(const state_specification &current_state,
+                                               const double dt_sec,
+                                               const std::vector<int> &horizon_steps,
+                                               std::vector<KDL::Frame> &predicted_poses)
+{
+    assert(("Number of horizons higher than the size of provided vector of poses", horizon_steps.size() <= predicted_poses.size()));
+    assert(NUM_OF_SEGMENTS_ == current_state.frame_velocity.size());
+    if (horizon_steps.empty()) return;
+
+    integrate_quaternion_poses(current_state.frame_pose[END_EFF_],
+                               current_state.frame_velocity[END_EFF_],
+                               dt_sec, horizon_steps.data(), horizon_steps.size(),
+                               predicted_poses.data());
+}
+
+void model_prediction::set_cartesian_prediction_method(const int method)
+{
+    assert(method == cartesian_prediction_method::EXPONENTIAL_MAP || method == cartesian_prediction_method::UNIT_QUATERNION);
+    cartesian_prediction_method_ = method;
+}
+
+/**
+ * Integrates pose under a constant base-frame twist, in unit quaternions:
+ * p_k = p_0 + k * dt * v and q_k = exp(k * dt * w) * q_0.
+ * Equivalent to the step-wise exponential map integration, but without 
+ * per-step matrix products and the SVD-based re-orthonormalization.
+*/
+void model_prediction::integrate_quaternion_poses(const KDL::Frame &current_pose,
+                                                  const KDL::Twist &twist,
+                                                  const double dt_sec,
+                                                  const int *horizon_steps,
+                                                  const int num_of_horizons,
+                                                  KDL::Frame *predicted_poses)
+{
+    double x, y, z, w;
+    current_pose.M.GetQuaternion(x, y, z, w);
+    const Eigen::Quaterniond current_orientation(w, x, y, z);
+    const Eigen::Vector3d angular_velocity(twist.rot(0), twist.rot(1), twist.rot(2));
+    Eigen::Quaterniond predicted_orientation;
+
+    for (int i = 0; i < num_of_horizons; i++)
+    {
+        assert(horizon_steps[i] >= 0);
+
+        const double horizon_sec = horizon_steps[i] * dt_sec;
+        predicted_orientation = geometry::exp_map_quaternion(angular_velocity * horizon_sec) * current_orientation;
+        geometry::renormalize_quaternion(predicted_orientation);
+
+        predicted_poses[i].M = KDL::Rotation::Quaternion(predicted_orientation.x(), predicted_orientation.y(),
+                                                         predicted_orientation.z(), predicted_orientation.w());
+        predicted_poses[i].p = current_pose.p + twist.vel * horizon_sec;
+    }
+}
+
 /**
  * Calculates Exponential map for both translation and rotation
  * Input: 
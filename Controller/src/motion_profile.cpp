@@ -27,45 +27,57 @@ SOFTWARE.
 
 namespace motion_profile
 {
-    std::deque<double> ramp_array(const double start_state, const double end_state,
-                                  const double step, const double threshold)
+    double ramp_function(const double state,
+                         const double start_value,
+                         const double end_value,
+                         const double rate)
     {
-        std::deque<double> setpoint_array;
-        double setpoint = start_state + step;
-
-        while ((step > 0.0)? setpoint < end_state : setpoint > end_state)
-        {
-            if (std::fabs(setpoint) < std::fabs(threshold)) break;
-
-            setpoint_array.push_back(setpoint);
-            setpoint = setpoint_array.back() + step;
-        }
-
-        setpoint_array.push_back(end_state);
-        return setpoint_array;
+        // Linear transition from start to end value, saturated at the end value
+        double value = start_value + ((end_value >= start_value)? 1.0 : -1.0) * std::fabs(rate) * std::max(state, 0.0);
+        if (end_value >= start_value) return std::min(value, end_value);
+        else return std::max(value, end_value);
     }
 
-    std::deque<double> s_curve_array(const double start_state, const double end_state,
-                                     const double step,
-                                     const double offset,
-                                     const double amplitude,
-                                     const double slope)
+    double jerk_limited_trapezoid_function(const double time,
+                                           const double path_length,
+                                           const double max_velocity,
+                                           const double max_acceleration,
+                                           const double max_jerk)
     {
-        std::deque<double> setpoint_array;
-        double state = start_state;
-        double alpha = 0.9;
-        setpoint_array.push_back(offset + amplitude * std::sin(slope * state));
+        assert(max_velocity > 0.0 && max_acceleration > 0.0 && max_jerk > 0.0);
+        if (time <= 0.0 || path_length <= 0.0) return 0.0;
 
-        while (std::fabs(step) > 0.0 && std::fabs(state + step) < std::fabs(end_state))
-        {
-            state += step;
+        // Distance needed for reaching the velocity, starting from rest
+        const double a_jerk = max_acceleration * max_acceleration / max_jerk;
+        double peak_velocity = max_velocity;
+        double ramp_distance = (peak_velocity >= a_jerk)? 0.5 * peak_velocity * (peak_velocity / max_acceleration + max_acceleration / max_jerk) :
+                                                          peak_velocity * std::sqrt(peak_velocity / max_jerk);
 
-            // First order low-pass filter
-            setpoint_array.push_back(alpha * setpoint_array.back() + (1.0 - alpha) * (offset + amplitude * std::sin(slope * state)));
+        // Path too short for reaching the max velocity: solve for the peak velocity such that ramps cover half of the path each
+        if (2.0 * ramp_distance > path_length)
+        {
+            peak_velocity = 0.5 * (-a_jerk + std::sqrt(a_jerk * a_jerk + 4.0 * max_acceleration * path_length));
+            if (peak_velocity < a_jerk) peak_velocity = std::pow(0.5 * path_length * std::sqrt(max_jerk), 2.0 / 3.0);
+            ramp_distance = 0.5 * path_length;
         }
 
-        setpoint_array.push_back(alpha * setpoint_array.back() + (1.0 - alpha) * (offset + amplitude * std::sin(slope * end_state)));
-        return setpoint_array;
+        // Duration of the jerk phase and of the complete acceleration ramp
+        const double t_jerk       = (peak_velocity >= a_jerk)? max_acceleration / max_jerk : std::sqrt(peak_velocity / max_jerk);
+        const double peak_acc     = max_jerk * t_jerk;
+        const double t_ramp       = (peak_velocity >= a_jerk)? peak_velocity / max_acceleration + t_jerk : 2.0 * t_jerk;
+        const double t_cruise     = (path_length - 2.0 * ramp_distance) / peak_velocity;
+        const double t_total      = 2.0 * t_ramp + t_cruise;
+
+        if (time >= t_total) return 0.0;
+
+        // Deceleration is the time-mirrored acceleration ramp
+        double t = time;
+        if (t >= t_ramp + t_cruise) t = t_total - t;
+        else if (t >= t_ramp) return peak_velocity;
+
+        if      (t < t_jerk)          return 0.5 * max_jerk * t * t;
+        else if (t < t_ramp - t_jerk) return 0.5 * peak_acc * t_jerk + peak_acc * (t - t_jerk);
+        else                          return peak_velocity - 0.5 * max_jerk * (t_ramp - t) * (t_ramp - t);
     }
 
     double tanh_function(const double state,
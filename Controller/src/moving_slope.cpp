@@ -22,15 +22,13 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
-
 #include <moving_slope.hpp>
 
 // Constructor without the predefined set/s of parameters
 moving_slope::moving_slope(const int window_size, const int num_dimensions):
-    WINDOW_SIZE_(window_size), DIMENSIONS_(num_dimensions),
+    DIMENSIONS_(num_dimensions), WINDOW_SIZE_(window_size),
     slopes_(Eigen::VectorXd::Zero(num_dimensions)),
-    indexes_(num_dimensions, 0),
-    windows_(num_dimensions, std::list<double>())
+    window_(window_size, num_dimensions)
 {
     assert(("Moving Slope algorithm not initialized properly", DIMENSIONS_ > 0));
     clear();
@@ -41,8 +39,12 @@ Eigen::VectorXd moving_slope::update(const Eigen::VectorXd &state)
     assert(DIMENSIONS_ == state.rows());
 
     for (int i = 0; i < DIMENSIONS_; i++)
-        update(i, state(i));
+    {
+        if (window_.is_full(i)) slopes_(i) = (state(i) - window_.get_oldest(i)) / static_cast<float>(WINDOW_SIZE_);
+        else                    slopes_(i) = 0.002; // Initial window elements
+    }
 
+    window_.update(state);
     return slopes_;
 }
 
@@ -51,26 +53,19 @@ double moving_slope::update(const int dimension, const double state)
     assert(dimension >= 0);
     assert(dimension < DIMENSIONS_);
 
-    windows_[dimension].push_back(state);
-
-    if (indexes_[dimension] < WINDOW_SIZE_)
-    { // Calculating slope for the initial window elements
-        indexes_[dimension]++;
-        slopes_(dimension) = 0.002;
-    }
-    else
-    { // Calculating slope for all other window elements
-        double removed_state = windows_[dimension].front(); windows_[dimension].pop_front();
-        slopes_(dimension)   = (state - removed_state) / static_cast<float>(WINDOW_SIZE_);
-    }
+    // Calculating slope for the initial window elements
+    if (!window_.is_full(dimension)) slopes_(dimension) = 0.002;
+    // Calculating slope for all other window elements
+    else slopes_(dimension) = (state - window_.get_oldest(dimension)) / static_cast<float>(WINDOW_SIZE_);
 
+    window_.update(dimension, state);
     return slopes_(dimension);
 }
 
 void moving_slope::clear()
 {
-    for (int i = 0; i < DIMENSIONS_; i++)
-        clear(i);
+    slopes_.setZero();
+    window_.clear();
 }
 
 void moving_slope::clear(const int dimension)
@@ -78,9 +73,8 @@ void moving_slope::clear(const int dimension)
     assert(dimension >= 0);
     assert(dimension < DIMENSIONS_);
 
-    slopes_(dimension)  = 0.0;
-    indexes_[dimension] = 0;
-    windows_[dimension].clear();
+    slopes_(dimension) = 0.0;
+    window_.clear(dimension);
 }
 
 Eigen::VectorXd moving_slope::get_slope()
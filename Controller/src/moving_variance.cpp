@@ -22,16 +22,12 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
-
 #include <moving_variance.hpp>
 
 // Constructor without the predefined set/s of parameters
 moving_variance::moving_variance(const int window_size, const int num_dimensions):
-    WINDOW_SIZE_(window_size), DIMENSIONS_(num_dimensions),
-    indexes_(num_dimensions, 0),
-    means_(Eigen::VectorXd::Zero(num_dimensions)),
-    variances_(Eigen::VectorXd::Zero(num_dimensions)),
-    windows_(num_dimensions, std::list<double>())
+    DIMENSIONS_(num_dimensions), WINDOW_SIZE_(window_size),
+    window_(window_size, num_dimensions)
 {
     assert(("Moving Variance algorithm not initialized properly", DIMENSIONS_ > 0));
     clear();
@@ -40,84 +36,42 @@ moving_variance::moving_variance(const int window_size, const int num_dimensions
 Eigen::VectorXd moving_variance::update(const Eigen::VectorXd &state)
 {   
     assert(DIMENSIONS_ == state.rows());
-    Eigen::VectorXd variance(DIMENSIONS_);
-
-    for (int i = 0; i < DIMENSIONS_; i++)
-        variance(i) = update(i, state(i));
-
-    return variance;
+    window_.update(state);
+    return window_.get_variance();
 }
 
 double moving_variance::update(const int dimension, const double state)
 {
-    assert(dimension >= 0);
-    assert(dimension < DIMENSIONS_);
-
-    windows_[dimension].push_back(state);
-
-    if (indexes_[dimension] < WINDOW_SIZE_)
-    { // Calculating variance for the initial window elements
-        indexes_[dimension]++;
-        double delta           = state - means_(dimension);
-        means_(dimension)     += delta / static_cast<float>(indexes_[dimension]);
-        variances_(dimension) += delta * (state - means_(dimension));
-    }
-    else
-    { // Calculating variance for all other window elements
-        double removed_state   = windows_[dimension].front(); windows_[dimension].pop_front();
-        double old_mean        = means_(dimension);
-        means_(dimension)     += (state - removed_state) / static_cast<float>(WINDOW_SIZE_);
-        variances_(dimension) += (state + removed_state - old_mean - means_(dimension)) * (state - removed_state);
-    }
-
-    // Normalize the value
-    return variances_(dimension) / static_cast<float>(windows_[dimension].size());
+    window_.update(dimension, state);
+    return window_.get_variance(dimension);
 }
 
 void moving_variance::clear()
 {
-    for (int i = 0; i < DIMENSIONS_; i++)
-        clear(i);
+    window_.clear();
 }
 
 void moving_variance::clear(const int dimension)
 {
-    assert(dimension >= 0);
-    assert(dimension < DIMENSIONS_);
-
-    means_(dimension)     = 0.0;
-    indexes_[dimension]   = 0;
-    variances_(dimension) = 0.0;
-    windows_[dimension].clear();
+    window_.clear(dimension);
 }
 
 Eigen::VectorXd moving_variance::get_variance()
 {
-    Eigen::VectorXd variance(DIMENSIONS_);
-    for (int i = 0; i < DIMENSIONS_; i++)
-        variance(i) = get_variance(i);
-    return variance;
+    return window_.get_variance();
 }
 
 double moving_variance::get_variance(const int dimension)
 {
-    assert(dimension >= 0);
-    assert(dimension < DIMENSIONS_);
-
-    // Normalize the value
-    if (windows_[dimension].size() == 0) return 0.0;
-    return variances_(dimension) / static_cast<float>(windows_[dimension].size());
+    return window_.get_variance(dimension);
 }
 
 Eigen::VectorXd moving_variance::get_mean()
 {
-    return means_;
+    return window_.get_mean();
 }
 
 double moving_variance::get_mean(const int dimension)
 {
-    assert(dimension >= 0);
-    assert(dimension < DIMENSIONS_);
-
-    return means_(dimension);
+    return window_.get_mean(dimension);
 }
\ No newline at end of file
@@ -0,0 +1,477 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <parameter_store.hpp>
+#include <constants.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <sys/stat.h>
+
+namespace
+{
+    const char *MODE_SUFFIX[NUMBER_OF_PARAMETER_MODES] = {"", ".approach", ".contact"};
+
+    bool is_open_unit_interval(const Eigen::VectorXd &values)
+    {
+        for (int i = 0; i < values.size(); i++)
+            if (!(values(i) > 0.0 && values(i) < 1.0)) return false;
+        return true;
+    }
+
+    bool is_finite(const Eigen::VectorXd &values)
+    {
+        for (int i = 0; i < values.size(); i++)
+            if (!std::isfinite(values(i))) return false;
+        return true;
+    }
+
+    std::string trim(const std::string &text)
+    {
+        const size_t first = text.find_first_not_of(" \t\r");
+        if (first == std::string::npos) return "";
+        const size_t last = text.find_last_not_of(" \t\r");
+        return text.substr(first, last - first + 1);
+    }
+}
+
+parameter_store::parameter_store(const int num_of_constraints, const int num_of_joints):
+    NUM_OF_CONSTRAINTS_(num_of_constraints), NUM_OF_JOINTS_(num_of_joints),
+    pending_(nullptr), active_(nullptr), retired_(RETIRED_CAPACITY_), stop_watcher_(false)
+{
+    watched_modification_time_.tv_sec  = 0;
+    watched_modification_time_.tv_nsec = 0;
+}
+
+parameter_store::~parameter_store()
+{
+    stop_watching();
+
+    delete pending_.exchange(nullptr);
+    delete active_;
+    while (parameter_bundle **retired = retired_.front())
+    {
+        delete *retired;
+        retired_.pop();
+    }
+}
+
+// Validate a single set against the dimensions of the controller and the ranges accepted by the ABAG
+int parameter_store::validate(const controller_parameters &parameters) const
+{
+    const char *name = parameters.name.c_str();
+    const Eigen::VectorXd *constraint_vectors[8] = {&parameters.max_command, &parameters.error_alpha,
+                                                    &parameters.bias_threshold, &parameters.bias_step,
+                                                    &parameters.gain_threshold, &parameters.gain_step,
+                                                    &parameters.min_bias_sat, &parameters.min_command_sat};
+    const Eigen::VectorXd *joint_vectors[6] = {&parameters.stop_motion_error_alpha, &parameters.stop_motion_bias_threshold,
+                                               &parameters.stop_motion_bias_step, &parameters.stop_motion_gain_threshold,
+                                               &parameters.stop_motion_gain_step, &parameters.wrench_estimation_gain};
+
+    for (int i = 0; i < 8; i++)
+    {
+        if (constraint_vectors[i]->size() != NUM_OF_CONSTRAINTS_ || !is_finite(*constraint_vectors[i]))
+        {
+            printf("Parameter set %s: ABAG vectors must contain %d finite values\n", name, NUM_OF_CONSTRAINTS_);
+            return -1;
+        }
+    }
+
+    for (int i = 0; i < 6; i++)
+    {
+        if (joint_vectors[i]->size() != NUM_OF_JOINTS_ || !is_finite(*joint_vectors[i]))
+        {
+            printf("Parameter set %s: stop-motion and wrench estimation vectors must contain %d finite values\n", name, NUM_OF_JOINTS_);
+            return -1;
+        }
+    }
+
+    if (parameters.null_space_parameters.size() != NUM_OF_CONSTRAINTS_ || parameters.compensation_parameters.size() != 2 * NUM_OF_CONSTRAINTS_ ||
+        !is_finite(parameters.null_space_parameters) || !is_finite(parameters.compensation_parameters))
+    {
+        printf("Parameter set %s: null-space and compensation vectors must contain %d and %d finite values\n", name, NUM_OF_CONSTRAINTS_, 2 * NUM_OF_CONSTRAINTS_);
+        return -1;
+    }
+
+    if (!std::isfinite(parameters.horizon_amplitude) || parameters.horizon_amplitude <= 0.0)
+    {
+        printf("Parameter set %s: horizon amplitude must be positive\n", name);
+        return -1;
+    }
+
+    if (!is_open_unit_interval(parameters.error_alpha)    || !is_open_unit_interval(parameters.bias_threshold) || 
+        !is_open_unit_interval(parameters.bias_step)      || !is_open_unit_interval(parameters.gain_threshold) || 
+        !is_open_unit_interval(parameters.gain_step)      || !is_open_unit_interval(parameters.null_space_parameters.head(5)) ||
+        !is_open_unit_interval(parameters.stop_motion_error_alpha)    || !is_open_unit_interval(parameters.stop_motion_bias_threshold) ||
+        !is_open_unit_interval(parameters.stop_motion_bias_step)      || !is_open_unit_interval(parameters.stop_motion_gain_threshold) ||
+        !is_open_unit_interval(parameters.stop_motion_gain_step))
+    {
+        printf("Parameter set %s: ABAG filter, thresholds and steps must lie in (0, 1)\n", name);
+        return -1;
+    }
+
+    if (parameters.max_command.minCoeff() < 0.0 || parameters.null_space_parameters(5) < 0.0 || parameters.wrench_estimation_gain.minCoeff() < 0.0)
+    {
+        printf("Parameter set %s: command limits and estimation gains must not be negative\n", name);
+        return -1;
+    }
+
+    if (parameters.min_bias_sat.minCoeff()    < -1.0 || parameters.min_bias_sat.maxCoeff()    > 0.0 ||
+        parameters.min_command_sat.minCoeff() < -1.0 || parameters.min_command_sat.maxCoeff() > 0.0)
+    {
+        printf("Parameter set %s: lower saturation limits must lie in [-1, 0]\n", name);
+        return -1;
+    }
+
+    return 0;
+}
+
+int parameter_store::validate_bundle(const parameter_bundle &bundle) const
+{
+    for (int i = 0; i < NUMBER_OF_PARAMETER_MODES; i++)
+        if (validate(bundle.mode[i]) != 0) return -1;
+    return 0;
+}
+
+/**
+ * Default FSM variants of the nominal set. While approaching the surface, the linear Z axis is
+ * velocity-controlled with the generic ABAG tuning; once in contact, it is force-controlled with
+ * the nominal tuning and a bias saturation equal to the command saturation.
+ */
+void parameter_store::derive_modes(parameter_bundle &bundle) const
+{
+    const controller_parameters &nominal = bundle.mode[NOMINAL_PARAMETERS];
+
+    controller_parameters &approach = bundle.mode[APPROACH_PARAMETERS];
+    approach      = nominal;
+    approach.name = nominal.name + MODE_SUFFIX[APPROACH_PARAMETERS];
+    approach.error_alpha(2)    = abag_parameter::ERROR_ALPHA(2);
+    approach.bias_threshold(2) = abag_parameter::BIAS_THRESHOLD(2);
+    approach.bias_step(2)      = abag_parameter::BIAS_STEP(2);
+    approach.gain_threshold(2) = abag_parameter::GAIN_THRESHOLD(2);
+    approach.gain_step(2)      = abag_parameter::GAIN_STEP(2);
+    approach.min_bias_sat      = Eigen::VectorXd::Constant(NUM_OF_CONSTRAINTS_, -1.0);
+    approach.min_command_sat   = Eigen::VectorXd::Constant(NUM_OF_CONSTRAINTS_, -1.0);
+    approach.max_command(2)    = abag_parameter::APPROACH_MAX_COMMAND;
+
+    controller_parameters &contact = bundle.mode[CONTACT_PARAMETERS];
+    contact              = nominal;
+    contact.name         = nominal.name + MODE_SUFFIX[CONTACT_PARAMETERS];
+    contact.min_bias_sat = nominal.min_command_sat;
+}
+
+int parameter_store::assign(controller_parameters &parameters, const std::string &key, const std::vector<double> &values)
+{
+    if (key == "horizon_amplitude")
+    {
+        if (values.size() != 1) return -1;
+        parameters.horizon_amplitude = values[0];
+        return 0;
+    }
+
+    Eigen::VectorXd *target = nullptr;
+    if      (key == "max_command")                target = &parameters.max_command;
+    else if (key == "error_alpha")                target = &parameters.error_alpha;
+    else if (key == "bias_threshold")             target = &parameters.bias_threshold;
+    else if (key == "bias_step")                  target = &parameters.bias_step;
+    else if (key == "gain_threshold")             target = &parameters.gain_threshold;
+    else if (key == "gain_step")                  target = &parameters.gain_step;
+    else if (key == "min_bias_sat")               target = &parameters.min_bias_sat;
+    else if (key == "min_command_sat")            target = &parameters.min_command_sat;
+    else if (key == "null_space_parameters")      target = &parameters.null_space_parameters;
+    else if (key == "compensation_parameters")    target = &parameters.compensation_parameters;
+    else if (key == "stop_motion_error_alpha")    target = &parameters.stop_motion_error_alpha;
+    else if (key == "stop_motion_bias_threshold") target = &parameters.stop_motion_bias_threshold;
+    else if (key == "stop_motion_bias_step")      target = &parameters.stop_motion_bias_step;
+    else if (key == "stop_motion_gain_threshold") target = &parameters.stop_motion_gain_threshold;
+    else if (key == "stop_motion_gain_step")      target = &parameters.stop_motion_gain_step;
+    else if (key == "wrench_estimation_gain")     target = &parameters.wrench_estimation_gain;
+    else return -1;
+
+    *target = Eigen::Map<const Eigen::VectorXd>(values.data(), values.size());
+    return 0;
+}
+
+void parameter_store::write(std::ostream &stream, const controller_parameters &parameters)
+{
+    const std::pair<const char*, const Eigen::VectorXd*> vectors[16] = {
+        {"max_command",                &parameters.max_command},
+        {"error_alpha",                &parameters.error_alpha},
+        {"bias_threshold",             &parameters.bias_threshold},
+        {"bias_step",                  &parameters.bias_step},
+        {"gain_threshold",             &parameters.gain_threshold},
+        {"gain_step",                  &parameters.gain_step},
+        {"min_bias_sat",               &parameters.min_bias_sat},
+        {"min_command_sat",            &parameters.min_command_sat},
+        {"null_space_parameters",      &parameters.null_space_parameters},
+        {"compensation_parameters",    &parameters.compensation_parameters},
+        {"stop_motion_error_alpha",    &parameters.stop_motion_error_alpha},
+        {"stop_motion_bias_threshold", &parameters.stop_motion_bias_threshold},
+        {"stop_motion_bias_step",      &parameters.stop_motion_bias_step},
+        {"stop_motion_gain_threshold", &parameters.stop_motion_gain_threshold},
+        {"stop_motion_gain_step",      &parameters.stop_motion_gain_step},
+        {"wrench_estimation_gain",     &parameters.wrench_estimation_gain}};
+
+    char line[64];
+    stream << "[" << parameters.name << "]\n";
+    snprintf(line, sizeof(line), "%-26s = %g\n", "horizon_amplitude", parameters.horizon_amplitude);
+    stream << line;
+
+    for (const auto &vector : vectors)
+    {
+        snprintf(line, sizeof(line), "%-26s =", vector.first);
+        stream << line;
+        for (int i = 0; i < vector.second->size(); i++)
+        {
+            snprintf(line, sizeof(line), "%s %g", (i == 0)? "" : ",", (*vector.second)(i));
+            stream << line;
+        }
+        stream << "\n";
+    }
+}
+
+int parameter_store::parse_file(const std::string &file_path, const std::string &set_name, parameter_bundle &bundle) const
+{
+    std::ifstream file(file_path);
+    if (!file.is_open())
+    {
+        printf("Unable to open parameter file: %s\n", file_path.c_str());
+        return -1;
+    }
+
+    // Collect the lines of the requested sections first: the mode sections may precede the nominal one
+    std::vector< std::pair<std::string, std::vector<double> > > entries[NUMBER_OF_PARAMETER_MODES];
+    bool section_found[NUMBER_OF_PARAMETER_MODES] = {false, false, false};
+    int section = -1, line_number = 0;
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        line_number++;
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        line = trim(line);
+        if (line.empty()) continue;
+
+        if (line.front() == '[' && line.back() == ']')
+        {
+            const std::string section_name = trim(line.substr(1, line.size() - 2));
+            section = -1;
+            for (int i = 0; i < NUMBER_OF_PARAMETER_MODES; i++)
+            {
+                if (section_name == set_name + MODE_SUFFIX[i])
+                {
+                    section = i;
+                    section_found[i] = true;
+                }
+            }
+            continue;
+        }
+
+        if (section == -1) continue;
+
+        const size_t separator = line.find('=');
+        if (separator == std::string::npos)
+        {
+            printf("Parameter file %s, line %d: expected \"key = values\"\n", file_path.c_str(), line_number);
+            return -1;
+        }
+
+        std::string value_text = line.substr(separator + 1);
+        for (char &character : value_text) if (character == ',') character = ' ';
+
+        std::vector<double> values;
+        std::istringstream value_stream(value_text);
+        std::string token;
+        while (value_stream >> token)
+        {
+            char *end = nullptr;
+            values.push_back(std::strtod(token.c_str(), &end));
+            if (*end != '\0')
+            {
+                printf("Parameter file %s, line %d: invalid number %s\n", file_path.c_str(), line_number, token.c_str());
+                return -1;
+            }
+        }
+
+        entries[section].push_back(std::make_pair(trim(line.substr(0, separator)), values));
+    }
+
+    if (!section_found[NOMINAL_PARAMETERS])
+    {
+        printf("Parameter set %s not found in: %s\n", set_name.c_str(), file_path.c_str());
+        return -1;
+    }
+
+    // Unset values are caught by the validation
+    controller_parameters &nominal = bundle.mode[NOMINAL_PARAMETERS];
+    nominal = controller_parameters();
+    nominal.name = set_name;
+    nominal.horizon_amplitude = std::nan("");
+
+    for (int mode = 0; mode < NUMBER_OF_PARAMETER_MODES; mode++)
+    {
+        if (mode == APPROACH_PARAMETERS)
+        {
+            if (validate(nominal) != 0) return -1;
+            derive_modes(bundle);
+        }
+
+        for (const auto &entry : entries[mode])
+        {
+            if (assign(bundle.mode[mode], entry.first, entry.second) != 0)
+            {
+                printf("Parameter set %s%s: invalid key or value count for %s\n", set_name.c_str(), MODE_SUFFIX[mode], entry.first.c_str());
+                return -1;
+            }
+        }
+    }
+
+    return validate_bundle(bundle);
+}
+
+int parameter_store::publish_bundle(parameter_bundle *bundle)
+{
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+
+    // Free the bundles the control loop has replaced in the meantime
+    while (parameter_bundle **retired = retired_.front())
+    {
+        delete *retired;
+        retired_.pop();
+    }
+
+    // A bundle still pending was never seen by the control loop
+    delete pending_.exchange(bundle, std::memory_order_acq_rel);
+    return 0;
+}
+
+int parameter_store::publish(const controller_parameters &nominal)
+{
+    parameter_bundle *bundle = new parameter_bundle();
+    bundle->mode[NOMINAL_PARAMETERS] = nominal;
+
+    if (validate(nominal) != 0)
+    {
+        delete bundle;
+        return -1;
+    }
+
+    derive_modes(*bundle);
+    if (validate_bundle(*bundle) != 0)
+    {
+        delete bundle;
+        return -1;
+    }
+
+    return publish_bundle(bundle);
+}
+
+int parameter_store::load(const std::string &file_path, const std::string &set_name)
+{
+    parameter_bundle *bundle = new parameter_bundle();
+    if (parse_file(file_path, set_name, *bundle) != 0)
+    {
+        delete bundle;
+        return -1;
+    }
+
+    return publish_bundle(bundle);
+}
+
+int parameter_store::watch(const std::string &file_path, const std::string &set_name)
+{
+    struct stat file_status;
+    if (stat(file_path.c_str(), &file_status) != 0)
+    {
+        printf("Unable to access parameter file: %s\n", file_path.c_str());
+        return -1;
+    }
+
+    if (load(file_path, set_name) != 0) return -1;
+
+    {
+        std::lock_guard<std::mutex> lock(watcher_mutex_);
+        watched_file_              = file_path;
+        watched_set_               = set_name;
+        watched_modification_time_ = file_status.st_mtim;
+        stop_watcher_              = false;
+    }
+
+    if (!watcher_.joinable()) watcher_ = std::thread(&parameter_store::watch_file, this);
+    return 0;
+}
+
+void parameter_store::stop_watching()
+{
+    {
+        std::lock_guard<std::mutex> lock(watcher_mutex_);
+        stop_watcher_ = true;
+    }
+    watcher_condition_.notify_all();
+    if (watcher_.joinable()) watcher_.join();
+}
+
+// Background thread: re-load the watched set whenever its file is modified. Invalid edits are reported and ignored
+void parameter_store::watch_file()
+{
+    std::unique_lock<std::mutex> lock(watcher_mutex_);
+    while (!watcher_condition_.wait_for(lock, std::chrono::milliseconds(dynamics_parameter::PARAMETER_FILE_POLL_PERIOD_MS),
+                                        [this]{ return stop_watcher_; }))
+    {
+        struct stat file_status;
+        if (stat(watched_file_.c_str(), &file_status) != 0) continue;
+        if (file_status.st_mtim.tv_sec  == watched_modification_time_.tv_sec &&
+            file_status.st_mtim.tv_nsec == watched_modification_time_.tv_nsec) continue;
+
+        watched_modification_time_ = file_status.st_mtim;
+        if (load(watched_file_, watched_set_) == 0) printf("Parameter set %s re-loaded\n", watched_set_.c_str());
+        else printf("Keeping the previous parameters of set %s\n", watched_set_.c_str());
+    }
+}
+
+// Control loop, at the cycle boundary: swap in the latest bundle and hand the replaced one back for deletion
+const parameter_bundle *parameter_store::acquire()
+{
+    parameter_bundle *bundle = pending_.exchange(nullptr, std::memory_order_acq_rel);
+    if (bundle == nullptr) return nullptr;
+
+    if (active_ != nullptr)
+    {
+        const bool retired = retired_.push(active_);
+        assert(("Retired parameter queue overflow", retired));
+        (void)retired;
+    }
+    active_ = bundle;
+    return active_;
+}
+
+const parameter_bundle *parameter_store::get_active() const
+{
+    return active_;
+}
@@ -0,0 +1,318 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <path_loader.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+const char path_loader::MAGIC_[8] = {'T', 'U', 'B', 'E', 'P', 'A', 'T', 'H'};
+
+path_loader::path_loader():
+    file_descriptor_(-1), format_(path_file_format::CSV_PATH), num_of_points_(0),
+    data_(nullptr), size_(0), page_size_(sysconf(_SC_PAGESIZE)), advised_end_(0),
+    csv_offset_(0), csv_point_index_(0)
+{
+}
+
+path_loader::~path_loader()
+{
+    close();
+}
+
+int path_loader::open(const std::string &file_path)
+{
+    close();
+
+    file_descriptor_ = ::open(file_path.c_str(), O_RDONLY);
+    if (file_descriptor_ < 0)
+    {
+        printf("Unable to open path file: %s\n", file_path.c_str());
+        return -1;
+    }
+
+    struct stat file_status;
+    if (fstat(file_descriptor_, &file_status) != 0 || file_status.st_size == 0)
+    {
+        printf("Path file is empty: %s\n", file_path.c_str());
+        close();
+        return -1;
+    }
+
+    size_ = file_status.st_size;
+    void *mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file_descriptor_, 0);
+    if (mapping == MAP_FAILED)
+    {
+        printf("Unable to map path file: %s\n", file_path.c_str());
+        data_ = nullptr;
+        close();
+        return -1;
+    }
+
+    data_ = static_cast<const char*>(mapping);
+
+    // Points are consumed front to back: let the kernel read ahead and drop used pages
+    madvise(mapping, size_, MADV_SEQUENTIAL);
+
+    int result = 0;
+    if (size_ >= sizeof(MAGIC_) && std::memcmp(data_, MAGIC_, sizeof(MAGIC_)) == 0) result = open_binary();
+    else result = open_csv();
+
+    if (result != 0 || (num_of_points_ >= 0 && num_of_points_ < 2))
+    {
+        printf("Path file must contain at least two valid points: %s\n", file_path.c_str());
+        close();
+        return -1;
+    }
+
+    advise_read_ahead((format_ == path_file_format::BINARY_PATH)? HEADER_SIZE_ : 0);
+    return 0;
+}
+
+void path_loader::close()
+{
+    if (data_ != nullptr) munmap(const_cast<char*>(data_), size_);
+    if (file_descriptor_ >= 0) ::close(file_descriptor_);
+
+    file_descriptor_ = -1;
+    data_            = nullptr;
+    size_            = 0;
+    num_of_points_   = 0;
+    advised_end_     = 0;
+    csv_offset_      = 0;
+    csv_point_index_ = 0;
+}
+
+bool path_loader::is_open() const
+{
+    return data_ != nullptr;
+}
+
+int path_loader::get_format() const
+{
+    return format_;
+}
+
+int path_loader::get_number_of_points() const
+{
+    return num_of_points_;
+}
+
+int path_loader::open_binary()
+{
+    format_ = path_file_format::BINARY_PATH;
+    if (size_ < (unsigned)HEADER_SIZE_) return -1;
+
+    uint32_t version = 0, dimensions = 0;
+    uint64_t num_of_points = 0;
+    std::memcpy(&version,       data_ + 8,  sizeof(version));
+    std::memcpy(&dimensions,    data_ + 12, sizeof(dimensions));
+    std::memcpy(&num_of_points, data_ + 16, sizeof(num_of_points));
+
+    if (version != VERSION_ || dimensions != DIMENSIONS_)
+    {
+        printf("Unsupported binary path version or dimension\n");
+        return -1;
+    }
+
+    if (size_ != HEADER_SIZE_ + num_of_points * DIMENSIONS_ * sizeof(double))
+    {
+        printf("Binary path file size does not match its header\n");
+        return -1;
+    }
+
+    num_of_points_ = static_cast<int>(num_of_points);
+    return 0;
+}
+
+/**
+ * Only checks that the file starts with a path, i.e. holds at least two point lines.
+ * The rest is not touched: the points are counted by the chunk reads, as the cursor passes them.
+ */
+int path_loader::open_csv()
+{
+    format_ = path_file_format::CSV_PATH;
+
+    int num_of_points = 0;
+    size_t line_start = 0;
+    for (; line_start < size_ && num_of_points < 2; line_start = next_line(line_start))
+        if (is_point_line(line_start)) num_of_points++;
+
+    // Short file: the count is already known
+    num_of_points_   = (line_start < size_)? -1 : num_of_points;
+    csv_offset_      = 0;
+    csv_point_index_ = 0;
+    return (num_of_points < 2)? -1 : 0;
+}
+
+bool path_loader::is_point_line(const size_t line_start) const
+{
+    size_t i = line_start;
+    while (i < size_ && (data_[i] == ' ' || data_[i] == '\t')) i++;
+    if (i == size_) return false;
+
+    const char c = data_[i];
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.';
+}
+
+size_t path_loader::next_line(const size_t line_start) const
+{
+    const void *line_end = std::memchr(data_ + line_start, '\n', size_ - line_start);
+    if (line_end == nullptr) return size_;
+    return static_cast<const char*>(line_end) - data_ + 1;
+}
+
+int path_loader::parse_csv_line(const size_t line_start, std::vector<double> &point) const
+{
+    char line[MAX_LINE_LENGTH_];
+    size_t length = 0;
+    while (line_start + length < size_ && data_[line_start + length] != '\n' && length < MAX_LINE_LENGTH_ - 1)
+    {
+        line[length] = data_[line_start + length];
+        length++;
+    }
+    line[length] = '\0';
+
+    char *cursor = line;
+    for (unsigned k = 0; k < DIMENSIONS_; k++)
+    {
+        while (*cursor == ',' || *cursor == ';' || *cursor == ' ' || *cursor == '\t') cursor++;
+
+        char *number_end = cursor;
+        point[k] = std::strtod(cursor, &number_end);
+        if (number_end == cursor) return -1;
+        cursor = number_end;
+    }
+
+    return 0;
+}
+
+int path_loader::read_points(const int first_point, const int num_of_points,
+                             std::vector< std::vector<double> > &points)
+{
+    assert(is_open());
+    assert(first_point >= 0);
+    assert(points.size() >= (unsigned)num_of_points);
+
+    const int count = (num_of_points_ < 0)? num_of_points : std::max(0, std::min(num_of_points, num_of_points_ - first_point));
+
+    if (format_ == path_file_format::BINARY_PATH)
+    {
+        const char *source = data_ + HEADER_SIZE_ + (size_t)first_point * DIMENSIONS_ * sizeof(double);
+        for (int i = 0; i < count; i++)
+        {
+            assert(points[i].size() == DIMENSIONS_);
+            std::memcpy(points[i].data(), source + (size_t)i * DIMENSIONS_ * sizeof(double), DIMENSIONS_ * sizeof(double));
+        }
+        advise_read_ahead(HEADER_SIZE_ + (size_t)(first_point + count) * DIMENSIONS_ * sizeof(double));
+        return count;
+    }
+
+    // CSV lines have variable length: reading backwards restarts the cursor from the file start
+    if (first_point < csv_point_index_)
+    {
+        csv_offset_      = 0;
+        csv_point_index_ = 0;
+        advised_end_     = 0;
+    }
+
+    int num_read = 0;
+    while (csv_offset_ < size_ && num_read < count)
+    {
+        const size_t line_start = csv_offset_;
+        csv_offset_ = next_line(line_start);
+        if (!is_point_line(line_start)) continue;
+
+        if (csv_point_index_ >= first_point)
+        {
+            assert(points[num_read].size() == DIMENSIONS_);
+            if (parse_csv_line(line_start, points[num_read]) != 0)
+            {
+                rt_event::publish(rt_event::TASK_ERROR, rt_event::INVALID_PATH_POINT, csv_point_index_);
+                return -1;
+            }
+            num_read++;
+        }
+        csv_point_index_++;
+    }
+
+    if (csv_offset_ >= size_) num_of_points_ = csv_point_index_;
+    advise_read_ahead(csv_offset_);
+    return num_read;
+}
+
+/*
+    Requests the window after the given offset with MADV_WILLNEED: the kernel starts reading it
+    in the background, without blocking the caller. Renewed once the offset is past
+    the first half of the advised window, so that most reads do not issue a system call.
+*/
+void path_loader::advise_read_ahead(const size_t offset)
+{
+    if (offset >= size_ || offset + READ_AHEAD_BYTES_ / 2 < advised_end_) return;
+
+    const size_t start = offset - offset % page_size_;
+    const size_t end   = std::min(size_, offset + READ_AHEAD_BYTES_);
+    madvise(const_cast<char*>(data_) + start, end - start, MADV_WILLNEED);
+    advised_end_ = end;
+}
+
+int path_loader::write_binary_file(const std::string &file_path,
+                                   const std::vector< std::vector<double> > &points)
+{
+    FILE *file = std::fopen(file_path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        printf("Unable to create path file: %s\n", file_path.c_str());
+        return -1;
+    }
+
+    const uint32_t version = VERSION_, dimensions = DIMENSIONS_;
+    const uint64_t num_of_points = points.size(), reserved = 0;
+
+    bool written = std::fwrite(MAGIC_,         sizeof(MAGIC_),         1, file) == 1 &&
+                   std::fwrite(&version,       sizeof(version),        1, file) == 1 &&
+                   std::fwrite(&dimensions,    sizeof(dimensions),     1, file) == 1 &&
+                   std::fwrite(&num_of_points, sizeof(num_of_points),  1, file) == 1 &&
+                   std::fwrite(&reserved,      sizeof(reserved),       1, file) == 1;
+
+    for (unsigned i = 0; written && i < points.size(); i++)
+    {
+        assert(points[i].size() == DIMENSIONS_);
+        written = std::fwrite(points[i].data(), sizeof(double), DIMENSIONS_, file) == DIMENSIONS_;
+    }
+
+    std::fclose(file);
+    if (!written)
+    {
+        printf("Unable to write path file: %s\n", file_path.c_str());
+        return -1;
+    }
+
+    return 0;
+}
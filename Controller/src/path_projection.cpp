@@ -0,0 +1,187 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <path_projection.hpp>
+
+path_projection::path_projection():
+    hysteresis_(0.0)
+{
+}
+
+void path_projection::build(const std::vector< std::vector<double> > &path_points,
+                            const double hysteresis)
+{
+    assert(("Path must contain at least one segment", path_points.size() > 1));
+    hysteresis_ = hysteresis;
+
+    points_.resize(path_points.size());
+    cumulative_lengths_.resize(path_points.size());
+    for (unsigned i = 0; i < path_points.size(); i++)
+    {
+        points_[i] = Eigen::Vector3d(path_points[i][0], path_points[i][1], path_points[i][2]);
+        cumulative_lengths_[i] = (i == 0)? 0.0 : cumulative_lengths_[i - 1] + (points_[i] - points_[i - 1]).norm();
+    }
+
+    // Binary tree over n segments: at most 2n - 1 nodes
+    nodes_.clear();
+    nodes_.reserve(2 * (points_.size() - 1));
+    build_node(0, points_.size() - 2);
+    reset();
+}
+
+int path_projection::build_node(const int first_segment, const int last_segment)
+{
+    const int index = nodes_.size();
+    nodes_.push_back(bvh_node());
+    nodes_[index].first_segment = first_segment;
+    nodes_[index].last_segment  = last_segment;
+    nodes_[index].left_child    = -1;
+    nodes_[index].right_child   = -1;
+
+    // Consecutive segments are spatially coherent: split the index range in halves
+    if (last_segment - first_segment + 1 > LEAF_SIZE_)
+    {
+        const int middle = (first_segment + last_segment) / 2;
+        const int left   = build_node(first_segment, middle);
+        const int right  = build_node(middle + 1, last_segment);
+        nodes_[index].left_child  = left;
+        nodes_[index].right_child = right;
+        nodes_[index].box = nodes_[left].box.merged(nodes_[right].box);
+    }
+    else
+    {
+        nodes_[index].box.setEmpty();
+        for (int i = first_segment; i <= last_segment + 1; i++) nodes_[index].box.extend(points_[i]);
+    }
+
+    return index;
+}
+
+bool path_projection::is_built() const
+{
+    return !nodes_.empty();
+}
+
+void path_projection::reset()
+{
+    result_ = path_projection_result();
+}
+
+double path_projection::squared_distance_to_segment(const Eigen::Vector3d &point, const int segment, double &parameter) const
+{
+    const Eigen::Vector3d direction = points_[segment + 1] - points_[segment];
+    const double squared_length = direction.squaredNorm();
+
+    parameter = (squared_length > 1e-18)? (point - points_[segment]).dot(direction) / squared_length : 0.0;
+    if      (parameter < 0.0) parameter = 0.0;
+    else if (parameter > 1.0) parameter = 1.0;
+
+    return (points_[segment] + parameter * direction - point).squaredNorm();
+}
+
+const path_projection_result &path_projection::project(const Eigen::Vector3d &point)
+{
+    return project(point, result_.segment);
+}
+
+const path_projection_result &path_projection::project(const Eigen::Vector3d &point, const int warm_start_segment)
+{
+    assert(is_built());
+    const int last_segment = points_.size() - 2;
+
+    // Local search around the previous answer provides the initial bound
+    int best_segment = std::max(0, std::min(warm_start_segment, last_segment));
+    double best_parameter = 0.0;
+    double best_distance = squared_distance_to_segment(point, best_segment, best_parameter);
+    double parameter = 0.0;
+
+    for (int i = std::max(0, warm_start_segment - WARM_START_WINDOW_); i <= std::min(last_segment, warm_start_segment + WARM_START_WINDOW_); i++)
+    {
+        const double distance = squared_distance_to_segment(point, i, parameter);
+        if (distance < best_distance)
+        {
+            best_distance  = distance;
+            best_segment   = i;
+            best_parameter = parameter;
+        }
+    }
+
+    // Global candidates must improve on the local answer by the hysteresis
+    const double local_distance = std::sqrt(best_distance);
+    double bound = std::max(0.0, local_distance - hysteresis_);
+    bound *= bound;
+
+    int stack[STACK_SIZE_];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0)
+    {
+        const bvh_node &node = nodes_[stack[--stack_size]];
+        if (node.box.squaredExteriorDistance(point) >= bound) continue;
+
+        if (node.left_child < 0)
+        {
+            for (int i = node.first_segment; i <= node.last_segment; i++)
+            {
+                const double distance = squared_distance_to_segment(point, i, parameter);
+                if (distance < bound)
+                {
+                    bound          = distance;
+                    best_distance  = distance;
+                    best_segment   = i;
+                    best_parameter = parameter;
+                }
+            }
+        }
+        else
+        {
+            // Tree depth is log2(n / LEAF_SIZE_): the fixed-size stack suffices for any realistic path
+            assert(stack_size + 2 <= STACK_SIZE_);
+            stack[stack_size++] = node.right_child;
+            stack[stack_size++] = node.left_child;
+        }
+    }
+
+    result_.segment           = best_segment;
+    result_.segment_parameter = best_parameter;
+    result_.arc_length        = cumulative_lengths_[best_segment] + best_parameter * (cumulative_lengths_[best_segment + 1] - cumulative_lengths_[best_segment]);
+    result_.distance          = std::sqrt(best_distance);
+    return result_;
+}
+
+const path_projection_result &path_projection::get_result() const
+{
+    return result_;
+}
+
+double path_projection::get_path_length() const
+{
+    return cumulative_lengths_.empty()? 0.0 : cumulative_lengths_.back();
+}
+
+int path_projection::get_number_of_segments() const
+{
+    return points_.size() - 1;
+}
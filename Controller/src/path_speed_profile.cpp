@@ -0,0 +1,143 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <path_speed_profile.hpp>
+
+path_speed_profile::path_speed_profile():
+    minimum_speed_(0.0)
+{
+}
+
+void path_speed_profile::compute(const std::vector< std::vector<double> > &path_points,
+                                 const std::vector<double> &segment_speed_limits,
+                                 const std::vector<double> &segment_acceleration_limits,
+                                 const double corner_deviation,
+                                 const double minimum_speed)
+{
+    const int num_of_segments = path_points.size() - 1;
+    assert(num_of_segments > 0);
+    assert(segment_speed_limits.size() == (unsigned)num_of_segments);
+    assert(segment_acceleration_limits.size() == (unsigned)num_of_segments);
+
+    minimum_speed_       = minimum_speed;
+    speed_limits_        = segment_speed_limits;
+    acceleration_limits_ = segment_acceleration_limits;
+    segment_lengths_.assign(num_of_segments, 0.0);
+    vertex_speeds_.assign(num_of_segments + 1, 0.0);
+
+    std::vector<Eigen::Vector3d> directions(num_of_segments);
+    for (int i = 0; i < num_of_segments; i++)
+    {
+        directions[i] = Eigen::Vector3d(path_points[i + 1][0] - path_points[i][0],
+                                        path_points[i + 1][1] - path_points[i][1],
+                                        path_points[i + 1][2] - path_points[i][2]);
+        segment_lengths_[i] = directions[i].norm();
+        if (segment_lengths_[i] > 1e-9) directions[i] /= segment_lengths_[i];
+    }
+
+    // Upper bounds at the interior vertices: adjacent segment limits and the corner limit
+    for (int i = 1; i < num_of_segments; i++)
+    {
+        vertex_speeds_[i] = std::min(speed_limits_[i - 1], speed_limits_[i]);
+
+        // Half of the angle between the incoming and the outgoing segment. Straight line: PI/2
+        const double cosine    = std::max(-1.0, std::min(1.0, -directions[i - 1].dot(directions[i])));
+        const double half_sine = std::sqrt(0.5 * (1.0 - cosine));
+        if (half_sine < 1.0 - 1e-9)
+        {
+            const double acceleration = std::min(acceleration_limits_[i - 1], acceleration_limits_[i]);
+            vertex_speeds_[i] = std::min(vertex_speeds_[i], std::sqrt(acceleration * corner_deviation * half_sine / (1.0 - half_sine)));
+        }
+    }
+
+    // Forward pass: reachable speeds when accelerating from the start
+    for (int i = 0; i < num_of_segments; i++)
+        vertex_speeds_[i + 1] = std::min(vertex_speeds_[i + 1], std::sqrt(vertex_speeds_[i] * vertex_speeds_[i] + 2.0 * acceleration_limits_[i] * segment_lengths_[i]));
+
+    // Backward pass: speeds from which the robot can still decelerate towards the end
+    for (int i = num_of_segments - 1; i >= 0; i--)
+        vertex_speeds_[i] = std::min(vertex_speeds_[i], std::sqrt(vertex_speeds_[i + 1] * vertex_speeds_[i + 1] + 2.0 * acceleration_limits_[i] * segment_lengths_[i]));
+}
+
+bool path_speed_profile::is_computed() const
+{
+    return !segment_lengths_.empty();
+}
+
+double path_speed_profile::get_speed(const int segment, const double distance_to_segment_end) const
+{
+    assert(is_computed());
+    assert(segment >= 0);
+    assert((unsigned)segment < segment_lengths_.size());
+
+    const double length    = segment_lengths_[segment];
+    const double remaining = std::max(0.0, std::min(distance_to_segment_end, length));
+    const double covered   = length - remaining;
+    const double a         = acceleration_limits_[segment];
+
+    double speed = std::min(speed_limits_[segment],
+                            std::min(std::sqrt(vertex_speeds_[segment] * vertex_speeds_[segment] + 2.0 * a * covered),
+                                     std::sqrt(vertex_speeds_[segment + 1] * vertex_speeds_[segment + 1] + 2.0 * a * remaining)));
+    return std::max(speed, minimum_speed_);
+}
+
+double path_speed_profile::get_vertex_speed(const int vertex) const
+{
+    assert(vertex >= 0);
+    assert((unsigned)vertex < vertex_speeds_.size());
+
+    return vertex_speeds_[vertex];
+}
+
+double path_speed_profile::get_segment_length(const int segment) const
+{
+    assert(segment >= 0);
+    assert((unsigned)segment < segment_lengths_.size());
+
+    return segment_lengths_[segment];
+}
+
+/**
+ * Time needed for traversing the whole path with the computed profile.
+ * Per segment: accelerate, cruise at the segment limit, decelerate (all closed form).
+ */
+double path_speed_profile::get_traversal_time() const
+{
+    double total_time = 0.0;
+    for (unsigned i = 0; i < segment_lengths_.size(); i++)
+    {
+        const double v0 = std::max(vertex_speeds_[i], minimum_speed_);
+        const double v1 = std::max(vertex_speeds_[i + 1], minimum_speed_);
+        const double a  = acceleration_limits_[i];
+        const double L  = segment_lengths_[i];
+
+        // Peak speed within the segment
+        const double v_peak = std::max(std::min(speed_limits_[i], std::sqrt(0.5 * (v0 * v0 + v1 * v1) + a * L)), std::max(v0, v1));
+        const double d_acc  = (v_peak * v_peak - v0 * v0) / (2.0 * a);
+        const double d_dec  = (v_peak * v_peak - v1 * v1) / (2.0 * a);
+
+        total_time += (v_peak - v0) / a + (v_peak - v1) / a + std::max(0.0, L - d_acc - d_dec) / v_peak;
+    }
+    return total_time;
+}
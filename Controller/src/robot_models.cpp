@@ -0,0 +1,101 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "robot_models.hpp"
+#include <kdl_parser/kdl_parser.hpp>
+#include <urdf/model.h>
+#include <constants.hpp>
+#include <cstdio>
+
+#ifndef URDF_DIR
+#define URDF_DIR "urdf/"
+#endif
+
+namespace
+{
+    // URDF -> KDL tree -> chain between root and tooltip
+    int load_model(const std::string &urdf_file, const std::string &root_name,
+                   const std::string &tooltip_name, KDL::Chain &chain)
+    {
+        urdf::Model urdf_model;
+        KDL::Tree tree;
+
+        if (!urdf_model.initFile(std::string(URDF_DIR) + urdf_file))
+        {
+            printf("ERROR: Failed to parse urdf robot model: %s\n", urdf_file.c_str());
+            return -1;
+        }
+
+        if (!kdl_parser::treeFromUrdfModel(urdf_model, tree))
+        {
+            printf("ERROR: Failed to construct kdl tree: %s\n", urdf_file.c_str());
+            return -1;
+        }
+
+        if (!tree.getChain(root_name, tooltip_name, chain))
+        {
+            printf("ERROR: Failed to extract kdl chain: %s\n", urdf_file.c_str());
+            return -1;
+        }
+        return 0;
+    }
+}
+
+int load_models(std::vector<robot_model> &models)
+{
+    models.resize(3);
+
+    models[0].name                  = "youbot";
+    models[0].joint_inertia         = youbot_constants::joint_inertia;
+    models[0].joint_torque_limits   = youbot_constants::joint_torque_limits;
+    models[0].position_limits_min   = youbot_constants::joint_position_limits_min_1;
+    models[0].position_limits_max   = youbot_constants::joint_position_limits_max_1;
+    models[0].joint_velocity_limits = youbot_constants::joint_velocity_limits;
+    models[0].root_acceleration     = youbot_constants::root_acceleration;
+    if (load_model("youbot_arm_only.urdf", youbot_constants::root_name,
+                   youbot_constants::tooltip_name, models[0].chain) != 0) return -1;
+
+    models[1].name                  = "kinova_gen3";
+    models[1].joint_inertia         = kinova_constants::joint_inertia;
+    models[1].joint_torque_limits   = kinova_constants::joint_torque_limits;
+    models[1].position_limits_min   = kinova_constants::joint_position_limits_min;
+    models[1].position_limits_max   = kinova_constants::joint_position_limits_max;
+    models[1].joint_velocity_limits = kinova_constants::joint_velocity_limits;
+    models[1].root_acceleration     = kinova_constants::root_acceleration_1;
+    if (load_model("kinova-gen3_urdf_V12.urdf", kinova_constants::root_name,
+                   kinova_constants::tooltip_name, models[1].chain) != 0) return -1;
+
+    models[2].name                  = "lwr";
+    models[2].joint_inertia         = lwr_constants::joint_inertia;
+    models[2].joint_torque_limits   = lwr_constants::joint_torque_limits;
+    models[2].position_limits_min   = lwr_constants::joint_position_limits_min;
+    models[2].position_limits_max   = lwr_constants::joint_position_limits_max;
+    models[2].joint_velocity_limits = lwr_constants::joint_velocity_limits;
+    models[2].root_acceleration     = lwr_constants::root_acceleration;
+    if (load_model("lwr.urdf", lwr_constants::root_name,
+                   lwr_constants::tooltip_name, models[2].chain) != 0) return -1;
+
+    return 0;
+}
@@ -25,30 +25,52 @@ SOFTWARE.
 
 #include <safety_monitor.hpp>
 
+const double LIMIT_APPROACH_VELOCITY = 0.05; // rad/s ... Joint moving towards a limit, within its position threshold
+
+static Eigen::ArrayXd to_array(const std::vector<double> &values)
+{
+    return Eigen::Map<const Eigen::ArrayXd>(values.data(), values.size());
+}
+
 safety_monitor::safety_monitor(robot_mediator *robot_driver, const bool print_logs):
-    joint_position_limits_max_(robot_driver->get_maximum_joint_pos_limits()),
-    joint_position_limits_min_(robot_driver->get_minimum_joint_pos_limits()),
-    joint_position_thresholds_(robot_driver->get_joint_position_thresholds()),
-    joint_velocity_limits_(robot_driver->get_joint_velocity_limits()),
-    joint_torque_limits_(robot_driver->get_joint_torque_limits()),
+    joint_position_limits_max_(to_array(robot_driver->get_maximum_joint_pos_limits())),
+    joint_position_limits_min_(to_array(robot_driver->get_minimum_joint_pos_limits())),
+    joint_position_thresholds_(to_array(robot_driver->get_joint_position_thresholds())),
+    joint_velocity_limits_(to_array(robot_driver->get_joint_velocity_limits())),
+    joint_torque_limits_(to_array(robot_driver->get_joint_torque_limits())),
     NUM_OF_JOINTS_(robot_driver->get_robot_model().getNrOfJoints()),
     NUM_OF_SEGMENTS_(robot_driver->get_robot_model().getNrOfSegments()),
     NUM_OF_FRAMES_(robot_driver->get_robot_model().getNrOfSegments() + 1),
     NUM_OF_CONSTRAINTS_(dynamics_parameter::NUMBER_OF_CONSTRAINTS),
-    PRINT_LOGS_(print_logs),
-    current_state_(NUM_OF_JOINTS_, NUM_OF_SEGMENTS_, NUM_OF_FRAMES_, NUM_OF_CONSTRAINTS_),
-    predicted_states_(2, current_state_)
+    PRINT_LOGS_(print_logs), prediction_step_(0),
+    joint_mask_(Eigen::Array<bool, Eigen::Dynamic, 1>::Constant(NUM_OF_JOINTS_, true))
 {
-
+    assert(joint_position_limits_max_.size() == NUM_OF_JOINTS_);
+    assert(joint_position_limits_min_.size() == NUM_OF_JOINTS_);
+    assert(joint_position_thresholds_.size() == NUM_OF_JOINTS_);
+    assert(joint_velocity_limits_.size() == NUM_OF_JOINTS_);
+    assert(joint_torque_limits_.size() == NUM_OF_JOINTS_);
 }
 
 int safety_monitor::monitor_joint_state(const state_specification &current_state,
-                                           const double dt_sec,
-                                           const int desired_control_mode,
-                                           const std::vector<state_specification> &predicted_states)
+                                        const double dt_sec,
+                                        const int desired_control_mode,
+                                        const std::vector<state_specification> &predicted_states,
+                                        const int num_of_predicted_states)
+{
+    return monitor_joint_state(joint_state_view(current_state), dt_sec, desired_control_mode, 
+                               predicted_states, num_of_predicted_states);
+}
+
+int safety_monitor::monitor_joint_state(const joint_state_view &current_state,
+                                        const double dt_sec,
+                                        const int desired_control_mode,
+                                        const std::vector<state_specification> &predicted_states,
+                                        const int num_of_predicted_states)
 {
     assert(NUM_OF_JOINTS_ == current_state.qd.rows());
-    current_state_ = current_state;
+    assert(num_of_predicted_states >= 1);
+    assert(num_of_predicted_states <= predicted_states.size());
 
     /*
         First Safety Level: Is the Current State Safe?
@@ -59,14 +81,15 @@ int safety_monitor::monitor_joint_state(const state_specification &current_state
         given the measured (not integrated) angles and velocities.
         If everything ok, proceed to the second level.
     */
-    if (!is_current_state_safe()) return control_mode::STOP_MOTION;
+    prediction_step_ = 0;
+    if (!is_current_state_safe(current_state)) return control_mode::STOP_MOTION;
 
     /*
         Integrated joint accelerations to velocities and positions
         I.e. prediction on where the robot will end-up
-        in next two steps, if the computed commands have been applied.
+        in the next steps of the horizon, if the computed commands have been applied.
+        Predicted states are only read here, not copied.
     */
-    predicted_states_ = predicted_states;
 
     /*
         Second Safety Level: Is the Future State Safe?
@@ -75,100 +98,135 @@ int safety_monitor::monitor_joint_state(const state_specification &current_state
         If yes, stop the robot.
         If not: continue with the original commands.
     */
-    return monitor_future_state(desired_control_mode);
+    return monitor_future_state(current_state, desired_control_mode, predicted_states, num_of_predicted_states);
 }
 
-bool safety_monitor::is_current_state_safe()
+bool safety_monitor::is_current_state_safe(const joint_state_view &state)
 {
     /* 
         Check current velocities and position for every case. 
         Our model is not correct and commanded torque in previous iteration,
         may produce too high velocities or move joint over position limits.
         Basically check for error in model evaluation and predictions.
+        All joints are checked at once; per-joint checks only run on failure, for the diagnostics.
     */
+    const auto q  = state.q.array();
+    const auto qd = state.qd.array();
+    const auto near_max_limit = (joint_position_limits_max_ - q) < joint_position_thresholds_;
+    const auto near_min_limit = (joint_position_limits_min_ - q) > -joint_position_thresholds_;
+
+    joint_mask_ = state.control_torque.array().isFinite() && state.qdd.array().isFinite() && 
+                  qd.isFinite() && q.isFinite() && 
+                  (qd.abs() < joint_velocity_limits_) &&
+                  (q < joint_position_limits_max_) && (q > joint_position_limits_min_) &&
+                  !(near_max_limit && (qd > LIMIT_APPROACH_VELOCITY)) &&
+                  !(!near_max_limit && near_min_limit && (qd < -LIMIT_APPROACH_VELOCITY));
+
+    if (joint_mask_.all()) return true;
+
+    // Report the first unsafe joint, with the same diagnostics as the per-joint checks
+    const int joint = first_unsafe_joint();
+    if (is_state_finite(state, joint) && !velocity_limit_reached(state, joint) && !position_limit_reached(state.q, joint))
+        reaching_position_limits(state, joint);
+    return false;
+}
+
+bool safety_monitor::is_position_safe(const Eigen::Ref<const Eigen::VectorXd> &q)
+{
+    joint_mask_ = (q.array() < joint_position_limits_max_) && (q.array() > joint_position_limits_min_);
+    if (joint_mask_.all()) return true;
+
+    position_limit_reached(q, first_unsafe_joint());
+    return false;
+}
+
+int safety_monitor::first_unsafe_joint() const
+{
     for (int i = 0; i < NUM_OF_JOINTS_; i++)
-    {
-        if (!is_state_finite(current_state_, i) || \
-            velocity_limit_reached(current_state_, i) || \
-            position_limit_reached(current_state_, i) || \
-            reaching_position_limits(current_state_, i)) return false;
-    }
-    return true;
+        if (!joint_mask_(i)) return i;
+    return 0;
 }
 
-bool safety_monitor::is_state_finite(const state_specification &state, const int joint)
+// Queued on the real-time event channel: printed by its background sink
+void safety_monitor::report(const int check, const int joint, const double value, const double limit) const
+{
+    rt_event::publish(rt_event::SAFETY_STOP, check, joint, value, limit, prediction_step_);
+}
+
+bool safety_monitor::is_state_finite(const joint_state_view &state, const int joint)
 {
     if (!std::isfinite(state.control_torque(joint))){
-        if (PRINT_LOGS_) printf("Computed torque for joint: %d is not finite!\n", joint + 1);
+        if (PRINT_LOGS_) report(rt_event::TORQUE_NOT_FINITE, joint, state.control_torque(joint), 0.0);
         return false;
     }
     else if (!std::isfinite(state.qdd(joint))){
-        if (PRINT_LOGS_) printf("Computed joint: %d acceleration is not finite!\n", joint + 1);
+        if (PRINT_LOGS_) report(rt_event::ACCELERATION_NOT_FINITE, joint, state.qdd(joint), 0.0);
         return false;
     }
     else if (!std::isfinite(state.qd(joint))){
-        if (PRINT_LOGS_) printf("Computed joint: %d velocity is not finite!\n", joint + 1);
+        if (PRINT_LOGS_) report(rt_event::VELOCITY_NOT_FINITE, joint, state.qd(joint), 0.0);
         return false;
     }
     else if (!std::isfinite(state.q(joint))){
-        if (PRINT_LOGS_) printf("Computed joint: %d position is not finite!\n", joint + 1);
+        if (PRINT_LOGS_) report(rt_event::POSITION_NOT_FINITE, joint, state.q(joint), 0.0);
         return false;
     }
 
     return true;
 }
 
-bool safety_monitor::torque_limit_reached(const state_specification &state, const int joint)
+bool safety_monitor::torque_limit_reached(const joint_state_view &state, const int joint)
 {
-    if (std::fabs(state.control_torque(joint)) >= joint_torque_limits_[joint])
+    if (std::fabs(state.control_torque(joint)) >= joint_torque_limits_(joint))
     {
-        if (PRINT_LOGS_) printf("Joint %d torque limit reached: %f \n", joint + 1, state.control_torque(joint));
+        if (PRINT_LOGS_) report(rt_event::TORQUE_LIMIT, joint, state.control_torque(joint), joint_torque_limits_(joint));
         return true;        
     }
 
     return false;
 }
 
-bool safety_monitor::velocity_limit_reached(const state_specification &state, const int joint)
+bool safety_monitor::velocity_limit_reached(const joint_state_view &state, const int joint)
 {
-    if (std::fabs(state.qd(joint)) >= joint_velocity_limits_[joint])
+    if (std::fabs(state.qd(joint)) >= joint_velocity_limits_(joint))
     {
-        if (PRINT_LOGS_) printf("Joint %d velocity limit reached: %f \n", joint + 1, state.qd(joint));
+        if (PRINT_LOGS_) report(rt_event::VELOCITY_LIMIT, joint, state.qd(joint), joint_velocity_limits_(joint));
         return true;        
     }
     
     return false;
 }
 
-bool safety_monitor::position_limit_reached(const state_specification &state, const int joint)
+bool safety_monitor::position_limit_reached(const Eigen::Ref<const Eigen::VectorXd> &q, const int joint)
 {
-    if ((state.q(joint) >= joint_position_limits_max_[joint]) || \
-        (state.q(joint) <= joint_position_limits_min_[joint]))
+    if ((q(joint) >= joint_position_limits_max_(joint)) || \
+        (q(joint) <= joint_position_limits_min_(joint)))
     {
-        if (PRINT_LOGS_) printf("Joint %d position limit reached: %f \n", joint + 1, state.q(joint));
+        const double limit = (q(joint) >= joint_position_limits_max_(joint))? joint_position_limits_max_(joint) : joint_position_limits_min_(joint);
+        if (PRINT_LOGS_) report(rt_event::POSITION_LIMIT, joint, q(joint), limit);
         return true; 
     }
 
     return false;
 }
 
-bool safety_monitor::reaching_position_limits(const state_specification &state, const int joint)
+bool safety_monitor::reaching_position_limits(const joint_state_view &state, const int joint)
 {
 
-    if ((joint_position_limits_max_[joint] - state.q(joint)) < joint_position_thresholds_[joint])
+    if ((joint_position_limits_max_(joint) - state.q(joint)) < joint_position_thresholds_(joint))
     {
-        if (state.qd(joint) > 0.05)
+        if (state.qd(joint) > LIMIT_APPROACH_VELOCITY)
         {
-            printf("Joint %d is too close to the max limit %f %f \n", joint + 1, state.q(joint), state.qd(joint));
+            report(rt_event::APPROACHING_MAX_LIMIT, joint, state.q(joint), joint_position_limits_max_(joint));
             return true;
         } 
     } 
 
-    else if ((joint_position_limits_min_[joint] - state.q(joint)) > -joint_position_thresholds_[joint])
+    else if ((joint_position_limits_min_(joint) - state.q(joint)) > -joint_position_thresholds_(joint))
     {
-        if (state.qd(joint) < -0.05)
+        if (state.qd(joint) < -LIMIT_APPROACH_VELOCITY)
         {
-            printf("Joint %d is too close to the min limit %f %f \n", joint + 1, state.q(joint), state.qd(joint));
+            report(rt_event::APPROACHING_MIN_LIMIT, joint, state.q(joint), joint_position_limits_min_(joint));
             return true;
         }
     } 
@@ -176,26 +234,32 @@ bool safety_monitor::reaching_position_limits(const state_specification &state,
     return false;
 }
 
-int safety_monitor::monitor_future_state(const int desired_control_mode)
+int safety_monitor::monitor_future_state(const joint_state_view &current_state,
+                                         const int desired_control_mode,
+                                         const std::vector<state_specification> &predicted_states,
+                                         const int num_of_predicted_states)
 {
     switch (desired_control_mode)
     {   
         /*
             Check if the commaned torques are over torque limits.
-            Check if the commanded torques will make a joint go over the position limits.
+            Check if the commanded torques will make a joint go over the position limits,
+            anywhere in the predicted horizon.
             If all ok: continue with this control mode.
             Else: stop the robot.
         */
         case control_mode::TORQUE:
-            for (int i = 0; i < NUM_OF_JOINTS_; i++)
+            joint_mask_ = current_state.control_torque.array().abs() < joint_torque_limits_;
+            if (!joint_mask_.all())
+            {
+                torque_limit_reached(current_state, first_unsafe_joint());
+                return control_mode::STOP_MOTION;
+            }
+
+            for (int k = 0; k < num_of_predicted_states; k++)
             {
-                if (torque_limit_reached(current_state_, i) || \
-                    position_limit_reached(predicted_states_[0], i) || \
-                    position_limit_reached(predicted_states_[1], i))
-                {
-                    if (PRINT_LOGS_) printf("Torque commands not safe \n");
-                    return control_mode::STOP_MOTION;
-                }
+                prediction_step_ = k + 1;
+                if (!is_position_safe(predicted_states[k].q.data)) return control_mode::STOP_MOTION;
             }
 
             return control_mode::TORQUE;
@@ -207,18 +271,23 @@ int safety_monitor::monitor_future_state(const int desired_control_mode)
             Else: stop the robot.
         */
         case control_mode::VELOCITY:
-            for (int i = 0; i < NUM_OF_JOINTS_; i++)
+        {
+            const joint_state_view next_state(predicted_states[0]);
+            prediction_step_ = 1;
+            joint_mask_ = next_state.qd.array().abs() < joint_velocity_limits_;
+            if (!joint_mask_.all())
             {
-                if (velocity_limit_reached(predicted_states_[0], i) || \
-                    position_limit_reached(predicted_states_[0], i) || \
-                    position_limit_reached(predicted_states_[1], i))
-                {
-                    if (PRINT_LOGS_) printf("Velocity commands not safe \n");
-                    return control_mode::STOP_MOTION;
-                }
+                velocity_limit_reached(next_state, first_unsafe_joint());
+                return control_mode::STOP_MOTION;
             }
 
+            if (!is_position_safe(next_state.q)) return control_mode::STOP_MOTION;
+
+            prediction_step_ = std::min(2, num_of_predicted_states);
+            if (!is_position_safe(predicted_states[prediction_step_ - 1].q.data)) return control_mode::STOP_MOTION;
+
             return control_mode::VELOCITY;
+        }
 
         /*
             Simple check if the computed postion commands are valid, i.e. over the limit.
@@ -226,17 +295,11 @@ int safety_monitor::monitor_future_state(const int desired_control_mode)
             Last step in safety check.
         */
         case control_mode::POSITION:
-            for (int i = 0; i < NUM_OF_JOINTS_; i++)
-            {
-                if (position_limit_reached(predicted_states_[0], i))
-                {
-                    if (PRINT_LOGS_) printf("Position commands not safe \n");
-                    return control_mode::STOP_MOTION;
-                }
-            }
+            prediction_step_ = 1;
+            if (!is_position_safe(predicted_states[0].q.data)) return control_mode::STOP_MOTION;
 
             return control_mode::POSITION;
 
         default: return control_mode::STOP_MOTION;
     }
-}
\ No newline at end of file
+}
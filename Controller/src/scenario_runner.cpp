@@ -0,0 +1,303 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "scenario_runner.hpp"
+#include <motion_profile.hpp>
+#include <constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <random>
+
+namespace
+{
+    const int JOINTS                   = 7;
+    const int NUMBER_OF_CONSTRAINTS    = 6;
+    const double TUBE_SPEED            = 0.07;
+    const double TUBE_FORCE            = -18.5;
+    const double INITIAL_PERTURBATION  = 0.5; // Unit degrees, uniform
+    const double POSITION_NOISE_STDDEV = 0.0001; // rad
+    const double VELOCITY_NOISE_STDDEV = 0.001; // rad/s
+    const double CONTACT_STIFFNESS     = 5000.0; // N/m
+    const double CONTACT_DAMPING       = 50.0; // Ns/m
+
+    // HOME configuration (unit degrees) and its pose targets, as in the Kinova main
+    const std::vector<double> HOME_CONFIGURATION = {0.0, 15.0, 180.0, 230.0, 0.0, 55.0, 90.0};
+    const std::vector<double> HOME_TUBE_START    = {0.395153, 0.0013505, 0.433652};
+    const std::vector<double> HOME_EE_POSE       = {0.565153, 0.0013505, 0.433652, // Linear: Vector
+                                                    0.0, 0.0, -1.0, // Angular: Rotation matrix
+                                                    1.0, 0.0, 0.0,
+                                                    0.0, -1.0, 0.0};
+
+    const std::vector<bool> CONTROL_DIMS                 = {true, true, true, // Linear
+                                                            true, true, true}; // Angular
+    const std::vector<bool> CONTROL_DIMS_MOVECONSTRAINED = {true, true, true, // Linear
+                                                            true, true, false}; // Angular
+
+    // Tube tolerances: x pos,    y pos,      z force,
+    //                  x torque, y torque,   null-space,
+    //                  x vel,    z_a pos/vel
+    const std::vector<double> TUBE_TOLERANCES                 = {0.01, 0.02, 0.02,
+                                                                 0.09, 0.0, 0.0,
+                                                                 TUBE_SPEED * 0.2, 0.0};
+    const std::vector<double> TUBE_TOLERANCES_MOVECONSTRAINED = {0.003, 0.03, 0.003,
+                                                                 0.005, 0.005, 25.0,
+                                                                 0.003, 0.001};
+
+    const std::vector<scenario_runner::scenario> SCENARIOS = {
+        {"full_pose",                   task_model::full_pose,                   {},     TUBE_TOLERANCES,                 {0, 1, 2}, true},
+        {"moveGuarded",                 task_model::moveGuarded,                 {1, 2}, TUBE_TOLERANCES,                 {1, 2},    true},
+        {"moveTo",                      task_model::moveTo,                      {1, 2}, TUBE_TOLERANCES,                 {1, 2},    true},
+        {"moveTo_follow_path",          task_model::moveTo_follow_path,          {1, 2}, TUBE_TOLERANCES,                 {1, 2},    true},
+        {"moveConstrained_follow_path", task_model::moveConstrained_follow_path, {1},    TUBE_TOLERANCES_MOVECONSTRAINED, {1},       true},
+        {"moveTo_weight_compensation",  task_model::moveTo_weight_compensation,  {1, 2}, TUBE_TOLERANCES,                 {1, 2},    true},
+        {"gravity_compensation",        task_model::gravity_compensation,        {},     TUBE_TOLERANCES,                 {},        false}
+    };
+
+    // The URDF parser is not known to be thread-safe: plants of parallel runs are built one at a time
+    std::mutex model_parser_mutex;
+
+    int define_task(dynamics_controller &controller, const scenario_runner::scenario &task,
+                    std::vector< std::vector<double> > &path_points,
+                    std::vector< std::vector<double> > &path_poses)
+    {
+        std::vector<double> desired_ee_pose = HOME_EE_POSE;
+        const double time_limit = scenario_runner::TASK_TIME_LIMIT_SEC;
+
+        switch (task.task_model)
+        {
+            case task_model::full_pose:
+                controller.define_full_pose_task(CONTROL_DIMS, desired_ee_pose,
+                                                 500.0, 500.0, // contact_threshold linear and angular
+                                                 time_limit, false, 90.0, task.tube_tolerances[7]);
+                return 0;
+
+            case task_model::moveGuarded:
+                controller.define_moveGuarded_task(CONTROL_DIMS, HOME_TUBE_START, task.tube_tolerances, TUBE_SPEED,
+                                                   35.0, 500.0, time_limit, false, 90.0, desired_ee_pose);
+                return 0;
+
+            case task_model::moveTo:
+                controller.define_moveTo_task(CONTROL_DIMS, HOME_TUBE_START, task.tube_tolerances, TUBE_SPEED,
+                                              500.0, 500.0, time_limit, false, 90.0, desired_ee_pose);
+                return 0;
+
+            case task_model::moveTo_follow_path:
+                path_points.assign(50, std::vector<double>(3, 0.0));
+                path_poses.assign(49, std::vector<double>(12, 0.0));
+                motion_profile::draw_inf_sign_xy(path_points, 0.5, 0.4, 0.18, 0.5,
+                                                 desired_ee_pose[0], desired_ee_pose[1], desired_ee_pose[2]);
+                controller.define_moveTo_follow_path_task(CONTROL_DIMS, path_points, task.tube_tolerances, TUBE_SPEED,
+                                                          500.0, 500.0, time_limit, false, 90.0, path_poses);
+                return 0;
+
+            case task_model::moveConstrained_follow_path:
+                path_points.assign(100, std::vector<double>(3, 0.0));
+                path_poses.assign(99, std::vector<double>(12, 0.0));
+                motion_profile::draw_inf_sign_xy(path_points, 0.25, 0.25, 0.4, 1.0,
+                                                 desired_ee_pose[0], desired_ee_pose[1], desired_ee_pose[2]);
+                controller.define_moveConstrained_follow_path_task(CONTROL_DIMS_MOVECONSTRAINED, path_points,
+                                                                   task.tube_tolerances, TUBE_SPEED, TUBE_FORCE,
+                                                                   90.5, 90.4, time_limit, false, 90.0, path_poses);
+                return 0;
+
+            case task_model::moveTo_weight_compensation:
+                controller.define_moveTo_weight_compensation_task(CONTROL_DIMS, HOME_TUBE_START, task.tube_tolerances, TUBE_SPEED,
+                                                                  500.0, 500.0, time_limit, false, 90.0,
+                                                                  false, desired_ee_pose);
+                return 0;
+
+            case task_model::gravity_compensation:
+                controller.define_gravity_compensation_task(time_limit);
+                return 0;
+
+            default:
+                printf("Unsupported task model: %d\n", task.task_model);
+                return -1;
+        }
+    }
+
+    // Contact surfaces: a wall across the moveGuarded tube, and a table just below the constrained path
+    void set_environment(simulation_mediator &plant, const scenario_runner::scenario &task)
+    {
+        if (task.task_model == task_model::moveGuarded)
+            plant.set_contact_plane(KDL::Vector(0.5, 0.0, 0.0), KDL::Vector(-1.0, 0.0, 0.0),
+                                    CONTACT_STIFFNESS, CONTACT_DAMPING);
+        else if (task.task_model == task_model::moveConstrained_follow_path)
+            plant.set_contact_plane(KDL::Vector(0.0, 0.0, HOME_EE_POSE[2] - 0.005), KDL::Vector(0.0, 0.0, 1.0),
+                                    CONTACT_STIFFNESS, CONTACT_DAMPING);
+        else plant.remove_contact_plane();
+    }
+}
+
+const std::vector<scenario_runner::scenario> &scenario_runner::get_scenarios()
+{
+    return SCENARIOS;
+}
+
+const scenario_runner::scenario *scenario_runner::find_scenario(const std::string &name)
+{
+    for (const scenario &task : SCENARIOS)
+        if (task.name == name) return &task;
+    return nullptr;
+}
+
+int scenario_runner::load_parameters(const scenario &task, const std::string &parameter_file,
+                                     controller_parameters &parameters)
+{
+    parameter_store store(NUMBER_OF_CONSTRAINTS, JOINTS);
+    if (store.load(parameter_file, task.name) != 0) return -1;
+
+    parameters = store.acquire()->mode[NOMINAL_PARAMETERS];
+    return 0;
+}
+
+int scenario_runner::setup(const scenario &task, const unsigned int seed, const std::string &parameter_file,
+                           const controller_parameters *parameters, session &run_session)
+{
+    simulation_mediator &plant = run_session.plant;
+    {
+        std::lock_guard<std::mutex> lock(model_parser_mutex);
+        plant.initialize(0, 0, robot_id::KINOVA_GEN3_1, DT_SEC);
+    }
+    if (!plant.is_initialized()) return -1;
+
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> perturbation(-INITIAL_PERTURBATION, INITIAL_PERTURBATION);
+    KDL::JntArray q(JOINTS), qd(JOINTS);
+    for (int j = 0; j < JOINTS; j++)
+        q(j) = DEG_TO_RAD(HOME_CONFIGURATION[j] + perturbation(generator));
+    plant.set_joint_state(q, qd);
+    plant.set_sensor_noise(POSITION_NOISE_STDDEV, VELOCITY_NOISE_STDDEV, seed);
+    set_environment(plant, task);
+
+    run_session.controller.reset(new dynamics_controller(&plant, RATE_HZ, false));
+    dynamics_controller &controller = *run_session.controller;
+    if (define_task(controller, task, run_session.path_points, run_session.path_poses) != 0) return -1;
+
+    const int parameter_result = (parameters != nullptr)? controller.set_parameters(*parameters) : 
+                                                           controller.load_parameters(parameter_file, task.name, false);
+    if (parameter_result != 0) return -1;
+    if (controller.initialize(control_mode::TORQUE, dynamics_interface::CART_ACCELERATION,
+                              m_profile::S_CURVE, false, true) != 0) return -1;
+    return 0;
+}
+
+int scenario_runner::run(const scenario &task, const unsigned int seed, const std::string &parameter_file,
+                         const controller_parameters *parameters, result &run_result)
+{
+    run_result      = result();
+    run_result.name = task.name;
+    run_result.seed = seed;
+
+    session run_session;
+    if (setup(task, seed, parameter_file, parameters, run_session) != 0) return -1;
+    simulation_mediator &plant = run_session.plant;
+    dynamics_controller &controller = *run_session.controller;
+    controller.set_free_running(true);
+
+    // Safety net only: the FSM ends the task at its time limit
+    const int max_cycles = static_cast<int>((TASK_TIME_LIMIT_SEC + 1.0) * RATE_HZ);
+    plant.set_cycle_limit(max_cycles);
+
+    std::vector<double> compute_times;
+    compute_times.reserve(max_cycles);
+    double squared_error_sum = 0.0, squared_torque_sum = 0.0;
+    bool initial_pose_stored = false;
+    KDL::Vector initial_position;
+
+    plant.set_cycle_callback([&](const double compute_time_micro)
+    {
+        compute_times.push_back(compute_time_micro);
+        const fsm_snapshot &snapshot = controller.get_fsm_snapshot();
+
+        double error = 0.0;
+        if (task.tracked_dims.empty())
+        {
+            if (!initial_pose_stored)
+            {
+                initial_position = snapshot.end_effector_pose.p;
+                initial_pose_stored = true;
+            }
+            error = (snapshot.end_effector_pose.p - initial_position).Norm();
+        }
+        else
+        {
+            for (const int i : task.tracked_dims)
+                error += snapshot.current_error.vel(i) * snapshot.current_error.vel(i);
+            error = std::sqrt(error);
+        }
+        run_result.peak_error = std::max(run_result.peak_error, error);
+        squared_error_sum    += error * error;
+
+        const KDL::JntArray &torques = plant.get_commanded_torques();
+        for (int j = 0; j < JOINTS; j++)
+        {
+            const double relative_torque = torques(j) / kinova_constants::joint_torque_limits[j];
+            squared_torque_sum += relative_torque * relative_torque / JOINTS;
+        }
+
+        for (const int i : task.tube_dims)
+        {
+            if (std::fabs(snapshot.current_error.vel(i)) > task.tube_tolerances[i])
+            {
+                run_result.tube_violation_sec += DT_SEC;
+                break;
+            }
+        }
+
+        if (!run_result.completed && task.has_goal && controller.is_goal_reached())
+        {
+            run_result.completed = true;
+            run_result.completion_time_sec = snapshot.time_passed_sec;
+            plant.set_cycle_limit(plant.get_cycle_count() + SETTLE_CYCLES);
+        }
+    });
+
+    run_result.return_flag = controller.control();
+    controller.deinitialize();
+
+    run_result.cycles = static_cast<int>(compute_times.size());
+    if (run_result.cycles == 0) return 0;
+
+    // Pure feedforward task: completed if it held the robot until its time limit
+    if (!task.has_goal)
+    {
+        run_result.completion_time_sec = controller.get_fsm_snapshot().time_passed_sec;
+        run_result.completed = (run_result.completion_time_sec >= TASK_TIME_LIMIT_SEC - DT_SEC);
+    }
+
+    run_result.rms_error    = std::sqrt(squared_error_sum / run_result.cycles);
+    run_result.torque_usage = std::sqrt(squared_torque_sum / run_result.cycles);
+    for (const double time : compute_times) run_result.compute_mean_us += time;
+    run_result.compute_mean_us /= run_result.cycles;
+
+    std::sort(compute_times.begin(), compute_times.end());
+    run_result.compute_p50_us = compute_times[run_result.cycles / 2];
+    run_result.compute_p99_us = compute_times[std::min(run_result.cycles - 1, static_cast<int>(0.99 * run_result.cycles))];
+    run_result.compute_max_us = compute_times.back();
+    return 0;
+}
@@ -0,0 +1,394 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "simulation_mediator.hpp"
+#define SIMULATION_ENVIRONMENT 1
+
+simulation_mediator::simulation_mediator():
+    is_initialized_(false), robot_id_(robot_id::KINOVA_GEN3_1), DT_SEC_(0.0),
+    NUM_OF_JOINTS_(kinova_constants::NUMBER_OF_JOINTS),
+    q_(NUM_OF_JOINTS_), qd_(NUM_OF_JOINTS_), qdd_(NUM_OF_JOINTS_),
+    measured_torque_(NUM_OF_JOINTS_), total_torque_(NUM_OF_JOINTS_), commanded_torque_(NUM_OF_JOINTS_),
+    contact_wrench_(KDL::Wrench::Zero()), noise_generator_(0),
+    standard_normal_(0.0, 1.0), position_noise_stddev_(0.0), velocity_noise_stddev_(0.0),
+    cycle_count_(0), max_cycles_(-1), state_read_time_(std::chrono::steady_clock::now())
+{
+    contact_plane_.active = false;
+}
+
+void simulation_mediator::initialize(const int robot_model,
+                                     const int robot_environment,
+                                     const int id,
+                                     const double DT_SEC)
+{
+    robot_id_ = id;
+    DT_SEC_   = DT_SEC;
+
+    int parser_result = get_model_from_urdf(kinova_constants::urdf_path, kinova_constants::tooltip_name, robot_chain_);
+    if (parser_result == 0) parser_result = get_model_from_urdf(kinova_constants::urdf_path, "EndEffector_Link", robot_chain_full_);
+    if (parser_result == 0) parser_result = get_model_from_urdf(kinova_constants::urdf_sim_path, kinova_constants::tooltip_sim_name, sim_chain_);
+    if (parser_result != 0)
+    {
+        printf("Cannot create simulation model! \n");
+        return;
+    }
+
+    this->fd_solver_rne_ = std::make_shared<KDL::FdSolver_RNE>(sim_chain_, 
+                                                               -1 * KDL::Vector(kinova_constants::root_acceleration_sim[0],
+                                                                                kinova_constants::root_acceleration_sim[1],
+                                                                                kinova_constants::root_acceleration_sim[2]), 
+                                                               kinova_constants::joint_sim_inertia);
+    this->fk_vel_solver_ = std::make_shared<KDL::ChainFkSolverVel_recursive>(sim_chain_);
+    ext_wrenches_ = KDL::Wrenches(sim_chain_.getNrOfSegments(), KDL::Wrench::Zero());
+    cycle_count_  = 0;
+    is_initialized_ = true;
+}
+
+int simulation_mediator::get_model_from_urdf(const std::string &urdf_path,
+                                             const std::string &tip_name,
+                                             KDL::Chain &chain)
+{
+    urdf::Model urdf_model;
+    KDL::Tree tree;
+
+    if (!urdf_model.initFile(urdf_path))
+    {
+        printf("ERROR: Failed to parse urdf robot model \n");
+        return -1;
+    }
+
+    //Extract KDL tree from the URDF file
+    if (!kdl_parser::treeFromUrdfModel(urdf_model, tree))
+    {
+        printf("ERROR: Failed to construct kdl tree \n");
+        return -1;
+    }
+
+    //Extract KDL chain from KDL tree
+    if (!tree.getChain(kinova_constants::root_name, tip_name, chain))
+    {
+        printf("ERROR: Failed to extract kdl chain \n");
+        return -1;
+    }
+    return 0;
+}
+
+void simulation_mediator::set_joint_state(const KDL::JntArray &joint_positions,
+                                          const KDL::JntArray &joint_velocities)
+{
+    q_  = joint_positions;
+    qd_ = joint_velocities;
+    KDL::SetToZero(qdd_);
+    KDL::SetToZero(measured_torque_);
+    KDL::SetToZero(commanded_torque_);
+    update_contact_wrench();
+}
+
+void simulation_mediator::set_sensor_noise(const double position_stddev,
+                                           const double velocity_stddev,
+                                           const unsigned int seed)
+{
+    noise_generator_.seed(seed);
+    standard_normal_.reset();
+    position_noise_stddev_ = position_stddev;
+    velocity_noise_stddev_ = velocity_stddev;
+}
+
+void simulation_mediator::set_contact_plane(const KDL::Vector &point, const KDL::Vector &normal,
+                                            const double stiffness, const double damping)
+{
+    assert(("Contact plane normal must not be zero", normal.Norm() > 0.0));
+    contact_plane_.point     = point;
+    contact_plane_.normal    = normal / normal.Norm();
+    contact_plane_.stiffness = stiffness;
+    contact_plane_.damping   = damping;
+    contact_plane_.active    = true;
+    update_contact_wrench();
+}
+
+void simulation_mediator::remove_contact_plane()
+{
+    contact_plane_.active = false;
+    update_contact_wrench();
+}
+
+void simulation_mediator::set_cycle_limit(const int max_cycles)
+{
+    max_cycles_ = max_cycles;
+}
+
+int simulation_mediator::get_cycle_count() const
+{
+    return cycle_count_;
+}
+
+void simulation_mediator::set_cycle_callback(const std::function<void(const double compute_time_micro)> &callback)
+{
+    cycle_callback_ = callback;
+}
+
+const KDL::JntArray &simulation_mediator::get_commanded_torques() const
+{
+    return commanded_torque_;
+}
+
+// Spring-damper reaction of the plane, applied at the end-effector and expressed in its frame
+void simulation_mediator::update_contact_wrench()
+{
+    KDL::SetToZero(contact_wrench_);
+    if (contact_plane_.active && is_initialized_)
+    {
+        KDL::FrameVel end_effector;
+        fk_vel_solver_->JntToCart(KDL::JntArrayVel(q_, qd_), end_effector);
+        const KDL::Frame pose   = end_effector.GetFrame();
+        const KDL::Twist twist  = end_effector.GetTwist();
+
+        const double penetration = -KDL::dot(contact_plane_.normal, pose.p - contact_plane_.point);
+        if (penetration > 0.0)
+        {
+            // The plane can only push
+            const double force = std::max(0.0, contact_plane_.stiffness * penetration - 
+                                               contact_plane_.damping * KDL::dot(contact_plane_.normal, twist.vel));
+            contact_wrench_.force = pose.M.Inverse(force * contact_plane_.normal);
+        }
+    }
+    if (!ext_wrenches_.empty()) ext_wrenches_.back() = contact_wrench_;
+}
+
+// Same convention as the Kinova API: positive angles, except for the joints with limits
+void simulation_mediator::get_joint_positions(KDL::JntArray &joint_positions) 
+{
+    for (int i = 0; i < NUM_OF_JOINTS_; i++)
+    {
+        joint_positions(i) = std::fmod(q_(i), 2.0 * M_PI);
+        if (joint_positions(i) < 0.0) joint_positions(i) += 2.0 * M_PI;
+        if (position_noise_stddev_ > 0.0) joint_positions(i) += position_noise_stddev_ * standard_normal_(noise_generator_);
+    }
+
+    if (joint_positions(1) > M_PI) joint_positions(1) -= 2.0 * M_PI;
+    if (joint_positions(3) > M_PI) joint_positions(3) -= 2.0 * M_PI;
+    if (joint_positions(5) > M_PI) joint_positions(5) -= 2.0 * M_PI;
+}
+
+void simulation_mediator::get_joint_velocities(KDL::JntArray &joint_velocities)
+{
+    for (int i = 0; i < NUM_OF_JOINTS_; i++)
+    {
+        joint_velocities(i) = qd_(i);
+        if (velocity_noise_stddev_ > 0.0) joint_velocities(i) += velocity_noise_stddev_ * standard_normal_(noise_generator_);
+    }
+}
+
+void simulation_mediator::get_joint_torques(KDL::JntArray &joint_torques)
+{
+    joint_torques = measured_torque_;
+}
+
+void simulation_mediator::get_end_effector_wrench(KDL::Wrench &end_effector_wrench)
+{
+    end_effector_wrench = contact_wrench_;
+}
+
+void simulation_mediator::get_joint_state(KDL::JntArray &joint_positions,
+                                          KDL::JntArray &joint_velocities,
+                                          KDL::JntArray &joint_torques)
+{
+    get_joint_positions(joint_positions);
+    get_joint_velocities(joint_velocities);
+    get_joint_torques(joint_torques);
+    state_read_time_ = std::chrono::steady_clock::now();
+}
+
+void simulation_mediator::get_robot_state(KDL::JntArray &joint_positions,
+                                          KDL::JntArray &joint_velocities,
+                                          KDL::JntArray &joint_torques,
+                                          KDL::Wrench &end_effector_wrench)
+{
+    get_end_effector_wrench(end_effector_wrench);
+    get_joint_state(joint_positions, joint_velocities, joint_torques);
+}
+
+int simulation_mediator::set_joint_command(const KDL::JntArray &joint_positions,
+                                           const KDL::JntArray &joint_velocities,
+                                           const KDL::JntArray &joint_torques,
+                                           const int desired_control_mode)
+{
+    const double compute_time_micro = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - state_read_time_).count();
+    if (max_cycles_ >= 0 && cycle_count_ >= max_cycles_) return -1;
+
+    int return_flag = 0;
+    switch (desired_control_mode)
+    {
+        case control_mode::TORQUE:
+            return_flag = set_joint_torques(joint_torques);
+            break;
+
+        case control_mode::VELOCITY:
+            return_flag = set_joint_velocities(joint_velocities);
+            break;
+
+        case control_mode::POSITION:
+            return_flag = set_joint_positions(joint_positions);
+            break;
+
+        case control_mode::STOP_MOTION:
+            return_flag = stop_robot_motion();
+            break;
+
+        default:
+            printf("Unsupported control mode\n");
+            return -1;
+    }
+    if (return_flag != 0) return return_flag;
+
+    cycle_count_++;
+    if (cycle_callback_) cycle_callback_(compute_time_micro);
+    return 0;
+}
+
+int simulation_mediator::set_joint_positions(const KDL::JntArray &joint_positions)
+{
+    q_ = joint_positions;
+    KDL::SetToZero(qd_);
+    update_contact_wrench();
+    return 0;
+}
+
+int simulation_mediator::set_joint_velocities(const KDL::JntArray &joint_velocities)
+{
+    qd_ = joint_velocities;
+    q_.data += qd_.data * DT_SEC_;
+    update_contact_wrench();
+    return 0;
+}
+
+int simulation_mediator::set_joint_torques(const KDL::JntArray &joint_torques)
+{
+    // Call FD solver (inverse-inertia version) to compute jnt acc. given the control torque commands
+    int solver_return = this->fd_solver_rne_->CartToJnt(q_, qd_, joint_torques, ext_wrenches_, qdd_, total_torque_);
+    if (solver_return != 0)
+    {
+        rt_event::publish(rt_event::SOLVER_ERROR, solver_return, rt_event::SIMULATION_MEDIATOR);
+        return -1;
+    }
+
+    // Symplectic Euler
+    qd_.data += qdd_.data * DT_SEC_;
+    q_.data  += qd_.data * DT_SEC_;
+
+    // Sign convention of the Kinova torque sensors
+    commanded_torque_ = joint_torques;
+    measured_torque_.data = -joint_torques.data;
+    update_contact_wrench();
+    return 0;
+}
+
+int simulation_mediator::stop_robot_motion()
+{
+    KDL::SetToZero(qd_);
+    KDL::SetToZero(qdd_);
+    update_contact_wrench();
+    return 0;
+}
+
+bool simulation_mediator::is_initialized()
+{
+    return is_initialized_;
+}
+
+int simulation_mediator::get_robot_ID()
+{
+    return robot_id_;
+}
+
+int simulation_mediator::get_robot_environment()
+{
+    return SIMULATION_ENVIRONMENT;
+}
+
+std::vector<double> simulation_mediator::get_maximum_joint_pos_limits()
+{
+    return kinova_constants::joint_position_limits_max;
+}
+
+std::vector<double> simulation_mediator::get_minimum_joint_pos_limits()
+{
+    return kinova_constants::joint_position_limits_min;
+}
+
+std::vector<double> simulation_mediator::get_joint_position_thresholds()
+{
+    return kinova_constants::joint_position_thresholds;
+}
+
+std::vector<double> simulation_mediator::get_joint_velocity_limits()
+{
+    return kinova_constants::joint_velocity_limits;
+}
+
+std::vector<double> simulation_mediator::get_joint_acceleration_limits()
+{
+    return kinova_constants::joint_acceleration_limits;
+}
+
+std::vector<double> simulation_mediator::get_joint_torque_limits()
+{
+    return kinova_constants::joint_torque_limits;
+}
+
+std::vector<double> simulation_mediator::get_joint_stopping_torque_limits()
+{
+    return kinova_constants::joint_stopping_torque_limits;
+}
+
+std::vector<double> simulation_mediator::get_joint_inertia()
+{
+    return kinova_constants::joint_inertia;
+}
+
+std::vector<double> simulation_mediator::get_joint_offsets()
+{
+    return kinova_constants::joint_offsets;
+}
+
+KDL::Twist simulation_mediator::get_root_acceleration()
+{
+    return KDL::Twist(KDL::Vector(kinova_constants::root_acceleration_1[0],
+                                  kinova_constants::root_acceleration_1[1],
+                                  kinova_constants::root_acceleration_1[2]),
+                      KDL::Vector(kinova_constants::root_acceleration_1[3],
+                                  kinova_constants::root_acceleration_1[4],
+                                  kinova_constants::root_acceleration_1[5]));
+}
+
+KDL::Chain simulation_mediator::get_robot_model() 
+{
+    return robot_chain_; 
+}
+
+KDL::Chain simulation_mediator::get_full_robot_model() 
+{
+    return robot_chain_full_; 
+}
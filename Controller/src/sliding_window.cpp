@@ -0,0 +1,279 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <sliding_window.hpp>
+
+sliding_window::sliding_window(const int window_size, const int num_dimensions):
+    WINDOW_SIZE_(window_size), DIMENSIONS_(num_dimensions), synchronized_(true),
+    samples_(Eigen::MatrixXd::Zero(num_dimensions, window_size)),
+    heads_(Eigen::VectorXi::Zero(num_dimensions)),
+    counts_(Eigen::VectorXi::Zero(num_dimensions)),
+    means_(Eigen::VectorXd::Zero(num_dimensions)),
+    variances_(Eigen::VectorXd::Zero(num_dimensions)),
+    sums_(Eigen::VectorXd::Zero(num_dimensions)),
+    index_sums_(Eigen::VectorXd::Zero(num_dimensions)),
+    removed_(Eigen::VectorXd::Zero(num_dimensions)),
+    delta_(Eigen::VectorXd::Zero(num_dimensions)),
+    median_buffer_(window_size, 0.0)
+{
+    assert(("Sliding window not initialized properly", DIMENSIONS_ > 0 && WINDOW_SIZE_ > 0));
+    clear();
+}
+
+void sliding_window::update(const Eigen::VectorXd &state)
+{
+    assert(DIMENSIONS_ == state.rows());
+
+    // Dimensions have been updated/cleared separately: no common head to operate on
+    if (!synchronized_)
+    {
+        for (int i = 0; i < DIMENSIONS_; i++)
+            push_sample(i, state(i));
+        return;
+    }
+
+    const int head = heads_(0);
+    if (counts_(0) < WINDOW_SIZE_)
+    { // Initial window elements
+        counts_.array() += 1;
+        delta_               = state - means_;
+        means_              += delta_ / static_cast<float>(counts_(0));
+        variances_.array()  += delta_.array() * (state - means_).array();
+        index_sums_         += static_cast<double>(counts_(0) - 1) * state;
+        sums_               += state;
+    }
+    else
+    { // All other window elements
+        removed_             = samples_.col(head);
+        delta_               = means_;
+        means_              += (state - removed_) / static_cast<float>(WINDOW_SIZE_);
+        variances_.array()  += (state + removed_ - delta_ - means_).array() * (state - removed_).array();
+        index_sums_         += static_cast<double>(WINDOW_SIZE_ - 1) * state - (sums_ - removed_);
+        sums_               += state - removed_;
+    }
+
+    samples_.col(head) = state;
+    heads_.setConstant((head + 1 == WINDOW_SIZE_)? 0 : head + 1);
+
+    // Bound the drift of the running sums: exact re-summation once per window
+    if ((heads_(0) == 0) && (counts_(0) == WINDOW_SIZE_))
+    {
+        for (int i = 0; i < DIMENSIONS_; i++)
+            refresh_sums(i);
+    }
+}
+
+void sliding_window::update(const int dimension, const double state)
+{
+    assert(dimension >= 0);
+    assert(dimension < DIMENSIONS_);
+
+    push_sample(dimension, state);
+    check_synchronization();
+}
+
+void sliding_window::push_sample(const int dimension, const double state)
+{
+    const int head = heads_(dimension);
+    if (counts_(dimension) < WINDOW_SIZE_)
+    { // Initial window elements
+        counts_(dimension)++;
+        double delta               = state - means_(dimension);
+        means_(dimension)         += delta / static_cast<float>(counts_(dimension));
+        variances_(dimension)     += delta * (state - means_(dimension));
+        index_sums_(dimension)    += static_cast<double>(counts_(dimension) - 1) * state;
+        sums_(dimension)          += state;
+    }
+    else
+    { // All other window elements
+        double removed_state       = samples_(dimension, head);
+        double old_mean            = means_(dimension);
+        means_(dimension)         += (state - removed_state) / static_cast<float>(WINDOW_SIZE_);
+        variances_(dimension)     += (state + removed_state - old_mean - means_(dimension)) * (state - removed_state);
+        index_sums_(dimension)    += static_cast<double>(WINDOW_SIZE_ - 1) * state - (sums_(dimension) - removed_state);
+        sums_(dimension)          += state - removed_state;
+    }
+
+    samples_(dimension, head) = state;
+    heads_(dimension) = (head + 1 == WINDOW_SIZE_)? 0 : head + 1;
+
+    if ((heads_(dimension) == 0) && (counts_(dimension) == WINDOW_SIZE_)) refresh_sums(dimension);
+}
+
+// Exact re-computation of the sums used by the least-squares slope
+void sliding_window::refresh_sums(const int dimension)
+{
+    const int oldest = oldest_index(dimension);
+    sums_(dimension)       = 0.0;
+    index_sums_(dimension) = 0.0;
+
+    for (int k = 0; k < counts_(dimension); k++)
+    {
+        const int slot = (oldest + k) % WINDOW_SIZE_;
+        sums_(dimension)       += samples_(dimension, slot);
+        index_sums_(dimension) += static_cast<double>(k) * samples_(dimension, slot);
+    }
+}
+
+void sliding_window::check_synchronization()
+{
+    synchronized_ = (counts_.array() == counts_(0)).all() && (heads_.array() == heads_(0)).all();
+}
+
+int sliding_window::oldest_index(const int dimension) const
+{
+    return (counts_(dimension) < WINDOW_SIZE_)? 0 : heads_(dimension);
+}
+
+void sliding_window::clear()
+{
+    samples_.setZero();
+    heads_.setZero();
+    counts_.setZero();
+    means_.setZero();
+    variances_.setZero();
+    sums_.setZero();
+    index_sums_.setZero();
+    synchronized_ = true;
+}
+
+void sliding_window::clear(const int dimension)
+{
+    assert(dimension >= 0);
+    assert(dimension < DIMENSIONS_);
+
+    samples_.row(dimension).setZero();
+    heads_(dimension)      = 0;
+    counts_(dimension)     = 0;
+    means_(dimension)      = 0.0;
+    variances_(dimension)  = 0.0;
+    sums_(dimension)       = 0.0;
+    index_sums_(dimension) = 0.0;
+    check_synchronization();
+}
+
+int sliding_window::get_size(const int dimension) const
+{
+    assert(dimension >= 0);
+    assert(dimension < DIMENSIONS_);
+
+    return counts_(dimension);
+}
+
+bool sliding_window::is_full(const int dimension) const
+{
+    return get_size(dimension) == WINDOW_SIZE_;
+}
+
+double sliding_window::get_oldest(const int dimension) const
+{
+    assert(("Window is empty", get_size(dimension) > 0));
+    return samples_(dimension, oldest_index(dimension));
+}
+
+double sliding_window::get_newest(const int dimension) const
+{
+    assert(("Window is empty", get_size(dimension) > 0));
+    return samples_(dimension, (heads_(dimension) == 0)? WINDOW_SIZE_ - 1 : heads_(dimension) - 1);
+}
+
+Eigen::VectorXd sliding_window::get_mean() const
+{
+    return means_;
+}
+
+double sliding_window::get_mean(const int dimension) const
+{
+    assert(dimension >= 0);
+    assert(dimension < DIMENSIONS_);
+
+    return means_(dimension);
+}
+
+Eigen::VectorXd sliding_window::get_variance() const
+{
+    Eigen::VectorXd variance(DIMENSIONS_);
+    for (int i = 0; i < DIMENSIONS_; i++)
+        variance(i) = get_variance(i);
+    return variance;
+}
+
+double sliding_window::get_variance(const int dimension) const
+{
+    // Normalize the value
+    if (get_size(dimension) == 0) return 0.0;
+    return variances_(dimension) / static_cast<float>(counts_(dimension));
+}
+
+Eigen::VectorXd sliding_window::get_slope() const
+{
+    Eigen::VectorXd slope(DIMENSIONS_);
+    for (int i = 0; i < DIMENSIONS_; i++)
+        slope(i) = get_slope(i);
+    return slope;
+}
+
+/**
+ * Least-squares fit of y = a + b * k, with k = 0 ... n-1 (oldest to newest):
+ * b = (n * sum(k * y) - sum(k) * sum(y)) / (n * sum(k^2) - sum(k)^2)
+ */
+double sliding_window::get_slope(const int dimension) const
+{
+    const double n = static_cast<double>(get_size(dimension));
+    if (n < 2.0) return 0.0;
+
+    const double k_sum        = n * (n - 1.0) / 2.0;
+    const double k_square_sum = (n - 1.0) * n * (2.0 * n - 1.0) / 6.0;
+    return (n * index_sums_(dimension) - k_sum * sums_(dimension)) / (n * k_square_sum - k_sum * k_sum);
+}
+
+double sliding_window::get_min(const int dimension) const
+{
+    assert(("Window is empty", get_size(dimension) > 0));
+    return samples_.row(dimension).head(counts_(dimension)).minCoeff();
+}
+
+double sliding_window::get_max(const int dimension) const
+{
+    assert(("Window is empty", get_size(dimension) > 0));
+    return samples_.row(dimension).head(counts_(dimension)).maxCoeff();
+}
+
+// Selection on a preallocated copy: O(n) on average, the window itself is not reordered
+double sliding_window::get_median(const int dimension)
+{
+    assert(("Window is empty", get_size(dimension) > 0));
+
+    const int n = counts_(dimension);
+    for (int k = 0; k < n; k++) median_buffer_[k] = samples_(dimension, k);
+
+    const int middle = n / 2;
+    std::nth_element(median_buffer_.begin(), median_buffer_.begin() + middle, median_buffer_.begin() + n);
+    const double upper = median_buffer_[middle];
+    if (n % 2 != 0) return upper;
+
+    // Even number of samples: average with the largest element of the lower half
+    const double lower = *std::max_element(median_buffer_.begin(), median_buffer_.begin() + middle);
+    return 0.5 * (lower + upper);
+}
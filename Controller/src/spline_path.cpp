@@ -0,0 +1,230 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <spline_path.hpp>
+
+spline_path::spline_path(const std::vector< std::vector<double> > &path_points)
+{
+    const int num_of_points = path_points.size();
+    assert(("Spline path requires at least two points", num_of_points > 1));
+
+    std::vector<Eigen::Vector3d> points(num_of_points);
+    for (int i = 0; i < num_of_points; i++)
+        points[i] = Eigen::Vector3d(path_points[i][0], path_points[i][1], path_points[i][2]);
+
+    const int num_of_pieces = num_of_points - 1;
+    std::vector<double> chord_lengths(num_of_pieces);
+    for (int i = 0; i < num_of_pieces; i++)
+        chord_lengths[i] = std::max((points[i + 1] - points[i]).norm(), 1e-9);
+
+    // Tangents at the points: chord-length weighted average of the adjacent unit chord directions, not unit length in general
+    std::vector<Eigen::Vector3d> tangents(num_of_points);
+    tangents[0]                 = (points[1] - points[0]) / chord_lengths[0];
+    tangents[num_of_points - 1] = (points[num_of_points - 1] - points[num_of_points - 2]) / chord_lengths[num_of_pieces - 1];
+    for (int i = 1; i < num_of_points - 1; i++)
+    {
+        tangents[i] = ((points[i + 1] - points[i]) / chord_lengths[i] * chord_lengths[i - 1] + 
+                       (points[i] - points[i - 1]) / chord_lengths[i - 1] * chord_lengths[i]) / (chord_lengths[i - 1] + chord_lengths[i]);
+    }
+
+    a_.resize(num_of_pieces); b_.resize(num_of_pieces);
+    c_.resize(num_of_pieces); d_.resize(num_of_pieces);
+    for (int i = 0; i < num_of_pieces; i++)
+    {
+        const Eigen::Vector3d m0 = chord_lengths[i] * tangents[i];
+        const Eigen::Vector3d m1 = chord_lengths[i] * tangents[i + 1];
+        a_[i] = points[i];
+        b_[i] = m0;
+        c_[i] = 3.0 * (points[i + 1] - points[i]) - 2.0 * m0 - m1;
+        d_[i] = 2.0 * (points[i] - points[i + 1]) + m0 + m1;
+    }
+
+    // Cumulative arc length at u = k / TABLE_SAMPLES_PER_PIECE_ of each piece
+    arc_length_table_.resize(num_of_pieces * TABLE_SAMPLES_PER_PIECE_ + 1);
+    arc_length_table_[0] = 0.0;
+    const double du = 1.0 / TABLE_SAMPLES_PER_PIECE_;
+    for (int i = 0; i < num_of_pieces; i++)
+    {
+        for (int k = 0; k < TABLE_SAMPLES_PER_PIECE_; k++)
+        {
+            const int index = i * TABLE_SAMPLES_PER_PIECE_ + k;
+            arc_length_table_[index + 1] = arc_length_table_[index] + piece_length(i, k * du, (k + 1) * du);
+        }
+    }
+}
+
+// 3-point Gauss-Legendre quadrature of |P'(u)|
+double spline_path::piece_length(const int piece, const double u_start, const double u_end) const
+{
+    const double half_width = 0.5 * (u_end - u_start);
+    const double center     = 0.5 * (u_end + u_start);
+    const double node       = std::sqrt(3.0 / 5.0);
+
+    return half_width * (5.0 / 9.0 * first_derivative(piece, center - half_width * node).norm() + 
+                         8.0 / 9.0 * first_derivative(piece, center).norm() + 
+                         5.0 / 9.0 * first_derivative(piece, center + half_width * node).norm());
+}
+
+void spline_path::locate(const double arc_length, int &piece, double &u) const
+{
+    const double s = std::max(0.0, std::min(arc_length, get_length()));
+
+    // Last table entry not greater than s
+    int index = std::upper_bound(arc_length_table_.begin(), arc_length_table_.end(), s) - arc_length_table_.begin() - 1;
+    index = std::max(0, std::min(index, static_cast<int>(arc_length_table_.size()) - 2));
+
+    piece = index / TABLE_SAMPLES_PER_PIECE_;
+    const double du = 1.0 / TABLE_SAMPLES_PER_PIECE_;
+    const double u_start = (index % TABLE_SAMPLES_PER_PIECE_) * du;
+    const double interval = arc_length_table_[index + 1] - arc_length_table_[index];
+
+    // Linear interpolation within the table interval, followed by a Newton step on the arc length
+    u = u_start + ((interval > 1e-12)? (s - arc_length_table_[index]) / interval * du : 0.0);
+    const double speed = first_derivative(piece, u).norm();
+    if (speed > 1e-12) u -= (arc_length_table_[index] + piece_length(piece, u_start, u) - s) / speed;
+    u = std::max(0.0, std::min(u, 1.0));
+}
+
+Eigen::Vector3d spline_path::position(const int piece, const double u) const
+{
+    return a_[piece] + u * (b_[piece] + u * (c_[piece] + u * d_[piece]));
+}
+
+Eigen::Vector3d spline_path::first_derivative(const int piece, const double u) const
+{
+    return b_[piece] + u * (2.0 * c_[piece] + 3.0 * u * d_[piece]);
+}
+
+Eigen::Vector3d spline_path::second_derivative(const int piece, const double u) const
+{
+    return 2.0 * c_[piece] + 6.0 * u * d_[piece];
+}
+
+double spline_path::get_length() const
+{
+    return arc_length_table_.back();
+}
+
+int spline_path::get_number_of_pieces() const
+{
+    return a_.size();
+}
+
+Eigen::Vector3d spline_path::get_position(const double arc_length) const
+{
+    int piece = 0; double u = 0.0;
+    locate(arc_length, piece, u);
+    return position(piece, u);
+}
+
+Eigen::Vector3d spline_path::get_tangent(const double arc_length) const
+{
+    int piece = 0; double u = 0.0;
+    locate(arc_length, piece, u);
+    return first_derivative(piece, u).normalized();
+}
+
+Eigen::Vector3d spline_path::get_normal(const double arc_length) const
+{
+    return get_frenet_frame(arc_length).col(1);
+}
+
+double spline_path::get_curvature(const double arc_length) const
+{
+    int piece = 0; double u = 0.0;
+    locate(arc_length, piece, u);
+
+    const Eigen::Vector3d velocity = first_derivative(piece, u);
+    const double speed = velocity.norm();
+    if (speed < 1e-12) return 0.0;
+    return velocity.cross(second_derivative(piece, u)).norm() / (speed * speed * speed);
+}
+
+Eigen::Matrix3d spline_path::get_frenet_frame(const double arc_length) const
+{
+    int piece = 0; double u = 0.0;
+    locate(arc_length, piece, u);
+
+    const Eigen::Vector3d tangent = first_derivative(piece, u).normalized();
+    Eigen::Vector3d normal = second_derivative(piece, u);
+    normal -= normal.dot(tangent) * tangent;
+
+    // Straight piece: normal is not defined by the curve, take the one of the task frame
+    if (normal.norm() < 1e-9) normal = Eigen::Quaterniond::FromTwoVectors(Eigen::Vector3d::UnitX(), tangent) * Eigen::Vector3d::UnitY();
+    normal.normalize();
+
+    Eigen::Matrix3d frame;
+    frame.col(0) = tangent;
+    frame.col(1) = normal;
+    frame.col(2) = tangent.cross(normal);
+    return frame;
+}
+
+Eigen::Matrix3d spline_path::get_task_frame(const double arc_length) const
+{
+    const Eigen::Vector3d tangent = get_tangent(arc_length);
+
+    // Anti-parallel case: same choice as in the tube task definitions (rotation about Z by PI)
+    if (tangent.dot(Eigen::Vector3d::UnitX()) < (-1.0 + 1e-6)) return Eigen::AngleAxisd(M_PI, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+    return Eigen::Quaterniond::FromTwoVectors(Eigen::Vector3d::UnitX(), tangent).toRotationMatrix();
+}
+
+/**
+ * Chord of length L on a curve with curvature k deviates approximately k * L^2 / 8 from it.
+ * Hence, long chords on straight parts and short ones in tight curves.
+ */
+void spline_path::sample_points(const double max_deviation,
+                                std::vector< std::vector<double> > &path_points) const
+{
+    std::vector<double> arc_lengths;
+    sample_points(max_deviation, path_points, arc_lengths);
+}
+
+void spline_path::sample_points(const double max_deviation,
+                                std::vector< std::vector<double> > &path_points,
+                                std::vector<double> &arc_lengths) const
+{
+    assert(max_deviation > 0.0);
+    const double length   = get_length();
+    const double min_step = std::max(length * 1e-4, 1e-6);
+
+    path_points.clear();
+    arc_lengths.clear();
+    double s = 0.0;
+    while (true)
+    {
+        const Eigen::Vector3d point = get_position(s);
+        path_points.push_back(std::vector<double>{point(0), point(1), point(2)});
+        arc_lengths.push_back(s);
+        if (s >= length) break;
+
+        // Curvature checked at the start and in the middle of the candidate chord
+        double curvature = std::max(get_curvature(s), 1e-9);
+        double step = std::sqrt(8.0 * max_deviation / curvature);
+        curvature = std::max(curvature, get_curvature(s + 0.5 * step));
+        step = std::max(min_step, std::sqrt(8.0 * max_deviation / curvature));
+
+        s = std::min(s + step, length);
+    }
+}
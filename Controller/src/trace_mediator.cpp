@@ -0,0 +1,552 @@
+/*
+Author(s): Djordje Vukcevic, Sven Schneider
+Institute: Hochschule Bonn-Rhein-Sieg
+
+Copyright (c) [2019]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "trace_mediator.hpp"
+#include <constants.hpp>
+#include <chrono>
+
+const char trace::MAGIC[8] = {'M', 'T', 'T', 'R', 'A', 'C', 'E', '1'};
+
+namespace
+{
+    // Ring size in bytes, rounded up to a power of two
+    std::size_t ring_size(const int capacity)
+    {
+        std::size_t size = 1;
+        while (size < (std::size_t)capacity) size <<= 1;
+        return size;
+    }
+}
+
+trace_mediator::trace_mediator(robot_mediator *robot_driver):
+    robot_driver_(robot_driver)
+{
+    assert(("Trace mediator requires a robot mediator", robot_driver_ != nullptr));
+}
+
+bool trace_mediator::is_initialized()
+{
+    return robot_driver_->is_initialized();
+}
+
+int trace_mediator::get_robot_ID()
+{
+    return robot_driver_->get_robot_ID();
+}
+
+int trace_mediator::get_robot_environment()
+{
+    return robot_driver_->get_robot_environment();
+}
+
+void trace_mediator::initialize(const int robot_model,
+                                const int robot_environment,
+                                const int id,
+                                const double DT_SEC)
+{
+    robot_driver_->initialize(robot_model, robot_environment, id, DT_SEC);
+}
+
+int trace_mediator::set_joint_positions(const KDL::JntArray &joint_positions)
+{
+    return robot_driver_->set_joint_positions(joint_positions);
+}
+
+int trace_mediator::set_joint_velocities(const KDL::JntArray &joint_velocities)
+{
+    return robot_driver_->set_joint_velocities(joint_velocities);
+}
+
+int trace_mediator::set_joint_torques(const KDL::JntArray &joint_torques)
+{
+    return robot_driver_->set_joint_torques(joint_torques);
+}
+
+int trace_mediator::stop_robot_motion()
+{
+    return robot_driver_->stop_robot_motion();
+}
+
+std::vector<double> trace_mediator::get_maximum_joint_pos_limits()
+{
+    return robot_driver_->get_maximum_joint_pos_limits();
+}
+
+std::vector<double> trace_mediator::get_minimum_joint_pos_limits()
+{
+    return robot_driver_->get_minimum_joint_pos_limits();
+}
+
+std::vector<double> trace_mediator::get_joint_position_thresholds()
+{
+    return robot_driver_->get_joint_position_thresholds();
+}
+
+std::vector<double> trace_mediator::get_joint_velocity_limits()
+{
+    return robot_driver_->get_joint_velocity_limits();
+}
+
+std::vector<double> trace_mediator::get_joint_acceleration_limits()
+{
+    return robot_driver_->get_joint_acceleration_limits();
+}
+
+std::vector<double> trace_mediator::get_joint_torque_limits()
+{
+    return robot_driver_->get_joint_torque_limits();
+}
+
+std::vector<double> trace_mediator::get_joint_stopping_torque_limits()
+{
+    return robot_driver_->get_joint_stopping_torque_limits();
+}
+
+std::vector<double> trace_mediator::get_joint_inertia()
+{
+    return robot_driver_->get_joint_inertia();
+}
+
+std::vector<double> trace_mediator::get_joint_offsets()
+{
+    return robot_driver_->get_joint_offsets();
+}
+
+KDL::Twist trace_mediator::get_root_acceleration()
+{
+    return robot_driver_->get_root_acceleration();
+}
+
+KDL::Chain trace_mediator::get_robot_model()
+{
+    return robot_driver_->get_robot_model();
+}
+
+KDL::Chain trace_mediator::get_full_robot_model()
+{
+    return robot_driver_->get_full_robot_model();
+}
+
+// Private getters are only reachable through the state functions of the derived classes
+void trace_mediator::get_joint_positions(KDL::JntArray &joint_positions){}
+void trace_mediator::get_joint_velocities(KDL::JntArray &joint_velocities){}
+void trace_mediator::get_joint_torques(KDL::JntArray &joint_torques){}
+void trace_mediator::get_end_effector_wrench(KDL::Wrench &end_effector_wrench){}
+
+
+recording_mediator::recording_mediator(robot_mediator *robot_driver):
+    trace_mediator(robot_driver), trace_file_(nullptr),
+    ring_(ring_size(dynamics_parameter::TRACE_RING_SIZE)), RING_MASK_(ring_.size() - 1),
+    write_position_(0), read_position_(0), pending_position_(0),
+    recording_(false), lost_records_(0), writer_running_(false)
+{
+}
+
+recording_mediator::~recording_mediator()
+{
+    close();
+}
+
+int recording_mediator::open(const std::string &trace_file)
+{
+    if (!robot_driver_->is_initialized())
+    {
+        printf("Robot is not initialized. Cannot record a trace\n");
+        return -1;
+    }
+
+    close();
+    trace_file_ = fopen(trace_file.c_str(), "wb");
+    if (trace_file_ == nullptr)
+    {
+        printf("Failed to open trace file: %s\n", trace_file.c_str());
+        return -1;
+    }
+
+    // Header is written before the control loop starts; records go through the ring
+    const int32_t header[3] = {robot_driver_->get_robot_ID(),
+                               robot_driver_->get_robot_environment(),
+                               (int32_t)robot_driver_->get_robot_model().getNrOfJoints()};
+    fwrite(trace::MAGIC, sizeof(trace::MAGIC), 1, trace_file_);
+    fwrite(header, sizeof(header), 1, trace_file_);
+
+    write_position_.store(0, std::memory_order_relaxed);
+    read_position_.store(0, std::memory_order_relaxed);
+    pending_position_ = 0;
+    lost_records_ = 0;
+    recording_ = true;
+
+    writer_running_.store(true, std::memory_order_release);
+    writer_ = std::thread(&recording_mediator::run_writer, this);
+    return 0;
+}
+
+void recording_mediator::close()
+{
+    if (trace_file_ == nullptr) return;
+
+    recording_ = false;
+    writer_running_.store(false, std::memory_order_release);
+    if (writer_.joinable()) writer_.join();
+
+    fclose(trace_file_);
+    trace_file_ = nullptr;
+    if (lost_records_ > 0)
+        printf("Trace ring overflowed: recording stopped, %d records not written\n", lost_records_);
+}
+
+// Writes the published records to the file, in at most two contiguous chunks
+void recording_mediator::write_out()
+{
+    const std::size_t end = write_position_.load(std::memory_order_acquire);
+    std::size_t position = read_position_.load(std::memory_order_relaxed);
+    while (position != end)
+    {
+        const std::size_t index = position & RING_MASK_;
+        const std::size_t size = std::min(end - position, ring_.size() - index);
+        fwrite(&ring_[index], 1, size, trace_file_);
+        position += size;
+    }
+
+    if (position == read_position_.load(std::memory_order_relaxed)) return;
+    read_position_.store(position, std::memory_order_release);
+    fflush(trace_file_);
+}
+
+void recording_mediator::run_writer()
+{
+    while (writer_running_.load(std::memory_order_acquire))
+    {
+        write_out();
+        std::this_thread::sleep_for(std::chrono::milliseconds(dynamics_parameter::TRACE_WRITER_POLL_PERIOD_MS));
+    }
+    write_out();
+}
+
+// Reserves space for a whole record. If it does not fit, recording stops: a partial trace must not have gaps
+bool recording_mediator::begin_record(const uint8_t type, const std::size_t payload_size)
+{
+    if (!recording_)
+    {
+        if (trace_file_ != nullptr) lost_records_++;
+        return false;
+    }
+
+    const std::size_t used = write_position_.load(std::memory_order_relaxed) -
+                             read_position_.load(std::memory_order_acquire);
+    if (used + 1 + payload_size > ring_.size())
+    {
+        recording_ = false;
+        lost_records_++;
+        return false;
+    }
+
+    pending_position_ = write_position_.load(std::memory_order_relaxed);
+    append(&type, sizeof(type));
+    return true;
+}
+
+void recording_mediator::append(const void *data, const std::size_t size)
+{
+    const std::size_t index = pending_position_ & RING_MASK_;
+    const std::size_t first_chunk = std::min(size, ring_.size() - index);
+    memcpy(&ring_[index], data, first_chunk);
+    memcpy(&ring_[0], static_cast<const char*>(data) + first_chunk, size - first_chunk);
+    pending_position_ += size;
+}
+
+void recording_mediator::end_record()
+{
+    write_position_.store(pending_position_, std::memory_order_release);
+}
+
+void recording_mediator::write_joint_arrays(const KDL::JntArray &a,
+                                            const KDL::JntArray &b,
+                                            const KDL::JntArray &c)
+{
+    const std::size_t size = a.rows() * sizeof(double);
+    append(a.data.data(), size);
+    append(b.data.data(), size);
+    append(c.data.data(), size);
+}
+
+void recording_mediator::get_joint_state(KDL::JntArray &joint_positions,
+                                         KDL::JntArray &joint_velocities,
+                                         KDL::JntArray &joint_torques)
+{
+    robot_driver_->get_joint_state(joint_positions, joint_velocities, joint_torques);
+    if (!begin_record(trace::JOINT_STATE, 3 * joint_positions.rows() * sizeof(double))) return;
+
+    write_joint_arrays(joint_positions, joint_velocities, joint_torques);
+    end_record();
+}
+
+void recording_mediator::get_robot_state(KDL::JntArray &joint_positions,
+                                         KDL::JntArray &joint_velocities,
+                                         KDL::JntArray &joint_torques,
+                                         KDL::Wrench &end_effector_wrench)
+{
+    robot_driver_->get_robot_state(joint_positions, joint_velocities,
+                                   joint_torques, end_effector_wrench);
+    record_robot_state(joint_positions, joint_velocities, joint_torques, end_effector_wrench);
+}
+
+int recording_mediator::set_joint_command(const KDL::JntArray &joint_positions,
+                                          const KDL::JntArray &joint_velocities,
+                                          const KDL::JntArray &joint_torques,
+                                          const int desired_control_mode)
+{
+    record_joint_command(joint_positions, joint_velocities, joint_torques, desired_control_mode);
+    return robot_driver_->set_joint_command(joint_positions, joint_velocities,
+                                            joint_torques, desired_control_mode);
+}
+
+void recording_mediator::record_robot_state(const KDL::JntArray &joint_positions,
+                                            const KDL::JntArray &joint_velocities,
+                                            const KDL::JntArray &joint_torques,
+                                            const KDL::Wrench &end_effector_wrench)
+{
+    const double wrench[6] = {end_effector_wrench.force(0),  end_effector_wrench.force(1),
+                              end_effector_wrench.force(2),  end_effector_wrench.torque(0),
+                              end_effector_wrench.torque(1), end_effector_wrench.torque(2)};
+    if (!begin_record(trace::ROBOT_STATE, 3 * joint_positions.rows() * sizeof(double) + sizeof(wrench))) return;
+
+    write_joint_arrays(joint_positions, joint_velocities, joint_torques);
+    append(wrench, sizeof(wrench));
+    end_record();
+}
+
+void recording_mediator::record_joint_command(const KDL::JntArray &joint_positions,
+                                              const KDL::JntArray &joint_velocities,
+                                              const KDL::JntArray &joint_torques,
+                                              const int control_mode)
+{
+    const int32_t mode = control_mode;
+    if (!begin_record(trace::JOINT_COMMAND, sizeof(mode) + 3 * joint_positions.rows() * sizeof(double))) return;
+
+    append(&mode, sizeof(mode));
+    write_joint_arrays(joint_positions, joint_velocities, joint_torques);
+    end_record();
+}
+
+
+replay_mediator::replay_mediator(robot_mediator *robot_driver):
+    trace_mediator(robot_driver), read_position_(0), num_of_joints_(0),
+    recorded_environment_(0), tolerance_(0.0), finished_(true), out_of_sync_(false),
+    compared_commands_(0), identical_commands_(0), commands_over_tolerance_(0),
+    mode_mismatches_(0), first_command_over_tolerance_(-1),
+    max_command_difference_(0.0)
+{
+}
+
+int replay_mediator::load(const std::string &trace_file, const double tolerance)
+{
+    FILE *file = fopen(trace_file.c_str(), "rb");
+    if (file == nullptr)
+    {
+        printf("Failed to open trace file: %s\n", trace_file.c_str());
+        return -1;
+    }
+
+    fseek(file, 0, SEEK_END);
+    const long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char magic[sizeof(trace::MAGIC)];
+    int32_t header[3];
+    if (file_size < (long)(sizeof(magic) + sizeof(header)) ||
+        fread(magic, sizeof(magic), 1, file) != 1 ||
+        fread(header, sizeof(header), 1, file) != 1 ||
+        memcmp(magic, trace::MAGIC, sizeof(magic)) != 0)
+    {
+        printf("Not a valid trace file: %s\n", trace_file.c_str());
+        fclose(file);
+        return -1;
+    }
+
+    if (header[0] != robot_driver_->get_robot_ID() ||
+        header[2] != (int32_t)robot_driver_->get_robot_model().getNrOfJoints())
+    {
+        printf("Trace was recorded on a different robot: ID %d, %d joints\n", header[0], header[2]);
+        fclose(file);
+        return -1;
+    }
+
+    trace_.resize(file_size - sizeof(magic) - sizeof(header));
+    if (!trace_.empty() && fread(trace_.data(), trace_.size(), 1, file) != 1)
+    {
+        printf("Failed to read trace file: %s\n", trace_file.c_str());
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+
+    recorded_environment_ = header[1];
+    num_of_joints_ = header[2];
+    tolerance_ = tolerance;
+    read_position_ = 0;
+    finished_ = trace_.empty();
+    out_of_sync_ = false;
+    compared_commands_ = 0;
+    identical_commands_ = 0;
+    commands_over_tolerance_ = 0;
+    mode_mismatches_ = 0;
+    first_command_over_tolerance_ = -1;
+    max_command_difference_ = 0.0;
+    return 0;
+}
+
+bool replay_mediator::is_finished() const
+{
+    return finished_;
+}
+
+int replay_mediator::get_robot_environment()
+{
+    return recorded_environment_;
+}
+
+// Moves the read position past the next record's type. Stops the replay if the controller's calls diverged from the recording
+bool replay_mediator::next_record(const uint8_t expected_type)
+{
+    if (finished_) return false;
+
+    std::size_t payload = 3 * num_of_joints_ * sizeof(double);
+    if (expected_type == trace::ROBOT_STATE)   payload += 6 * sizeof(double);
+    if (expected_type == trace::JOINT_COMMAND) payload += sizeof(int32_t);
+
+    if (read_position_ >= trace_.size() ||
+        (uint8_t)trace_[read_position_] != expected_type ||
+        read_position_ + 1 + payload > trace_.size())
+    {
+        if (read_position_ < trace_.size())
+        {
+            printf("Replay out of sync with the trace at byte %zu: expected record type %d, found %d\n",
+                   read_position_, expected_type, (uint8_t)trace_[read_position_]);
+            out_of_sync_ = true;
+        }
+        finished_ = true;
+        return false;
+    }
+
+    read_position_++;
+    return true;
+}
+
+void replay_mediator::read_joint_arrays(KDL::JntArray &a, KDL::JntArray &b, KDL::JntArray &c)
+{
+    const std::size_t size = num_of_joints_ * sizeof(double);
+    memcpy(a.data.data(), &trace_[read_position_], size);
+    memcpy(b.data.data(), &trace_[read_position_ + size], size);
+    memcpy(c.data.data(), &trace_[read_position_ + 2 * size], size);
+    read_position_ += 3 * size;
+}
+
+// Once the trace is exhausted, the last sample is held until the controller stops
+void replay_mediator::get_joint_state(KDL::JntArray &joint_positions,
+                                      KDL::JntArray &joint_velocities,
+                                      KDL::JntArray &joint_torques)
+{
+    if (!next_record(trace::JOINT_STATE)) return;
+    read_joint_arrays(joint_positions, joint_velocities, joint_torques);
+}
+
+void replay_mediator::get_robot_state(KDL::JntArray &joint_positions,
+                                      KDL::JntArray &joint_velocities,
+                                      KDL::JntArray &joint_torques,
+                                      KDL::Wrench &end_effector_wrench)
+{
+    if (!next_record(trace::ROBOT_STATE)) return;
+    read_joint_arrays(joint_positions, joint_velocities, joint_torques);
+
+    double wrench[6];
+    memcpy(wrench, &trace_[read_position_], sizeof(wrench));
+    read_position_ += sizeof(wrench);
+    end_effector_wrench = KDL::Wrench(KDL::Vector(wrench[0], wrench[1], wrench[2]),
+                                      KDL::Vector(wrench[3], wrench[4], wrench[5]));
+}
+
+// Max. absolute difference to the recorded array at the read position
+double replay_mediator::compare(const KDL::JntArray &command, bool &identical)
+{
+    const std::size_t size = num_of_joints_ * sizeof(double);
+    identical = identical && (memcmp(&trace_[read_position_], command.data.data(), size) == 0);
+
+    double recorded, difference = 0.0;
+    for (int i = 0; i < num_of_joints_; i++)
+    {
+        memcpy(&recorded, &trace_[read_position_ + i * sizeof(double)], sizeof(double));
+        difference = std::max(difference, std::fabs(command(i) - recorded));
+    }
+    read_position_ += size;
+    return difference;
+}
+
+int replay_mediator::set_joint_command(const KDL::JntArray &joint_positions,
+                                       const KDL::JntArray &joint_velocities,
+                                       const KDL::JntArray &joint_torques,
+                                       const int desired_control_mode)
+{
+    if (!next_record(trace::JOINT_COMMAND)) return -1;
+
+    int32_t recorded_mode;
+    memcpy(&recorded_mode, &trace_[read_position_], sizeof(recorded_mode));
+    read_position_ += sizeof(recorded_mode);
+
+    bool identical = (recorded_mode == desired_control_mode);
+    if (!identical) mode_mismatches_++;
+
+    // Only the command of the active control mode is sent to the robot, but all are compared
+    double difference = compare(joint_positions, identical);
+    difference = std::max(difference, compare(joint_velocities, identical));
+    difference = std::max(difference, compare(joint_torques, identical));
+
+    if (identical) identical_commands_++;
+    if (difference > tolerance_ || recorded_mode != desired_control_mode)
+    {
+        if (first_command_over_tolerance_ < 0) first_command_over_tolerance_ = compared_commands_;
+        commands_over_tolerance_++;
+    }
+    max_command_difference_ = std::max(max_command_difference_, difference);
+    compared_commands_++;
+
+    if (read_position_ >= trace_.size()) finished_ = true;
+    return 0;
+}
+
+int replay_mediator::print_report() const
+{
+    printf("\nReplay report:\n");
+    printf("Compared commands:          %d\n", compared_commands_);
+    printf("Bit-identical commands:     %d\n", identical_commands_);
+    printf("Control mode mismatches:    %d\n", mode_mismatches_);
+    printf("Commands over tolerance:    %d (tolerance: %e)\n", commands_over_tolerance_, tolerance_);
+    printf("Max. command difference:    %e\n", max_command_difference_);
+    if (first_command_over_tolerance_ >= 0)
+        printf("First command over tolerance: %d\n", first_command_over_tolerance_);
+    if (out_of_sync_) printf("Replay diverged from the recorded call sequence\n");
+
+    return (commands_over_tolerance_ == 0 && !out_of_sync_)? 0 : -1;
+}
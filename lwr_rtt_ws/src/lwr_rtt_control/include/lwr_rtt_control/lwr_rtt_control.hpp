@@ -58,6 +58,7 @@ SOFTWARE.
 // Custom Controller code
 #include <state_specification.hpp>
 #include <dynamics_controller.hpp>
+#include <trace_mediator.hpp>
 #include <utility> 
 
 enum desired_pose 
@@ -85,6 +86,7 @@ class LwrRttControl : public RTT::TaskContext{
         void updateHook();
         void stopHook();
         bool configureHook();
+        bool dataOnPortHook(RTT::base::PortInterface *port);
 
     private:
         const int RATE_HZ_;
@@ -94,6 +96,13 @@ class LwrRttControl : public RTT::TaskContext{
         int environment_, robot_model_, iteration_count_, simulation_loop_iterations_;
         int gazebo_arm_eef_;
 
+        // Event-driven mode: the component runs on new JointPosition samples (non-periodic activity)
+        bool event_driven_;
+        int stale_sample_count_;
+
+        // Binary trace of the sensor samples and commands, for offline replay. Empty: not recorded
+        std::string trace_file_;
+
         std::ofstream log_file_ext_force_;
 
         //Timer
@@ -122,6 +131,7 @@ class LwrRttControl : public RTT::TaskContext{
         // State and Driver
         state_specification robot_state_;
         lwr_mediator robot_driver_;
+        recording_mediator recorder_;
 
         //Solvers
         std::shared_ptr<dynamics_controller> controller_;
@@ -163,6 +173,9 @@ class LwrRttControl : public RTT::TaskContext{
                         jnt_trq_cmd_out;
         KDL::JntArray jnt_gravity_trq_out;
 
+        // Reads joint state in event-driven mode. Returns false if no new joint position sample arrived
+        bool read_fresh_samples();
+
         void visualize_pose(const std::vector<double> &pose, 
                             const std::vector<std::vector<double>> &path_poses);
         
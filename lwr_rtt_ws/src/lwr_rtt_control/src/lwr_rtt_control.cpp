@@ -31,6 +31,7 @@ LwrRttControl::LwrRttControl(const std::string& name):
     NUM_OF_JOINTS_(7), NUM_OF_CONSTRAINTS_(6), 
     environment_(lwr_environment::LWR_SIMULATION), 
     robot_model_(lwr_model::LWR_URDF), iteration_count_(0), gazebo_arm_eef_(0),
+    event_driven_(false), stale_sample_count_(0), trace_file_(""),
     simulation_loop_iterations_(10000), total_time_(0.0), task_time_limit_sec_(0.0),
     krc_compensate_gravity_(false), load_ati_sensor_(false),
     control_null_space_(false), use_mass_alternation_(false),
@@ -52,11 +53,11 @@ LwrRttControl::LwrRttControl(const std::string& name):
     null_space_abag_parameters_(Eigen::VectorXd::Constant(6, 0.1)),
     compensation_parameters_(Eigen::VectorXd::Constant(12, 0.0)),
     robot_state_(NUM_OF_JOINTS_, NUM_OF_SEGMENTS_, NUM_OF_SEGMENTS_ + 1, NUM_OF_CONSTRAINTS_),
-    return_msg_(RTT::NoData)
+    recorder_(&robot_driver_), return_msg_(RTT::NoData)
 {
     // Here you can add your ports, properties and operations
     // ex : this->addOperation("my_super_function",&LwrRttControl::MyFunction,this,RTT::OwnThread);
-    this->addPort("JointPosition",port_joint_position_in).doc("Current joint positions");
+    this->addEventPort("JointPosition",port_joint_position_in).doc("Current joint positions, triggers the component in event-driven mode");
     this->addPort("JointVelocity",port_joint_velocity_in).doc("Current joint velocities");
     this->addPort("JointTorque",port_joint_torque_in).doc("Current joint torques");
     this->addPort("ExtCartForce", port_ext_force_in).doc("ExtCartForce from ATI sensor");
@@ -64,6 +65,8 @@ LwrRttControl::LwrRttControl(const std::string& name):
     this->addPort("JointVelocityCommand",port_joint_velocity_cmd_out).doc("Command joint velocities");
     this->addPort("JointTorqueCommand",port_joint_torque_cmd_out).doc("Command joint torques");
 
+    this->addProperty("event_driven", event_driven_).doc("Compute commands on each new JointPosition sample, instead of periodically");
+    this->addProperty("trace_file", trace_file_).doc("Records the sensor samples and commands of the session, for offline replay. Empty: not recorded");
     this->addProperty("load_ati_sensor", load_ati_sensor_).doc("load_ati_sensor");
     this->addProperty("robot_model", robot_model_).doc("robot_model");
     this->addProperty("simulation_loop_iterations", simulation_loop_iterations_).doc("simulation_loop_iterations");
@@ -116,6 +119,7 @@ bool LwrRttControl::configureHook()
     jnt_trq_cmd_out.setZero(NUM_OF_JOINTS_);
     jnt_gravity_trq_out.data.setZero(NUM_OF_JOINTS_);
 
+    // Preallocated samples: write() copies into the connection buffers without allocating
     port_joint_position_cmd_out.setDataSample(jnt_pos_cmd_out);
     port_joint_velocity_cmd_out.setDataSample(jnt_vel_cmd_out);
     port_joint_torque_cmd_out.setDataSample(jnt_trq_cmd_out);
@@ -131,6 +135,9 @@ bool LwrRttControl::configureHook()
 
     if (load_ati_sensor_ && !port_ext_force_in.connected()) RTT::log(RTT::Fatal) << "No EXT Force input connection!" << RTT::endlog();
 
+    if (event_driven_ && this->getActivity() && this->getActivity()->isPeriodic())
+        RTT::log(RTT::Warning) << "Event-driven mode requested, but the activity is periodic!" << RTT::endlog();
+
     if ( !port_joint_position_cmd_out.connected() || !port_joint_torque_cmd_out.connected()) 
     {
            RTT::log(RTT::Warning) << "No output connection!"<< RTT::endlog();  
@@ -138,6 +145,7 @@ bool LwrRttControl::configureHook()
 
     robot_driver_.initialize(robot_model_, environment_, krc_compensate_gravity_);
     assert(NUM_OF_JOINTS_ == robot_driver_.get_robot_model().getNrOfSegments());
+    if (!trace_file_.empty() && recorder_.open(trace_file_) != 0) return false;
 
     this->gravity_solver_ = std::make_shared<KDL::ChainDynParam>(gazebo_arm_.Chain(), -1 * robot_driver_.get_root_acceleration().vel);
     this->fk_solver_      = std::make_shared<KDL::ChainFkSolverPos_recursive>(gazebo_arm_.Chain());
@@ -378,19 +386,28 @@ void LwrRttControl::updateHook()
     total_time_ = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_time_).count();
 
     // Read status from robot
-    port_joint_position_in.read(jnt_pos_in);
-    port_joint_velocity_in.read(jnt_vel_in);
-    port_joint_torque_in.read(jnt_trq_in);
+    if (event_driven_)
+    {
+        if (!read_fresh_samples()) return;
+    }
+    else
+    {
+        port_joint_position_in.read(jnt_pos_in);
+        port_joint_velocity_in.read(jnt_vel_in);
+        port_joint_torque_in.read(jnt_trq_in);
+        if (load_ati_sensor_) return_msg_ = port_ext_force_in.read(wrench_msg_);
+    }
 
     robot_state_.q.data  = jnt_pos_in;
     robot_state_.qd.data = jnt_vel_in;
+    robot_state_.measured_torque.data = jnt_trq_in;
     
     int function_result = 0;
     if (load_ati_sensor_)
     {
-        return_msg_ = port_ext_force_in.read(wrench_msg_);
+        // Without a new sample, the last converted wrench is used
         if (return_msg_ == RTT::NoData) RTT::log(RTT::Error) << "No Force-Torque sensor data:" << iteration_count_ << RTT::endlog(); 
-        else
+        else if (return_msg_ == RTT::NewData)
         {
             tf::wrenchMsgToKDL(wrench_msg_.wrench, ext_wrench_kdl_);
 
@@ -411,12 +428,15 @@ void LwrRttControl::updateHook()
         }
     }
     
+    // Samples and commands go through the ports, not through the mediator: recorded explicitly
+    recorder_.record_robot_state(robot_state_.q, robot_state_.qd, robot_state_.measured_torque, ext_wrench_kdl_);
     function_result = controller_->step(robot_state_.q, 
                                         robot_state_.qd, 
                                         ext_wrench_kdl_, 
                                         robot_state_.control_torque,
                                         total_time_ / SECOND,
                                         iteration_count_);
+    recorder_.record_joint_command(robot_state_.q, robot_state_.qd, robot_state_.control_torque, desired_control_mode_);
 
     if (function_result != 0)
     {
@@ -445,10 +465,44 @@ void LwrRttControl::updateHook()
     iteration_count_++;
 }
 
+// New joint position sample (the only event port): trigger updateHook only in event-driven mode
+bool LwrRttControl::dataOnPortHook(RTT::base::PortInterface * /*port*/)
+{
+    return event_driven_;
+}
+
+/*
+    Joint position is the triggering port: without a new sample, there is nothing to compute.
+    Velocity and torque are published together with the position by the robot component,
+    but may not have arrived yet; the last values are used then and counted as stale.
+    The same holds for the force sensor, which is published by a separate component.
+*/
+bool LwrRttControl::read_fresh_samples()
+{
+    if (port_joint_position_in.read(jnt_pos_in) != RTT::NewData) return false;
+
+    RTT::FlowStatus velocity_status = port_joint_velocity_in.read(jnt_vel_in);
+    RTT::FlowStatus torque_status   = port_joint_torque_in.read(jnt_trq_in);
+
+    if (velocity_status == RTT::NoData || torque_status == RTT::NoData)
+    {
+        RTT::log(RTT::Error) << "RTT: No joint velocity or torque data:" << iteration_count_ << RTT::endlog(); 
+        return false;
+    }
+
+    if (load_ati_sensor_) return_msg_ = port_ext_force_in.read(wrench_msg_);
+
+    if (velocity_status == RTT::OldData || torque_status == RTT::OldData ||
+        (load_ati_sensor_ && return_msg_ == RTT::OldData)) stale_sample_count_++;
+    return true;
+}
+
 void LwrRttControl::stopHook()
 {
     controller_->deinitialize();
+    recorder_.close();
     RTT::log(RTT::Error) << "Robot stopped!" << RTT::endlog();
+    if (event_driven_) RTT::log(RTT::Info) << "Cycles computed with stale velocity, torque or force samples: " << stale_sample_count_ << RTT::endlog();
     
     if(load_ati_sensor_) log_file_ext_force_.close();
 }